@@ -44,6 +44,7 @@ struct ROSCPP_DECL AdvertiseServiceOptions
 {
   AdvertiseServiceOptions()
   : callback_queue(0)
+  , priority(0)
   {
   }
 
@@ -125,6 +126,10 @@ struct ROSCPP_DECL AdvertiseServiceOptions
 
   CallbackQueueInterface* callback_queue;                             ///< Queue to add callbacks to.  If NULL, the global callback queue will be used
 
+  /// Priority of this service's callbacks.  Queues which order callbacks by priority (see PriorityCallbackQueue)
+  /// call higher priorities first; other queues ignore it.  Defaults to 0.
+  int32_t priority;
+
   /**
    * \brief An object whose destruction will prevent the callback associated with this service from being called
    *
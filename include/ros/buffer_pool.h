@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_BUFFER_POOL_H
+#define ROSCPP_BUFFER_POOL_H
+
+#include "common.h"
+#include "ros/serialization.h"
+
+#include <boost/shared_array.hpp>
+#include "ros/threading.h"
+#include <boost/thread/tss.hpp>
+
+#include <vector>
+#include <cstddef>
+#include <new>
+
+namespace ros
+{
+
+/**
+ * \brief Process-wide pool of message buffers
+ *
+ * Buffers are rounded up to a power-of-two size class, from MIN_BLOCK_SIZE to MAX_BLOCK_SIZE, and carved
+ * out of large slabs.  Each thread keeps a small cache of free blocks per size class, so most allocations
+ * and frees take no lock; the caches exchange blocks in batches with a global free list per size class.
+ * Buffers larger than MAX_BLOCK_SIZE are allocated directly.
+ *
+ * Slab memory is never handed back to the system, so the footprint of the pool is the high-water mark of
+ * the buffers in use at once.
+ */
+class ROSCPP_DECL BufferPool
+{
+public:
+  /// Smallest size class, in bytes
+  static const uint32_t MIN_BLOCK_SIZE = 64;
+  /// Largest size class, in bytes.  Larger buffers are not pooled.
+  static const uint32_t MAX_BLOCK_SIZE = 1 << 20;
+  /// Number of size classes between MIN_BLOCK_SIZE and MAX_BLOCK_SIZE
+  static const uint32_t NUM_SIZE_CLASSES = 15;
+  /// Size of the slabs blocks are carved out of
+  static const uint32_t SLAB_SIZE = 1 << 20;
+
+  /**
+   * \brief Whether allocate() uses the pool.  Defaults to true, and can be turned off with ROSCPP_BUFFER_POOL=0,
+   * eg. to track buffers individually with a memory checker.
+   */
+  static bool s_enabled_;
+
+  /**
+   * \brief Pool statistics.  Block counts include the blocks holding the reference counts of pooled buffers.
+   */
+  struct Stats
+  {
+    /// Block allocations served from memory already in the pool
+    uint64_t hits;
+    /// Block allocations which needed a new block to be carved out of a slab
+    uint64_t misses;
+    /// Buffers too large to be pooled (or allocated while the pool is disabled)
+    uint64_t unpooled;
+    /// Total size of the slabs allocated, in bytes
+    uint64_t footprint;
+    /// Size of the blocks sitting in the global free lists, in bytes.  Does not include the per-thread caches.
+    uint64_t free;
+  };
+
+  static BufferPool& instance();
+
+  /**
+   * \brief Allocate a buffer of at least size bytes.  The memory goes back to the pool when the last reference
+   * to it is dropped, from whichever thread that happens on.
+   */
+  boost::shared_array<uint8_t> allocate(uint32_t size);
+
+  /**
+   * \brief Allocate a raw block of at least size bytes.  Must be released with freeBlock(), passing the same size.
+   */
+  void* allocateBlock(uint32_t size);
+  void freeBlock(void* block, uint32_t size);
+
+  /**
+   * \brief Returns the pool statistics.  Each thread's counts are folded into the totals whenever its cache
+   * exchanges blocks with the global free lists, so they may lag slightly behind.
+   */
+  Stats getStats();
+
+private:
+  BufferPool();
+  ~BufferPool();
+
+  struct ThreadCache;
+  struct SizeClass;
+
+  ThreadCache* getCache();
+  void refill(uint32_t size_class, ThreadCache& cache);
+  void flush(uint32_t size_class, ThreadCache& cache, uint32_t count);
+  void foldStats(ThreadCache& cache);
+  static void releaseCache(ThreadCache* cache);
+
+  SizeClass* classes_;
+  boost::thread_specific_ptr<ThreadCache> cache_;
+
+  threading::mutex stats_mutex_;
+  Stats stats_;
+};
+
+/**
+ * \brief STL-style allocator which takes its memory from the BufferPool.  Used for the reference counts of
+ * pooled buffers, so that a pooled allocation makes no calls into the system allocator at all.
+ */
+template<typename T>
+class BufferPoolAllocator
+{
+public:
+  typedef T value_type;
+  typedef T* pointer;
+  typedef const T* const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template<typename U>
+  struct rebind
+  {
+    typedef BufferPoolAllocator<U> other;
+  };
+
+  BufferPoolAllocator() {}
+  template<typename U>
+  BufferPoolAllocator(const BufferPoolAllocator<U>&) {}
+
+  pointer address(reference r) const { return &r; }
+  const_pointer address(const_reference r) const { return &r; }
+  size_type max_size() const { return size_type(-1) / sizeof(T); }
+
+  pointer allocate(size_type n, const void* = 0)
+  {
+    return static_cast<pointer>(BufferPool::instance().allocateBlock(n * sizeof(T)));
+  }
+
+  void deallocate(pointer p, size_type n)
+  {
+    BufferPool::instance().freeBlock(p, n * sizeof(T));
+  }
+
+  void construct(pointer p, const T& t) { new (p) T(t); }
+  void destroy(pointer p) { p->~T(); }
+
+  template<typename U>
+  bool operator==(const BufferPoolAllocator<U>&) const { return true; }
+  template<typename U>
+  bool operator!=(const BufferPoolAllocator<U>&) const { return false; }
+};
+
+/**
+ * \brief Identical to serialization::serializeMessage(), except that the buffer comes from the BufferPool
+ */
+template<typename M>
+inline SerializedMessage serializePooledMessage(const M& message)
+{
+  namespace ser = serialization;
+
+  SerializedMessage m;
+  uint32_t len = ser::serializationLength(message);
+  m.num_bytes = len + 4;
+  m.buf = BufferPool::instance().allocate(m.num_bytes);
+
+  ser::OStream s(m.buf.get(), (uint32_t)m.num_bytes);
+  ser::serialize(s, (uint32_t)m.num_bytes - 4);
+  m.message_start = s.getData();
+  ser::serialize(s, message);
+
+  return m;
+}
+
+} // namespace ros
+
+#endif // ROSCPP_BUFFER_POOL_H
@@ -40,9 +40,7 @@
 #include "common.h"
 
 #include <boost/shared_ptr.hpp>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/shared_mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
+#include "ros/threading.h"
 #include <boost/thread/tss.hpp>
 
 #include <list>
@@ -88,7 +86,7 @@ public:
    * \param timeout The amount of time to wait for a callback to be available.  If there is already a callback available,
    * this parameter does nothing.
    */
-  CallOneResult callOne(ros::WallDuration timeout);
+  virtual CallOneResult callOne(ros::WallDuration timeout);
 
   /**
    * \brief Invoke all callbacks currently in the queue.  If a callback was not ready to be called, pushes it back onto the queue.
@@ -104,7 +102,7 @@ public:
    * \param timeout The amount of time to wait for at least one callback to be available.  If there is already at least one callback available,
    * this parameter does nothing.
    */
-  void callAvailable(ros::WallDuration timeout);
+  virtual void callAvailable(ros::WallDuration timeout);
 
   /**
    * \brief returns whether or not the queue is empty
@@ -113,24 +111,24 @@ public:
   /**
    * \brief returns whether or not the queue is empty
    */
-  bool isEmpty();
+  virtual bool isEmpty();
   /**
    * \brief Removes all callbacks from the queue.  Does \b not wait for calls currently in progress to finish.
    */
-  void clear();
+  virtual void clear();
 
   /**
    * \brief Enable the queue (queue is enabled by default)
    */
-  void enable();
+  virtual void enable();
   /**
    * \brief Disable the queue, meaning any calls to addCallback() will have no effect
    */
-  void disable();
+  virtual void disable();
   /**
    * \brief Returns whether or not this queue is enabled
    */
-  bool isEnabled();
+  virtual bool isEnabled();
 
 protected:
   void setupTLS();
@@ -141,7 +139,7 @@ protected:
   struct IDInfo
   {
     uint64_t id;
-    boost::shared_mutex calling_rw_mutex;
+    threading::shared_mutex calling_rw_mutex;
   };
   typedef boost::shared_ptr<IDInfo> IDInfoPtr;
   typedef std::map<uint64_t, IDInfoPtr> M_IDInfo;
@@ -153,19 +151,40 @@ protected:
     CallbackInfo()
     : removal_id(0)
     , marked_for_removal(false)
+    , priority(0)
     {}
     CallbackInterfacePtr callback;
     uint64_t removal_id;
     bool marked_for_removal;
+    /// Only filled in by queues which order callbacks by priority or deadline
+    int32_t priority;
+    WallTime added;
+    WallTime deadline;
   };
+
+  /**
+   * \brief Put a callback into callbacks_, either newly added or pushed back because it returned TryAgain.  Called
+   * with mutex_ held.  Appends to the back of the queue by default.
+   */
+  virtual void pushCallback(const CallbackInfo& info);
+  /**
+   * \brief Called after a callback has been called, from the thread which called it.  Does nothing by default.
+   */
+  virtual void callFinished(const CallbackInfo& info, CallbackInterface::CallResult result);
+
+  /**
+   * \brief Implements callAvailable() by calling callOne() once for each callback available when it is called, so that
+   * every call picks whichever callback is at the front of the queue by then
+   */
+  void callAvailableInTurn(ros::WallDuration timeout);
   typedef std::list<CallbackInfo> L_CallbackInfo;
   typedef std::deque<CallbackInfo> D_CallbackInfo;
   D_CallbackInfo callbacks_;
   size_t calling_;
-  boost::mutex mutex_;
-  boost::condition_variable condition_;
+  threading::pi_mutex mutex_;
+  threading::condition_variable condition_;
 
-  boost::mutex id_info_mutex_;
+  threading::pi_mutex id_info_mutex_;
   M_IDInfo id_info_;
 
   struct TLS
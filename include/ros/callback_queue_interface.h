@@ -38,6 +38,7 @@
 #include <boost/shared_ptr.hpp>
 #include "common.h"
 #include "ros/types.h"
+#include "ros/time.h"
 
 namespace ros
 {
@@ -70,6 +71,22 @@ public:
    * before call() actually takes place.
    */
   virtual bool ready() { return true; }
+  /**
+   * \brief Returns the priority of this callback.  Queues which order callbacks by priority (see
+   * PriorityCallbackQueue) call higher priorities first; other queues ignore it.
+   */
+  virtual int32_t getPriority() { return 0; }
+  /**
+   * \brief Returns how soon after being added to a queue this callback should have finished, or zero for no deadline.
+   * Queues which schedule by deadline (see DeadlineCallbackQueue) call the callback with the nearest deadline first;
+   * other queues ignore it.
+   */
+  virtual WallDuration getDeadline() { return WallDuration(); }
+  /**
+   * \brief Called by queues which schedule by deadline when this callback finished after its deadline
+   * \param lateness How long after the deadline the callback finished
+   */
+  virtual void deadlineMissed(const WallDuration& lateness) {}
 };
 typedef boost::shared_ptr<CallbackInterface> CallbackInterfacePtr;
 
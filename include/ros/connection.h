@@ -39,15 +39,13 @@
 #include "common.h"
 
 #include <boost/signals2.hpp>
+#include <boost/atomic.hpp>
 
 #include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/shared_array.hpp>
 #include <boost/enable_shared_from_this.hpp>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/recursive_mutex.hpp>
-
-#define READ_BUFFER_SIZE (1024*64)
+#include "ros/threading.h"
 
 namespace ros
 {
@@ -121,6 +119,8 @@ public:
    * The finished callback is of the form void(const ConnectionPtr&, const boost::shared_array<uint8_t>&, uint32_t)
    *
    * \note The finished callback may be called from within this call to read() if the data has already arrived
+   * \note On stream transports, small reads are served from a per-connection receive buffer.  The buffer passed to the
+   * finished callback is always its own BufferPool allocation, which the data is copied into.
    *
    * \param size The size, in bytes, of data to read
    * \param finished_callback The function to call when this read is finished
@@ -143,6 +143,22 @@ public:
    * the data off to the server thread
    */
   void write(const boost::shared_array<uint8_t>& buffer, uint32_t size, const WriteFinishedFunc& finished_callback, bool immedate = true);
+  /**
+   * \brief Write several buffers of bytes back to back, calling a callback once all of them have been written
+   *
+   * The same rules apply as for write().  The buffers are handed to the transport together (see Transport::writev()),
+   * so for example several small messages can go out in a single system call.
+   *
+   * \param buffers The buffers of data to write
+   * \param sizes The size of each buffer, in bytes
+   * \param finished_callback The function to call when the write has finished
+   * \param immediate Whether to immediately try to write as much data as possible to the socket or to pass
+   * the data off to the server thread
+   */
+  void write(const std::vector<boost::shared_array<uint8_t> >& buffers, const std::vector<uint32_t>& sizes, const WriteFinishedFunc& finished_callback, bool immediate = true);
+
+  /// Most buffers handed to the transport in one Transport::writev() call
+  static const uint32_t MAX_WRITE_BUFFERS = 64;
 
   typedef boost::signals2::signal<void(const ConnectionPtr&, DropReason reason)> DropSignal;
   typedef boost::function<void(const ConnectionPtr&, DropReason reason)> DropFunc;
@@ -201,10 +217,23 @@ private:
    * read() will read it until the fixed read buffer is filled.
    */
   void readTransport();
+  /**
+   * \brief Does the reading for readTransport(), with read_mutex_ held
+   */
+  void readTransportLocked();
+  /**
+   * \brief Make room at the end of the receive buffer for at least MAX_BUFFERED_READ more bytes, moving any unconsumed
+   * data to the front.  Allocates the block if the connection doesn't currently hold one.
+   */
+  void compactReceiveBuffer();
   /**
    * \brief Write data to our transport.  Also manages calling the write callback.
    */
   void writeTransport();
+  /**
+   * \brief Does the writing for writeTransport(), with write_mutex_ held
+   */
+  void writeTransportLocked();
 
   /// Are we a server?  Servers wait for clients to send a header and then send a header in response.
   bool is_server_;
@@ -226,27 +255,45 @@ private:
   /// Function to call when the read is finished
   ReadFinishedFunc read_callback_;
   /// Mutex used for protecting reading.  Recursive because a read can immediately cause another read through the callback.
-  boost::recursive_mutex read_mutex_;
+  threading::recursive_mutex read_mutex_;
   /// Flag telling us if we're in the middle of a read (mostly to avoid recursive deadlocking)
   bool reading_;
+  /// Set when readTransport() is called while another thread is reading, which must then go round again
+  boost::atomic<bool> read_pending_;
   /// flag telling us if there is a read callback
   /// 32-bit loads and stores are atomic on x86 and PPC... TODO: use a cross-platform atomic operations library
   /// to ensure this is done atomically
   volatile uint32_t has_read_callback_;
 
-  /// Buffer to write from
-  boost::shared_array<uint8_t> write_buffer_;
-  /// Amount of data we've written from the write buffer
+  /// Size of the receive buffer
+  static const uint32_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+  /// Reads larger than this bypass the receive buffer, and are read directly into a buffer of their own
+  static const uint32_t MAX_BUFFERED_READ = RECEIVE_BUFFER_SIZE / 4;
+  /// Data read from the transport ahead of the read() calls asking for it.  Completed reads are copied out of it, and it
+  /// is released whenever it has been emptied.
+  boost::shared_array<uint8_t> receive_buffer_;
+  /// Offset of the first unconsumed byte in the receive buffer
+  uint32_t receive_start_;
+  /// Offset of the end of the data in the receive buffer
+  uint32_t receive_end_;
+
+  /// Buffers to write from, in order
+  std::vector<boost::shared_array<uint8_t> > write_buffers_;
+  /// Sizes of the write buffers
+  std::vector<uint32_t> write_sizes_;
+  /// Index of the write buffer currently being written
+  uint32_t write_index_;
+  /// Amount of data we've written from the current write buffer
   uint32_t write_sent_;
-  /// Size of the write buffer
-  uint32_t write_size_;
   /// Function to call when the current write is finished
   WriteFinishedFunc write_callback_;
-  boost::mutex write_callback_mutex_;
+  threading::mutex write_callback_mutex_;
   /// Mutex used for protecting writing.  Recursive because a write can immediately cause another write through the callback
-  boost::recursive_mutex write_mutex_;
+  threading::recursive_mutex write_mutex_;
   /// Flag telling us if we're in the middle of a write (mostly used to avoid recursive deadlocking)
   bool writing_;
+  /// Set when writeTransport() is called while another thread is writing, which must then go round again
+  boost::atomic<bool> write_pending_;
   /// flag telling us if there is a write callback
   /// 32-bit loads and stores are atomic on x86 and PPC... TODO: use a cross-platform atomic operations library
   /// to ensure this is done atomically
@@ -259,10 +306,13 @@ private:
   DropSignal drop_signal_;
 
   /// Synchronizes drop() calls
-  boost::recursive_mutex drop_mutex_;
+  threading::recursive_mutex drop_mutex_;
 
   /// If we're sending a header error we disable most other calls
   bool sending_header_error_;
+
+  /// Whether the poll set only reports events once, in which case reads and writes carry on until they would block
+  bool edge_triggered_;
 };
 typedef boost::shared_ptr<Connection> ConnectionPtr;
 
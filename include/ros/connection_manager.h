@@ -29,7 +29,7 @@
 #include "connection.h"
 #include "common.h"
 
-#include <boost/thread/mutex.hpp>
+#include "ros/threading.h"
 #include <boost/signals2/connection.hpp>
 
 namespace ros
@@ -37,6 +37,7 @@ namespace ros
 
 class PollManager;
 typedef boost::shared_ptr<PollManager> PollManagerPtr;
+class PollSet;
 
 class ConnectionManager;
 typedef boost::shared_ptr<ConnectionManager> ConnectionManagerPtr;
@@ -46,6 +47,22 @@ class ROSCPP_DECL ConnectionManager
 public:
   static const ConnectionManagerPtr& instance();
 
+  /**
+   * \brief How new connections are spread across the PollManager's PollSets
+   */
+  enum PollSetAssignment
+  {
+    /// Each new connection goes to the next PollSet in turn
+    RoundRobin,
+    /// All connections for a topic go to the same PollSet.  Connections whose topic isn't known
+    /// yet (incoming TCPROS connections, before their header arrives) are assigned round-robin.
+    TopicAffinity,
+  };
+  /**
+   * \brief Defaults to RoundRobin, and can be selected with the ROSCPP_POLL_ASSIGNMENT environment variable ("round_robin" or "topic")
+   */
+  static PollSetAssignment s_poll_set_assignment_;
+
   ConnectionManager();
   ~ConnectionManager();
 
@@ -61,11 +78,24 @@ public:
 
   void clear(Connection::DropReason reason);
 
+  /** @brief Get the PollSet a new connection's transport should be serviced by
+   *
+   * @param topic The topic the connection is for, if known
+   */
+  PollSet* getPollSet(const std::string& topic = std::string());
+
   uint32_t getTCPPort();
   uint32_t getUDPPort();
+  /** @brief Get the port SHMROS doorbell connections are accepted on, or 0 if SHMROS isn't available
+   */
+  uint32_t getSHMPort();
+  /** @brief Get the path of the unix domain socket TCPROS connections from this host are accepted on, or an empty string if there isn't one
+   */
+  std::string getUnixSocketPath();
 
   const TransportTCPPtr& getTCPServerTransport() { return tcpserver_transport_; }
   const TransportUDPPtr& getUDPServerTransport() { return udpserver_transport_; }
+  const TransportTCPPtr& getSHMServerTransport() { return shmserver_transport_; }
 
   void udprosIncomingConnection(const TransportUDPPtr& transport, Header& header);
 
@@ -81,23 +111,33 @@ private:
 
   bool onConnectionHeaderReceived(const ConnectionPtr& conn, const Header& header);
   void tcprosAcceptConnection(const TransportTCPPtr& transport);
+  void shmrosAcceptConnection(const TransportTCPPtr& transport);
 
   PollManagerPtr poll_manager_;
 
   S_Connection connections_;
   V_Connection dropped_connections_;
-  boost::mutex connections_mutex_;
-  boost::mutex dropped_connections_mutex_;
+  // Dropped connections waiting for every poll thread to finish the update() it was in when they were dropped,
+  // along with the update counts of each poll thread at that point
+  typedef std::pair<ConnectionPtr, std::vector<uint64_t> > ConnectionAndUpdateCounts;
+  std::vector<ConnectionAndUpdateCounts> pending_dropped_connections_;
+  threading::mutex connections_mutex_;
+  threading::mutex dropped_connections_mutex_;
 
   // The connection ID counter, used to assign unique ID to each inbound or
   // outbound connection.  Access via getNewConnectionID()
   uint32_t connection_id_counter_;
-  boost::mutex connection_id_counter_mutex_;
+  threading::mutex connection_id_counter_mutex_;
+
+  uint32_t next_poll_set_;
+  threading::mutex next_poll_set_mutex_;
 
   boost::signals2::connection poll_conn_;
 
   TransportTCPPtr tcpserver_transport_;
   TransportUDPPtr udpserver_transport_;
+  TransportTCPPtr shmserver_transport_;
+  TransportTCPPtr unixserver_transport_;
 
   const static int MAX_TCPROS_CONN_QUEUE = 100; // magic
 };
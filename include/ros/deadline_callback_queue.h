@@ -0,0 +1,99 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_DEADLINE_CALLBACK_QUEUE_H
+#define ROSCPP_DEADLINE_CALLBACK_QUEUE_H
+
+#include "ros/callback_queue.h"
+#include "common.h"
+
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace ros
+{
+
+/**
+ * \brief A CallbackQueue which calls the callback with the earliest deadline first
+ *
+ * Each callback's deadline is the time it was added to the queue (for subscriptions, when the message was received, and
+ * for timers, when the timer fired) plus CallbackInterface::getDeadline().  Subscriptions and timers take theirs from the
+ * deadline field of SubscribeOptions and TimerOptions/WallTimerOptions.  Callbacks which do not declare a deadline are
+ * given the default deadline, so they are still called eventually when the queue is overloaded.  Callbacks with the
+ * same deadline are called in the order they were added.
+ *
+ * A callback which finishes after its deadline is counted as a miss, and told so through
+ * CallbackInterface::deadlineMissed().  Subscribers and timers keep count of their own misses, see
+ * Subscriber::getDeadlineMisses() and Timer::getDeadlineMisses().
+ *
+ * \verbatim
+ * ros::DeadlineCallbackQueue queue;
+ * nh.setCallbackQueue(&queue);
+ * ros::SubscribeOptions ops = ros::SubscribeOptions::create<std_msgs::Float64>("command", 1, commandCallback, ros::VoidPtr(), &queue);
+ * ops.deadline = ros::WallDuration(0.002);
+ * ros::Subscriber sub = nh.subscribe(ops);
+ * ros::AsyncSpinner spinner(2, &queue);
+ * \endverbatim
+ */
+class ROSCPP_DECL DeadlineCallbackQueue : public CallbackQueue
+{
+public:
+  /**
+   * \param default_deadline Deadline of callbacks which do not declare one
+   * \param enabled Whether the queue starts enabled
+   */
+  DeadlineCallbackQueue(ros::WallDuration default_deadline = ros::WallDuration(1.0), bool enabled = true);
+  virtual ~DeadlineCallbackQueue();
+
+  using CallbackQueue::callAvailable;
+  virtual void callAvailable(ros::WallDuration timeout);
+
+  /**
+   * \brief Returns the number of callbacks which have finished after their deadline
+   */
+  uint64_t getDeadlineMissCount() { return missed_.load(); }
+
+protected:
+  virtual void pushCallback(const CallbackInfo& info);
+  virtual void callFinished(const CallbackInfo& info, CallbackInterface::CallResult result);
+
+private:
+  ros::WallDuration default_deadline_;
+  boost::atomic<uint64_t> missed_;
+};
+typedef boost::shared_ptr<DeadlineCallbackQueue> DeadlineCallbackQueuePtr;
+
+}
+
+#endif
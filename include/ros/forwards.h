@@ -74,6 +74,8 @@ typedef boost::weak_ptr<Subscription> SubscriptionWPtr;
 typedef std::list<SubscriptionPtr> L_Subscription;
 typedef std::vector<SubscriptionPtr> V_Subscription;
 typedef std::set<SubscriptionPtr> S_Subscription;
+class SubscriptionQueue;
+typedef boost::shared_ptr<SubscriptionQueue> SubscriptionQueuePtr;
 class PublisherLink;
 typedef boost::shared_ptr<PublisherLink> PublisherLinkPtr;
 typedef std::vector<PublisherLinkPtr> V_PublisherLink;
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_HIGH_RESOLUTION_SLEEPER_H
+#define ROSCPP_HIGH_RESOLUTION_SLEEPER_H
+
+#include "common.h"
+#include "ros/time.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace ros
+{
+
+/**
+ * \brief Sleeps a single thread until an absolute time on the monotonic clock, with sub-millisecond precision
+ *
+ * Uses a timerfd armed with an absolute CLOCK_MONOTONIC expiry, polled along with an eventfd so that wake() can cut the
+ * sleep short.  The sleeping thread's timer slack is set to the minimum, and it can be made SCHED_FIFO.  Only available
+ * on Linux: elsewhere create() returns an empty pointer.
+ */
+class ROSCPP_DECL HighResolutionSleeper
+{
+public:
+  /**
+   * \brief SCHED_FIFO priority of threads calling setupThread(), or 0 to leave their scheduling alone.  Set from
+   * ROSCPP_HIGH_RESOLUTION_TIMER_PRIORITY.
+   */
+  static int32_t s_thread_priority_;
+
+  /**
+   * \brief Returns a new sleeper, or an empty pointer if high resolution sleeps are not available
+   */
+  static boost::shared_ptr<HighResolutionSleeper> create();
+
+  ~HighResolutionSleeper();
+
+  /**
+   * \brief Set up the calling thread, which is to be the only one calling sleep()
+   */
+  void setupThread();
+
+  /**
+   * \brief Sleep for the given duration, or until wake() is called
+   */
+  void sleep(const WallDuration& duration);
+
+  /**
+   * \brief Wake up the thread in sleep(), or make its next sleep() return immediately if it is not sleeping
+   */
+  void wake();
+
+private:
+  HighResolutionSleeper(int timer_fd, int wake_fd);
+
+  int timer_fd_;
+  int wake_fd_;
+};
+typedef boost::shared_ptr<HighResolutionSleeper> HighResolutionSleeperPtr;
+
+}
+
+#endif
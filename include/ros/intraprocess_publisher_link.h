@@ -31,7 +31,8 @@
 #include "publisher_link.h"
 #include "common.h"
 
-#include <boost/thread/recursive_mutex.hpp>
+#include "ros/threading.h"
+#include <boost/atomic.hpp>
 
 namespace ros
 {
@@ -67,8 +68,9 @@ public:
 
 private:
   IntraProcessSubscriberLinkPtr publisher_;
-  bool dropped_;
-  boost::recursive_mutex drop_mutex_;
+  /// Checked without a lock on every message.  A message already being handled when the link is dropped may still
+  /// be passed on to the subscription.
+  boost::atomic<bool> dropped_;
 };
 typedef boost::shared_ptr<IntraProcessPublisherLink> IntraProcessPublisherLinkPtr;
 
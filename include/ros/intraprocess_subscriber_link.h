@@ -30,7 +30,7 @@
 #include "subscriber_link.h"
 #include "common.h"
 
-#include <boost/thread/recursive_mutex.hpp>
+#include <boost/atomic.hpp>
 
 namespace ros
 {
@@ -58,9 +58,12 @@ public:
   virtual void getPublishTypes(bool& ser, bool& nocopy, const std::type_info& ti);
 
 private:
+  /// Set before the link is added to its publication, and kept until the link is destroyed, so that messages can be
+  /// enqueued without a lock
   IntraProcessPublisherLinkPtr subscriber_;
-  bool dropped_;
-  boost::recursive_mutex drop_mutex_;
+  /// Checked without a lock on every message.  A message already being enqueued when the link is dropped may still
+  /// be passed on to the subscriber.
+  boost::atomic<bool> dropped_;
 };
 typedef boost::shared_ptr<IntraProcessSubscriberLink> IntraProcessSubscriberLinkPtr;
 
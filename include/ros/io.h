@@ -150,6 +150,18 @@ ROSCPP_DECL int set_non_blocking(socket_fd_t &socket);
 ROSCPP_DECL int close_socket(socket_fd_t &socket);
 ROSCPP_DECL int create_signal_pair(signal_fd_t signal_pair[2]);
 
+/*****************************************************************************
+** Socket Watchers (epoll where available)
+*****************************************************************************/
+
+ROSCPP_DECL bool socket_watcher_available();
+ROSCPP_DECL int create_socket_watcher();
+ROSCPP_DECL void close_socket_watcher(int watcher);
+ROSCPP_DECL int add_socket_to_watcher(int watcher, socket_fd_t fd);
+ROSCPP_DECL int del_socket_from_watcher(int watcher, socket_fd_t fd);
+ROSCPP_DECL int set_events_on_socket(int watcher, socket_fd_t fd, int events, bool edge_triggered);
+ROSCPP_DECL int poll_socket_watcher(int watcher, socket_pollfd *fds, nfds_t max_fds, int timeout);
+
 /*****************************************************************************
 ** Inlines - almost direct api replacements, should stay fast.
 *****************************************************************************/
@@ -0,0 +1,206 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_LOCKFREE_CALLBACK_QUEUE_H
+#define ROSCPP_LOCKFREE_CALLBACK_QUEUE_H
+
+#include "ros/callback_queue.h"
+#include "common.h"
+
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include "ros/threading.h"
+#include <boost/thread/tss.hpp>
+
+#include <deque>
+#include <map>
+
+namespace ros
+{
+
+/**
+ * \brief A CallbackQueue which avoids locks on the paths taken for every callback
+ *
+ * Callbacks are held in a bounded multi-producer/multi-consumer ring, where adding and popping a callback is a
+ * single compare-and-swap.  If the ring fills up, callbacks spill over into a mutex-protected overflow list until
+ * it has been drained again.  Threads waiting for callbacks park on a futex (a condition variable where futexes
+ * are not available), and adding a callback only makes a system call to wake one up if a thread is actually waiting.
+ *
+ * Removal by ID behaves as in CallbackQueue: once removeByID() returns, no callback added with that ID before the
+ * call will be called, and none are still being called (other than by the thread calling removeByID() itself, from
+ * within such a callback).  Instead of a read/write lock per ID, each ID keeps a count of the calls in progress and a
+ * removed flag, and removeByID() waits for the count to drain.  The IDs a thread adds callbacks for are cached
+ * per-thread, so adding a callback normally takes no lock either.
+ *
+ * Unlike CallbackQueue, callbacks which are not ready() are moved to the back of the queue rather than left in
+ * place, and callAvailable() leaves callbacks in the queue while it runs, so other threads may call some of them.
+ *
+ * This queue can be used anywhere a CallbackQueue can, including with the spinners.  Setting the
+ * ROSCPP_LOCKFREE_CALLBACK_QUEUE environment variable makes the global callback queue one of these.
+ */
+class ROSCPP_DECL LockFreeCallbackQueue : public CallbackQueue
+{
+public:
+  /// Default number of callbacks the ring holds before spilling over
+  static const uint32_t DEFAULT_CAPACITY = 4096;
+
+  /**
+   * \param enabled Whether the queue starts enabled
+   * \param capacity Number of callbacks the ring holds.  Rounded up to a power of two.
+   */
+  LockFreeCallbackQueue(bool enabled = true, uint32_t capacity = DEFAULT_CAPACITY);
+  virtual ~LockFreeCallbackQueue();
+
+  virtual void addCallback(const CallbackInterfacePtr& callback, uint64_t removal_id = 0);
+  virtual void removeByID(uint64_t removal_id);
+
+  using CallbackQueue::callOne;
+  using CallbackQueue::callAvailable;
+  virtual CallOneResult callOne(ros::WallDuration timeout);
+  virtual void callAvailable(ros::WallDuration timeout);
+
+  virtual bool isEmpty();
+  virtual void clear();
+
+  virtual void enable();
+  virtual void disable();
+  virtual bool isEnabled();
+
+private:
+  struct RemovalIDInfo
+  {
+    RemovalIDInfo(uint64_t id)
+    : id(id)
+    , calling(0)
+    , removed(false)
+    {}
+
+    uint64_t id;
+    /// Number of callbacks with this ID currently being called
+    boost::atomic<uint32_t> calling;
+    /// Set by removeByID().  Queued callbacks referring to a removed RemovalIDInfo are dropped.
+    boost::atomic<bool> removed;
+  };
+  typedef boost::shared_ptr<RemovalIDInfo> RemovalIDInfoPtr;
+  typedef std::map<uint64_t, RemovalIDInfoPtr> M_RemovalIDInfo;
+
+  struct QueuedCallback
+  {
+    CallbackInterfacePtr callback;
+    RemovalIDInfoPtr id_info;
+  };
+
+  struct Cell
+  {
+    boost::atomic<size_t> sequence;
+    QueuedCallback item;
+  };
+
+  /// The ID map is split into stripes, each with its own lock, so that lookups for different IDs rarely contend
+  static const uint32_t ID_STRIPES = 16;
+  struct IDStripe
+  {
+    threading::mutex mutex;
+    M_RemovalIDInfo ids;
+  };
+
+  /// Number of IDs each thread caches the RemovalIDInfo of
+  static const uint32_t ID_CACHE_SIZE = 16;
+  struct ThreadState
+  {
+    ThreadState()
+    : calling_in_this_thread(0xffffffffffffffffULL)
+    {}
+
+    uint64_t calling_in_this_thread;
+    RemovalIDInfoPtr id_cache[ID_CACHE_SIZE];
+  };
+
+  ThreadState* getThreadState();
+  RemovalIDInfoPtr getRemovalIDInfo(uint64_t id);
+
+  void push(const QueuedCallback& item);
+  bool pop(QueuedCallback& item);
+  bool tryPushRing(const QueuedCallback& item);
+  bool tryPopRing(QueuedCallback& item);
+  /// Approximate number of callbacks in the queue
+  size_t size();
+
+  /**
+   * \brief Call a popped callback, unless its ID has been removed
+   * \return false if the callback was dropped because its ID has been removed
+   */
+  bool call(const QueuedCallback& item, ThreadState* state, CallOneResult& result);
+
+  /**
+   * \brief Park the calling thread until a callback is added, the queue is disabled, or timeout has elapsed
+   */
+  void wait(ros::WallDuration timeout);
+  /**
+   * \brief Wake up one thread waiting in wait(), or all of them
+   */
+  void notify(bool all);
+
+  Cell* cells_;
+  size_t mask_;
+  char pad0_[64];
+  boost::atomic<size_t> enqueue_pos_;
+  char pad1_[64];
+  boost::atomic<size_t> dequeue_pos_;
+  char pad2_[64];
+
+  threading::mutex overflow_mutex_;
+  std::deque<QueuedCallback> overflow_;
+  boost::atomic<size_t> overflow_size_;
+
+  /// Number of callbacks currently being called
+  boost::atomic<size_t> calling_count_;
+  boost::atomic<bool> is_enabled_;
+
+  IDStripe id_stripes_[ID_STRIPES];
+  boost::thread_specific_ptr<ThreadState> thread_state_;
+
+  /// Number of threads in wait()
+  boost::atomic<uint32_t> waiters_;
+  /// Futex word, bumped whenever waiting threads are woken.  Only used where futexes are available.
+  volatile int32_t wait_epoch_;
+  /// Used to wait where futexes are not available
+  threading::mutex wait_mutex_;
+  threading::condition_variable wait_condition_;
+};
+typedef boost::shared_ptr<LockFreeCallbackQueue> LockFreeCallbackQueuePtr;
+
+}
+
+#endif
@@ -33,8 +33,9 @@
 
 #include <ros/serialized_message.h>
 
-#include <boost/thread/mutex.hpp>
+#include "ros/threading.h"
 #include <boost/shared_array.hpp>
+#include <boost/atomic.hpp>
 
 namespace ros
 {
@@ -42,20 +43,37 @@ namespace ros
 class SubscriptionCallbackHelper;
 typedef boost::shared_ptr<SubscriptionCallbackHelper> SubscriptionCallbackHelperPtr;
 
+/**
+ * \brief Lazily deserializes one received message, for all the callbacks which take it as the same C++ type
+ *
+ * The message is only deserialized the first time deserialize() is called, normally just before the first of those
+ * callbacks is called, and the result is shared by the rest of them.  The serialized buffer is released as soon as it
+ * has been deserialized.
+ */
 class ROSCPP_DECL MessageDeserializer
 {
 public:
   MessageDeserializer(const SubscriptionCallbackHelperPtr& helper, const SerializedMessage& m, const boost::shared_ptr<M_string>& connection_header);
+  ~MessageDeserializer();
 
   VoidConstPtr deserialize();
   const boost::shared_ptr<M_string>& getConnectionHeader() { return connection_header_; }
 
+  /**
+   * \brief Returns the number of deserializations avoided, process-wide.  That is calls to deserialize() which were
+   * served by an earlier call or by a message passed intraprocess, plus received messages which were never
+   * deserialized at all (eg. because they were dropped from a full subscription queue).
+   */
+  static uint64_t getDeserializationsAvoided() { return s_avoided_.load(); }
+
 private:
+  static boost::atomic<uint64_t> s_avoided_;
+
   SubscriptionCallbackHelperPtr helper_;
   SerializedMessage serialized_message_;
   boost::shared_ptr<M_string> connection_header_;
 
-  boost::mutex mutex_;
+  threading::mutex mutex_;
   VoidConstPtr msg_;
 };
 typedef boost::shared_ptr<MessageDeserializer> MessageDeserializerPtr;
@@ -43,6 +43,10 @@ namespace network
 ROSCPP_DECL bool splitURI(const std::string& uri, std::string& host, uint32_t& port);
 ROSCPP_DECL const std::string& getHost();
 ROSCPP_DECL uint16_t getTCPROSPort();
+/**
+ * \brief Returns whether host (a hostname or numeric address, as found in a URI) refers to this machine
+ */
+ROSCPP_DECL bool isLocalHost(const std::string& host);
 
 } // namespace network
 
@@ -822,6 +822,80 @@ if (sub)  // Enter if subscriber is valid
    */
   Subscriber subscribe(SubscribeOptions& ops);
 
+  /**
+   * \brief Subscribe to a topic, delivering messages in batches, version for class member function with bare pointer
+   *
+   * Instead of one callback per message, fp is passed all the messages which have arrived since it was last called,
+   * up to max_batch of them, as a vector.  This saves the trip through the callback queue for each message on
+   * high-rate topics.  See SubscribeOptions::max_batch and SubscribeOptions::max_latency.
+\verbatim
+void Foo::callback(const std::vector<std_msgs::Empty::ConstPtr>& messages)
+{
+}
+
+ros::Subscriber sub = handle.subscribeBatch("my_topic", 100, 20, ros::WallDuration(0.01), &Foo::callback, &foo_object);
+\endverbatim
+   *
+   * \param M [template] M here is the message type
+   * \param topic Topic to subscribe to
+   * \param queue_size Number of incoming messages to queue up for
+   * processing (messages in excess of this queue capacity will be
+   * discarded).
+   * \param max_batch Largest number of messages to pass to the callback at once
+   * \param max_latency How long a batch may wait to fill up to max_batch messages before the callback is called anyway.
+   * Zero calls the callback as soon as possible, with whatever has arrived by then.
+   * \param fp Member function pointer to call with each batch of messages
+   * \param obj Object to call fp on
+   * \param transport_hints a TransportHints structure which defines various transport-related options
+   * \return On success, a Subscriber that, when all copies of it go out of scope, will unsubscribe from this topic.
+   *  \throws InvalidNameException If the topic name begins with a tilde, or is an otherwise invalid graph resource name
+   *  \throws ConflictingSubscriptionException If this node is already subscribed to the same topic with a different datatype
+   */
+  template<class M, class T>
+  Subscriber subscribeBatch(const std::string& topic, uint32_t queue_size, uint32_t max_batch, const WallDuration& max_latency,
+                            void(T::*fp)(const std::vector<boost::shared_ptr<M const> >&), T* obj,
+                            const TransportHints& transport_hints = TransportHints())
+  {
+    SubscribeOptions ops;
+    ops.template initBatch<M>(topic, queue_size, max_batch, max_latency, boost::bind(fp, obj, _1));
+    ops.transport_hints = transport_hints;
+    return subscribe(ops);
+  }
+
+  /**
+   * \brief Subscribe to a topic, delivering messages in batches, version for arbitrary boost::function object
+   *
+   * Instead of one callback per message, callback is passed all the messages which have arrived since it was last
+   * called, up to max_batch of them, as a vector.  See SubscribeOptions::max_batch and SubscribeOptions::max_latency.
+   *
+   * \param M [template] M here is the message type
+   * \param topic Topic to subscribe to
+   * \param queue_size Number of incoming messages to queue up for
+   * processing (messages in excess of this queue capacity will be
+   * discarded).
+   * \param max_batch Largest number of messages to pass to the callback at once
+   * \param max_latency How long a batch may wait to fill up to max_batch messages before the callback is called anyway.
+   * Zero calls the callback as soon as possible, with whatever has arrived by then.
+   * \param callback Callback to call with each batch of messages
+   * \param tracked_object A shared pointer to an object to track for these callbacks.  If set, the a weak_ptr will be created to this object,
+   * and if the reference count goes to 0 the subscriber callbacks will not get called.
+   * \param transport_hints a TransportHints structure which defines various transport-related options
+   * \return On success, a Subscriber that, when all copies of it go out of scope, will unsubscribe from this topic.
+   *  \throws InvalidNameException If the topic name begins with a tilde, or is an otherwise invalid graph resource name
+   *  \throws ConflictingSubscriptionException If this node is already subscribed to the same topic with a different datatype
+   */
+  template<class M>
+  Subscriber subscribeBatch(const std::string& topic, uint32_t queue_size, uint32_t max_batch, const WallDuration& max_latency,
+                            const boost::function<void (const std::vector<boost::shared_ptr<M const> >&)>& callback,
+                            const VoidConstPtr& tracked_object = VoidConstPtr(), const TransportHints& transport_hints = TransportHints())
+  {
+    SubscribeOptions ops;
+    ops.template initBatch<M>(topic, queue_size, max_batch, max_latency, callback);
+    ops.tracked_object = tracked_object;
+    ops.transport_hints = transport_hints;
+    return subscribe(ops);
+  }
+
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////
   // Versions of advertiseService()
   //////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -34,8 +34,9 @@
 
 #include <boost/signals2.hpp>
 
-#include <boost/thread/recursive_mutex.hpp>
-#include <boost/thread/thread.hpp>
+#include "ros/threading.h"
+
+#include <vector>
 
 namespace ros
 {
@@ -45,15 +46,42 @@ typedef boost::shared_ptr<PollManager> PollManagerPtr;
 typedef boost::signals2::signal<void(void)> VoidSignal;
 typedef boost::function<void(void)> VoidFunc;
 
+/**
+ * \brief Owns the PollSets which service every socket in the process, and the threads which run them.
+ *
+ * By default there is a single PollSet serviced by a single thread.  Setting s_thread_count_ (or the
+ * ROSCPP_POLL_THREADS environment variable) before the PollManager is created spreads sockets across
+ * that many PollSets, each with its own thread.  ConnectionManager decides which PollSet a new
+ * connection is assigned to.  Poll thread listeners are always run from the thread servicing the
+ * first PollSet.
+ */
 class ROSCPP_DECL PollManager
 {
 public:
   static const PollManagerPtr& instance();
 
+  /**
+   * \brief The number of poll threads (and PollSets) newly constructed PollManagers start.  Defaults to 1.
+   */
+  static uint32_t s_thread_count_;
+
   PollManager();
   ~PollManager();
 
-  PollSet& getPollSet() { return poll_set_; }
+  /**
+   * \brief Returns the first PollSet, which is also the one whose thread runs the poll thread listeners
+   */
+  PollSet& getPollSet() { return *poll_sets_.front(); }
+  /**
+   * \brief Returns the PollSet at index, in the range [0, getNumPollSets())
+   */
+  PollSet& getPollSet(uint32_t index) { return *poll_sets_[index]; }
+  uint32_t getNumPollSets() const { return poll_sets_.size(); }
+
+  /**
+   * \brief Returns the number of calls to PollSet::update() the thread servicing PollSet index has completed
+   */
+  uint64_t getUpdateCount(uint32_t index);
 
   boost::signals2::connection addPollThreadListener(const VoidFunc& func);
   void removePollThreadListener(boost::signals2::connection c);
@@ -61,15 +89,20 @@ public:
   void start();
   void shutdown();
 private:
-  void threadFunc();
+  void threadFunc(uint32_t index);
 
-  PollSet poll_set_;
+  typedef boost::shared_ptr<PollSet> PollSetPtr;
+  std::vector<PollSetPtr> poll_sets_;
   volatile bool shutting_down_;
 
   VoidSignal poll_signal_;
-  boost::recursive_mutex signal_mutex_;
+  threading::recursive_mutex signal_mutex_;
+
+  std::vector<uint64_t> update_counts_;
+  threading::mutex update_counts_mutex_;
 
-  boost::thread thread_;
+  typedef boost::shared_ptr<threading::thread> ThreadPtr;
+  std::vector<ThreadPtr> threads_;
 };
 
 }
@@ -40,7 +40,7 @@
 #include "common.h"
 #include <boost/shared_ptr.hpp>
 #include <boost/function.hpp>
-#include <boost/thread/mutex.hpp>
+#include "ros/threading.h"
 
 namespace ros
 {
@@ -53,13 +53,39 @@ typedef boost::shared_ptr<Transport> TransportPtr;
  *
  * PollSet provides thread-safe ways of adding and deleting sockets, as well as adding
  * and deleting events.
+ *
+ * Where available (Linux), sockets are watched through epoll instead: interest is registered
+ * incrementally as events are added and deleted, and update() only visits the sockets
+ * which actually have events.  poll() is used as the fallback.
  */
 class ROSCPP_DECL PollSet
 {
 public:
+  enum Backend
+  {
+    /// Rebuild a pollfd array and poll() every socket on each update()
+    Poll,
+    /// epoll, level-triggered.  Same semantics as Poll.
+    EpollLevelTriggered,
+    /// epoll, edge-triggered.  Update functions are only called again once new data arrives,
+    /// so they must consume everything available each time they are called.
+    EpollEdgeTriggered,
+  };
+
+  /**
+   * \brief The backend used by newly constructed PollSets.  Defaults to EpollLevelTriggered,
+   * and can be selected with the ROSCPP_POLL_BACKEND environment variable ("poll", "epoll" or "epoll_et").
+   */
+  static Backend s_backend_;
+
   PollSet();
   ~PollSet();
 
+  /**
+   * \brief Returns the backend actually in use, which is Poll if epoll is not available
+   */
+  Backend getBackend() const { return backend_; }
+
   typedef boost::function<void(int)> SocketUpdateFunc;
   /**
    * \brief Add a socket.
@@ -122,6 +148,11 @@ private:
    */
   void createNativePollset();
 
+  /**
+   * \brief Pushes the events registered for a socket to the epoll watcher.  socket_info_mutex_ must be held.
+   */
+  void updateWatcherEvents(int fd, int events);
+
   /**
    * \brief Called when events have been triggered on our signal pipe
    */
@@ -136,16 +167,20 @@ private:
   };
   typedef std::map<int, SocketInfo> M_SocketInfo;
   M_SocketInfo socket_info_;
-  boost::mutex socket_info_mutex_;
+  threading::mutex socket_info_mutex_;
   bool sockets_changed_;
 
-  boost::mutex just_deleted_mutex_;
+  threading::mutex just_deleted_mutex_;
   typedef std::vector<int> V_int;
   V_int just_deleted_;
 
   std::vector<socket_pollfd> ufds_;
 
-  boost::mutex signal_mutex_;
+  Backend backend_;
+  /// epoll descriptor, -1 when using the poll() backend
+  int epfd_;
+
+  threading::mutex signal_mutex_;
   signal_fd_t signal_pipe_[2];
 };
 
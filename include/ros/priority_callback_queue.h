@@ -0,0 +1,100 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_PRIORITY_CALLBACK_QUEUE_H
+#define ROSCPP_PRIORITY_CALLBACK_QUEUE_H
+
+#include "ros/callback_queue.h"
+#include "common.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace ros
+{
+
+/**
+ * \brief A CallbackQueue which calls callbacks with a higher priority first
+ *
+ * The priority of a callback comes from CallbackInterface::getPriority().  Subscriptions, timers and service servers
+ * take theirs from the priority field of SubscribeOptions, TimerOptions and AdvertiseServiceOptions, and default to 0.
+ * Callbacks with the same priority are called in the order they were added.
+ *
+ * So that a steady stream of high priority callbacks can not starve the rest, a callback is only overtaken by callbacks
+ * with a higher priority until it has been waiting for longer than the starvation timeout.  After that, callbacks added
+ * later queue up behind it whatever their priority, so no callback waits much longer than the starvation timeout plus
+ * the time it takes to call the callbacks already ahead of it.
+ *
+ * callAvailable() picks each callback in turn rather than taking all of them at once, so a high priority callback added
+ * while it runs is called before the lower priority ones still waiting.
+ *
+ * \verbatim
+ * ros::PriorityCallbackQueue queue;
+ * nh.setCallbackQueue(&queue);
+ * ros::SubscribeOptions ops = ros::SubscribeOptions::create<std_msgs::Float64>("command", 1, commandCallback, ros::VoidPtr(), &queue);
+ * ops.priority = 10;
+ * ros::Subscriber sub = nh.subscribe(ops);
+ * ros::AsyncSpinner spinner(2, &queue);
+ * \endverbatim
+ */
+class ROSCPP_DECL PriorityCallbackQueue : public CallbackQueue
+{
+public:
+  /**
+   * \param starvation_timeout How long a callback can wait before callbacks with a higher priority stop overtaking it
+   * \param enabled Whether the queue starts enabled
+   */
+  PriorityCallbackQueue(ros::WallDuration starvation_timeout = ros::WallDuration(0.1), bool enabled = true);
+  virtual ~PriorityCallbackQueue();
+
+  using CallbackQueue::callAvailable;
+  virtual void callAvailable(ros::WallDuration timeout);
+
+  /**
+   * \brief Set how long a callback can wait before callbacks with a higher priority stop overtaking it.  Only applies
+   * to callbacks added afterwards.
+   */
+  void setStarvationTimeout(ros::WallDuration timeout);
+  ros::WallDuration getStarvationTimeout();
+
+protected:
+  virtual void pushCallback(const CallbackInfo& info);
+
+private:
+  ros::WallDuration starvation_timeout_;
+};
+typedef boost::shared_ptr<PriorityCallbackQueue> PriorityCallbackQueuePtr;
+
+}
+
+#endif
@@ -33,7 +33,8 @@
 #include "common.h"
 #include "XmlRpc.h"
 
-#include <boost/thread/mutex.hpp>
+#include "ros/threading.h"
+#include <boost/atomic.hpp>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/shared_array.hpp>
@@ -46,6 +47,7 @@ namespace ros
 class SubscriberLink;
 typedef boost::shared_ptr<SubscriberLink> SubscriberLinkPtr;
 typedef std::vector<SubscriberLinkPtr> V_SubscriberLink;
+typedef boost::shared_ptr<const V_SubscriberLink> V_SubscriberLinkConstPtr;
 
 /**
  * \brief A Publication manages an advertised topic
@@ -157,6 +159,10 @@ private:
    * \brief Called when a peer has disconnected. Calls the disconnection callback
    */
   void peerDisconnect(const SubscriberLinkPtr& sub_link);
+  /**
+   * \brief Replace the subscriber_links_ and intraprocess_links_ snapshots.  Called with subscriber_links_mutex_ held.
+   */
+  void setSubscriberLinks(const V_SubscriberLink& links);
 
   std::string name_;
   std::string datatype_;
@@ -164,27 +170,32 @@ private:
   std::string message_definition_;
   size_t max_queue_;
   uint32_t seq_;
-  boost::mutex seq_mutex_;
+  threading::pi_mutex seq_mutex_;
 
   typedef std::vector<SubscriberCallbacksPtr> V_Callback;
   V_Callback callbacks_;
-  boost::mutex callbacks_mutex_;
+  threading::mutex callbacks_mutex_;
 
-  V_SubscriberLink subscriber_links_;
-  // We use a recursive mutex here for the rare case that a publish call causes another one (like in the case of a rosconsole call)
-  boost::mutex subscriber_links_mutex_;
+  /// Snapshot of the subscriber links.  Never modified, only replaced by setSubscriberLinks(), so that publishing can
+  /// read it with boost::atomic_load() and go through it without taking any lock.  Adding and removing links pays for
+  /// the copy instead.
+  V_SubscriberLinkConstPtr subscriber_links_;
+  /// Serializes changes to subscriber_links_, and protects last_message_
+  threading::pi_mutex subscriber_links_mutex_;
 
-  bool dropped_;
+  boost::atomic<bool> dropped_;
 
   bool latch_;
   bool has_header_;
   SerializedMessage last_message_;
 
   uint32_t intraprocess_subscriber_count_;
+  /// The intraprocess links in subscriber_links_, or NULL if there are none.  Replaced along with subscriber_links_.
+  V_SubscriberLinkConstPtr intraprocess_links_;
 
   typedef std::vector<SerializedMessage> V_SerializedMessage;
   V_SerializedMessage publish_queue_;
-  boost::mutex publish_queue_mutex_;
+  threading::pi_mutex publish_queue_mutex_;
 };
 
 }
@@ -32,6 +32,7 @@
 #include "ros/common.h"
 #include "ros/message.h"
 #include "ros/serialization.h"
+#include "ros/buffer_pool.h"
 #include <boost/bind.hpp>
 
 namespace ros
@@ -85,7 +86,7 @@ namespace ros
       m.type_info = &typeid(M);
       m.message = message;
 
-      publish(boost::bind(serializeMessage<M>, boost::ref(*message)), m);
+      publish(boost::bind(serializePooledMessage<M>, boost::ref(*message)), m);
     }
 
     /**
@@ -115,7 +116,7 @@ namespace ros
                      impl_->datatype_.c_str(), impl_->md5sum_.c_str());
 
       SerializedMessage m;
-      publish(boost::bind(serializeMessage<M>, boost::ref(message)), m);
+      publish(boost::bind(serializePooledMessage<M>, boost::ref(message)), m);
     }
 
     /**
@@ -194,6 +195,7 @@ namespace ros
 
     friend class NodeHandle;
     friend class NodeHandleBackingCollection;
+    friend class RealtimePublisherBase;
   };
 
   typedef std::vector<Publisher> V_Publisher;
@@ -36,6 +36,7 @@
 #include <boost/shared_array.hpp>
 #include <boost/weak_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/atomic.hpp>
 
 #include <queue>
 
@@ -59,7 +60,8 @@ public:
   class Stats
   {
   public:
-    uint64_t bytes_received_, messages_received_, drops_;
+    /// Atomic, since intraprocess links can be handed messages from several publishing threads at once
+    boost::atomic<uint64_t> bytes_received_, messages_received_, drops_;
     Stats()
     : bytes_received_(0), messages_received_(0), drops_(0) { }
   };
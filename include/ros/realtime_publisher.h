@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_REALTIME_PUBLISHER_H
+#define ROSCPP_REALTIME_PUBLISHER_H
+
+#include "ros/common.h"
+#include "ros/publisher.h"
+#include "ros/node_handle.h"
+#include "ros/serialization.h"
+#include "ros/threading.h"
+
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+
+namespace ros
+{
+
+/**
+ * \brief Untyped part of RealtimePublisher
+ *
+ * Holds a ring of preallocated, fixed size slots.  The real-time thread serializes messages straight into the
+ * slots, and a publish thread owned by this object takes them out in order and hands them to the Publisher.
+ * The ring has exactly one producer and one consumer, so neither side takes a lock: the real-time side only
+ * touches two atomic counters, and at most makes a non-blocking wake-up call when the publish thread is asleep.
+ */
+class ROSCPP_DECL RealtimePublisherBase
+{
+public:
+  /**
+   * \brief Publish statistics
+   */
+  struct Stats
+  {
+    /// Messages queued by publish()
+    uint64_t published;
+    /// Messages dropped because every slot was in use
+    uint64_t dropped_full;
+    /// Messages dropped because they did not fit in a slot
+    uint64_t dropped_oversize;
+  };
+
+  ~RealtimePublisherBase();
+
+  /**
+   * \brief Publishes any messages still in the ring and stops the publish thread.  Unadvertises the topic if this
+   * object advertised it, otherwise just lets go of the Publisher it was given.  Not real-time safe.
+   */
+  void shutdown();
+
+  /**
+   * \brief Returns the underlying Publisher.  Its methods are not real-time safe.
+   */
+  const Publisher& getPublisher() const { return publisher_; }
+
+  /// Number of slots in the ring
+  uint32_t getNumSlots() const { return num_slots_; }
+  /// Size of each slot, in bytes, including the 4 byte length prefix of the serialized message
+  uint32_t getSlotSize() const { return slot_size_; }
+
+  Stats getStats() const;
+
+protected:
+  /**
+   * \param owns_advertisement Whether publisher was advertised for this object, and should be shut down with it
+   */
+  RealtimePublisherBase(const Publisher& publisher, uint32_t num_slots, uint32_t slot_size, bool owns_advertisement);
+
+  /**
+   * \brief Returns the next free slot, or NULL if the ring is full.  Must be followed by commit() before the
+   * next call.
+   */
+  uint8_t* reserve()
+  {
+    uint32_t tail = tail_.load(boost::memory_order_relaxed);
+    if (tail - head_.load(boost::memory_order_acquire) >= num_slots_)
+    {
+      dropped_full_.fetch_add(1, boost::memory_order_relaxed);
+      return 0;
+    }
+
+    return &slots_[(size_t)(tail & slot_mask_) * slot_size_];
+  }
+
+  /**
+   * \brief Queues the slot returned by reserve(), holding num_bytes of serialized message
+   */
+  void commit(uint32_t num_bytes);
+
+  void dropOversize()
+  {
+    dropped_oversize_.fetch_add(1, boost::memory_order_relaxed);
+  }
+
+private:
+  RealtimePublisherBase(const RealtimePublisherBase&);
+  RealtimePublisherBase& operator=(const RealtimePublisherBase&);
+
+  void publishThread();
+  bool publishOne();
+  void wait();
+  void wake();
+
+  Publisher publisher_;
+  bool owns_advertisement_;
+  uint32_t num_slots_;
+  uint32_t slot_mask_;
+  uint32_t slot_size_;
+  boost::scoped_array<uint8_t> slots_;
+  boost::scoped_array<uint32_t> lengths_;
+
+  char pad0_[64];
+  /// Number of messages taken out of the ring.  Only written by the publish thread.
+  boost::atomic<uint32_t> head_;
+  char pad1_[64];
+  /// Number of messages put into the ring.  Only written by the real-time thread.
+  boost::atomic<uint32_t> tail_;
+  char pad2_[64];
+
+  boost::atomic<uint64_t> published_;
+  boost::atomic<uint64_t> dropped_full_;
+  boost::atomic<uint64_t> dropped_oversize_;
+
+  /// Set while the publish thread is, or is about to be, asleep
+  boost::atomic<bool> waiting_;
+  boost::atomic<bool> shutting_down_;
+  /// Futex word, bumped whenever the publish thread is woken.  Only used where futexes are available.
+  volatile int32_t wait_epoch_;
+  /// Used to wait where futexes are not available
+  threading::mutex wait_mutex_;
+  threading::condition_variable wait_condition_;
+
+  threading::thread publish_thread_;
+};
+
+/**
+ * \brief Publisher which can be used from a real-time thread
+ *
+ * Publisher::publish() allocates a buffer for every message, and takes several locks on its way to the
+ * subscribers, so it can't be called from a hard real-time loop.  RealtimePublisher preallocates num_slots
+ * buffers of slot_size bytes up front.  publish() serializes the message into a free one and returns; a
+ * separate, non real-time thread passes the serialized messages on to the subscribers in order.  Once
+ * constructed, publish() makes no heap allocations, takes no locks, and never blocks.
+ *
+ * A message is dropped, and publish() returns false, if every slot is still waiting to be sent or if the message
+ * does not fit in a slot.  The number of slots is rounded up to a power of two.
+ *
+ * publish() may only be called from one thread at a time.  The other methods are not real-time safe.
+ *
+\verbatim
+ros::RealtimePublisher<std_msgs::Float64> pub(nh, "effort", 10, 16, 64);
+...
+// In the control loop
+pub.publish(msg);
+\endverbatim
+ */
+template<typename M>
+class RealtimePublisher : public RealtimePublisherBase
+{
+public:
+  /**
+   * \brief Advertises topic on node_handle and preallocates the slots
+   *
+   * \param queue_size Outgoing queue size of the advertisement, as in NodeHandle::advertise()
+   * \param num_slots Number of messages which can wait to be published at once
+   * \param slot_size Largest serialized message which can be published, in bytes, not counting the 4 byte
+   * length prefix
+   */
+  RealtimePublisher(NodeHandle& node_handle, const std::string& topic, uint32_t queue_size,
+                    uint32_t num_slots, uint32_t slot_size, bool latch = false)
+  : RealtimePublisherBase(node_handle.advertise<M>(topic, queue_size, latch), num_slots, slot_size + 4, true)
+  {
+  }
+
+  /**
+   * \brief Publishes on an existing advertisement, which must be for messages of type M.  The advertisement stays
+   * up after shutdown().
+   */
+  RealtimePublisher(const Publisher& publisher, uint32_t num_slots, uint32_t slot_size)
+  : RealtimePublisherBase(publisher, num_slots, slot_size + 4, false)
+  {
+  }
+
+  /**
+   * \brief Serializes message into a free slot and queues it to be published.  Real-time safe.
+   * \return false if the message was dropped
+   */
+  bool publish(const M& message)
+  {
+    namespace ser = serialization;
+
+    uint32_t num_bytes = ser::serializationLength(message) + 4;
+    if (num_bytes > getSlotSize())
+    {
+      dropOversize();
+      return false;
+    }
+
+    uint8_t* slot = reserve();
+    if (!slot)
+    {
+      return false;
+    }
+
+    ser::OStream s(slot, num_bytes);
+    ser::serialize(s, num_bytes - 4);
+    ser::serialize(s, message);
+    commit(num_bytes);
+
+    return true;
+  }
+};
+
+}
+
+#endif // ROSCPP_REALTIME_PUBLISHER_H
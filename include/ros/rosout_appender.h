@@ -41,7 +41,7 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
 
-#include <boost/thread.hpp>
+#include "ros/threading.h"
 
 namespace rosgraph_msgs
 {
@@ -72,11 +72,11 @@ protected:
 
   typedef std::vector<rosgraph_msgs::LogPtr> V_Log;
   V_Log log_queue_;
-  boost::mutex queue_mutex_;
-  boost::condition_variable queue_condition_;
+  threading::mutex queue_mutex_;
+  threading::condition_variable queue_condition_;
   bool shutting_down_;
 
-  boost::thread publish_thread_;
+  threading::thread publish_thread_;
 };
 
 } // namespace ros
@@ -33,8 +33,7 @@
 #include "advertise_service_options.h"
 #include "service_client_options.h"
 
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/recursive_mutex.hpp>
+#include "ros/threading.h"
 
 namespace ros
 {
@@ -127,13 +126,13 @@ private:
   bool isShuttingDown() { return shutting_down_; }
 
   L_ServicePublication service_publications_;
-  boost::mutex service_publications_mutex_;
+  threading::mutex service_publications_mutex_;
 
   L_ServiceServerLink service_server_links_;
-  boost::mutex service_server_links_mutex_;
+  threading::mutex service_server_links_mutex_;
 
   volatile bool shutting_down_;
-  boost::recursive_mutex shutting_down_mutex_;
+  threading::recursive_mutex shutting_down_mutex_;
 
   PollManagerPtr poll_manager_;
   ConnectionManagerPtr connection_manager_;
@@ -32,7 +32,7 @@
 #include "common.h"
 #include "XmlRpc.h"
 
-#include <boost/thread/mutex.hpp>
+#include "ros/threading.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/shared_array.hpp>
@@ -63,7 +63,7 @@ class ROSCPP_DECL ServicePublication : public boost::enable_shared_from_this<Ser
 public:
   ServicePublication(const std::string& name, const std::string &md5sum, const std::string& data_type, const std::string& request_data_type,
                 const std::string& response_data_type, const ServiceCallbackHelperPtr& helper, CallbackQueueInterface* queue,
-                const VoidConstPtr& tracked_object);
+                const VoidConstPtr& tracked_object, int32_t priority);
   ~ServicePublication();
 
   /**
@@ -106,13 +106,14 @@ private:
   ServiceCallbackHelperPtr helper_;
 
   V_ServiceClientLink client_links_;
-  boost::mutex client_links_mutex_;
+  threading::mutex client_links_mutex_;
 
   bool dropped_;
 
   CallbackQueueInterface* callback_queue_;
   bool has_tracked_object_;
   VoidConstWPtr tracked_object_;
+  int32_t priority_;
 };
 typedef boost::shared_ptr<ServicePublication> ServicePublicationPtr;
 
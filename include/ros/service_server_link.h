@@ -37,7 +37,7 @@
 
 #include "ros/common.h"
 
-#include <boost/thread/mutex.hpp>
+#include "ros/threading.h"
 #include <boost/shared_array.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/thread.hpp>
@@ -64,9 +64,9 @@ private:
     SerializedMessage* resp_;
 
     bool finished_;
-    boost::condition_variable finished_condition_;
-    boost::mutex finished_mutex_;
-    boost::thread::id caller_thread_id_;
+    threading::condition_variable finished_condition_;
+    threading::mutex finished_mutex_;
+    threading::thread::id caller_thread_id_;
 
     bool success_;
     bool call_finished_;
@@ -146,7 +146,7 @@ private:
   bool header_read_;
 
   Q_CallInfo call_queue_;
-  boost::mutex call_queue_mutex_;
+  threading::mutex call_queue_mutex_;
 
   CallInfoPtr current_call_;
 
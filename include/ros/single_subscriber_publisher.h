@@ -30,6 +30,7 @@
 
 #include "ros/forwards.h"
 #include "ros/serialization.h"
+#include "ros/buffer_pool.h"
 #include "common.h"
 
 #include <boost/utility.hpp>
@@ -80,8 +81,7 @@ public:
   template<class M>
   void publish(const M& message) const
   {
-    using namespace serialization;
-    SerializedMessage m = serializeMessage(message);
+    SerializedMessage m = serializePooledMessage(message);
     publish(m);
   }
 
@@ -49,6 +49,9 @@ struct ROSCPP_DECL SubscribeOptions
   : queue_size(1)
   , callback_queue(0)
   , allow_concurrent_callbacks(false)
+  , priority(0)
+  , conflate(false)
+  , max_batch(0)
   {
   }
 
@@ -68,6 +71,9 @@ struct ROSCPP_DECL SubscribeOptions
   , datatype(_datatype)
   , callback_queue(0)
   , allow_concurrent_callbacks(false)
+  , priority(0)
+  , conflate(false)
+  , max_batch(0)
   {}
 
   /**
@@ -112,6 +118,30 @@ struct ROSCPP_DECL SubscribeOptions
     helper = SubscriptionCallbackHelperPtr(new SubscriptionCallbackHelperT<const boost::shared_ptr<MessageType const>&>(_callback, factory_fn));
   }
 
+  /**
+   * \brief Templated initialization for batched delivery, templated on message type
+   * \param _topic Topic to subscribe on
+   * \param _queue_size Number of incoming messages to queue up for
+   *        processing (messages in excess of this queue capacity will be
+   *        discarded).
+   * \param _max_batch Largest number of messages to pass to the callback at once
+   * \param _max_latency How long a batch may wait to fill up before the callback is called anyway
+   * \param _callback Callback to call with each batch of messages which arrives on this topic
+   */
+  template<class M>
+  void initBatch(const std::string& _topic, uint32_t _queue_size, uint32_t _max_batch, const WallDuration& _max_latency,
+       const boost::function<void (const std::vector<boost::shared_ptr<M const> >&)>& _callback,
+       const boost::function<boost::shared_ptr<M>(void)>& factory_fn = DefaultMessageCreator<M>())
+  {
+    topic = _topic;
+    queue_size = _queue_size;
+    max_batch = _max_batch;
+    max_latency = _max_latency;
+    md5sum = message_traits::md5sum<M>();
+    datatype = message_traits::datatype<M>();
+    helper = SubscriptionCallbackHelperPtr(new SubscriptionBatchCallbackHelperT<M>(_callback, factory_fn));
+  }
+
   std::string topic;                                                ///< Topic to subscribe to
   uint32_t queue_size;                                              ///< Number of incoming messages to queue up for processing (messages in excess of this queue capacity will be discarded).
 
@@ -126,6 +156,32 @@ struct ROSCPP_DECL SubscribeOptions
   /// time.  Setting this to true allows you to receive multiple messages on the same topic from multiple threads at the same time
   bool allow_concurrent_callbacks;
 
+  /// Priority of this subscription's callbacks.  Queues which order callbacks by priority (see PriorityCallbackQueue)
+  /// call higher priorities first; other queues ignore it.  Defaults to 0.
+  int32_t priority;
+
+  /// How soon after a message is received its callback should have finished.  Queues which schedule by deadline (see
+  /// DeadlineCallbackQueue) call the callback with the nearest deadline first, and count the callbacks which finish late;
+  /// other queues ignore it.  Defaults to zero, for no deadline.
+  WallDuration deadline;
+
+  /// Keep only the newest message from each publisher, rather than queueing up to queue_size of them.  A message
+  /// which arrives before the previous one from the same publisher has been called back replaces it, and is counted
+  /// by Subscriber::getConflatedCount() rather than as a drop.  Useful for state topics, where only the latest value
+  /// matters.  Defaults to false.
+  bool conflate;
+
+  /// Largest number of messages to pass to the callback in one call.  Messages which arrive while a callback is
+  /// waiting to be called join its batch, so a busy topic costs one trip through the callback queue per batch rather
+  /// than per message.  Callbacks set up with initBatch() get the whole batch as a vector; others are called for each
+  /// message in turn.  Defaults to 0, for no batching.  Ignored when conflating.
+  uint32_t max_batch;
+
+  /// When batching, how long a batch may wait to fill up to max_batch messages before its callback is added anyway.
+  /// Defaults to zero, where the callback is added for the first message and the batch holds whatever arrived before
+  /// it is called.
+  WallDuration max_latency;
+
   /**
    * \brief An object whose destruction will prevent the callback associated with this subscription
    *
@@ -68,6 +68,18 @@ public:
    */
   uint32_t getNumPublishers() const;
 
+  /**
+   * \brief Returns the number of times this subscriber's callback finished after its deadline (see
+   * SubscribeOptions::deadline).  Only counted when the callback queue schedules by deadline, like DeadlineCallbackQueue.
+   */
+  uint32_t getDeadlineMisses() const;
+
+  /**
+   * \brief Returns the number of messages superseded by a newer one before this subscriber's callback was called for
+   * them, when subscribed with SubscribeOptions::conflate
+   */
+  uint64_t getConflatedCount() const;
+
   operator void*() const { return (impl_ && impl_->isValid()) ? (void*)1 : (void*)0; }
 
   bool operator<(const Subscriber& rhs) const
@@ -37,7 +37,7 @@
 #include "ros/statistics.h"
 #include "XmlRpc.h"
 
-#include <boost/thread.hpp>
+#include "ros/threading.h"
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
@@ -96,8 +96,13 @@ public:
   XmlRpc::XmlRpcValue getStats();
   void getInfo(XmlRpc::XmlRpcValue& info);
 
-  bool addCallback(const SubscriptionCallbackHelperPtr& helper, const std::string& md5sum, CallbackQueueInterface* queue, int32_t queue_size, const VoidConstPtr& tracked_object, bool allow_concurrent_callbacks);
+  bool addCallback(const SubscriptionCallbackHelperPtr& helper, const std::string& md5sum, CallbackQueueInterface* queue, int32_t queue_size, const VoidConstPtr& tracked_object, bool allow_concurrent_callbacks, int32_t priority, const WallDuration& deadline, bool conflate,
+                   uint32_t max_batch, const WallDuration& max_latency);
   void removeCallback(const SubscriptionCallbackHelperPtr& helper);
+  /**
+   * \brief Returns the queue of the callback for helper, or an empty pointer if there is no such callback
+   */
+  SubscriptionQueuePtr getSubscriptionQueue(const SubscriptionCallbackHelperPtr& helper);
 
   typedef std::map<std::string, std::string> M_string;
 
@@ -200,29 +205,31 @@ private:
     SubscriptionQueuePtr subscription_queue_;
     bool has_tracked_object_;
     VoidConstWPtr tracked_object_;
+    /// Index of the callback's C++ message type in callback_types_
+    size_t type_index_;
   };
   typedef boost::shared_ptr<CallbackInfo> CallbackInfoPtr;
   typedef std::vector<CallbackInfoPtr> V_CallbackInfo;
 
   std::string name_;
-  boost::mutex md5sum_mutex_;
+  threading::mutex md5sum_mutex_;
   std::string md5sum_;
   std::string datatype_;
-  boost::mutex callbacks_mutex_;
+  threading::mutex callbacks_mutex_;
   V_CallbackInfo callbacks_;
   uint32_t nonconst_callbacks_;
 
   bool dropped_;
   bool shutting_down_;
-  boost::mutex shutdown_mutex_;
+  threading::mutex shutdown_mutex_;
 
   typedef std::set<PendingConnectionPtr> S_PendingConnection;
   S_PendingConnection pending_connections_;
-  boost::mutex pending_connections_mutex_;
+  threading::mutex pending_connections_mutex_;
 
   typedef std::vector<PublisherLinkPtr> V_PublisherLink;
   V_PublisherLink publisher_links_;
-  boost::mutex publisher_links_mutex_;
+  threading::mutex publisher_links_mutex_;
 
   TransportHints transport_hints_;
 
@@ -239,8 +246,18 @@ private:
   typedef std::map<PublisherLinkPtr, LatchInfo> M_PublisherLinkToLatchInfo;
   M_PublisherLinkToLatchInfo latched_messages_;
 
-  typedef std::vector<std::pair<const std::type_info*, MessageDeserializerPtr> > V_TypeAndDeserializer;
-  V_TypeAndDeserializer cached_deserializers_;
+  /**
+   * \brief Rebuild callback_types_, and the callbacks' indices into it.  Called with callbacks_mutex_ held whenever
+   * callbacks_ changes.
+   */
+  void updateCallbackTypes();
+
+  /// The distinct C++ message types of the callbacks
+  typedef std::vector<const std::type_info*> V_TypeInfo;
+  V_TypeInfo callback_types_;
+  /// The deserializer for each of callback_types_, for the message being handled
+  typedef std::vector<MessageDeserializerPtr> V_MessageDeserializer;
+  V_MessageDeserializer deserializers_;
 };
 
 }
@@ -29,6 +29,7 @@
 #define ROSCPP_SUBSCRIPTION_CALLBACK_HELPER_H
 
 #include <typeinfo>
+#include <vector>
 
 #include "common.h"
 #include "ros/forwards.h"
@@ -60,6 +61,7 @@ struct ROSCPP_DECL SubscriptionCallbackHelperCallParams
 {
   MessageEvent<void const> event;
 };
+typedef std::vector<SubscriptionCallbackHelperCallParams> V_SubscriptionCallbackHelperCallParams;
 
 /**
  * \brief Abstract base class used by subscriptions to deal with concrete message types through a common
@@ -72,6 +74,17 @@ public:
   virtual ~SubscriptionCallbackHelper() {}
   virtual VoidConstPtr deserialize(const SubscriptionCallbackHelperDeserializeParams&) = 0;
   virtual void call(SubscriptionCallbackHelperCallParams& params) = 0;
+  /**
+   * \brief Call the callback for a batch of messages, when subscribed with SubscribeOptions::max_batch.  By default
+   * calls call() for each of them in turn.
+   */
+  virtual void callBatch(V_SubscriptionCallbackHelperCallParams& params)
+  {
+    for (size_t i = 0; i < params.size(); ++i)
+    {
+      call(params[i]);
+    }
+  }
   virtual const std::type_info& getTypeInfo() = 0;
   virtual bool isConst() = 0;
   virtual bool hasHeader() = 0;
@@ -159,6 +172,89 @@ private:
   CreateFunction create_;
 };
 
+/**
+ * \brief SubscriptionCallbackHelper which passes its callback all the messages of a batch at once, as a vector.  Use
+ * with SubscribeOptions::initBatch().
+ */
+template<typename M>
+class SubscriptionBatchCallbackHelperT : public SubscriptionCallbackHelper
+{
+public:
+  typedef typename boost::remove_const<M>::type NonConstType;
+  typedef boost::shared_ptr<NonConstType> NonConstTypePtr;
+  typedef boost::shared_ptr<NonConstType const> ConstTypePtr;
+  typedef std::vector<ConstTypePtr> V_ConstTypePtr;
+
+  typedef boost::function<void(const V_ConstTypePtr&)> Callback;
+  typedef boost::function<NonConstTypePtr()> CreateFunction;
+
+  SubscriptionBatchCallbackHelperT(const Callback& callback,
+                                   const CreateFunction& create = DefaultMessageCreator<NonConstType>())
+    : callback_(callback)
+    , create_(create)
+  { }
+
+  virtual bool hasHeader()
+  {
+     return message_traits::hasHeader<NonConstType>();
+  }
+
+  virtual VoidConstPtr deserialize(const SubscriptionCallbackHelperDeserializeParams& params)
+  {
+    namespace ser = serialization;
+
+    NonConstTypePtr msg = create_();
+
+    if (!msg)
+    {
+      ROS_DEBUG("Allocation failed for message of type [%s]", getTypeInfo().name());
+      return VoidConstPtr();
+    }
+
+    ser::PreDeserializeParams<NonConstType> predes_params;
+    predes_params.message = msg;
+    predes_params.connection_header = params.connection_header;
+    ser::PreDeserialize<NonConstType>::notify(predes_params);
+
+    ser::IStream stream(params.buffer, params.length);
+    ser::deserialize(stream, *msg);
+
+    return VoidConstPtr(msg);
+  }
+
+  virtual void call(SubscriptionCallbackHelperCallParams& params)
+  {
+    V_ConstTypePtr msgs(1, boost::static_pointer_cast<NonConstType const>(params.event.getConstMessage()));
+    callback_(msgs);
+  }
+
+  virtual void callBatch(V_SubscriptionCallbackHelperCallParams& params)
+  {
+    V_ConstTypePtr msgs;
+    msgs.reserve(params.size());
+    for (size_t i = 0; i < params.size(); ++i)
+    {
+      msgs.push_back(boost::static_pointer_cast<NonConstType const>(params[i].event.getConstMessage()));
+    }
+
+    callback_(msgs);
+  }
+
+  virtual const std::type_info& getTypeInfo()
+  {
+    return typeid(NonConstType);
+  }
+
+  virtual bool isConst()
+  {
+    return true;
+  }
+
+private:
+  Callback callback_;
+  CreateFunction create_;
+};
+
 }
 
 #endif // ROSCPP_SUBSCRIPTION_CALLBACK_HELPER_H
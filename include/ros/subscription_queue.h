@@ -31,11 +31,12 @@
 #include "forwards.h"
 #include "common.h"
 #include "ros/message_event.h"
+#include "ros/timer_options.h"
 #include "callback_queue_interface.h"
 
-#include <boost/thread/recursive_mutex.hpp>
-#include <boost/thread/mutex.hpp>
+#include "ros/threading.h"
 #include <boost/enable_shared_from_this.hpp>
+#include <boost/atomic.hpp>
 #include <deque>
 
 namespace ros
@@ -63,31 +64,147 @@ private:
   };
   typedef std::deque<Item> D_Item;
 
+  /**
+   * \brief The pending message from one publisher link, when conflating.  A slot is marked removed when its link is,
+   * taken out of the list once its message has been called, and deleted once no call() can still be walking past it.
+   */
+  struct ConflationSlot
+  {
+    ConflationSlot(const void* link)
+    : link(link)
+    , removed(false)
+    , item(0)
+    , next(0)
+    , retired_next(0)
+    {}
+
+    const void* link;
+    /// Only used with queue_mutex_ held
+    bool removed;
+    boost::atomic<Item*> item;
+    boost::atomic<ConflationSlot*> next;
+    /// Only used with queue_mutex_ held.  Kept apart from next, which a call() on this slot may still follow.
+    ConflationSlot* retired_next;
+  };
+
 public:
-  SubscriptionQueue(const std::string& topic, int32_t queue_size, bool allow_concurrent_callbacks);
+  /**
+   * \param conflate Whether to keep only the newest message from each publisher link, rather than a queue of up to
+   * queue_size messages
+   * \param max_batch Largest number of messages to pass to the callback helper in one call, see
+   * SubscriptionCallbackHelper::callBatch().  0 or 1 calls it for each message on its own.  Ignored when conflating.
+   * \param max_latency How long a batch may wait to fill up to max_batch messages before it is called anyway.  Only
+   * used once setBatchCallbackQueue() has been called; otherwise batches hold whatever arrived before they were called.
+   */
+  SubscriptionQueue(const std::string& topic, int32_t queue_size, bool allow_concurrent_callbacks, int32_t priority, const WallDuration& deadline,
+                    bool conflate, uint32_t max_batch = 0, const WallDuration& max_latency = WallDuration());
   ~SubscriptionQueue();
 
+  /**
+   * \param link The publisher link the message came in on.  Only used when conflating.
+   * \param was_conflated Set to true if the message replaced one from the same link which was still waiting to be
+   * called.  No callback needs to be added for it then.
+   * \param was_batched Set to true if the message joined a batch which is already waiting to be called, or which
+   * the max_latency timer will add a callback for.  No callback needs to be added for it then.
+   */
   void push(const SubscriptionCallbackHelperPtr& helper, const MessageDeserializerPtr& deserializer, 
 	    bool has_tracked_object, const VoidConstWPtr& tracked_object, bool nonconst_need_copy, 
-	    ros::Time receipt_time = ros::Time(), bool* was_full = 0);
+	    ros::Time receipt_time = ros::Time(), bool* was_full = 0, const void* link = 0, bool* was_conflated = 0,
+	    bool* was_batched = 0);
   void clear();
 
+  /**
+   * \brief Drop the conflation slot for a publisher link which has gone away, once its pending message (if any) has
+   * been called
+   */
+  void removeLink(const void* link);
+
+  /**
+   * \brief Set the queue, and removal ID, the max_latency timer adds this queue's callbacks to
+   */
+  void setBatchCallbackQueue(CallbackQueueInterface* queue, uint64_t removal_id);
+
   virtual CallbackInterface::CallResult call();
   virtual bool ready();
+  virtual int32_t getPriority() { return priority_; }
+  virtual WallDuration getDeadline() { return deadline_; }
+  virtual void deadlineMissed(const WallDuration& lateness);
   bool full();
 
+  /**
+   * \brief Returns the number of callbacks which finished after their deadline
+   */
+  uint32_t getDeadlineMisses();
+
+  /**
+   * \brief Returns the number of messages which were replaced by a newer one before being called, when conflating
+   */
+  uint64_t getConflatedCount() { return conflated_.load(); }
+
 private:
   bool fullNoLock();
+  /**
+   * \brief Take the pending message from any publisher link, without locking queue_mutex_
+   */
+  bool popConflated(Item& item);
+  void clearConflated();
+  /**
+   * \brief Reset an item taken out of a conflation slot, and keep it for the next push() to reuse
+   */
+  void releaseConflated(Item* item);
+  /**
+   * \brief Unlink removed slots with no pending message, and delete the unlinked ones if no call() is walking the
+   * list.  Called with queue_mutex_ held.
+   */
+  void reclaimSlots();
+  /**
+   * \param self Set to a reference to this queue before calling the callback helper, which may drop the last other one
+   */
+  CallbackInterface::CallResult callBatch(boost::shared_ptr<SubscriptionQueue>& self);
+  /**
+   * \brief Start the max_latency timer for the current batch.  Returns false if there is no timer to start, in which
+   * case a callback should be added straight away.
+   * \param old_timer Set to the previous batch's timer, which the caller must remove once it has released queue_mutex_
+   */
+  bool armBatchTimer(int32_t& old_timer);
+  void onBatchTimer(const WallTimerEvent& event, uint32_t generation);
   std::string topic_;
   int32_t size_;
   bool full_;
 
-  boost::mutex queue_mutex_;
+  threading::mutex queue_mutex_;
   D_Item queue_;
   uint32_t queue_size_;
   bool allow_concurrent_callbacks_;
-
-  boost::recursive_mutex callback_mutex_;
+  int32_t priority_;
+  WallDuration deadline_;
+  uint32_t deadline_misses_;
+
+  bool conflate_;
+  /// List of ConflationSlots.  Only changed with queue_mutex_ held.
+  boost::atomic<ConflationSlot*> slots_;
+  /// Slots taken out of slots_ but not yet deleted, linked through retired_next.  Guarded by queue_mutex_.
+  ConflationSlot* retired_slots_;
+  /// Slots marked removed but not yet deleted.  Guarded by queue_mutex_.
+  uint32_t removed_slots_;
+  /// Number of call()s walking slots_ right now
+  boost::atomic<uint32_t> conflation_readers_;
+  /// A spare Item, so that a steady stream of messages reuses the displaced ones instead of allocating
+  boost::atomic<Item*> free_item_;
+  boost::atomic<uint64_t> conflated_;
+
+  uint32_t max_batch_;
+  WallDuration max_latency_;
+  /// Whether a callback has been added for the queued messages, or the max_latency timer will add one
+  bool batch_scheduled_;
+  bool batch_timer_armed_;
+  int32_t batch_timer_handle_;
+  /// Incremented for every batch timer, so that onBatchTimer() can tell if it is for the current batch
+  uint32_t batch_timer_generation_;
+  CallbackQueueInterface* batch_callback_queue_;
+  uint64_t batch_removal_id_;
+
+  threading::recursive_mutex callback_mutex_;
 };
 
 }
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_THREADING_H
+#define ROSCPP_THREADING_H
+
+#include "common.h"
+
+#ifdef ROSCPP_USE_RTAI_THREAD
+#include <rtai_thread.h>
+#else
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread.hpp>
+#endif
+
+namespace ros
+{
+
+/**
+ * \brief The threading primitives libros is built on
+ *
+ * libros uses these typedefs rather than naming a threading library directly, so that the same sources build on
+ * boost::thread (the default) or on rtai_thread, which provides the same API on top of real-time threads.  The backend
+ * is chosen when roscpp is configured, with the ROSCPP_THREADING CMake option, and recorded in ros/common.h so that
+ * code including the roscpp headers sees the same types libros was built with.
+ *
+ * Locks are still boost::unique_lock and boost::shared_lock (or the scoped_lock typedefs of the mutexes), which
+ * work with either backend.
+ *
+ * pi_mutex and ceiling_mutex are for mutexes a real-time thread may block on, such as those on the publish and
+ * callback paths.  With rtai_thread they inherit priority, or run the holder at a priority ceiling, so a low priority
+ * thread holding one can't hold up a control thread indefinitely.  boost::thread has no priority protocols, so there
+ * they are plain mutexes.  Either way their scoped_lock can wait on a condition_variable.
+ */
+namespace threading
+{
+
+#ifdef ROSCPP_USE_RTAI_THREAD
+typedef rtai_thread::mutex mutex;
+typedef rtai_thread::pi_mutex pi_mutex;
+typedef rtai_thread::ceiling_mutex ceiling_mutex;
+typedef rtai_thread::recursive_mutex recursive_mutex;
+typedef rtai_thread::shared_mutex shared_mutex;
+typedef rtai_thread::condition_variable condition_variable;
+typedef rtai_thread::thread thread;
+typedef rtai_thread::thread_group thread_group;
+namespace this_thread = rtai_thread::this_thread;
+#else
+typedef boost::mutex mutex;
+typedef boost::mutex pi_mutex;
+class ceiling_mutex : public boost::mutex
+{
+public:
+  explicit ceiling_mutex(int /*ceiling*/) {}
+};
+typedef boost::recursive_mutex recursive_mutex;
+typedef boost::shared_mutex shared_mutex;
+typedef boost::condition_variable condition_variable;
+typedef boost::thread thread;
+typedef boost::thread_group thread_group;
+namespace this_thread = boost::this_thread;
+#endif
+
+} // namespace threading
+
+} // namespace ros
+
+#endif // ROSCPP_THREADING_H
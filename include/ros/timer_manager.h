@@ -32,16 +32,18 @@
 #include "ros/time.h"
 #include "ros/file_log.h"
 
-#include <boost/thread/thread.hpp>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/recursive_mutex.hpp>
-#include <boost/thread/condition_variable.hpp>
+#include "ros/threading.h"
 
 #include "ros/assert.h"
 #include "ros/callback_queue_interface.h"
+#include "ros/high_resolution_sleeper.h"
+#include "ros/timer_statistics.h"
+
+#include <boost/atomic.hpp>
 
 #include <vector>
-#include <list>
+#include <map>
+#include <algorithm>
 
 namespace ros
 {
@@ -65,16 +67,28 @@ private:
 
     T last_real;
 
-    bool removed;
+    /// Written with timers_mutex_ held, but read without it by the timer thread's inline calls
+    boost::atomic<bool> removed;
 
     VoidConstWPtr tracked_object;
     bool has_tracked_object;
 
     // TODO: atomicize
-    boost::mutex waiting_mutex;
+    threading::mutex waiting_mutex;
     uint32_t waiting_callbacks;
 
     bool oneshot;
+    bool call_inline;
+    int32_t priority;
+    WallDuration deadline;
+    // protected by waiting_mutex
+    uint32_t deadline_misses;
+
+    // position in waiting_, or NOT_WAITING.  protected by waiting_mutex_
+    size_t waiting_index;
+
+    // protected by waiting_mutex
+    TimerStatistics statistics;
 
     // debugging info
     uint32_t total_calls;
@@ -82,17 +96,26 @@ private:
   typedef boost::shared_ptr<TimerInfo> TimerInfoPtr;
   typedef boost::weak_ptr<TimerInfo> TimerInfoWPtr;
   typedef std::vector<TimerInfoPtr> V_TimerInfo;
-
-  typedef std::list<int32_t> L_int32;
+  typedef std::map<int32_t, TimerInfoPtr> M_TimerInfo;
 
 public:
-  TimerManager();
+  /**
+   * \param high_resolution Whether to sleep with a HighResolutionSleeper rather than a condition variable.  Only
+   * meaningful for wall-clock timers; falls back to a condition variable where high resolution sleeps are not available.
+   */
+  TimerManager(bool high_resolution = false);
   ~TimerManager();
 
-  int32_t add(const D& period, const boost::function<void(const E&)>& callback, CallbackQueueInterface* callback_queue, const VoidConstPtr& tracked_object, bool oneshot);
+  /**
+   * \param call_inline Whether to call the callback directly from the timer thread, rather than adding it to callback_queue
+   */
+  int32_t add(const D& period, const boost::function<void(const E&)>& callback, CallbackQueueInterface* callback_queue, const VoidConstPtr& tracked_object, bool oneshot,
+              int32_t priority = 0, const WallDuration& deadline = WallDuration(), bool call_inline = false);
   void remove(int32_t handle);
 
   bool hasPending(int32_t handle);
+  uint32_t getDeadlineMisses(int32_t handle);
+  TimerStatistics getStatistics(int32_t handle);
   void setPeriod(int32_t handle, const D& period, bool reset=true);
 
   static TimerManager& global()
@@ -101,31 +124,77 @@ public:
     return global;
   }
 
+  /**
+   * \brief Returns the manager for high resolution timers, which has a thread of its own
+   */
+  static TimerManager& highResolution()
+  {
+    static TimerManager<T, D, E> high_resolution(true);
+    return high_resolution;
+  }
+
 private:
   void threadFunc();
 
-  bool waitingCompare(int32_t lhs, int32_t rhs);
   TimerInfoPtr findTimer(int32_t handle);
   void schedule(const TimerInfoPtr& info);
   void updateNext(const TimerInfoPtr& info, const T& current_time);
-
-  V_TimerInfo timers_;
-  boost::mutex timers_mutex_;
-  boost::condition_variable timers_cond_;
+  /**
+   * \brief Call a timer's callback.  Returns false if its tracked object has gone away.
+   */
+  bool callTimer(const TimerInfoPtr& info, const T& last_expected, const T& last_real, const T& current_expected);
+  /// Wake up threadFunc().  Called with timers_mutex_ held.
+  void notifyThread();
+
+  M_TimerInfo timers_;
+  threading::mutex timers_mutex_;
+  threading::condition_variable timers_cond_;
   volatile bool new_timer_;
 
-  boost::mutex waiting_mutex_;
-  L_int32 waiting_;
+  /**
+   * \brief The timers waiting to fire, as a d-ary min-heap ordered by next_expected.  Each timer knows its position in the
+   * heap, so adding, removing and rescheduling a timer are all O(log n).
+   */
+  static const size_t WAITING_ARITY = 4;
+  static const size_t NOT_WAITING = (size_t)-1;
+  static bool waitingLess(const TimerInfoPtr& lhs, const TimerInfoPtr& rhs);
+  void waitingPush(const TimerInfoPtr& info);
+  void waitingRemove(const TimerInfoPtr& info);
+  /// Restore the heap order after the next_expected of a waiting timer has changed
+  void waitingUpdate(const TimerInfoPtr& info);
+  void waitingRebuild();
+  void waitingSet(size_t index, const TimerInfoPtr& info);
+  void waitingSiftUp(size_t index);
+  void waitingSiftDown(size_t index);
+
+  threading::mutex waiting_mutex_;
+  V_TimerInfo waiting_;
 
   uint32_t id_counter_;
-  boost::mutex id_mutex_;
+  threading::mutex id_mutex_;
 
   bool thread_started_;
 
-  boost::thread thread_;
+  threading::thread thread_;
 
   bool quit_;
 
+  HighResolutionSleeperPtr sleeper_;
+
+  /// A timer called inline, with the times it was called for
+  struct InlineCall
+  {
+    TimerInfoPtr info;
+    T last_expected;
+    T last_real;
+    T current_expected;
+  };
+  /// Inline timers due in the current pass of threadFunc().  Only touched by the timer thread, and kept around so that its
+  /// storage is reused from one pass to the next.
+  std::vector<InlineCall> inline_calls_;
+  /// Held by the timer thread while calling inline timers, so that remove() can wait for a call in progress to finish
+  threading::mutex inline_mutex_;
+
   class TimerQueueCallback : public CallbackInterface
   {
   public:
@@ -135,9 +204,11 @@ private:
     , last_expected_(last_expected)
     , last_real_(last_real)
     , current_expected_(current_expected)
+    , priority_(info->priority)
+    , deadline_(info->deadline)
     , called_(false)
     {
-      boost::mutex::scoped_lock lock(info->waiting_mutex);
+      threading::mutex::scoped_lock lock(info->waiting_mutex);
       ++info->waiting_callbacks;
     }
 
@@ -146,7 +217,7 @@ private:
       TimerInfoPtr info = info_.lock();
       if (info)
       {
-        boost::mutex::scoped_lock lock(info->waiting_mutex);
+        threading::mutex::scoped_lock lock(info->waiting_mutex);
         --info->waiting_callbacks;
       }
     }
@@ -159,38 +230,35 @@ private:
         return Invalid;
       }
 
+      called_ = true;
+      if (!parent_->callTimer(info, last_expected_, last_real_, current_expected_))
       {
-        ++info->total_calls;
-        called_ = true;
+        return Invalid;
+      }
 
-        VoidConstPtr tracked;
-        if (info->has_tracked_object)
-        {
-          tracked = info->tracked_object.lock();
-          if (!tracked)
-          {
-            return Invalid;
-          }
-        }
+      parent_->schedule(info);
 
-        E event;
-        event.last_expected = last_expected_;
-        event.last_real = last_real_;
-        event.current_expected = current_expected_;
-        event.current_real = T::now();
-        event.profile.last_duration = info->last_cb_duration;
+      return Success;
+    }
 
-        WallTime cb_start = WallTime::now();
-        info->callback(event);
-        WallTime cb_end = WallTime::now();
-        info->last_cb_duration = cb_end - cb_start;
+    virtual int32_t getPriority()
+    {
+      return priority_;
+    }
 
-        info->last_real = event.current_real;
+    virtual WallDuration getDeadline()
+    {
+      return deadline_;
+    }
 
-        parent_->schedule(info);
+    virtual void deadlineMissed(const WallDuration&)
+    {
+      TimerInfoPtr info = info_.lock();
+      if (info)
+      {
+        threading::mutex::scoped_lock lock(info->waiting_mutex);
+        ++info->deadline_misses;
       }
-
-      return Success;
     }
 
   private:
@@ -199,16 +267,21 @@ private:
     T last_expected_;
     T last_real_;
     T current_expected_;
+    int32_t priority_;
+    WallDuration deadline_;
 
     bool called_;
   };
 };
 
 template<class T, class D, class E>
-TimerManager<T, D, E>::TimerManager() :
+TimerManager<T, D, E>::TimerManager(bool high_resolution) :
   new_timer_(false), id_counter_(0), thread_started_(false), quit_(false)
 {
-
+  if (high_resolution)
+  {
+    sleeper_ = HighResolutionSleeper::create();
+  }
 }
 
 template<class T, class D, class E>
@@ -216,8 +289,8 @@ TimerManager<T, D, E>::~TimerManager()
 {
   quit_ = true;
   {
-    boost::mutex::scoped_lock lock(timers_mutex_);
-    timers_cond_.notify_all();
+    threading::mutex::scoped_lock lock(timers_mutex_);
+    notifyThread();
   }
   if (thread_started_)
   {
@@ -226,29 +299,154 @@ TimerManager<T, D, E>::~TimerManager()
 }
 
 template<class T, class D, class E>
-bool TimerManager<T, D, E>::waitingCompare(int32_t lhs, int32_t rhs)
+bool TimerManager<T, D, E>::waitingLess(const TimerInfoPtr& lhs, const TimerInfoPtr& rhs)
 {
-  TimerInfoPtr infol = findTimer(lhs);
-  TimerInfoPtr infor = findTimer(rhs);
-  if (!infol || !infor)
+  // Timers due at the same time fire in the order they were added
+  if (lhs->next_expected == rhs->next_expected)
   {
-    return infol < infor;
+    return lhs->handle < rhs->handle;
   }
 
-  return infol->next_expected < infor->next_expected;
+  return lhs->next_expected < rhs->next_expected;
 }
 
 template<class T, class D, class E>
-typename TimerManager<T, D, E>::TimerInfoPtr TimerManager<T, D, E>::findTimer(int32_t handle)
+void TimerManager<T, D, E>::waitingSet(size_t index, const TimerInfoPtr& info)
+{
+  waiting_[index] = info;
+  info->waiting_index = index;
+}
+
+template<class T, class D, class E>
+void TimerManager<T, D, E>::waitingSiftUp(size_t index)
+{
+  TimerInfoPtr info = waiting_[index];
+  while (index > 0)
+  {
+    size_t parent = (index - 1) / WAITING_ARITY;
+    if (!waitingLess(info, waiting_[parent]))
+    {
+      break;
+    }
+
+    waitingSet(index, waiting_[parent]);
+    index = parent;
+  }
+
+  waitingSet(index, info);
+}
+
+template<class T, class D, class E>
+void TimerManager<T, D, E>::waitingSiftDown(size_t index)
 {
-  typename V_TimerInfo::iterator it = timers_.begin();
-  typename V_TimerInfo::iterator end = timers_.end();
-  for (; it != end; ++it)
+  TimerInfoPtr info = waiting_[index];
+  size_t size = waiting_.size();
+  while (true)
   {
-    if ((*it)->handle == handle)
+    size_t first = index * WAITING_ARITY + 1;
+    if (first >= size)
     {
-      return *it;
+      break;
     }
+
+    size_t last = std::min(first + WAITING_ARITY, size);
+    size_t best = first;
+    for (size_t child = first + 1; child < last; ++child)
+    {
+      if (waitingLess(waiting_[child], waiting_[best]))
+      {
+        best = child;
+      }
+    }
+
+    if (!waitingLess(waiting_[best], info))
+    {
+      break;
+    }
+
+    waitingSet(index, waiting_[best]);
+    index = best;
+  }
+
+  waitingSet(index, info);
+}
+
+template<class T, class D, class E>
+void TimerManager<T, D, E>::waitingPush(const TimerInfoPtr& info)
+{
+  if (info->waiting_index != NOT_WAITING)
+  {
+    waitingUpdate(info);
+    return;
+  }
+
+  waiting_.push_back(info);
+  info->waiting_index = waiting_.size() - 1;
+  waitingSiftUp(info->waiting_index);
+}
+
+template<class T, class D, class E>
+void TimerManager<T, D, E>::waitingRemove(const TimerInfoPtr& info)
+{
+  size_t index = info->waiting_index;
+  if (index == NOT_WAITING)
+  {
+    return;
+  }
+
+  ROS_ASSERT(index < waiting_.size() && waiting_[index] == info);
+
+  TimerInfoPtr last = waiting_.back();
+  waiting_.pop_back();
+  info->waiting_index = NOT_WAITING;
+
+  if (index < waiting_.size())
+  {
+    waitingSet(index, last);
+    waitingUpdate(last);
+  }
+}
+
+template<class T, class D, class E>
+void TimerManager<T, D, E>::waitingUpdate(const TimerInfoPtr& info)
+{
+  size_t index = info->waiting_index;
+  if (index == NOT_WAITING)
+  {
+    return;
+  }
+
+  if (index > 0 && waitingLess(info, waiting_[(index - 1) / WAITING_ARITY]))
+  {
+    waitingSiftUp(index);
+  }
+  else
+  {
+    waitingSiftDown(index);
+  }
+}
+
+template<class T, class D, class E>
+void TimerManager<T, D, E>::waitingRebuild()
+{
+  if (waiting_.size() < 2)
+  {
+    return;
+  }
+
+  for (size_t index = (waiting_.size() - 2) / WAITING_ARITY + 1; index > 0; --index)
+  {
+    waitingSiftDown(index - 1);
+  }
+}
+
+template<class T, class D, class E>
+typename TimerManager<T, D, E>::TimerInfoPtr TimerManager<T, D, E>::findTimer(int32_t handle)
+{
+  typename M_TimerInfo::iterator it = timers_.find(handle);
+  if (it != timers_.end())
+  {
+    return it->second;
   }
 
   return TimerInfoPtr();
@@ -257,7 +455,7 @@ typename TimerManager<T, D, E>::TimerInfoPtr TimerManager<T, D, E>::findTimer(in
 template<class T, class D, class E>
 bool TimerManager<T, D, E>::hasPending(int32_t handle)
 {
-  boost::mutex::scoped_lock lock(timers_mutex_);
+  threading::mutex::scoped_lock lock(timers_mutex_);
   TimerInfoPtr info = findTimer(handle);
 
   if (!info)
@@ -274,13 +472,54 @@ bool TimerManager<T, D, E>::hasPending(int32_t handle)
     }
   }
 
-  boost::mutex::scoped_lock lock2(info->waiting_mutex);
+  threading::mutex::scoped_lock lock2(info->waiting_mutex);
   return info->next_expected <= T::now() || info->waiting_callbacks != 0;
 }
 
+template<class T, class D, class E>
+TimerStatistics TimerManager<T, D, E>::getStatistics(int32_t handle)
+{
+  threading::mutex::scoped_lock lock(timers_mutex_);
+  TimerInfoPtr info = findTimer(handle);
+
+  if (!info)
+  {
+    return TimerStatistics();
+  }
+
+  threading::mutex::scoped_lock lock2(info->waiting_mutex);
+  return info->statistics;
+}
+
+template<class T, class D, class E>
+void TimerManager<T, D, E>::notifyThread()
+{
+  timers_cond_.notify_all();
+  if (sleeper_)
+  {
+    sleeper_->wake();
+  }
+}
+
+template<class T, class D, class E>
+uint32_t TimerManager<T, D, E>::getDeadlineMisses(int32_t handle)
+{
+  threading::mutex::scoped_lock lock(timers_mutex_);
+  TimerInfoPtr info = findTimer(handle);
+
+  if (!info)
+  {
+    return 0;
+  }
+
+  threading::mutex::scoped_lock lock2(info->waiting_mutex);
+  return info->deadline_misses;
+}
+
 template<class T, class D, class E>
 int32_t TimerManager<T, D, E>::add(const D& period, const boost::function<void(const E&)>& callback, CallbackQueueInterface* callback_queue,
-                                   const VoidConstPtr& tracked_object, bool oneshot)
+                                   const VoidConstPtr& tracked_object, bool oneshot, int32_t priority, const WallDuration& deadline,
+                                   bool call_inline)
 {
   TimerInfoPtr info(new TimerInfo);
   info->period = period;
@@ -293,6 +532,11 @@ int32_t TimerManager<T, D, E>::add(const D& period, const boost::function<void(c
   info->waiting_callbacks = 0;
   info->total_calls = 0;
   info->oneshot = oneshot;
+  info->call_inline = call_inline;
+  info->priority = priority;
+  info->deadline = deadline;
+  info->deadline_misses = 0;
+  info->waiting_index = NOT_WAITING;
   if (tracked_object)
   {
     info->tracked_object = tracked_object;
@@ -300,28 +544,27 @@ int32_t TimerManager<T, D, E>::add(const D& period, const boost::function<void(c
   }
 
   {
-    boost::mutex::scoped_lock lock(id_mutex_);
+    threading::mutex::scoped_lock lock(id_mutex_);
     info->handle = id_counter_++;
   }
 
   {
-    boost::mutex::scoped_lock lock(timers_mutex_);
-    timers_.push_back(info);
+    threading::mutex::scoped_lock lock(timers_mutex_);
+    timers_.insert(std::make_pair(info->handle, info));
 
     if (!thread_started_)
     {
-      thread_ = boost::thread(boost::bind(&TimerManager::threadFunc, this));
+      thread_ = threading::thread(boost::bind(&TimerManager::threadFunc, this));
       thread_started_ = true;
     }
 
     {
-      boost::mutex::scoped_lock lock(waiting_mutex_);
-      waiting_.push_back(info->handle);
-      waiting_.sort(boost::bind(&TimerManager::waitingCompare, this, _1, _2));
+      threading::mutex::scoped_lock lock(waiting_mutex_);
+      waitingPush(info);
     }
 
     new_timer_ = true;
-    timers_cond_.notify_all();
+    notifyThread();
   }
 
   return info->handle;
@@ -332,37 +575,33 @@ void TimerManager<T, D, E>::remove(int32_t handle)
 {
   CallbackQueueInterface* callback_queue = 0;
   uint64_t remove_id = 0;
+  bool wait_for_inline = false;
 
   {
-    boost::mutex::scoped_lock lock(timers_mutex_);
+    threading::mutex::scoped_lock lock(timers_mutex_);
 
-    typename V_TimerInfo::iterator it = timers_.begin();
-    typename V_TimerInfo::iterator end = timers_.end();
-    for (; it != end; ++it)
+    typename M_TimerInfo::iterator it = timers_.find(handle);
+    if (it != timers_.end())
     {
-      const TimerInfoPtr& info = *it;
-      if (info->handle == handle)
-      {
-        info->removed = true;
-        callback_queue = info->callback_queue;
-        remove_id = (uint64_t)info.get();
-        timers_.erase(it);
-        break;
-      }
-    }
-
-    {
-      boost::mutex::scoped_lock lock2(waiting_mutex_);
+      TimerInfoPtr info = it->second;
+      info->removed = true;
+      callback_queue = info->callback_queue;
+      remove_id = (uint64_t)info.get();
+      wait_for_inline = info->call_inline && threading::this_thread::get_id() != thread_.get_id();
+      timers_.erase(it);
+
+      threading::mutex::scoped_lock lock2(waiting_mutex_);
       // Remove from the waiting list if it's in it
-      L_int32::iterator it = std::find(waiting_.begin(), waiting_.end(), handle);
-      if (it != waiting_.end())
-      {
-        waiting_.erase(it);
-      }
+      waitingRemove(info);
     }
   }
 
-  if (callback_queue)
+  if (wait_for_inline)
+  {
+    // The timer thread may be calling this timer right now.  Wait for it to finish, unless this is that call.
+    threading::mutex::scoped_lock lock(inline_mutex_);
+  }
+  else if (callback_queue)
   {
     callback_queue->removeByID(remove_id);
   }
@@ -371,7 +610,7 @@ void TimerManager<T, D, E>::remove(int32_t handle)
 template<class T, class D, class E>
 void TimerManager<T, D, E>::schedule(const TimerInfoPtr& info)
 {
-  boost::mutex::scoped_lock lock(timers_mutex_);
+  threading::mutex::scoped_lock lock(timers_mutex_);
 
   if (info->removed)
   {
@@ -380,15 +619,45 @@ void TimerManager<T, D, E>::schedule(const TimerInfoPtr& info)
 
   updateNext(info, T::now());
   {
-    boost::mutex::scoped_lock lock(waiting_mutex_);
+    threading::mutex::scoped_lock lock(waiting_mutex_);
 
-    waiting_.push_back(info->handle);
-    // waitingCompare requires a lock on the timers_mutex_
-    waiting_.sort(boost::bind(&TimerManager::waitingCompare, this, _1, _2));
+    waitingPush(info);
   }
 
   new_timer_ = true;
-  timers_cond_.notify_one();
+  notifyThread();
+}
+
+template<class T, class D, class E>
+bool TimerManager<T, D, E>::callTimer(const TimerInfoPtr& info, const T& last_expected, const T& last_real, const T& current_expected)
+{
+  ++info->total_calls;
+
+  VoidConstPtr tracked;
+  if (info->has_tracked_object)
+  {
+    tracked = info->tracked_object.lock();
+    if (!tracked)
+    {
+      return false;
+    }
+  }
+
+  E event;
+  event.last_expected = last_expected;
+  event.last_real = last_real;
+  event.current_expected = current_expected;
+  event.current_real = T::now();
+  event.profile.last_duration = info->last_cb_duration;
+
+  WallTime cb_start = WallTime::now();
+  info->callback(event);
+  WallTime cb_end = WallTime::now();
+  info->last_cb_duration = cb_end - cb_start;
+
+  info->last_real = event.current_real;
+
+  return true;
 }
 
 template<class T, class D, class E>
@@ -421,7 +690,7 @@ void TimerManager<T, D, E>::updateNext(const TimerInfoPtr& info, const T& curren
 template<class T, class D, class E>
 void TimerManager<T, D, E>::setPeriod(int32_t handle, const D& period, bool reset)
 {
-  boost::mutex::scoped_lock lock(timers_mutex_);
+  threading::mutex::scoped_lock lock(timers_mutex_);
   TimerInfoPtr info = findTimer(handle);
 
   if (!info)
@@ -430,7 +699,7 @@ void TimerManager<T, D, E>::setPeriod(int32_t handle, const D& period, bool rese
   }
 
   {
-    boost::mutex::scoped_lock lock(waiting_mutex_);
+    threading::mutex::scoped_lock lock(waiting_mutex_);
   
     if(reset)
     {
@@ -458,22 +727,27 @@ void TimerManager<T, D, E>::setPeriod(int32_t handle, const D& period, bool rese
     // In this case, let next_expected be updated only in updateNext
     
     info->period = period;
-    waiting_.sort(boost::bind(&TimerManager::waitingCompare, this, _1, _2));
+    waitingUpdate(info);
   }
 
   new_timer_ = true;
-  timers_cond_.notify_one();
+  notifyThread();
 }
 
 template<class T, class D, class E>
 void TimerManager<T, D, E>::threadFunc()
 {
+  if (sleeper_)
+  {
+    sleeper_->setupThread();
+  }
+
   T current;
   while (!quit_)
   {
     T sleep_end;
 
-    boost::mutex::scoped_lock lock(timers_mutex_);
+    threading::mutex::scoped_lock lock(timers_mutex_);
 
     // detect time jumping backwards
     if (T::now() < current)
@@ -482,11 +756,11 @@ void TimerManager<T, D, E>::threadFunc()
 
       current = T::now();
 
-      typename V_TimerInfo::iterator it = timers_.begin();
-      typename V_TimerInfo::iterator end = timers_.end();
+      typename M_TimerInfo::iterator it = timers_.begin();
+      typename M_TimerInfo::iterator end = timers_.end();
       for (; it != end; ++it)
       {
-        const TimerInfoPtr& info = *it;
+        const TimerInfoPtr& info = it->second;
 
         // Timer may have been added after the time jump, so also check if time has jumped past its last call time
         if (current < info->last_expected)
@@ -495,12 +769,15 @@ void TimerManager<T, D, E>::threadFunc()
           info->next_expected = current + info->period;
         }
       }
+
+      threading::mutex::scoped_lock waitlock(waiting_mutex_);
+      waitingRebuild();
     }
 
     current = T::now();
 
     {
-      boost::mutex::scoped_lock waitlock(waiting_mutex_);
+      threading::mutex::scoped_lock waitlock(waiting_mutex_);
 
       if (waiting_.empty())
       {
@@ -508,33 +785,107 @@ void TimerManager<T, D, E>::threadFunc()
       }
       else
       {
-        TimerInfoPtr info = findTimer(waiting_.front());
+        TimerInfoPtr info = waiting_.front();
 
-        while (!waiting_.empty() && info && info->next_expected <= current)
+        while (!waiting_.empty() && info->next_expected <= current)
         {
           current = T::now();
 
           //ROS_DEBUG("Scheduling timer callback for timer [%d] of period [%f], [%f] off expected", info->handle, info->period.toSec(), (current - info->next_expected).toSec());
-          CallbackInterfacePtr cb(new TimerQueueCallback(this, info, info->last_expected, info->last_real, info->next_expected));
-          info->callback_queue->addCallback(cb, (uint64_t)info.get());
+          {
+            D lateness = current - info->next_expected;
+            int64_t period_nsec = info->period.toNSec();
+            WallDuration wall_lateness;
+            wall_lateness.fromNSec(lateness.toNSec());
+
+            threading::mutex::scoped_lock info_lock(info->waiting_mutex);
+            info->statistics.record(wall_lateness, period_nsec > 0 ? lateness.toNSec() / period_nsec : 0);
+          }
 
-          waiting_.pop_front();
+          if (info->call_inline)
+          {
+            InlineCall call;
+            call.info = info;
+            call.last_expected = info->last_expected;
+            call.last_real = info->last_real;
+            call.current_expected = info->next_expected;
+            inline_calls_.push_back(call);
+          }
+          else
+          {
+            CallbackInterfacePtr cb(new TimerQueueCallback(this, info, info->last_expected, info->last_real, info->next_expected));
+            info->callback_queue->addCallback(cb, (uint64_t)info.get());
+          }
+
+          waitingRemove(info);
 
           if (waiting_.empty())
           {
             break;
           }
 
-          info = findTimer(waiting_.front());
+          info = waiting_.front();
         }
 
-        if (info)
+        if (info->waiting_index != NOT_WAITING)
         {
           sleep_end = info->next_expected;
         }
+        else
+        {
+          sleep_end = current + D(0.1);
+        }
       }
     }
 
+    if (!inline_calls_.empty())
+    {
+      // Call inline timers without timers_mutex_ held, so that they can start, stop and reschedule timers themselves
+      {
+        threading::mutex::scoped_lock inline_lock(inline_mutex_);
+        lock.unlock();
+
+        typename std::vector<InlineCall>::iterator it = inline_calls_.begin();
+        typename std::vector<InlineCall>::iterator end = inline_calls_.end();
+        for (; it != end; ++it)
+        {
+          // An earlier inline call may have removed this timer, in which case remove() didn't wait for us
+          if (it->info->removed)
+          {
+            it->info.reset();
+            continue;
+          }
+
+          try
+          {
+            if (!callTimer(it->info, it->last_expected, it->last_real, it->current_expected))
+            {
+              // Its tracked object has gone away, don't reschedule it
+              it->info.reset();
+            }
+          }
+          catch (std::exception& e)
+          {
+            ROS_ERROR("Exception thrown by timer callback called on the timer thread: %s", e.what());
+          }
+        }
+      }
+
+      // schedule() marks new_timer_, so we go straight round again rather than sleeping until the stale sleep_end
+      typename std::vector<InlineCall>::iterator it = inline_calls_.begin();
+      typename std::vector<InlineCall>::iterator end = inline_calls_.end();
+      for (; it != end; ++it)
+      {
+        if (it->info)
+        {
+          schedule(it->info);
+        }
+      }
+      inline_calls_.clear();
+
+      lock.lock();
+    }
+
     while (!new_timer_ && T::now() < sleep_end && !quit_)
     {
       // detect backwards jumps in time
@@ -552,9 +903,20 @@ void TimerManager<T, D, E>::threadFunc()
         break;
       }
 
+      if (sleeper_ && T::isSystemTime())
+      {
+        // Sleep right up to sleep_end, without the condition variable's millisecond granularity.  Anything else requiring
+        // processing wakes the sleeper up.
+        WallDuration remaining;
+        remaining.fromNSec((sleep_end - current).toNSec());
+
+        lock.unlock();
+        sleeper_->sleep(remaining);
+        lock.lock();
+      }
       // If we're on simulation time we need to check now() against sleep_end more often than on system time,
       // since simulation time may be running faster than real time.
-      if (!T::isSystemTime())
+      else if (!T::isSystemTime())
       {
         timers_cond_.timed_wait(lock, boost::posix_time::milliseconds(1));
       }
@@ -44,6 +44,8 @@ struct ROSCPP_DECL TimerOptions
     , callback_queue(0)
     , oneshot(false)
     , autostart(true)
+    , priority(0)
+    , call_inline(false)
   { }
 
   /*
@@ -57,6 +59,8 @@ struct ROSCPP_DECL TimerOptions
     , callback_queue(_queue)
     , oneshot(oneshot)
     , autostart(autostart)
+    , priority(0)
+    , call_inline(false)
   { }
 
   Duration period;                                                  ///< The period to call the callback at
@@ -76,6 +80,20 @@ struct ROSCPP_DECL TimerOptions
 
   bool oneshot;
   bool autostart;
+
+  /// Priority of this timer's callbacks.  Queues which order callbacks by priority (see PriorityCallbackQueue)
+  /// call higher priorities first; other queues ignore it.  Defaults to 0.
+  int32_t priority;
+
+  /// How soon after the timer fires its callback should have finished.  Queues which schedule by deadline (see
+  /// DeadlineCallbackQueue) call the callback with the nearest deadline first, and count the callbacks which finish late;
+  /// other queues ignore it.  Defaults to zero, for no deadline.
+  WallDuration deadline;
+
+  /// Whether to call the callback directly from the timer thread instead of adding it to callback_queue.  This avoids
+  /// the queueing delay and makes no allocations per tick, but the callback then holds up every other timer while it
+  /// runs, so it must be short and must not block.  Defaults to false.
+  bool call_inline;
 };
 
 
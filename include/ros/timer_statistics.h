@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_TIMER_STATISTICS_H
+#define ROSCPP_TIMER_STATISTICS_H
+
+#include "common.h"
+#include "ros/time.h"
+
+namespace ros
+{
+
+/**
+ * \brief Histograms of how late a timer fired, and of how many periods it overran
+ *
+ * Both histograms have power-of-two buckets: bucket 0 counts values of 0, and bucket i counts values from 2^(i-1) up to
+ * 2^i - 1.  The last bucket also counts everything larger.
+ */
+struct ROSCPP_DECL TimerStatistics
+{
+  static const uint32_t BUCKETS = 24;
+
+  TimerStatistics()
+  : fires(0)
+  {
+    for (uint32_t i = 0; i < BUCKETS; ++i)
+    {
+      jitter[i] = 0;
+      overruns[i] = 0;
+    }
+  }
+
+  /**
+   * \brief Returns the bucket a value falls into
+   */
+  static uint32_t bucket(uint64_t value)
+  {
+    uint32_t b = 0;
+    while (value != 0 && b < BUCKETS - 1)
+    {
+      value >>= 1;
+      ++b;
+    }
+
+    return b;
+  }
+
+  /**
+   * \brief Record one firing of the timer
+   * \param lateness How long after its expected time the timer fired
+   * \param overruns How many whole periods had passed since the expected time when the timer fired
+   */
+  void record(const WallDuration& lateness, uint64_t overrun)
+  {
+    int64_t usec = lateness.toNSec() / 1000;
+    ++jitter[bucket(usec > 0 ? usec : 0)];
+    ++overruns[bucket(overrun)];
+    if (lateness > max_jitter)
+    {
+      max_jitter = lateness;
+    }
+    ++fires;
+  }
+
+  /**
+   * \brief Add the counts from another set of statistics to these
+   */
+  void add(const TimerStatistics& rhs)
+  {
+    for (uint32_t i = 0; i < BUCKETS; ++i)
+    {
+      jitter[i] += rhs.jitter[i];
+      overruns[i] += rhs.overruns[i];
+    }
+
+    if (rhs.max_jitter > max_jitter)
+    {
+      max_jitter = rhs.max_jitter;
+    }
+    fires += rhs.fires;
+  }
+
+  /// Number of times the timer fired
+  uint64_t fires;
+  /// How late the timer fired, in microseconds
+  uint64_t jitter[BUCKETS];
+  /// How many whole periods late the timer fired
+  uint64_t overruns[BUCKETS];
+  /// The latest the timer has fired
+  WallDuration max_jitter;
+};
+
+}
+
+#endif
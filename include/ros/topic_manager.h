@@ -31,12 +31,12 @@
 #include "forwards.h"
 #include "common.h"
 #include "ros/serialization.h"
+#include "ros/buffer_pool.h"
 #include "rosout_appender.h"
 
 #include "XmlRpcValue.h"
 
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/recursive_mutex.hpp>
+#include "ros/threading.h"
 
 namespace ros
 {
@@ -118,13 +118,21 @@ public:
    */
   size_t getNumPublishers(const std::string &_topic);
 
+  /**
+   * \brief Return the queue of a subscription callback, or an empty pointer if it is not subscribed
+   *
+   * \param _topic the topic name the callback is subscribed to
+   * \param helper the helper of the callback
+   */
+  SubscriptionQueuePtr lookupSubscriptionQueue(const std::string &_topic, const SubscriptionCallbackHelperPtr& helper);
+
   template<typename M>
   void publish(const std::string& topic, const M& message)
   {
     using namespace serialization;
 
     SerializedMessage m;
-    publish(topic, boost::bind(serializeMessage<M>, boost::ref(message)), m);
+    publish(topic, boost::bind(serializePooledMessage<M>, boost::ref(message)), m);
   }
 
   void publish(const std::string &_topic, const boost::function<SerializedMessage(void)>& serfunc, SerializedMessage& m);
@@ -218,16 +226,19 @@ private:
 
   bool isShuttingDown() { return shutting_down_; }
 
-  boost::mutex subs_mutex_;
+  threading::mutex subs_mutex_;
   L_Subscription subscriptions_;
 
-  boost::recursive_mutex advertised_topics_mutex_;
+  threading::recursive_mutex advertised_topics_mutex_;
   V_Publication advertised_topics_;
+  /// Copy of advertised_topics_ for processPublishQueues(), which only runs on the poll thread.  Kept as a member
+  /// so the copy reuses its storage.
+  V_Publication publish_queue_topics_;
   std::list<std::string> advertised_topic_names_;
-  boost::mutex advertised_topic_names_mutex_;
+  threading::mutex advertised_topic_names_mutex_;
 
   volatile bool shutting_down_;
-  boost::mutex shutting_down_mutex_;
+  threading::mutex shutting_down_mutex_;
 
   PollManagerPtr poll_manager_;
   ConnectionManagerPtr connection_manager_;
@@ -73,6 +73,23 @@ public:
    */
   virtual int32_t write(uint8_t* buffer, uint32_t size) = 0;
 
+  /**
+   * \brief One of the buffers passed to writev()
+   */
+  struct WriteBuffer
+  {
+    uint8_t* data;
+    uint32_t size;
+  };
+  /**
+   * \brief Write from several buffers, in order, with as few system calls as possible.  Not guaranteed to write
+   * all of them.  The default implementation calls write() for each buffer in turn, stopping at the first short write.
+   * \param buffers The buffers to write from
+   * \param count The number of buffers
+   * \return The total number of bytes actually written, or -1 if there was an error
+   */
+  virtual int32_t writev(const WriteBuffer* buffers, uint32_t count);
+
   /**
    * \brief Enable writing on this transport.  Allows derived classes to, for example, enable write polling for asynchronous sockets
    */
@@ -126,6 +143,12 @@ public:
    */
   virtual bool requiresHeader() {return true;}
 
+  /**
+   * \brief Returns whether the data read from this transport is a plain byte stream, so that it may be read ahead of
+   * what is asked for.  Transports with message boundaries return false.
+   */
+  virtual bool isStream() {return true;}
+
   /**
    * \brief Provides an opportunity for transport-specific options to come in through the header
    */
@@ -0,0 +1,184 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef ROSCPP_TRANSPORT_SHM_H
+#define ROSCPP_TRANSPORT_SHM_H
+
+#include <ros/types.h>
+#include <ros/transport/transport.h>
+#include <ros/transport/transport_tcp.h>
+
+#include "ros/threading.h"
+#include <ros/common.h>
+
+namespace ros
+{
+
+class TransportSHM;
+typedef boost::shared_ptr<TransportSHM> TransportSHMPtr;
+
+class PollSet;
+
+/**
+ * \brief SHMROS transport, for connections between processes on the same host
+ *
+ * Data is exchanged through a pair of single-producer/single-consumer byte rings in a POSIX
+ * shared memory segment, one for each direction.  The stream carried by the rings is identical
+ * to TCPROS (connection header, then length-prefixed messages), so Connection is unchanged.
+ *
+ * A TCP connection to the peer is kept alongside the segment.  It carries the segment name when
+ * the connection is set up, and afterwards single "doorbell" bytes, sent only when the peer is
+ * waiting for data (or for space in a full ring).  This lets the transport be driven by a PollSet
+ * like any other, and lets a disconnect be noticed by either side.
+ *
+ * The subscriber creates the segment (see connect()), the publisher attaches to it when the
+ * doorbell connection is accepted (see accept()) and then unlinks it.
+ */
+class ROSCPP_DECL TransportSHM : public Transport
+{
+public:
+  /// Default size of the publisher->subscriber ring, in bytes
+  static const uint32_t DEFAULT_RING_SIZE = 1 << 23;
+
+  /**
+   * \brief Returns whether shared memory transports are supported on this platform
+   */
+  static bool isAvailable();
+
+  /**
+   * \param poll_set The PollSet the doorbell connection is serviced by
+   * \param ring_size The size of the ring carrying data from the publisher to the subscriber.  Must be a power of two.
+   * Only used by the side which creates the segment.
+   */
+  TransportSHM(PollSet* poll_set, uint32_t ring_size = DEFAULT_RING_SIZE);
+  virtual ~TransportSHM();
+
+  /**
+   * \brief Create a new segment, and connect the doorbell to a publisher's SHMROS server port
+   * \param host The hostname/IP to connect to.  Must be this host.
+   * \param port The port to connect to
+   * \return Whether or not the connection was successful
+   */
+  bool connect(const std::string& host, int port);
+
+  /**
+   * \brief Take over a doorbell connection accepted on the SHMROS server port.  The segment name is
+   * read from it before any data can flow.
+   */
+  bool accept(const TransportTCPPtr& transport);
+
+  // overrides from Transport
+  virtual int32_t read(uint8_t* buffer, uint32_t size);
+  virtual int32_t write(uint8_t* buffer, uint32_t size);
+
+  virtual void enableWrite();
+  virtual void disableWrite();
+  virtual void enableRead();
+  virtual void disableRead();
+
+  virtual void close();
+
+  virtual std::string getTransportInfo();
+
+  virtual const char* getType() { return "SHMROS"; }
+
+  /// Control block of one direction of the segment, see transport_shm.cpp
+  struct Ring;
+
+private:
+
+  enum State
+  {
+    /// Client side: waiting for the doorbell connection to finish so the segment name can be sent
+    SendingSegmentName,
+    /// Server side: waiting for the segment name from the client
+    ReceivingSegmentName,
+    /// Segment mapped by both sides, data can flow
+    Active,
+  };
+
+  bool createSegment();
+  bool attachSegment(const std::string& name);
+  void unmapSegment();
+  void setupRings(bool is_client, uint32_t client_ring_size, uint32_t server_ring_size);
+
+  /**
+   * \brief Wake the peer up, if it is waiting on flag.  flag lives in shared memory.
+   */
+  void ringDoorbell(volatile uint32_t* flag);
+
+  /**
+   * \brief Called by the doorbell transport when it is readable, writable or has been disconnected
+   */
+  void onDoorbellReadable(const TransportPtr& transport);
+  void onDoorbellWritable(const TransportPtr& transport);
+  void onDoorbellDisconnect(const TransportPtr& transport);
+
+  void setDoorbellCallbacks();
+  void notifyActive();
+
+  TransportTCPPtr doorbell_;
+  PollSet* poll_set_;
+  uint32_t ring_size_;
+
+  State state_;
+  bool closed_;
+  threading::recursive_mutex close_mutex_;
+
+  bool expecting_read_;
+  bool expecting_write_;
+
+  std::string segment_name_;
+  uint8_t* segment_;
+  size_t segment_size_;
+
+  Ring* rx_;
+  uint8_t* rx_data_;
+  /// Ring sizes, checked against the mapping once when it is set up.  The copies in shared memory are never used again.
+  uint32_t rx_size_;
+  Ring* tx_;
+  uint8_t* tx_data_;
+  uint32_t tx_size_;
+
+  /// Length-prefixed segment name, while it is being sent or received over the doorbell connection
+  std::vector<uint8_t> name_buffer_;
+  uint32_t name_buffer_done_;
+
+  std::string cached_remote_host_;
+};
+
+}
+
+#endif // ROSCPP_TRANSPORT_SHM_H
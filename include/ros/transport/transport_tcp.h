@@ -38,7 +38,7 @@
 #include <ros/types.h>
 #include <ros/transport/transport.h>
 
-#include <boost/thread/recursive_mutex.hpp>
+#include "ros/threading.h"
 #include "ros/io.h"
 #include <ros/common.h>
 
@@ -58,6 +58,16 @@ class ROSCPP_DECL TransportTCP : public Transport
 public:
   static bool s_use_keepalive_;
   static bool s_use_ipv6_;
+  /**
+   * \brief Whether connections to publishers on this host go over unix domain sockets.  Defaults to true
+   * where they are supported, and can be turned off with ROSCPP_UNIX_SOCKETS=0
+   */
+  static bool s_use_unix_sockets_;
+
+  /**
+   * \brief Returns whether unix domain sockets are supported on this platform
+   */
+  static bool isUnixAvailable();
 
 public:
   enum Flags
@@ -75,6 +85,12 @@ public:
    * \return Whether or not the connection was successful
    */
   bool connect(const std::string& host, int port);
+  /**
+   * \brief Connect to a unix domain socket on this host.  The TCPROS stream is carried unchanged.
+   * \param path The filesystem path of the socket
+   * \return Whether or not the connection was successful
+   */
+  bool connectUnix(const std::string& path);
 
   /**
    * \brief Returns the URI of the remote host
@@ -89,6 +105,21 @@ public:
    * \param accept_cb The function to call when a client socket has connected
    */
   bool listen(int port, int backlog, const AcceptCallback& accept_cb);
+  /**
+   * \brief Start a unix domain server socket.  Any stale socket at path is removed first, and the
+   * socket is unlinked again when this transport is closed.
+   * \param path The filesystem path to bind to
+   * \param backlog Identical to the backlog parameter to the ::listen function
+   * \param accept_cb The function to call when a client socket has connected
+   */
+  bool listenUnix(const std::string& path, int backlog, const AcceptCallback& accept_cb);
+
+  typedef boost::function<PollSet*()> PollSetFunc;
+  /**
+   * \brief Set the function that picks the PollSet each accepted connection is serviced by.  If not set,
+   * accepted connections share this transport's PollSet.
+   */
+  void setAcceptPollSetFunc(const PollSetFunc& func) { accept_poll_set_func_ = func; }
   /**
    * \brief Accept a connection on a server socket.  Blocks until a connection is available
    */
@@ -104,10 +135,19 @@ public:
 
   const std::string& getConnectedHost() { return connected_host_; }
   int getConnectedPort() { return connected_port_; }
+  /**
+   * \brief Returns whether this transport is a unix domain socket rather than TCP/IP
+   */
+  bool isUnix() { return is_unix_; }
+  /**
+   * \brief Returns the path this transport is connected to or listening on, if it is a unix domain socket
+   */
+  const std::string& getUnixPath() { return unix_path_; }
 
   // overrides from Transport
   virtual int32_t read(uint8_t* buffer, uint32_t size);
   virtual int32_t write(uint8_t* buffer, uint32_t size);
+  virtual int32_t writev(const WriteBuffer* buffers, uint32_t count);
 
   virtual void enableWrite();
   virtual void disableWrite();
@@ -141,7 +181,7 @@ private:
 
   socket_fd_t sock_;
   bool closed_;
-  boost::recursive_mutex close_mutex_;
+  threading::recursive_mutex close_mutex_;
 
   bool expecting_read_;
   bool expecting_write_;
@@ -155,6 +195,7 @@ private:
   int server_port_;
   int local_port_;
   AcceptCallback accept_cb_;
+  PollSetFunc accept_poll_set_func_;
 
   std::string cached_remote_host_;
 
@@ -163,6 +204,9 @@ private:
 
   std::string connected_host_;
   int connected_port_;
+
+  bool is_unix_;
+  std::string unix_path_;
 };
 
 }
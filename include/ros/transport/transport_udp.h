@@ -38,10 +38,14 @@
 #include <ros/types.h>
 #include <ros/transport/transport.h>
 
-#include <boost/thread/mutex.hpp>
+#include "ros/threading.h"
 #include "ros/io.h"
 #include <ros/common.h>
 
+#include <boost/atomic.hpp>
+
+#include <vector>
+
 namespace ros
 {
 
@@ -105,6 +109,11 @@ public:
   // overrides from Transport
   virtual int32_t read(uint8_t* buffer, uint32_t size);
   virtual int32_t write(uint8_t* buffer, uint32_t size);
+  /**
+   * \brief Writes each buffer as a message of its own.  The fragments of all of them go to the kernel together,
+   * with sendmmsg() where it is available.
+   */
+  virtual int32_t writev(const WriteBuffer* buffers, uint32_t count);
 
   virtual void enableWrite();
   virtual void disableWrite();
@@ -117,10 +126,28 @@ public:
 
   virtual bool requiresHeader() {return false;}
 
+  virtual bool isStream() {return false;}
+
   virtual const char* getType() {return "UDPROS";}
 
   int getMaxDatagramSize() const {return max_datagram_size_;}
 
+  /**
+   * \brief Message, datagram and syscall counts for this transport.  Atomic, since they are updated by the threads
+   * reading and writing while being read from others.
+   */
+  class Stats
+  {
+  public:
+    /// messages_dropped counts messages only partly sent, because the socket stayed full
+    boost::atomic<uint64_t> messages_sent, messages_dropped, datagrams_sent, send_syscalls;
+    boost::atomic<uint64_t> messages_received, datagrams_received, recv_syscalls;
+    Stats()
+    : messages_sent(0), messages_dropped(0), datagrams_sent(0), send_syscalls(0)
+    , messages_received(0), datagrams_received(0), recv_syscalls(0) { }
+  };
+  const Stats& getStats() const { return stats_; }
+
 private:
   /**
    * \brief Initializes the assigned socket -- sets it to non-blocking and enables reading
@@ -134,11 +161,29 @@ private:
    */
   bool setSocket(int sock);
 
+  /**
+   * \brief Sends each buffer as a message, batching the fragments of all of them into as few sendmmsg() calls as
+   * possible.  Only defined where sendmmsg() is available.
+   */
+  int32_t sendMessages(const WriteBuffer* buffers, uint32_t count);
+  /**
+   * \brief Wait briefly for the socket to become writable again, so that the rest of a partly sent message can follow
+   * \return Whether it became writable
+   */
+  bool waitWritable();
+
   void socketUpdate(int events);
 
+  /**
+   * \brief Get the next datagram, from the last batch received if there are any left, or from
+   * a new batch otherwise.  Sets datagram_start_ and data_filled_ to its payload.
+   * \return The size of the datagram including its header, or -1 on error
+   */
+  int32_t receiveDatagram(TransportUDPHeader& header);
+
   socket_fd_t sock_;
   bool closed_;
-  boost::mutex close_mutex_;
+  threading::mutex close_mutex_;
 
   bool expecting_read_;
   bool expecting_write_;
@@ -164,11 +209,22 @@ private:
   uint8_t* data_buffer_;
   uint8_t* data_start_;
   uint32_t data_filled_;
+  // Start of the payload of the datagram data_start_ points into
+  uint8_t* datagram_start_;
 
   uint8_t* reorder_buffer_;
   uint8_t* reorder_start_;
   TransportUDPHeader reorder_header_;
   uint32_t reorder_bytes_;
+
+  // Datagrams received by the last recvmmsg(), consumed in order by receiveDatagram()
+  std::vector<uint8_t> recv_batch_buffer_;
+  std::vector<TransportUDPHeader> recv_batch_headers_;
+  std::vector<uint32_t> recv_batch_sizes_;
+  uint32_t recv_batch_count_;
+  uint32_t recv_batch_next_;
+
+  Stats stats_;
 };
 
 }
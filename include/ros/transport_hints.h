@@ -150,6 +150,16 @@ public:
     return *this;
   }
 
+  /**
+   * \brief Specifies the shared memory transport.  Only used when the publisher is on the same
+   * host; otherwise, or if the publisher doesn't support it, the connection falls back to TCP.
+   */
+  TransportHints& shm()
+  {
+    transports_.push_back("SHM");
+    return *this;
+  }
+
   /**
    * \brief Returns a vector of transports, ordered by preference
    */
@@ -29,6 +29,7 @@
 #define ROSCPP_TRANSPORT_SUBSCRIBER_LINK_H
 #include "common.h"
 #include "subscriber_link.h"
+#include "threading.h"
 
 #include <boost/signals2/connection.hpp>
 
@@ -69,7 +70,7 @@ private:
   boost::signals2::connection dropped_conn_;
 
   std::queue<SerializedMessage> outbox_;
-  boost::mutex outbox_mutex_;
+  threading::mutex outbox_mutex_;
   bool queue_full_;
 };
 typedef boost::shared_ptr<TransportSubscriberLink> TransportSubscriberLinkPtr;
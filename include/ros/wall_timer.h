@@ -31,6 +31,7 @@
 #include "common.h"
 #include "forwards.h"
 #include "wall_timer_options.h"
+#include "timer_statistics.h"
 
 namespace ros
 {
@@ -65,6 +66,17 @@ public:
    */
   bool hasPending();
 
+  /**
+   * \brief Returns the number of times this timer's callback finished after its deadline (see WallTimerOptions::deadline).
+   * Only counted when the callback queue schedules by deadline, like DeadlineCallbackQueue.
+   */
+  uint32_t getDeadlineMisses();
+
+  /**
+   * \brief Returns histograms of how late this timer has fired, and by how many periods
+   */
+  TimerStatistics getStatistics();
+
   /**
    * \brief Set the period of this timer
    * \param reset Whether to reset the timer. If true, timer ignores elapsed time and next cb occurs at now()+period
@@ -100,6 +112,8 @@ private:
 
     bool isValid();
     bool hasPending();
+    uint32_t getDeadlineMisses();
+    TimerStatistics getStatistics();
     void setPeriod(const WallDuration& period, bool reset=true);
 
     void start();
@@ -114,6 +128,14 @@ private:
     VoidConstWPtr tracked_object_;
     bool has_tracked_object_;
     bool oneshot_;
+    bool call_inline_;
+    int32_t priority_;
+    WallDuration deadline_;
+    /// Deadline misses from before the timer was last stopped
+    uint32_t deadline_misses_;
+    /// Statistics from before the timer was last stopped
+    TimerStatistics statistics_;
+    bool high_resolution_;
   };
   typedef boost::shared_ptr<Impl> ImplPtr;
   typedef boost::weak_ptr<Impl> ImplWPtr;
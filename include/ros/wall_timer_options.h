@@ -44,6 +44,9 @@ struct ROSCPP_DECL WallTimerOptions
   , callback_queue(0)
   , oneshot(false)
   , autostart(true)
+  , priority(0)
+  , high_resolution(false)
+  , call_inline(false)
   {
   }
 
@@ -58,6 +61,9 @@ struct ROSCPP_DECL WallTimerOptions
   , callback_queue(_queue)
   , oneshot(oneshot)
   , autostart(autostart)
+  , priority(0)
+  , high_resolution(false)
+  , call_inline(false)
   {}
 
   WallDuration period;                                              ///< The period to call the callback at
@@ -77,6 +83,25 @@ struct ROSCPP_DECL WallTimerOptions
 
   bool oneshot;
   bool autostart;
+
+  /// Priority of this timer's callbacks.  Queues which order callbacks by priority (see PriorityCallbackQueue)
+  /// call higher priorities first; other queues ignore it.  Defaults to 0.
+  int32_t priority;
+
+  /// How soon after the timer fires its callback should have finished.  Queues which schedule by deadline (see
+  /// DeadlineCallbackQueue) call the callback with the nearest deadline first, and count the callbacks which finish late;
+  /// other queues ignore it.  Defaults to zero, for no deadline.
+  WallDuration deadline;
+
+  /// Whether to fire this timer from a dedicated thread which sleeps on the monotonic clock with sub-millisecond
+  /// precision (see HighResolutionSleeper), rather than from the thread shared by all other wall-clock timers.
+  /// Linux only; elsewhere the timer is fired the normal way.  Defaults to false.
+  bool high_resolution;
+
+  /// Whether to call the callback directly from the timer thread (the dedicated one, with high_resolution) instead of adding it to callback_queue.  This avoids
+  /// the queueing delay and makes no allocations per tick, but the callback then holds up every other timer while it
+  /// runs, so it must be short and must not block.  Defaults to false.
+  bool call_inline;
 };
 
 
@@ -0,0 +1,156 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ROSCPP_WORK_STEALING_CALLBACK_QUEUE_H
+#define ROSCPP_WORK_STEALING_CALLBACK_QUEUE_H
+
+#include "ros/callback_queue.h"
+#include "common.h"
+
+#include <boost/atomic.hpp>
+#include <boost/shared_ptr.hpp>
+#include "ros/threading.h"
+#include <boost/thread/tss.hpp>
+
+#include <deque>
+#include <vector>
+
+namespace ros
+{
+
+/**
+ * \brief A CallbackQueue split into one local queue per spinner thread, where idle threads steal work from busy ones
+ *
+ * Each thread calling callOne()/callAvailable() is given one of the local queues the first time it does so (once there
+ * are more threads than local queues, they start sharing).  Callbacks are handed to the local queues as they are
+ * added: with affinity enabled, all callbacks with the same removal ID (eg. all messages for one subscription) go to the
+ * same local queue, so they tend to be run by the same thread, keeping that subscription's state warm in its cache.
+ * Callbacks without a removal ID are spread round-robin.  A thread whose local queue is empty takes callbacks from the
+ * back of the others'.
+ *
+ * Callbacks which return TryAgain are put back on the local queue they were added to.  A SubscriptionQueue which does not
+ * allow concurrent callbacks returns TryAgain when called while it is already being called, so such subscriptions are
+ * never called concurrently, even when their callbacks are stolen.
+ *
+ * To spin one of these with a thread per local queue:
+ * \verbatim
+ * ros::WorkStealingCallbackQueue queue(4);
+ * nh.setCallbackQueue(&queue);
+ * ros::AsyncSpinner spinner(4, &queue);
+ * spinner.start();
+ * \endverbatim
+ */
+class ROSCPP_DECL WorkStealingCallbackQueue : public CallbackQueue
+{
+public:
+  /**
+   * \param worker_count Number of local queues.  Should match the number of threads spinning this queue.
+   * \param affinity Whether callbacks with the same removal ID always go to the same local queue
+   * \param enabled Whether the queue starts enabled
+   */
+  WorkStealingCallbackQueue(uint32_t worker_count, bool affinity = true, bool enabled = true);
+  virtual ~WorkStealingCallbackQueue();
+
+  virtual void addCallback(const CallbackInterfacePtr& callback, uint64_t removal_id = 0);
+  virtual void removeByID(uint64_t removal_id);
+
+  using CallbackQueue::callOne;
+  using CallbackQueue::callAvailable;
+  virtual CallOneResult callOne(ros::WallDuration timeout);
+  virtual void callAvailable(ros::WallDuration timeout);
+
+  virtual bool isEmpty();
+  virtual void clear();
+
+  virtual void enable();
+  virtual void disable();
+  virtual bool isEnabled();
+
+  /**
+   * \brief Returns the number of callbacks run by a thread other than the one whose local queue they were added to
+   */
+  uint64_t getStolenCount() { return stolen_.load(); }
+
+private:
+  struct Worker
+  {
+    threading::mutex mutex;
+    D_CallbackInfo callbacks;
+  };
+  typedef boost::shared_ptr<Worker> WorkerPtr;
+
+  /**
+   * \brief Returns the index of the local queue of the calling thread, assigning one if it doesn't have one yet
+   */
+  uint32_t getWorkerIndex();
+  /**
+   * \brief Returns the local queue a callback with this removal ID should be added to
+   */
+  uint32_t pickWorker(uint64_t removal_id);
+  void push(uint32_t index, const CallbackInfo& info);
+
+  /**
+   * \brief Pop a callback off the front of the local queue index, or failing that, steal one off the back of another
+   */
+  bool pop(uint32_t index, CallbackInfo& info, uint32_t& from);
+
+  /**
+   * \brief Call a popped callback, unless its ID has been removed.  Callbacks which return TryAgain are put back.
+   */
+  CallOneResult call(const CallbackInfo& info, uint32_t from);
+
+  void wait(ros::WallDuration timeout);
+
+  std::vector<WorkerPtr> workers_;
+  bool affinity_;
+  boost::atomic<bool> is_enabled_;
+
+  /// Number of callbacks in all the local queues
+  boost::atomic<size_t> count_;
+  /// Number of callbacks currently being called
+  boost::atomic<size_t> calling_count_;
+  boost::atomic<uint64_t> stolen_;
+
+  boost::atomic<uint32_t> next_worker_;
+  boost::atomic<uint32_t> next_round_robin_;
+  boost::thread_specific_ptr<uint32_t> worker_index_;
+
+  /// Number of threads in wait(), which waits on condition_
+  boost::atomic<uint32_t> waiters_;
+};
+typedef boost::shared_ptr<WorkStealingCallbackQueue> WorkStealingCallbackQueuePtr;
+
+}
+
+#endif
@@ -31,8 +31,7 @@
 #include <string>
 #include <set>
 #include <boost/function.hpp>
-#include <boost/thread/mutex.hpp>
-#include <boost/thread/thread.hpp>
+#include "ros/threading.h"
 #include <boost/enable_shared_from_this.hpp>
 
 #include "common.h"
@@ -137,25 +136,25 @@ private:
 
   std::string uri_;
   int port_;
-  boost::thread server_thread_;
+  threading::thread server_thread_;
 
 #if defined(__APPLE__)
   // OSX has problems with lots of concurrent xmlrpc calls
-  boost::mutex xmlrpc_call_mutex_;
+  threading::mutex xmlrpc_call_mutex_;
 #endif
   XmlRpc::XmlRpcServer server_;
   typedef std::vector<CachedXmlRpcClient> V_CachedXmlRpcClient;
   V_CachedXmlRpcClient clients_;
-  boost::mutex clients_mutex_;
+  threading::mutex clients_mutex_;
 
   bool shutting_down_;
 
   ros::WallDuration master_retry_timeout_;
 
   S_ASyncXMLRPCConnection added_connections_;
-  boost::mutex added_connections_mutex_;
+  threading::mutex added_connections_mutex_;
   S_ASyncXMLRPCConnection removed_connections_;
-  boost::mutex removed_connections_mutex_;
+  threading::mutex removed_connections_mutex_;
 
   S_ASyncXMLRPCConnection connections_;
 
@@ -167,7 +166,7 @@ private:
     XMLRPCCallWrapperPtr wrapper;
   };
   typedef std::map<std::string, FunctionInfo> M_StringToFuncInfo;
-  boost::mutex functions_mutex_;
+  threading::mutex functions_mutex_;
   M_StringToFuncInfo functions_;
 
   volatile bool unbind_requested_;
@@ -3,7 +3,7 @@
 
 #include <boost/assert.hpp>
 #include <boost/throw_exception.hpp>
-#include <rtai_posix.h>
+#include "rtai_config.hpp"
 #include <boost/thread/cv_status.hpp>
 #include "rtai_mutex.hpp"
 #include <boost/thread/lock_types.hpp>
@@ -50,7 +50,12 @@ namespace rtai_thread
         condition_variable()
         {
 #if defined BOOST_THREAD_PROVIDES_INTERRUPTIONS
+            // waits block on internal_mutex rather than the caller's mutex, so it needs priority inheritance too
+#ifdef RTAI_THREAD_POSIX
+            int const res=posix::pthread_mutex_init_protocol(&internal_mutex,PTHREAD_MUTEX_NORMAL,PTHREAD_PRIO_INHERIT,0);
+#else
             int const res=pthread_mutex_init(&internal_mutex,NULL);
+#endif
             if(res)
             {
                 boost::throw_exception(boost::thread_resource_error(res, "rtai_thread::condition_variable::condition_variable() constructor failed in pthread_mutex_init"));
@@ -0,0 +1,32 @@
+#ifndef RTAI_CONFIG_HPP
+#define RTAI_CONFIG_HPP
+
+// Selects the pthread implementation rtai_thread is built on.
+//
+// By default the headers use RTAI's LXRT wrappers from rtai_posix.h, which return negated error codes.
+// Defining RTAI_THREAD_POSIX builds the same API on plain POSIX threads instead, so it can be used on
+// PREEMPT_RT kernels and built and tested on any Linux box.
+
+#include <errno.h>
+
+#ifdef RTAI_THREAD_POSIX
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE	// pthread_attr_setaffinity_np
+#endif
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+// pthread_mutex_trylock() result for a mutex held by someone else
+#define RTAI_THREAD_EBUSY EBUSY
+
+#else
+
+#include <rtai_posix.h>
+
+#define RTAI_THREAD_EBUSY (-EBUSY)	// 由于rtai_posix.h返回值为-EBUSY，这里修改了符号
+
+#endif
+
+#endif //RTAI_CONFIG_HPP
@@ -0,0 +1,486 @@
+#ifndef RTAI_FUTEX_SHARED_MUTEX_HPP
+#define RTAI_FUTEX_SHARED_MUTEX_HPP
+
+// Reader/writer lock on a Linux futex, used as rtai_thread::shared_mutex by the POSIX backend.
+//
+// Readers take and release the lock with a single atomic operation on state, and never touch a mutex.  Writers and
+// upgraders are serialized on gate, a priority inheriting rtai_thread::mutex.  A writer holding gate sets PENDING,
+// which stops new readers, then waits for the readers already in to leave, so writers wait at most for the longest
+// read-side critical section in progress rather than for a stream of new readers.
+
+#include "rtai_config.hpp"
+#include "rtai_mutex.hpp"
+#include "rtai_timespec.hpp"
+#include <boost/assert.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/thread_time.hpp>
+#ifdef BOOST_THREAD_USES_CHRONO
+#include <boost/chrono/system_clocks.hpp>
+#include <boost/chrono/ceil.hpp>
+#endif
+#include <boost/thread/detail/delete.hpp>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+
+#include <boost/config/abi_prefix.hpp>
+
+namespace rtai_thread
+{
+    class futex_shared_mutex
+    {
+    private:
+        // state: number of readers (an upgrader counts as one) in the low bits
+        static const boost::uint32_t READERS_MASK = 0x3fffffff;
+        // a writer holds gate, and new readers block until it unlocks
+        static const boost::uint32_t PENDING = 0x40000000;
+        // readers are sleeping on state, waiting for PENDING to clear
+        static const boost::uint32_t READERS_WAITING = 0x80000000;
+
+        volatile boost::uint32_t state;
+        // bumped by the last reader out while a writer is waiting for the readers to drain
+        volatile boost::uint32_t drained;
+        // held by the writer or the upgrader, if any
+        rtai_thread::mutex gate;
+
+        // abs_time is CLOCK_REALTIME, NULL waits forever.  Returns false on timeout.
+        static bool futex_wait(volatile boost::uint32_t* addr, boost::uint32_t val, const timespec* abs_time)
+        {
+            long const res = syscall(SYS_futex, addr, FUTEX_WAIT_BITSET_PRIVATE | FUTEX_CLOCK_REALTIME, val, abs_time,
+                                     NULL, FUTEX_BITSET_MATCH_ANY);
+            return !(res == -1 && errno == ETIMEDOUT);
+        }
+
+        static void futex_wake(volatile boost::uint32_t* addr, int count)
+        {
+            syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+        }
+
+        bool lock_gate(const timespec* abs_time)
+        {
+            if (!abs_time)
+            {
+                gate.lock();
+                return true;
+            }
+            int res;
+            do
+            {
+                res = pthread_mutex_timedlock(gate.native_handle(), abs_time);
+            } while (res == EINTR);
+            if (res && res != ETIMEDOUT)
+            {
+                boost::throw_exception(boost::lock_error(res, "rtai_thread::futex_shared_mutex lock failed in pthread_mutex_timedlock"));
+            }
+            return !res;
+        }
+
+        bool lock_shared_until(const timespec* abs_time)
+        {
+            boost::uint32_t s = state;
+            for (;;)
+            {
+                if (!(s & PENDING))
+                {
+                    boost::uint32_t const prev = __sync_val_compare_and_swap(&state, s, s + 1);
+                    if (prev == s)
+                    {
+                        return true;
+                    }
+                    s = prev;
+                    continue;
+                }
+
+                if (!(s & READERS_WAITING))
+                {
+                    boost::uint32_t const prev = __sync_val_compare_and_swap(&state, s, s | READERS_WAITING);
+                    if (prev != s)
+                    {
+                        s = prev;
+                        continue;
+                    }
+                    s |= READERS_WAITING;
+                }
+                // Returns straight away if state has changed since we read it, ie. if the writer has already left
+                if (!futex_wait(&state, s, abs_time))
+                {
+                    return false;
+                }
+                s = state;
+            }
+        }
+
+        // Called holding gate, with PENDING set.  Returns false on timeout, with PENDING still set.
+        bool wait_for_readers(const timespec* abs_time)
+        {
+            for (;;)
+            {
+                boost::uint32_t const seq = drained;
+                if (!(__sync_fetch_and_add(&state, 0) & READERS_MASK))
+                {
+                    return true;
+                }
+                if (!futex_wait(&drained, seq, abs_time))
+                {
+                    return (__sync_fetch_and_add(&state, 0) & READERS_MASK) == 0;
+                }
+            }
+        }
+
+        // Clears PENDING, letting readers back in
+        void release_readers()
+        {
+            boost::uint32_t const prev = __sync_fetch_and_and(&state, ~(PENDING | READERS_WAITING));
+            if (prev & READERS_WAITING)
+            {
+                futex_wake(&state, INT_MAX);
+            }
+        }
+
+        bool lock_until(const timespec* abs_time)
+        {
+            if (!lock_gate(abs_time))
+            {
+                return false;
+            }
+            __sync_fetch_and_or(&state, PENDING);
+            if (!wait_for_readers(abs_time))
+            {
+                release_readers();
+                gate.unlock();
+                return false;
+            }
+            return true;
+        }
+
+        bool lock_upgrade_until(const timespec* abs_time)
+        {
+            if (!lock_gate(abs_time))
+            {
+                return false;
+            }
+            // No writer can be in, it would be holding gate
+            __sync_fetch_and_add(&state, 1);
+            return true;
+        }
+
+        // Called holding gate and one read lock, which this turns into the write lock
+        bool unlock_shared_and_lock_until(const timespec* abs_time)
+        {
+            __sync_fetch_and_or(&state, PENDING);
+            __sync_fetch_and_sub(&state, 1);
+            if (!wait_for_readers(abs_time))
+            {
+                __sync_fetch_and_add(&state, 1);
+                release_readers();
+                return false;
+            }
+            return true;
+        }
+
+#ifdef BOOST_THREAD_USES_CHRONO
+        template <class Clock, class Duration>
+        static timespec to_realtime(const boost::chrono::time_point<Clock, Duration>& abs_time)
+        {
+            using namespace boost::chrono;
+            system_clock::time_point const s_abs = system_clock::now() + ceil<nanoseconds>(abs_time - Clock::now());
+            return boost::detail::to_timespec(duration_cast<nanoseconds>(s_abs.time_since_epoch()));
+        }
+#endif
+
+    public:
+        BOOST_THREAD_NO_COPYABLE(futex_shared_mutex)
+
+        futex_shared_mutex() :
+          state(0),
+          drained(0)
+        {
+        }
+
+        ~futex_shared_mutex()
+        {
+            BOOST_ASSERT(state == 0);
+        }
+
+        // shared ownership
+
+        void lock_shared()
+        {
+            lock_shared_until(0);
+        }
+
+        bool try_lock_shared()
+        {
+            boost::uint32_t s = state;
+            while (!(s & PENDING))
+            {
+                boost::uint32_t const prev = __sync_val_compare_and_swap(&state, s, s + 1);
+                if (prev == s)
+                {
+                    return true;
+                }
+                s = prev;
+            }
+            return false;
+        }
+
+        void unlock_shared()
+        {
+            boost::uint32_t const prev = __sync_fetch_and_sub(&state, 1);
+            BOOST_ASSERT(prev & READERS_MASK);
+            if ((prev & PENDING) && (prev & READERS_MASK) == 1)
+            {
+                // last reader out, the writer can go ahead
+                __sync_fetch_and_add(&drained, 1);
+                futex_wake(&drained, 1);
+            }
+        }
+
+#if defined BOOST_THREAD_USES_DATETIME
+        bool timed_lock_shared(boost::system_time const& timeout)
+        {
+            timespec const ts = boost::detail::to_timespec(timeout);
+            return lock_shared_until(&ts);
+        }
+
+        template<typename TimeDuration>
+        bool timed_lock_shared(TimeDuration const & relative_time)
+        {
+            return timed_lock_shared(boost::get_system_time()+relative_time);
+        }
+#endif
+#ifdef BOOST_THREAD_USES_CHRONO
+        template <class Rep, class Period>
+        bool try_lock_shared_for(const boost::chrono::duration<Rep, Period>& rel_time)
+        {
+            return try_lock_shared_until(boost::chrono::steady_clock::now() + rel_time);
+        }
+
+        template <class Clock, class Duration>
+        bool try_lock_shared_until(const boost::chrono::time_point<Clock, Duration>& abs_time)
+        {
+            timespec const ts = to_realtime(abs_time);
+            return lock_shared_until(&ts);
+        }
+#endif
+
+        // exclusive ownership
+
+        void lock()
+        {
+            lock_until(0);
+        }
+
+        bool try_lock()
+        {
+            if (!gate.try_lock())
+            {
+                return false;
+            }
+            if (__sync_val_compare_and_swap(&state, 0, PENDING) != 0)
+            {
+                gate.unlock();
+                return false;
+            }
+            return true;
+        }
+
+        void unlock()
+        {
+            BOOST_ASSERT((state & (PENDING | READERS_MASK)) == PENDING);
+            release_readers();
+            gate.unlock();
+        }
+
+#if defined BOOST_THREAD_USES_DATETIME
+        bool timed_lock(boost::system_time const& timeout)
+        {
+            timespec const ts = boost::detail::to_timespec(timeout);
+            return lock_until(&ts);
+        }
+
+        template<typename TimeDuration>
+        bool timed_lock(TimeDuration const & relative_time)
+        {
+            return timed_lock(boost::get_system_time()+relative_time);
+        }
+#endif
+#ifdef BOOST_THREAD_USES_CHRONO
+        template <class Rep, class Period>
+        bool try_lock_for(const boost::chrono::duration<Rep, Period>& rel_time)
+        {
+            return try_lock_until(boost::chrono::steady_clock::now() + rel_time);
+        }
+
+        template <class Clock, class Duration>
+        bool try_lock_until(const boost::chrono::time_point<Clock, Duration>& abs_time)
+        {
+            timespec const ts = to_realtime(abs_time);
+            return lock_until(&ts);
+        }
+#endif
+
+        // upgrade ownership: shared with readers, exclusive against writers and other upgraders
+
+        void lock_upgrade()
+        {
+            lock_upgrade_until(0);
+        }
+
+        bool try_lock_upgrade()
+        {
+            if (!gate.try_lock())
+            {
+                return false;
+            }
+            __sync_fetch_and_add(&state, 1);
+            return true;
+        }
+
+        void unlock_upgrade()
+        {
+            boost::uint32_t const prev = __sync_fetch_and_sub(&state, 1);
+            BOOST_ASSERT(!(prev & PENDING) && (prev & READERS_MASK));
+            boost::ignore_unused(prev);
+            gate.unlock();
+        }
+
+#if defined BOOST_THREAD_USES_DATETIME
+        bool timed_lock_upgrade(boost::system_time const& timeout)
+        {
+            timespec const ts = boost::detail::to_timespec(timeout);
+            return lock_upgrade_until(&ts);
+        }
+
+        template<typename TimeDuration>
+        bool timed_lock_upgrade(TimeDuration const & relative_time)
+        {
+            return timed_lock_upgrade(boost::get_system_time()+relative_time);
+        }
+#endif
+#ifdef BOOST_THREAD_USES_CHRONO
+        template <class Rep, class Period>
+        bool try_lock_upgrade_for(const boost::chrono::duration<Rep, Period>& rel_time)
+        {
+            return try_lock_upgrade_until(boost::chrono::steady_clock::now() + rel_time);
+        }
+
+        template <class Clock, class Duration>
+        bool try_lock_upgrade_until(const boost::chrono::time_point<Clock, Duration>& abs_time)
+        {
+            timespec const ts = to_realtime(abs_time);
+            return lock_upgrade_until(&ts);
+        }
+#endif
+
+        // conversions
+
+        void unlock_upgrade_and_lock()
+        {
+            unlock_shared_and_lock_until(0);
+        }
+
+        bool try_unlock_upgrade_and_lock()
+        {
+            // only if we are the last reader
+            return __sync_bool_compare_and_swap(&state, 1, PENDING);
+        }
+
+#ifdef BOOST_THREAD_USES_CHRONO
+        template <class Rep, class Period>
+        bool try_unlock_upgrade_and_lock_for(const boost::chrono::duration<Rep, Period>& rel_time)
+        {
+            return try_unlock_upgrade_and_lock_until(boost::chrono::steady_clock::now() + rel_time);
+        }
+
+        template <class Clock, class Duration>
+        bool try_unlock_upgrade_and_lock_until(const boost::chrono::time_point<Clock, Duration>& abs_time)
+        {
+            timespec const ts = to_realtime(abs_time);
+            return unlock_shared_and_lock_until(&ts);
+        }
+#endif
+
+        void unlock_and_lock_upgrade()
+        {
+            __sync_fetch_and_add(&state, 1);
+            release_readers();
+        }
+
+        void unlock_and_lock_shared()
+        {
+            __sync_fetch_and_add(&state, 1);
+            release_readers();
+            gate.unlock();
+        }
+
+        void unlock_upgrade_and_lock_shared()
+        {
+            gate.unlock();
+        }
+
+#ifdef BOOST_THREAD_PROVIDES_SHARED_MUTEX_UPWARDS_CONVERSIONS
+        bool try_unlock_shared_and_lock()
+        {
+            if (!gate.try_lock())
+            {
+                return false;
+            }
+            if (!__sync_bool_compare_and_swap(&state, 1, PENDING))
+            {
+                gate.unlock();
+                return false;
+            }
+            return true;
+        }
+
+        bool try_unlock_shared_and_lock_upgrade()
+        {
+            return gate.try_lock();
+        }
+
+#ifdef BOOST_THREAD_USES_CHRONO
+        template <class Rep, class Period>
+        bool try_unlock_shared_and_lock_for(const boost::chrono::duration<Rep, Period>& rel_time)
+        {
+            return try_unlock_shared_and_lock_until(boost::chrono::steady_clock::now() + rel_time);
+        }
+
+        template <class Clock, class Duration>
+        bool try_unlock_shared_and_lock_until(const boost::chrono::time_point<Clock, Duration>& abs_time)
+        {
+            timespec const ts = to_realtime(abs_time);
+            if (!lock_gate(&ts))
+            {
+                return false;
+            }
+            if (!unlock_shared_and_lock_until(&ts))
+            {
+                gate.unlock();
+                return false;
+            }
+            return true;
+        }
+
+        template <class Rep, class Period>
+        bool try_unlock_shared_and_lock_upgrade_for(const boost::chrono::duration<Rep, Period>& rel_time)
+        {
+            return try_unlock_shared_and_lock_upgrade_until(boost::chrono::steady_clock::now() + rel_time);
+        }
+
+        template <class Clock, class Duration>
+        bool try_unlock_shared_and_lock_upgrade_until(const boost::chrono::time_point<Clock, Duration>& abs_time)
+        {
+            timespec const ts = to_realtime(abs_time);
+            return lock_gate(&ts);
+        }
+#endif
+#endif
+    };
+}
+
+#include <boost/config/abi_suffix.hpp>
+
+#endif //RTAI_FUTEX_SHARED_MUTEX_HPP
@@ -1,7 +1,7 @@
 #ifndef RTAI_MUTEX_HPP
 #define RTAI_MUTEX_HPP
 
-#include "rtai_posix.h"
+#include "rtai_config.hpp"
 #include "rtai_pthread_mutex_scoped_lock.hpp"
 #include <boost/thread/detail/config.hpp>
 #include <boost/assert.hpp>
@@ -15,6 +15,9 @@
 #include <boost/thread/thread_time.hpp>
 #include <boost/thread/xtime.hpp>
 #include <errno.h>
+#include <sched.h>
+#include <climits>
+#include <cstdio>
 #include "rtai_timespec.hpp"
 #ifdef BOOST_THREAD_USES_CHRONO
 #include <boost/chrono/system_clocks.hpp>
@@ -36,10 +39,16 @@
 #define BOOST_THREAD_HAS_EINTR_BUG
 #endif
 
+#if defined RTAI_THREAD_POSIX || defined BOOST_THREAD_HAS_PTHREAD_MUTEXATTR_SETTYPE
+#define RTAI_THREAD_HAS_MUTEXATTR_SETTYPE
+#endif
+
 namespace rtai_thread
 {
 
+#ifndef RTAI_THREAD_POSIX
 #define __KERNEL__	// use rtai_posix pthread functions
+#endif
 
   namespace posix {
 #ifdef BOOST_THREAD_HAS_EINTR_BUG
@@ -86,23 +95,139 @@ namespace rtai_thread
 
 #endif
 
+#ifdef RTAI_THREAD_POSIX
+    // Initializes a mutex of the given type and priority protocol, see mutex_protocol
+    inline int pthread_mutex_init_protocol(pthread_mutex_t* m, int type, int protocol, int ceiling)
+    {
+      pthread_mutexattr_t attr;
+      int res = pthread_mutexattr_init(&attr);
+      if (res)
+      {
+        return res;
+      }
+      res = pthread_mutexattr_settype(&attr, type);
+      if (!res)
+      {
+        res = pthread_mutexattr_setprotocol(&attr, protocol);
+      }
+      if (!res && protocol == PTHREAD_PRIO_PROTECT)
+      {
+        res = pthread_mutexattr_setprioceiling(&attr, ceiling);
+      }
+      if (!res)
+      {
+        res = ::pthread_mutex_init(m, &attr);
+      }
+      BOOST_VERIFY(!pthread_mutexattr_destroy(&attr));
+      return res;
+    }
+#endif
+
+  }
+
+  // How a mutex deals with priority inversion, when a low priority thread holds a mutex a high priority one wants.
+  // Only the POSIX backend uses it: RTAI's mutexes are resource semaphores, which always inherit priority.
+  enum mutex_protocol
+  {
+    mutex_protocol_none,    // PTHREAD_PRIO_NONE: the holder keeps its own priority
+    mutex_protocol_inherit, // PTHREAD_PRIO_INHERIT: the holder runs at the priority of the highest waiter
+    mutex_protocol_protect  // PTHREAD_PRIO_PROTECT: the holder runs at the mutex's ceiling priority
+  };
+
+  namespace posix {
+#ifdef RTAI_THREAD_POSIX
+    inline int to_pthread_protocol(mutex_protocol protocol)
+    {
+      switch (protocol)
+      {
+      case mutex_protocol_inherit:
+        return PTHREAD_PRIO_INHERIT;
+      case mutex_protocol_protect:
+        return PTHREAD_PRIO_PROTECT;
+      default:
+        return PTHREAD_PRIO_NONE;
+      }
+    }
+#endif
+
+    // Passed as the ceiling by constructors which don't take one
+    const int no_ceiling = INT_MIN;
+
+    // mutex_protocol_protect has no sensible default ceiling: pthreads would take anything outside the SCHED_FIFO
+    // range, 0 included, and only fail when the mutex is locked.  So it must be given one, in that range.
+    inline void check_ceiling(mutex_protocol protocol, int ceiling, const char* what)
+    {
+#ifdef RTAI_THREAD_POSIX
+      if (protocol != mutex_protocol_protect)
+      {
+        return;
+      }
+
+      int const min = sched_get_priority_min(SCHED_FIFO);
+      int const max = sched_get_priority_max(SCHED_FIFO);
+      if (ceiling >= min && ceiling <= max)
+      {
+        return;
+      }
+
+      char msg[160];
+      if (ceiling == no_ceiling)
+      {
+        snprintf(msg, sizeof(msg), "rtai_thread:: %s failed: mutex_protocol_protect needs a priority ceiling", what);
+      }
+      else
+      {
+        snprintf(msg, sizeof(msg), "rtai_thread:: %s failed: priority ceiling %d is outside the SCHED_FIFO range %d to %d",
+                 what, ceiling, min, max);
+      }
+      boost::throw_exception(boost::thread_resource_error(EINVAL, msg));
+#else
+      boost::ignore_unused(protocol, ceiling, what);
+#endif
+    }
   }
 
 	class mutex
 	{
 	private:
 		pthread_mutex_t m;
-	public:
-		BOOST_THREAD_NO_COPYABLE(mutex)
 
-		mutex()
-        {
+		void init(mutex_protocol protocol, int ceiling)
+		{
+            posix::check_ceiling(protocol, ceiling, "mutex constructor");
+#ifdef RTAI_THREAD_POSIX
+            int const res=posix::pthread_mutex_init_protocol(&m,PTHREAD_MUTEX_NORMAL,posix::to_pthread_protocol(protocol),ceiling);
+#else
+            boost::ignore_unused(protocol, ceiling);
             int const res=pthread_mutex_init(&m,NULL);
+#endif
             if(res)
             {
                 boost::throw_exception(boost::thread_resource_error(res, "rtai_thread:: mutex constructor failed in pthread_mutex_init_rt"));
             }
+		}
+	public:
+		BOOST_THREAD_NO_COPYABLE(mutex)
+
+		// Priority inheriting, so a real-time thread blocking on it boosts the holder instead of waiting behind
+		// whatever medium priority thread preempted it.
+		mutex()
+        {
+            init(mutex_protocol_inherit, 0);
         }
+
+		// Throws for mutex_protocol_protect, which needs a ceiling
+		explicit mutex(mutex_protocol protocol)
+		{
+            init(protocol, posix::no_ceiling);
+		}
+
+		// ceiling is the priority the holder runs at with mutex_protocol_protect, which has to be in the SCHED_FIFO
+		// range.  Ignored for the other protocols.
+		mutex(mutex_protocol protocol, int ceiling)
+		{
+            init(protocol, ceiling);
+		}
 		~mutex()
 		{
 			int const res = posix::pthread_mutex_destroy(&m);
@@ -131,7 +256,7 @@ namespace rtai_thread
             {
                 res = pthread_mutex_trylock(&m);
             } while (res == EINTR);
-            if (res== -EBUSY)	// 由于rtat_posix.h返回值为-EBUSY，这里修改了符号
+            if (res== RTAI_THREAD_EBUSY)
             {
                 return false;
             }
@@ -139,17 +264,45 @@ namespace rtai_thread
             return !res;
         }
 
+#define BOOST_THREAD_DEFINES_MUTEX_NATIVE_HANDLE
+        typedef pthread_mutex_t* native_handle_type;
+        native_handle_type native_handle()
+        {
+            return &m;
+        }
+
         typedef boost::unique_lock<mutex> scoped_lock;
         typedef boost::detail::try_lock_wrapper<mutex> scoped_try_lock;
 	};
 
 	typedef mutex try_mutex;
+
+	// A mutex that always inherits priority, whatever mutex() defaults to.  Lock it through pi_mutex::scoped_lock,
+	// which is a boost::unique_lock<mutex>, to wait on a condition_variable with it.
+	class pi_mutex : public mutex
+	{
+	public:
+		pi_mutex() : mutex(mutex_protocol_inherit)
+		{
+		}
+	};
+
+	// A priority ceiling mutex: whoever holds it runs at ceiling priority, so it can never be preempted by a thread
+	// that might want the mutex.  ceiling has to be at least the highest priority of any thread locking it, in the
+	// SCHED_FIFO range.  Lock it through ceiling_mutex::scoped_lock to wait on a condition_variable with it.
+	class ceiling_mutex : public mutex
+	{
+	public:
+		explicit ceiling_mutex(int ceiling) : mutex(mutex_protocol_protect, ceiling)
+		{
+		}
+	};
 	
 	class recursive_mutex
     {
     private:
         pthread_mutex_t m;
-#ifndef BOOST_THREAD_HAS_PTHREAD_MUTEXATTR_SETTYPE
+#ifndef RTAI_THREAD_HAS_MUTEXATTR_SETTYPE
         pthread_cond_t cond;
         bool is_locked;
         pthread_t owner;
@@ -157,28 +310,39 @@ namespace rtai_thread
 #endif
     public:
         BOOST_THREAD_NO_COPYABLE(recursive_mutex)
-        recursive_mutex()
+        // protocol and ceiling as for mutex
+        explicit recursive_mutex(mutex_protocol protocol = mutex_protocol_inherit, int ceiling = posix::no_ceiling)
         {
-#ifdef BOOST_THREAD_HAS_PTHREAD_MUTEXATTR_SETTYPE
+            posix::check_ceiling(protocol, ceiling, "recursive_mutex constructor");
+#ifndef RTAI_THREAD_POSIX
+            boost::ignore_unused(protocol, ceiling);
+#endif
+#if defined RTAI_THREAD_POSIX
+            int const res=posix::pthread_mutex_init_protocol(&m,PTHREAD_MUTEX_RECURSIVE,posix::to_pthread_protocol(protocol),ceiling);
+            if(res)
+            {
+                boost::throw_exception(boost::thread_resource_error(res, "rtai_thread:: recursive_mutex constructor failed in pthread_mutex_init"));
+            }
+#elif defined RTAI_THREAD_HAS_MUTEXATTR_SETTYPE
             pthread_mutexattr_t attr;
 
             int const init_attr_res=pthread_mutexattr_init(&attr);
             if(init_attr_res)
             {
-                boost::throw_exception(thread_resource_error(init_attr_res, "rtai_thread:: recursive_mutex constructor failed in pthread_mutexattr_init"));
+                boost::throw_exception(boost::thread_resource_error(init_attr_res, "rtai_thread:: recursive_mutex constructor failed in pthread_mutexattr_init"));
             }
             int const set_attr_res=pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
             if(set_attr_res)
             {
                 BOOST_VERIFY(!pthread_mutexattr_destroy(&attr));
-                boost::throw_exception(thread_resource_error(set_attr_res, "rtai_thread:: recursive_mutex constructor failed in pthread_mutexattr_settype"));
+                boost::throw_exception(boost::thread_resource_error(set_attr_res, "rtai_thread:: recursive_mutex constructor failed in pthread_mutexattr_settype"));
             }
 
             int const res=pthread_mutex_init(&m,&attr);
             if(res)
             {
                 BOOST_VERIFY(!pthread_mutexattr_destroy(&attr));
-                boost::throw_exception(thread_resource_error(res, "rtai_thread:: recursive_mutex constructor failed in pthread_mutex_init"));
+                boost::throw_exception(boost::thread_resource_error(res, "rtai_thread:: recursive_mutex constructor failed in pthread_mutex_init"));
             }
             BOOST_VERIFY(!pthread_mutexattr_destroy(&attr));
 #else
@@ -200,12 +364,12 @@ namespace rtai_thread
         ~recursive_mutex()
         {
             BOOST_VERIFY(!pthread_mutex_destroy(&m));
-#ifndef BOOST_THREAD_HAS_PTHREAD_MUTEXATTR_SETTYPE
+#ifndef RTAI_THREAD_HAS_MUTEXATTR_SETTYPE
             BOOST_VERIFY(!pthread_cond_destroy(&cond));
 #endif
         }
 
-#ifdef BOOST_THREAD_HAS_PTHREAD_MUTEXATTR_SETTYPE
+#ifdef RTAI_THREAD_HAS_MUTEXATTR_SETTYPE
         void lock()
         {
             BOOST_VERIFY(!pthread_mutex_lock(&m));
@@ -219,7 +383,7 @@ namespace rtai_thread
         bool try_lock() BOOST_NOEXCEPT
         {
             int const res=pthread_mutex_trylock(&m);
-            BOOST_ASSERT(!res || res== -EBUSY);	// 由于rtat_posix.h返回值为-EBUSY，这里修改了符号
+            BOOST_ASSERT(!res || res== RTAI_THREAD_EBUSY);
             return !res;
         }
 #define BOOST_THREAD_DEFINES_RECURSIVE_MUTEX_NATIVE_HANDLE
@@ -1,7 +1,7 @@
 #ifndef RTAI_PTHREAD_MUTEX_SCOPED_LOCK_HPP
 #define RTAI_PTHREAD_MUTEX_SCOPED_LOCK_HPP
 
-#include <rtai_posix.h>
+#include "rtai_config.hpp"
 #include <boost/assert.hpp>
 #include <boost/config/abi_prefix.hpp>
 
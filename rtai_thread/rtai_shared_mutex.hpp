@@ -1,6 +1,7 @@
 #ifndef RTAI_THREAD_SHARED_MUTEX_HPP
 #define RTAI_THREAD_SHARED_MUTEX_HPP
 
+#include "rtai_config.hpp"
 
 #include <boost/assert.hpp>
 #include <boost/static_assert.hpp>
@@ -21,7 +22,9 @@
 namespace rtai_thread
 {
     using boost::cv_status;
-    class shared_mutex
+    // Reader/writer lock on a mutex and three condition variables, after boost::shared_mutex.  shared_mutex with the
+    // RTAI backend; the POSIX backend keeps it to compare futex_shared_mutex against.
+    class cv_shared_mutex
     {
     private:
         class state_data
@@ -165,13 +168,13 @@ namespace rtai_thread
 
     public:
 
-        BOOST_THREAD_NO_COPYABLE(shared_mutex)
+        BOOST_THREAD_NO_COPYABLE(cv_shared_mutex)
 
-        shared_mutex()
+        cv_shared_mutex()
         {
         }
 
-        ~shared_mutex()
+        ~cv_shared_mutex()
         {
         }
 
@@ -600,15 +603,15 @@ namespace rtai_thread
         template <class Rep, class Period>
             bool
             try_unlock_shared_and_lock_for(
-                                const chrono::duration<Rep, Period>& rel_time)
+                                const boost::chrono::duration<Rep, Period>& rel_time)
         {
           return try_unlock_shared_and_lock_until(
-                                 chrono::steady_clock::now() + rel_time);
+                                 boost::chrono::steady_clock::now() + rel_time);
         }
         template <class Clock, class Duration>
             bool
             try_unlock_shared_and_lock_until(
-                          const chrono::time_point<Clock, Duration>& abs_time)
+                          const boost::chrono::time_point<Clock, Duration>& abs_time)
         {
 #if defined BOOST_THREAD_PROVIDES_INTERRUPTIONS
           boost::this_thread::disable_interruption do_not_disturb;
@@ -664,15 +667,15 @@ namespace rtai_thread
         template <class Rep, class Period>
             bool
             try_unlock_shared_and_lock_upgrade_for(
-                                const chrono::duration<Rep, Period>& rel_time)
+                                const boost::chrono::duration<Rep, Period>& rel_time)
         {
           return try_unlock_shared_and_lock_upgrade_until(
-                                 chrono::steady_clock::now() + rel_time);
+                                 boost::chrono::steady_clock::now() + rel_time);
         }
         template <class Clock, class Duration>
             bool
             try_unlock_shared_and_lock_upgrade_until(
-                          const chrono::time_point<Clock, Duration>& abs_time)
+                          const boost::chrono::time_point<Clock, Duration>& abs_time)
         {
 #if defined BOOST_THREAD_PROVIDES_INTERRUPTIONS
           boost::this_thread::disable_interruption do_not_disturb;
@@ -702,10 +705,29 @@ namespace rtai_thread
 #endif
 #endif
     };
+}
+
+#include <boost/config/abi_suffix.hpp>
+
+#ifdef RTAI_THREAD_POSIX
 
+// Readers only do an atomic operation, and writers can't be starved by them, see rtai_futex_shared_mutex.hpp
+#include "rtai_futex_shared_mutex.hpp"
+
+namespace rtai_thread
+{
+    typedef futex_shared_mutex shared_mutex;
     typedef shared_mutex upgrade_mutex;
 }
 
-#include <boost/config/abi_suffix.hpp>
+#else
+
+namespace rtai_thread
+{
+    typedef cv_shared_mutex shared_mutex;
+    typedef shared_mutex upgrade_mutex;
+}
+
+#endif // RTAI_THREAD_POSIX
 
 #endif
@@ -0,0 +1,485 @@
+// Out of line parts of rtai_thread::thread, following Boost.Thread's src/pthread/thread.cpp.
+// Build this file with the same RTAI_THREAD_POSIX setting as the code including rtai_thread.h.
+
+#include "rtai_thread.h"
+
+#include <boost/thread/once.hpp>
+
+#include <alloca.h>
+
+namespace rtai_thread
+{
+    namespace detail
+    {
+        struct thread_exit_callback_node
+        {
+            thread_exit_function_base* func;
+            thread_exit_callback_node* next;
+
+            thread_exit_callback_node(thread_exit_function_base* func_,
+                                      thread_exit_callback_node* next_):
+                func(func_),next(next_)
+            {}
+        };
+
+        thread_data_base::~thread_data_base()
+        {
+            for (notify_list_t::iterator i = notify.begin(), e = notify.end();
+                    i != e; ++i)
+            {
+                i->second->unlock();
+                i->first->notify_all();
+            }
+        }
+
+        namespace
+        {
+            boost::once_flag current_thread_tls_init_flag=BOOST_ONCE_INIT;
+            pthread_key_t current_thread_tls_key;
+
+            extern "C"
+            {
+                static void tls_destructor(void* data)
+                {
+                    thread_data_base* const thread_info=static_cast<thread_data_base*>(data);
+                    if(thread_info)
+                    {
+                        while(thread_info->thread_exit_callbacks)
+                        {
+                            thread_exit_callback_node* const current_node=thread_info->thread_exit_callbacks;
+                            thread_info->thread_exit_callbacks=current_node->next;
+                            if(current_node->func)
+                            {
+                                (*current_node->func)();
+                                boost::detail::heap_delete(current_node->func);
+                            }
+                            boost::detail::heap_delete(current_node);
+                        }
+                        thread_info->tss_data.clear();
+                        thread_info->self.reset();
+                    }
+                }
+            }
+
+            void create_current_thread_tls_key()
+            {
+                BOOST_VERIFY(!pthread_key_create(&current_thread_tls_key,&tls_destructor));
+            }
+
+            void set_current_thread_data(thread_data_base* new_data)
+            {
+                boost::call_once(current_thread_tls_init_flag,create_current_thread_tls_key);
+                BOOST_VERIFY(!pthread_setspecific(current_thread_tls_key,new_data));
+            }
+
+            // Touches size bytes below the current stack frame, a page at a time, so the kernel maps those pages
+            // now.  With mlockall(MCL_FUTURE) in effect they also stay resident.
+            BOOST_NOINLINE void prefault_stack(std::size_t size)
+            {
+                volatile unsigned char* const stack=static_cast<unsigned char*>(alloca(size));
+                std::size_t const page_size=getpagesize();
+                for(std::size_t offset=0;offset<size;offset+=page_size)
+                {
+                    stack[offset]=0;
+                }
+            }
+
+            extern "C"
+            {
+                static void* thread_proxy(void* param)
+                {
+                    thread_data_ptr thread_info = static_cast<thread_data_base*>(param)->shared_from_this();
+                    thread_info->self.reset();
+                    set_current_thread_data(thread_info.get());
+                    if(thread_info->has_cpu_affinity)
+                    {
+                        BOOST_VERIFY(!pthread_setaffinity_np(pthread_self(),sizeof(cpu_set_t),&thread_info->cpu_affinity));
+                    }
+                    if(thread_info->prefault_stack_size)
+                    {
+                        prefault_stack(thread_info->prefault_stack_size);
+                    }
+                    BOOST_TRY
+                    {
+                        thread_info->run();
+                    }
+                    BOOST_CATCH (boost::thread_interrupted const&)
+                    {
+                    }
+                    BOOST_CATCH_END
+
+                    tls_destructor(thread_info.get());
+                    set_current_thread_data(0);
+                    boost::lock_guard<mutex> lock(thread_info->data_mutex);
+                    thread_info->done=true;
+                    thread_info->done_condition.notify_all();
+
+                    return 0;
+                }
+            }
+        }
+
+        thread_data_base* get_current_thread_data()
+        {
+            boost::call_once(current_thread_tls_init_flag,create_current_thread_tls_key);
+            return static_cast<thread_data_base*>(pthread_getspecific(current_thread_tls_key));
+        }
+
+        void add_thread_exit_function(thread_exit_function_base* func)
+        {
+            thread_data_base* const current_thread_data(get_current_thread_data());
+            if(current_thread_data)
+            {
+                thread_exit_callback_node* const new_node=
+                    boost::detail::heap_new<thread_exit_callback_node>(func,current_thread_data->thread_exit_callbacks);
+                current_thread_data->thread_exit_callbacks=new_node;
+            }
+        }
+    }
+
+    thread::thread() BOOST_NOEXCEPT
+    {}
+
+    thread::thread(detail::thread_data_ptr data):
+        thread_info(data)
+    {}
+
+    bool thread::start_thread_noexcept()
+    {
+        thread_info->self=thread_info;
+        int const res = pthread_create(&thread_info->thread_handle, 0, &detail::thread_proxy, thread_info.get());
+        if (res != 0)
+        {
+            thread_info->self.reset();
+            return false;
+        }
+        return true;
+    }
+
+    bool thread::start_thread_noexcept(const attributes& attr)
+    {
+        if (attr.get_lock_memory() && mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        {
+            return false;
+        }
+
+        std::size_t prefault_size = attr.get_prefault_stack_size();
+        if (prefault_size)
+        {
+            // leave room for thread_proxy's own frames and the function the thread runs
+            std::size_t const page_size = getpagesize();
+            std::size_t const stack_size = attr.get_stack_size();
+            std::size_t const reserve = 4 * page_size;
+            if (stack_size <= reserve)
+            {
+                prefault_size = 0;
+            }
+            else if (prefault_size > stack_size - reserve)
+            {
+                prefault_size = stack_size - reserve;
+            }
+        }
+        thread_info->prefault_stack_size = prefault_size;
+
+        if (const cpu_set_t* cpus = attr.get_cpu_affinity())
+        {
+            thread_info->has_cpu_affinity = true;
+            thread_info->cpu_affinity = *cpus;
+        }
+
+        thread_info->self=thread_info;
+        int const res = pthread_create(&thread_info->thread_handle, attr.native_handle(), &detail::thread_proxy, thread_info.get());
+        if (res != 0)
+        {
+            thread_info->self.reset();
+            return false;
+        }
+        return true;
+    }
+
+    detail::thread_data_ptr thread::get_thread_info BOOST_PREVENT_MACRO_SUBSTITUTION () const
+    {
+        return thread_info;
+    }
+
+    bool thread::join_noexcept()
+    {
+        detail::thread_data_ptr const local_thread_info=(get_thread_info)();
+        if(!local_thread_info)
+        {
+            return false;
+        }
+
+        bool do_join=false;
+        {
+            boost::unique_lock<mutex> lock(local_thread_info->data_mutex);
+            while(!local_thread_info->done)
+            {
+                local_thread_info->done_condition.wait(lock);
+            }
+            do_join=!local_thread_info->join_started;
+
+            if(do_join)
+            {
+                local_thread_info->join_started=true;
+            }
+            else
+            {
+                while(!local_thread_info->joined)
+                {
+                    local_thread_info->done_condition.wait(lock);
+                }
+            }
+        }
+        if(do_join)
+        {
+            void* result=0;
+            BOOST_VERIFY(!pthread_join(local_thread_info->thread_handle,&result));
+            boost::lock_guard<mutex> lock(local_thread_info->data_mutex);
+            local_thread_info->joined=true;
+            local_thread_info->done_condition.notify_all();
+        }
+
+        if(thread_info==local_thread_info)
+        {
+            thread_info.reset();
+        }
+        return true;
+    }
+
+    bool thread::do_try_join_until_noexcept(struct timespec const &timeout, bool& res)
+    {
+        detail::thread_data_ptr const local_thread_info=(get_thread_info)();
+        if(!local_thread_info)
+        {
+            return false;
+        }
+
+        bool do_join=false;
+        {
+            boost::unique_lock<mutex> lock(local_thread_info->data_mutex);
+            while(!local_thread_info->done)
+            {
+                if(!local_thread_info->done_condition.do_wait_until(lock,timeout))
+                {
+                    res=false;
+                    return true;
+                }
+            }
+            do_join=!local_thread_info->join_started;
+
+            if(do_join)
+            {
+                local_thread_info->join_started=true;
+            }
+            else
+            {
+                while(!local_thread_info->joined)
+                {
+                    local_thread_info->done_condition.wait(lock);
+                }
+            }
+        }
+        if(do_join)
+        {
+            void* result=0;
+            BOOST_VERIFY(!pthread_join(local_thread_info->thread_handle,&result));
+            boost::lock_guard<mutex> lock(local_thread_info->data_mutex);
+            local_thread_info->joined=true;
+            local_thread_info->done_condition.notify_all();
+        }
+
+        if(thread_info==local_thread_info)
+        {
+            thread_info.reset();
+        }
+        res=true;
+        return true;
+    }
+
+    bool thread::joinable() const BOOST_NOEXCEPT
+    {
+        return (get_thread_info)()?true:false;
+    }
+
+    void thread::detach()
+    {
+        detail::thread_data_ptr local_thread_info;
+        thread_info.swap(local_thread_info);
+
+        if(local_thread_info)
+        {
+            boost::lock_guard<mutex> lock(local_thread_info->data_mutex);
+            if(!local_thread_info->join_started)
+            {
+                BOOST_VERIFY(!pthread_detach(local_thread_info->thread_handle));
+                local_thread_info->join_started=true;
+                local_thread_info->joined=true;
+            }
+        }
+    }
+
+    unsigned thread::hardware_concurrency() BOOST_NOEXCEPT
+    {
+        long const count=sysconf(_SC_NPROCESSORS_ONLN);
+        return count>0?static_cast<unsigned>(count):0;
+    }
+
+    unsigned thread::physical_concurrency() BOOST_NOEXCEPT
+    {
+        return hardware_concurrency();
+    }
+
+    thread::native_handle_type thread::native_handle()
+    {
+        detail::thread_data_ptr const local_thread_info=(get_thread_info)();
+        if(local_thread_info)
+        {
+            boost::lock_guard<mutex> lk(local_thread_info->data_mutex);
+            return local_thread_info->thread_handle;
+        }
+        else
+        {
+            return pthread_t();
+        }
+    }
+
+#if defined BOOST_THREAD_PROVIDES_INTERRUPTIONS
+    void thread::interrupt()
+    {
+        detail::thread_data_ptr const local_thread_info=(get_thread_info)();
+        if(local_thread_info)
+        {
+            boost::lock_guard<mutex> lk(local_thread_info->data_mutex);
+            local_thread_info->interrupt_requested=true;
+            if(local_thread_info->current_cond)
+            {
+                rtai_thread::pthread_mutex_scoped_lock internal_lock(local_thread_info->cond_mutex);
+                BOOST_VERIFY(!pthread_cond_broadcast(local_thread_info->current_cond));
+            }
+        }
+    }
+
+    bool thread::interruption_requested() const BOOST_NOEXCEPT
+    {
+        detail::thread_data_ptr const local_thread_info=(get_thread_info)();
+        if(local_thread_info)
+        {
+            boost::lock_guard<mutex> lk(local_thread_info->data_mutex);
+            return local_thread_info->interrupt_requested;
+        }
+        else
+        {
+            return false;
+        }
+    }
+#endif
+
+    namespace this_thread
+    {
+        namespace no_interruption_point
+        {
+            namespace hiden
+            {
+                void sleep_for(const timespec& ts)
+                {
+                    if (boost::detail::timespec_ge(ts, boost::detail::timespec_zero()))
+                    {
+                        timespec remaining = ts;
+                        while (nanosleep(&remaining, &remaining) == -1 && errno == EINTR)
+                        {
+                        }
+                    }
+                }
+
+                void sleep_until(const timespec& ts)
+                {
+                    while (clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &ts, 0) == EINTR)
+                    {
+                    }
+                }
+            }
+        }
+
+        namespace hiden
+        {
+            void sleep_for(const timespec& ts)
+            {
+                detail::thread_data_base* const thread_info=detail::get_current_thread_data();
+                if(thread_info)
+                {
+                    boost::unique_lock<mutex> lk(thread_info->sleep_mutex);
+                    while(thread_info->sleep_condition.do_wait_for(lk,ts)) {}
+                }
+                else
+                {
+                    this_thread::no_interruption_point::hiden::sleep_for(ts);
+                }
+            }
+
+            void sleep_until(const timespec& ts)
+            {
+                detail::thread_data_base* const thread_info=detail::get_current_thread_data();
+                if(thread_info)
+                {
+                    boost::unique_lock<mutex> lk(thread_info->sleep_mutex);
+                    while(thread_info->sleep_condition.do_wait_until(lk,ts)) {}
+                }
+                else
+                {
+                    this_thread::no_interruption_point::hiden::sleep_until(ts);
+                }
+            }
+        }
+
+        void yield() BOOST_NOEXCEPT
+        {
+            BOOST_VERIFY(!sched_yield());
+        }
+
+#if defined BOOST_THREAD_PROVIDES_INTERRUPTIONS
+        void interruption_point()
+        {
+            detail::thread_data_base* const thread_info=detail::get_current_thread_data();
+            if(thread_info && thread_info->interrupt_enabled)
+            {
+                boost::lock_guard<mutex> lg(thread_info->data_mutex);
+                if(thread_info->interrupt_requested)
+                {
+                    thread_info->interrupt_requested=false;
+                    throw boost::thread_interrupted();
+                }
+            }
+        }
+
+        bool interruption_enabled() BOOST_NOEXCEPT
+        {
+            detail::thread_data_base* const thread_info=detail::get_current_thread_data();
+            return thread_info && thread_info->interrupt_enabled;
+        }
+
+        bool interruption_requested() BOOST_NOEXCEPT
+        {
+            detail::thread_data_base* const thread_info=detail::get_current_thread_data();
+            if(!thread_info)
+            {
+                return false;
+            }
+            else
+            {
+                boost::lock_guard<mutex> lg(thread_info->data_mutex);
+                return thread_info->interrupt_requested;
+            }
+        }
+#endif
+    }
+
+    void notify_all_at_thread_exit(condition_variable& cond, boost::unique_lock<mutex> lk)
+    {
+        detail::thread_data_base* const current_thread_data(detail::get_current_thread_data());
+        if(current_thread_data)
+        {
+            current_thread_data->notify_all_at_thread_exit(&cond, lk.release());
+        }
+    }
+}
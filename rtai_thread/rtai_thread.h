@@ -8,6 +8,7 @@
 
 #include "rtai_thread_data.hpp"
 #include "rtai_thread_detail.hpp"
+#include "rtai_thread_group.hpp"
 
 #include <boost/thread/lock_types.hpp>	// offer unique_lock & shared_lock
 #include <boost/thread/tss.hpp>			// offer thread_specific_ptr
@@ -1,5 +1,5 @@
-#ifndef BOOST_THREAD_PTHREAD_THREAD_DATA_HPP
-#define BOOST_THREAD_PTHREAD_THREAD_DATA_HPP
+#ifndef RTAI_THREAD_DATA_HPP
+#define RTAI_THREAD_DATA_HPP
 
 
 #include <boost/thread/detail/config.hpp>
@@ -27,7 +27,7 @@
 # endif
 #endif
 
-#include <rtai_posix.h>
+#include "rtai_config.hpp"
 #include <unistd.h>
 
 #include <boost/thread/tss.hpp>
@@ -39,7 +39,12 @@ namespace rtai_thread
 {
     class thread_attributes {
     public:
-        thread_attributes() BOOST_NOEXCEPT {
+        thread_attributes() BOOST_NOEXCEPT :
+          has_cpu_affinity_(false),
+          prefault_stack_size_(0),
+          lock_memory_(false)
+        {
+            CPU_ZERO(&cpu_affinity_);
             int res = pthread_attr_init(&val_);
             BOOST_VERIFY(!res && "pthread_attr_init failed");
         }
@@ -52,7 +57,7 @@ namespace rtai_thread
           if (size==0) return;
           std::size_t page_size = getpagesize();
 #ifdef PTHREAD_STACK_MIN
-          if (size<PTHREAD_STACK_MIN) size=PTHREAD_STACK_MIN;
+          if (size<static_cast<std::size_t>(PTHREAD_STACK_MIN)) size=PTHREAD_STACK_MIN;
 #endif
           size = ((size+page_size-1)/page_size)*page_size;
           int res = pthread_attr_setstacksize(&val_, size);
@@ -65,6 +70,71 @@ namespace rtai_thread
             BOOST_VERIFY(!res && "pthread_attr_getstacksize failed");
             return size;
         }
+
+        // scheduling: policy is SCHED_FIFO, SCHED_RR or SCHED_OTHER.  Real-time policies need CAP_SYS_NICE
+        // (or an RLIMIT_RTPRIO), otherwise starting the thread fails with thread_resource_error.
+        void set_scheduling(int policy, int priority) BOOST_NOEXCEPT {
+          int res = pthread_attr_setinheritsched(&val_, PTHREAD_EXPLICIT_SCHED);
+          BOOST_VERIFY(!res && "pthread_attr_setinheritsched failed");
+          res = pthread_attr_setschedpolicy(&val_, policy);
+          BOOST_VERIFY(!res && "pthread_attr_setschedpolicy failed");
+          sched_param param;
+          param.sched_priority = priority;
+          res = pthread_attr_setschedparam(&val_, &param);
+          BOOST_VERIFY(!res && "pthread_attr_setschedparam failed");
+        }
+
+        int get_sched_policy() const BOOST_NOEXCEPT {
+          int policy;
+          int res = pthread_attr_getschedpolicy(&val_, &policy);
+          BOOST_VERIFY(!res && "pthread_attr_getschedpolicy failed");
+          return policy;
+        }
+
+        int get_sched_priority() const BOOST_NOEXCEPT {
+          sched_param param;
+          int res = pthread_attr_getschedparam(&val_, &param);
+          BOOST_VERIFY(!res && "pthread_attr_getschedparam failed");
+          return param.sched_priority;
+        }
+
+        // affinity: the thread only ever runs on the cpus in the set.  It is applied by the new thread itself
+        // before its function runs, rather than stored in val_, so these attributes stay copyable.
+        void set_cpu_affinity(const cpu_set_t& cpus) BOOST_NOEXCEPT {
+          cpu_affinity_ = cpus;
+          has_cpu_affinity_ = true;
+        }
+
+        void set_cpu_affinity(int cpu) BOOST_NOEXCEPT {
+          cpu_set_t cpus;
+          CPU_ZERO(&cpus);
+          CPU_SET(cpu, &cpus);
+          set_cpu_affinity(cpus);
+        }
+
+        const cpu_set_t* get_cpu_affinity() const BOOST_NOEXCEPT {
+          return has_cpu_affinity_ ? &cpu_affinity_ : 0;
+        }
+
+        // memory: the new thread touches the first size bytes of its stack before running its function, so
+        // those page faults don't happen later inside a control loop.  Clamped to the stack size.
+        void set_prefault_stack_size(std::size_t size) BOOST_NOEXCEPT {
+          prefault_stack_size_ = size;
+        }
+
+        std::size_t get_prefault_stack_size() const BOOST_NOEXCEPT {
+          return prefault_stack_size_;
+        }
+
+        // mlockall(MCL_CURRENT | MCL_FUTURE) before the thread is started.  This pins the whole process, and
+        // stays in effect after the thread exits.
+        void set_lock_memory(bool lock) BOOST_NOEXCEPT {
+          lock_memory_ = lock;
+        }
+
+        bool get_lock_memory() const BOOST_NOEXCEPT {
+          return lock_memory_;
+        }
 #define BOOST_THREAD_DEFINES_THREAD_ATTRIBUTES_NATIVE_HANDLE
 
         typedef pthread_attr_t native_handle_type;
@@ -77,6 +147,10 @@ namespace rtai_thread
 
     private:
         pthread_attr_t val_;
+        cpu_set_t cpu_affinity_;
+        bool has_cpu_affinity_;
+        std::size_t prefault_stack_size_;
+        bool lock_memory_;
     };
 
     class thread;
@@ -88,10 +162,10 @@ namespace rtai_thread
         struct thread_exit_callback_node;
         struct tss_data_node
         {
-            boost::shared_ptr<boost::detail::tss_cleanup_function> func;
+            boost::shared_ptr<tss_cleanup_function> func;
             void* value;
 
-            tss_data_node(boost::shared_ptr<boost::detail::tss_cleanup_function> func_,
+            tss_data_node(boost::shared_ptr<tss_cleanup_function> func_,
                           void* value_):
                 func(func_),value(value_)
             {}
@@ -137,6 +211,9 @@ namespace rtai_thread
             bool interrupt_enabled;
             bool interrupt_requested;
 //#endif
+            bool has_cpu_affinity;
+            cpu_set_t cpu_affinity;
+            std::size_t prefault_stack_size;
             thread_data_base():
                 thread_handle(0),
                 done(false),join_started(false),joined(false),
@@ -151,6 +228,8 @@ namespace rtai_thread
                 , interrupt_enabled(true)
                 , interrupt_requested(false)
 //#endif
+                , has_cpu_affinity(false)
+                , prefault_stack_size(0)
             {}
             virtual ~thread_data_base();
 
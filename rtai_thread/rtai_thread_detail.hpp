@@ -77,7 +77,7 @@ namespace rtai_thread
           }
 
       private:
-          std::tuple<typename decay<F>::type, typename decay<ArgTypes>::type...> fp;
+          std::tuple<typename boost::decay<F>::type, typename boost::decay<ArgTypes>::type...> fp;
       };
 #else // defined(BOOST_THREAD_PROVIDES_VARIADIC_THREAD)
 
@@ -193,7 +193,7 @@ namespace rtai_thread
         template<typename F, class ...ArgTypes>
         static inline detail::thread_data_ptr make_thread_info(BOOST_THREAD_RV_REF(F) f, BOOST_THREAD_RV_REF(ArgTypes)... args)
         {
-            return detail::thread_data_ptr(detail::heap_new<
+            return detail::thread_data_ptr(boost::detail::heap_new<
                   detail::thread_data<typename boost::remove_reference<F>::type, ArgTypes...>
                   >(
                     boost::forward<F>(f), boost::forward<ArgTypes>(args)...
@@ -204,21 +204,21 @@ namespace rtai_thread
         template<typename F>
         static inline detail::thread_data_ptr make_thread_info(BOOST_THREAD_RV_REF(F) f)
         {
-            return detail::thread_data_ptr(detail::heap_new<detail::thread_data<typename boost::remove_reference<F>::type> >(
+            return detail::thread_data_ptr(boost::detail::heap_new<detail::thread_data<typename boost::remove_reference<F>::type> >(
                 boost::forward<F>(f)));
         }
 #endif
         static inline detail::thread_data_ptr make_thread_info(void (*f)())
         {
-            return detail::thread_data_ptr(detail::heap_new<detail::thread_data<void(*)()> >(
+            return detail::thread_data_ptr(boost::detail::heap_new<detail::thread_data<void(*)()> >(
                 boost::forward<void(*)()>(f)));
         }
 #else
         template<typename F>
         static inline detail::thread_data_ptr make_thread_info(F f
-            , typename disable_if_c<
+            , typename boost::disable_if_c<
                 //boost::thread_detail::is_convertible<F&,BOOST_THREAD_RV_REF(F)>::value ||
-                is_same<typename decay<F>::type, thread>::value,
+                boost::is_same<typename boost::decay<F>::type, thread>::value,
                 dummy* >::type=0
                 )
         {
@@ -256,7 +256,7 @@ namespace rtai_thread
         explicit thread(BOOST_THREAD_RV_REF(F) f
         //, typename disable_if<is_same<typename decay<F>::type, thread>, dummy* >::type=0
         ):
-          thread_info(make_thread_info(thread_detail::decay_copy(boost::forward<F>(f))))
+          thread_info(make_thread_info(boost::thread_detail::decay_copy(boost::forward<F>(f))))
         {
             start_thread();
         }
@@ -264,7 +264,7 @@ namespace rtai_thread
           class F
         >
         thread(attributes const& attrs, BOOST_THREAD_RV_REF(F) f):
-          thread_info(make_thread_info(thread_detail::decay_copy(boost::forward<F>(f))))
+          thread_info(make_thread_info(boost::thread_detail::decay_copy(boost::forward<F>(f))))
         {
             start_thread(attrs);
         }
@@ -286,7 +286,7 @@ namespace rtai_thread
 #else
         template <class F>
         explicit thread(F f
-        , typename disable_if_c<
+        , typename boost::disable_if_c<
         boost::thread_detail::is_rv<F>::value // todo ass a thread_detail::is_rv
         //boost::thread_detail::is_convertible<F&,BOOST_THREAD_RV_REF(F)>::value
             //|| is_same<typename decay<F>::type, thread>::value
@@ -298,8 +298,8 @@ namespace rtai_thread
         }
         template <class F>
         thread(attributes const& attrs, F f
-            , typename disable_if<boost::thread_detail::is_rv<F>, dummy* >::type=0
-            //, typename disable_if<boost::thread_detail::is_convertible<F&,BOOST_THREAD_RV_REF(F) >, dummy* >::type=0
+            , typename boost::disable_if<boost::thread_detail::is_rv<F>, dummy* >::type=0
+            //, typename boost::disable_if<boost::thread_detail::is_convertible<F&,BOOST_THREAD_RV_REF(F) >, dummy* >::type=0
         ):
             thread_info(make_thread_info(f))
         {
@@ -308,7 +308,7 @@ namespace rtai_thread
 #endif
         template <class F>
         explicit thread(BOOST_THREAD_RV_REF(F) f
-        , typename disable_if<is_same<typename decay<F>::type, thread>, dummy* >::type=0
+        , typename boost::disable_if<boost::is_same<typename boost::decay<F>::type, thread>, dummy* >::type=0
         ):
 #ifdef BOOST_THREAD_USES_MOVE
         thread_info(make_thread_info(boost::move<F>(f))) // todo : Add forward
@@ -360,9 +360,9 @@ namespace rtai_thread
         template <class F, class Arg, class ...Args>
         thread(F&& f, Arg&& arg, Args&&... args) :
           thread_info(make_thread_info(
-              thread_detail::decay_copy(boost::forward<F>(f)),
-              thread_detail::decay_copy(boost::forward<Arg>(arg)),
-              thread_detail::decay_copy(boost::forward<Args>(args))...)
+              boost::thread_detail::decay_copy(boost::forward<F>(f)),
+              boost::thread_detail::decay_copy(boost::forward<Arg>(arg)),
+              boost::thread_detail::decay_copy(boost::forward<Args>(args))...)
           )
 
         {
@@ -371,9 +371,9 @@ namespace rtai_thread
         template <class F, class Arg, class ...Args>
         thread(attributes const& attrs, F&& f, Arg&& arg, Args&&... args) :
           thread_info(make_thread_info(
-              thread_detail::decay_copy(boost::forward<F>(f)),
-              thread_detail::decay_copy(boost::forward<Arg>(arg)),
-              thread_detail::decay_copy(boost::forward<Args>(args))...)
+              boost::thread_detail::decay_copy(boost::forward<F>(f)),
+              boost::thread_detail::decay_copy(boost::forward<Arg>(arg)),
+              boost::thread_detail::decay_copy(boost::forward<Args>(args))...)
           )
 
         {
@@ -381,7 +381,7 @@ namespace rtai_thread
         }
 #else
         template <class F,class A1>
-        thread(F f,A1 a1,typename disable_if<boost::thread_detail::is_convertible<F&,thread_attributes >, dummy* >::type=0):
+        thread(F f,A1 a1,typename boost::disable_if<boost::thread_detail::is_convertible<F&,thread_attributes >, dummy* >::type=0):
             thread_info(make_thread_info(boost::bind(boost::type<void>(),f,a1)))
         {
             start_thread();
@@ -480,7 +480,7 @@ namespace rtai_thread
         bool try_join_until(const boost::chrono::time_point<Clock, Duration>& t)
         {
           using namespace boost::chrono;
-          system_clock::time_point     s_now = boost::system_clock::now();
+          system_clock::time_point     s_now = system_clock::now();
           bool joined= false;
           do {
             typename Clock::duration   d = ceil<nanoseconds>(t-Clock::now());
@@ -594,8 +594,16 @@ namespace rtai_thread
     }
 #endif
 
-    BOOST_THREAD_DCL_MOVABLE(thread)
+}
+
+// Boost's move emulation traits are specialized in namespace boost
+namespace boost
+{
+    BOOST_THREAD_DCL_MOVABLE(rtai_thread::thread)
+}
 
+namespace rtai_thread
+{
     namespace this_thread
     {
 #ifdef BOOST_THREAD_PLATFORM_PTHREAD
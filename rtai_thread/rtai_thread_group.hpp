@@ -0,0 +1,132 @@
+#ifndef RTAI_THREAD_GROUP_HPP
+#define RTAI_THREAD_GROUP_HPP
+
+#include <list>
+#include <algorithm>
+#include "rtai_mutex.hpp"
+#include "rtai_shared_mutex.hpp"
+#include "rtai_thread_data.hpp"
+#include "rtai_thread_detail.hpp"
+#include <boost/thread/csbl/memory/unique_ptr.hpp>
+#include <boost/thread/lock_guard.hpp>
+#include <boost/thread/lock_types.hpp>
+
+#include <boost/config/abi_prefix.hpp>
+
+namespace rtai_thread
+{
+    class thread_group
+    {
+    private:
+        thread_group(thread_group const&);
+        thread_group& operator=(thread_group const&);
+    public:
+        thread_group() {}
+        ~thread_group()
+        {
+            for(std::list<thread*>::iterator it=threads.begin(),end=threads.end();
+                it!=end;
+                ++it)
+            {
+                delete *it;
+            }
+        }
+
+        bool is_this_thread_in()
+        {
+            thread::id id = this_thread::get_id();
+            boost::shared_lock<shared_mutex> guard(m);
+            for(std::list<thread*>::iterator it=threads.begin(),end=threads.end();
+                it!=end;
+                ++it)
+            {
+              if ((*it)->get_id() == id)
+                return true;
+            }
+            return false;
+        }
+
+        template<typename F>
+        thread* create_thread(F threadfunc)
+        {
+            boost::lock_guard<shared_mutex> guard(m);
+            boost::csbl::unique_ptr<thread> new_thread(new thread(threadfunc));
+            threads.push_back(new_thread.get());
+            return new_thread.release();
+        }
+
+        // same as create_thread(), with the scheduling, affinity and memory settings in attrs
+        template<typename F>
+        thread* create_thread(thread_attributes const& attrs, F threadfunc)
+        {
+            boost::lock_guard<shared_mutex> guard(m);
+            boost::csbl::unique_ptr<thread> new_thread(new thread(attrs, threadfunc));
+            threads.push_back(new_thread.get());
+            return new_thread.release();
+        }
+
+        void add_thread(thread* thrd)
+        {
+            if(thrd)
+            {
+                boost::lock_guard<shared_mutex> guard(m);
+                threads.push_back(thrd);
+            }
+        }
+
+        void remove_thread(thread* thrd)
+        {
+            boost::lock_guard<shared_mutex> guard(m);
+            std::list<thread*>::iterator const it=std::find(threads.begin(),threads.end(),thrd);
+            if(it!=threads.end())
+            {
+                threads.erase(it);
+            }
+        }
+
+        void join_all()
+        {
+            if (is_this_thread_in())
+            {
+                boost::throw_exception(boost::thread_resource_error(static_cast<int>(boost::system::errc::resource_deadlock_would_occur), "rtai_thread::thread_group: trying joining itself"));
+            }
+            boost::shared_lock<shared_mutex> guard(m);
+
+            for(std::list<thread*>::iterator it=threads.begin(),end=threads.end();
+                it!=end;
+                ++it)
+            {
+              if ((*it)->joinable())
+                (*it)->join();
+            }
+        }
+
+#if defined BOOST_THREAD_PROVIDES_INTERRUPTIONS
+        void interrupt_all()
+        {
+            boost::shared_lock<shared_mutex> guard(m);
+
+            for(std::list<thread*>::iterator it=threads.begin(),end=threads.end();
+                it!=end;
+                ++it)
+            {
+                (*it)->interrupt();
+            }
+        }
+#endif
+
+        size_t size() const
+        {
+            boost::shared_lock<shared_mutex> guard(m);
+            return threads.size();
+        }
+
+    private:
+        std::list<thread*> threads;
+        mutable shared_mutex m;
+    };
+}
+
+#include <boost/config/abi_suffix.hpp>
+
+#endif
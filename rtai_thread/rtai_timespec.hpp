@@ -6,7 +6,7 @@
 #if defined BOOST_THREAD_USES_DATETIME
 #include <boost/date_time/posix_time/conversion.hpp>
 #endif
-#include <rtai_posix.h>
+#include "rtai_config.hpp"
 #ifndef _WIN32
 #include <unistd.h>
 #endif
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/buffer_pool.h"
+#include <ros/assert.h>
+
+#include <algorithm>
+
+namespace ros
+{
+
+bool BufferPool::s_enabled_ = true;
+
+namespace
+{
+
+/// Number of bytes of free blocks each thread may cache per size class
+const uint32_t CACHE_BYTES = 1 << 20;
+
+inline uint32_t blockSize(uint32_t size_class)
+{
+  return BufferPool::MIN_BLOCK_SIZE << size_class;
+}
+
+inline uint32_t sizeClass(uint32_t size)
+{
+  uint32_t size_class = 0;
+  while (blockSize(size_class) < size)
+  {
+    ++size_class;
+  }
+  return size_class;
+}
+
+/**
+ * \brief The number of free blocks of a size class a thread may cache.  The cache exchanges half of that with the
+ * global free list at a time.
+ */
+inline uint32_t cacheLimit(uint32_t size_class)
+{
+  return std::max(2u, std::min(128u, CACHE_BYTES / blockSize(size_class)));
+}
+
+/**
+ * \brief Deleter of the buffers handed out by BufferPool::allocate()
+ */
+struct BlockDeleter
+{
+  BlockDeleter(uint32_t size)
+  : size_(size)
+  {}
+
+  void operator()(uint8_t* block) const
+  {
+    BufferPool::instance().freeBlock(block, size_);
+  }
+
+  uint32_t size_;
+};
+
+}
+
+struct BufferPool::SizeClass
+{
+  SizeClass()
+  : slab_(0)
+  , slab_left_(0)
+  {}
+
+  threading::mutex mutex_;
+  std::vector<void*> free_;
+  /// Next unused part of the current slab
+  uint8_t* slab_;
+  uint32_t slab_left_;
+};
+
+struct BufferPool::ThreadCache
+{
+  ThreadCache()
+  : hits_(0)
+  , misses_(0)
+  , unpooled_(0)
+  {}
+
+  std::vector<void*> blocks_[NUM_SIZE_CLASSES];
+
+  // Counts not yet folded into BufferPool::stats_
+  uint64_t hits_;
+  uint64_t misses_;
+  uint64_t unpooled_;
+};
+
+BufferPool& BufferPool::instance()
+{
+  // Never destroyed, so that buffers still referenced during static destruction can be freed safely
+  static BufferPool* pool = new BufferPool;
+  return *pool;
+}
+
+BufferPool::BufferPool()
+: classes_(new SizeClass[NUM_SIZE_CLASSES])
+, cache_(&BufferPool::releaseCache)
+{
+  ROS_ASSERT(blockSize(NUM_SIZE_CLASSES - 1) == MAX_BLOCK_SIZE);
+
+  stats_.hits = 0;
+  stats_.misses = 0;
+  stats_.unpooled = 0;
+  stats_.footprint = 0;
+  stats_.free = 0;
+}
+
+BufferPool::~BufferPool()
+{
+  delete [] classes_;
+}
+
+BufferPool::ThreadCache* BufferPool::getCache()
+{
+  ThreadCache* cache = cache_.get();
+  if (!cache)
+  {
+    cache = new ThreadCache;
+    cache_.reset(cache);
+  }
+
+  return cache;
+}
+
+boost::shared_array<uint8_t> BufferPool::allocate(uint32_t size)
+{
+  if (!s_enabled_ || size > MAX_BLOCK_SIZE)
+  {
+    ++getCache()->unpooled_;
+    return boost::shared_array<uint8_t>(new uint8_t[size]);
+  }
+
+  uint8_t* block = static_cast<uint8_t*>(allocateBlock(size));
+  return boost::shared_array<uint8_t>(block, BlockDeleter(size), BufferPoolAllocator<uint8_t>());
+}
+
+void* BufferPool::allocateBlock(uint32_t size)
+{
+  if (size > MAX_BLOCK_SIZE)
+  {
+    return ::operator new(size);
+  }
+
+  uint32_t size_class = sizeClass(size);
+  ThreadCache* cache = getCache();
+  std::vector<void*>& blocks = cache->blocks_[size_class];
+  if (blocks.empty())
+  {
+    refill(size_class, *cache);
+  }
+  else
+  {
+    ++cache->hits_;
+  }
+
+  ROS_ASSERT(!blocks.empty());
+  void* block = blocks.back();
+  blocks.pop_back();
+  return block;
+}
+
+void BufferPool::freeBlock(void* block, uint32_t size)
+{
+  if (size > MAX_BLOCK_SIZE)
+  {
+    ::operator delete(block);
+    return;
+  }
+
+  uint32_t size_class = sizeClass(size);
+  ThreadCache* cache = getCache();
+  std::vector<void*>& blocks = cache->blocks_[size_class];
+  if (blocks.size() >= cacheLimit(size_class))
+  {
+    flush(size_class, *cache, cacheLimit(size_class) / 2);
+  }
+
+  blocks.push_back(block);
+}
+
+void BufferPool::refill(uint32_t size_class, ThreadCache& cache)
+{
+  SizeClass& sc = classes_[size_class];
+  std::vector<void*>& blocks = cache.blocks_[size_class];
+  uint32_t block_size = blockSize(size_class);
+  uint32_t slab_size = std::max(SLAB_SIZE, block_size);
+  uint32_t count = 0;
+  bool new_slab = false;
+
+  {
+    threading::mutex::scoped_lock lock(sc.mutex_);
+
+    count = std::min<uint32_t>(cacheLimit(size_class) / 2, sc.free_.size());
+    if (count > 0)
+    {
+      blocks.insert(blocks.end(), sc.free_.end() - count, sc.free_.end());
+      sc.free_.resize(sc.free_.size() - count);
+    }
+    else
+    {
+      // Nothing free, carve a new block out of the current slab (or a new one)
+      if (sc.slab_left_ < block_size)
+      {
+        sc.slab_ = new uint8_t[slab_size];
+        sc.slab_left_ = slab_size;
+        new_slab = true;
+      }
+
+      blocks.push_back(sc.slab_);
+      sc.slab_ += block_size;
+      sc.slab_left_ -= block_size;
+    }
+  }
+
+  if (count > 0)
+  {
+    ++cache.hits_;
+  }
+  else
+  {
+    ++cache.misses_;
+  }
+
+  threading::mutex::scoped_lock lock(stats_mutex_);
+  stats_.free -= (uint64_t)count * block_size;
+  if (new_slab)
+  {
+    stats_.footprint += slab_size;
+  }
+  foldStats(cache);
+}
+
+void BufferPool::flush(uint32_t size_class, ThreadCache& cache, uint32_t count)
+{
+  SizeClass& sc = classes_[size_class];
+  std::vector<void*>& blocks = cache.blocks_[size_class];
+  count = std::min<uint32_t>(count, blocks.size());
+
+  {
+    threading::mutex::scoped_lock lock(sc.mutex_);
+    sc.free_.insert(sc.free_.end(), blocks.end() - count, blocks.end());
+  }
+  blocks.resize(blocks.size() - count);
+
+  threading::mutex::scoped_lock lock(stats_mutex_);
+  stats_.free += (uint64_t)count * blockSize(size_class);
+  foldStats(cache);
+}
+
+void BufferPool::foldStats(ThreadCache& cache)
+{
+  // stats_mutex_ must be held
+  stats_.hits += cache.hits_;
+  stats_.misses += cache.misses_;
+  stats_.unpooled += cache.unpooled_;
+  cache.hits_ = 0;
+  cache.misses_ = 0;
+  cache.unpooled_ = 0;
+}
+
+void BufferPool::releaseCache(ThreadCache* cache)
+{
+  // Called as a thread exits, hand everything it had cached back to the global free lists
+  BufferPool& pool = instance();
+  for (uint32_t i = 0; i < NUM_SIZE_CLASSES; ++i)
+  {
+    pool.flush(i, *cache, cache->blocks_[i].size());
+  }
+
+  {
+    threading::mutex::scoped_lock lock(pool.stats_mutex_);
+    pool.foldStats(*cache);
+  }
+
+  delete cache;
+}
+
+BufferPool::Stats BufferPool::getStats()
+{
+  ThreadCache* cache = getCache();
+
+  threading::mutex::scoped_lock lock(stats_mutex_);
+  foldStats(*cache);
+  return stats_;
+}
+
+} // namespace ros
@@ -51,7 +51,7 @@ CallbackQueue::~CallbackQueue()
 
 void CallbackQueue::enable()
 {
-  boost::mutex::scoped_lock lock(mutex_);
+  threading::pi_mutex::scoped_lock lock(mutex_);
   enabled_ = true;
 
   condition_.notify_all();
@@ -59,7 +59,7 @@ void CallbackQueue::enable()
 
 void CallbackQueue::disable()
 {
-  boost::mutex::scoped_lock lock(mutex_);
+  threading::pi_mutex::scoped_lock lock(mutex_);
   enabled_ = false;
 
   condition_.notify_all();
@@ -67,21 +67,21 @@ void CallbackQueue::disable()
 
 void CallbackQueue::clear()
 {
-  boost::mutex::scoped_lock lock(mutex_);
+  threading::pi_mutex::scoped_lock lock(mutex_);
 
   callbacks_.clear();
 }
 
 bool CallbackQueue::isEmpty()
 {
-  boost::mutex::scoped_lock lock(mutex_);
+  threading::pi_mutex::scoped_lock lock(mutex_);
 
   return callbacks_.empty() && calling_ == 0;
 }
 
 bool CallbackQueue::isEnabled()
 {
-  boost::mutex::scoped_lock lock(mutex_);
+  threading::pi_mutex::scoped_lock lock(mutex_);
 
   return enabled_;
 }
@@ -100,35 +100,46 @@ void CallbackQueue::addCallback(const CallbackInterfacePtr& callback, uint64_t r
   info.callback = callback;
   info.removal_id = removal_id;
 
+  // The ID has to be known before the callback can be seen by a spinner, which would otherwise find no IDInfo for it
+  // and drop it without calling it
   {
-    boost::mutex::scoped_lock lock(mutex_);
+    threading::pi_mutex::scoped_lock lock(id_info_mutex_);
 
-    if (!enabled_)
+    M_IDInfo::iterator it = id_info_.find(removal_id);
+    if (it == id_info_.end())
     {
-      return;
+      IDInfoPtr id_info(new IDInfo);
+      id_info->id = removal_id;
+      id_info_.insert(std::make_pair(removal_id, id_info));
     }
-
-    callbacks_.push_back(info);
   }
 
   {
-    boost::mutex::scoped_lock lock(id_info_mutex_);
+    threading::pi_mutex::scoped_lock lock(mutex_);
 
-    M_IDInfo::iterator it = id_info_.find(removal_id);
-    if (it == id_info_.end())
+    if (!enabled_)
     {
-      IDInfoPtr id_info(new IDInfo);
-      id_info->id = removal_id;
-      id_info_.insert(std::make_pair(removal_id, id_info));
+      return;
     }
+
+    pushCallback(info);
   }
 
   condition_.notify_one();
 }
 
+void CallbackQueue::pushCallback(const CallbackInfo& info)
+{
+  callbacks_.push_back(info);
+}
+
+void CallbackQueue::callFinished(const CallbackInfo&, CallbackInterface::CallResult)
+{
+}
+
 CallbackQueue::IDInfoPtr CallbackQueue::getIDInfo(uint64_t id)
 {
-  boost::mutex::scoped_lock lock(id_info_mutex_);
+  threading::pi_mutex::scoped_lock lock(id_info_mutex_);
   M_IDInfo::iterator it = id_info_.find(id);
   if (it != id_info_.end())
   {
@@ -145,7 +156,7 @@ void CallbackQueue::removeByID(uint64_t removal_id)
   {
     IDInfoPtr id_info;
     {
-      boost::mutex::scoped_lock lock(id_info_mutex_);
+      threading::pi_mutex::scoped_lock lock(id_info_mutex_);
       M_IDInfo::iterator it = id_info_.find(removal_id);
       if (it != id_info_.end())
       {
@@ -165,8 +176,8 @@ void CallbackQueue::removeByID(uint64_t removal_id)
     }
 
     {
-      boost::unique_lock<boost::shared_mutex> rw_lock(id_info->calling_rw_mutex);
-      boost::mutex::scoped_lock lock(mutex_);
+      boost::unique_lock<threading::shared_mutex> rw_lock(id_info->calling_rw_mutex);
+      threading::pi_mutex::scoped_lock lock(mutex_);
       D_CallbackInfo::iterator it = callbacks_.begin();
       for (; it != callbacks_.end();)
       {
@@ -204,7 +215,7 @@ void CallbackQueue::removeByID(uint64_t removal_id)
   }
 
   {
-    boost::mutex::scoped_lock lock(id_info_mutex_);
+    threading::pi_mutex::scoped_lock lock(id_info_mutex_);
     id_info_.erase(removal_id);
   }
 }
@@ -217,7 +228,7 @@ CallbackQueue::CallOneResult CallbackQueue::callOne(ros::WallDuration timeout)
   CallbackInfo cb_info;
 
   {
-    boost::mutex::scoped_lock lock(mutex_);
+    threading::pi_mutex::scoped_lock lock(mutex_);
 
     if (!enabled_)
     {
@@ -281,7 +292,7 @@ CallbackQueue::CallOneResult CallbackQueue::callOne(ros::WallDuration timeout)
   CallOneResult res = callOneCB(tls);
   if (res != Empty)
   {
-    boost::mutex::scoped_lock lock(mutex_);
+    threading::pi_mutex::scoped_lock lock(mutex_);
     --calling_;
   }
   return res;
@@ -293,7 +304,7 @@ void CallbackQueue::callAvailable(ros::WallDuration timeout)
   TLS* tls = tls_.get();
 
   {
-    boost::mutex::scoped_lock lock(mutex_);
+    threading::pi_mutex::scoped_lock lock(mutex_);
 
     if (!enabled_)
     {
@@ -337,11 +348,50 @@ void CallbackQueue::callAvailable(ros::WallDuration timeout)
   }
 
   {
-    boost::mutex::scoped_lock lock(mutex_);
+    threading::pi_mutex::scoped_lock lock(mutex_);
     calling_ -= called;
   }
 }
 
+void CallbackQueue::callAvailableInTurn(ros::WallDuration timeout)
+{
+  size_t count = 0;
+
+  {
+    threading::pi_mutex::scoped_lock lock(mutex_);
+
+    if (!enabled_)
+    {
+      return;
+    }
+
+    if (callbacks_.empty())
+    {
+      if (!timeout.isZero())
+      {
+        condition_.timed_wait(lock, boost::posix_time::microseconds((int64_t)(timeout.toSec() * 1000000.0)));
+      }
+
+      if (callbacks_.empty() || !enabled_)
+      {
+        return;
+      }
+    }
+
+    count = callbacks_.size();
+  }
+
+  // Bounded by the number of callbacks available when we started, as in callAvailable()
+  for (size_t i = 0; i < count; ++i)
+  {
+    CallOneResult result = callOne(ros::WallDuration());
+    if (result == Empty || result == Disabled)
+    {
+      break;
+    }
+  }
+}
+
 CallbackQueue::CallOneResult CallbackQueue::callOneCB(TLS* tls)
 {
   // Check for a recursive call.  If recursive, increment the current iterator.  Otherwise
@@ -365,7 +415,7 @@ CallbackQueue::CallOneResult CallbackQueue::callOneCB(TLS* tls)
   IDInfoPtr id_info = getIDInfo(info.removal_id);
   if (id_info)
   {
-    boost::shared_lock<boost::shared_mutex> rw_lock(id_info->calling_rw_mutex);
+    boost::shared_lock<threading::shared_mutex> rw_lock(id_info->calling_rw_mutex);
 
     uint64_t last_calling = tls->calling_in_this_thread;
     tls->calling_in_this_thread = id_info->id;
@@ -391,11 +441,13 @@ CallbackQueue::CallOneResult CallbackQueue::callOneCB(TLS* tls)
 
     tls->calling_in_this_thread = last_calling;
 
+    callFinished(info, result);
+
     // Push TryAgain callbacks to the back of the shared queue
     if (result == CallbackInterface::TryAgain && !info.marked_for_removal)
     {
-      boost::mutex::scoped_lock lock(mutex_);
-      callbacks_.push_back(info);
+      threading::pi_mutex::scoped_lock lock(mutex_);
+      pushCallback(info);
 
       return TryAgain;
     }
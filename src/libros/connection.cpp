@@ -33,8 +33,10 @@
  */
 
 #include "ros/connection.h"
+#include "ros/buffer_pool.h"
 #include "ros/transport/transport.h"
 #include "ros/file_log.h"
+#include "ros/poll_set.h"
 
 #include <ros/assert.h>
 
@@ -50,12 +52,17 @@ Connection::Connection()
 , read_filled_(0)
 , read_size_(0)
 , reading_(false)
+, read_pending_(false)
 , has_read_callback_(0)
+, receive_start_(0)
+, receive_end_(0)
+, write_index_(0)
 , write_sent_(0)
-, write_size_(0)
 , writing_(false)
+, write_pending_(false)
 , has_write_callback_(0)
 , sending_header_error_(false)
+, edge_triggered_(PollSet::s_backend_ == PollSet::EpollEdgeTriggered)
 {
 }
 
@@ -86,13 +93,13 @@ void Connection::initialize(const TransportPtr& transport, bool is_server, const
 
 boost::signals2::connection Connection::addDropListener(const DropFunc& slot)
 {
-  boost::recursive_mutex::scoped_lock lock(drop_mutex_);
+  threading::recursive_mutex::scoped_lock lock(drop_mutex_);
   return drop_signal_.connect(slot);
 }
 
 void Connection::removeDropListener(const boost::signals2::connection& c)
 {
-  boost::recursive_mutex::scoped_lock lock(drop_mutex_);
+  threading::recursive_mutex::scoped_lock lock(drop_mutex_);
   c.disconnect();
 }
 
@@ -105,19 +112,127 @@ void Connection::onReadable(const TransportPtr& transport)
 
 void Connection::readTransport()
 {
-  boost::recursive_mutex::scoped_try_lock lock(read_mutex_);
-
-  if (!lock.owns_lock() || dropped_ || reading_)
+  while (true)
   {
-    return;
-  }
+    threading::recursive_mutex::scoped_try_lock lock(read_mutex_);
+
+    if (!lock.owns_lock())
+    {
+      // Another thread is reading.  An edge-triggered poll set won't report this event again, so leave it for that
+      // thread to pick up before it lets go of the lock, unless it already has.
+      read_pending_ = true;
+      if (!lock.try_lock())
+      {
+        return;
+      }
+    }
 
-  reading_ = true;
+    if (dropped_ || reading_)
+    {
+      return;
+    }
+
+    read_pending_ = false;
+    reading_ = true;
+    readTransportLocked();
+    reading_ = false;
+
+    lock.unlock();
+    if (!read_pending_)
+    {
+      return;
+    }
+  }
+}
 
+void Connection::readTransportLocked()
+{
+  bool buffered = transport_->isStream();
+  bool drained = false;
   while (!dropped_ && has_read_callback_)
   {
-    ROS_ASSERT(read_buffer_);
+    if (!read_buffer_)
+    {
+      uint32_t available = receive_end_ - receive_start_;
+      if (buffered && available >= read_size_)
+      {
+        // Everything asked for has already been read.  Copy it out rather than handing out a slice of the receive
+        // buffer, so that a message held on to by a subscriber doesn't pin the whole block.
+        ReadFinishedFunc callback;
+        uint32_t size;
+        boost::shared_array<uint8_t> buffer = BufferPool::instance().allocate(read_size_);
+        memcpy(buffer.get(), receive_buffer_.get() + receive_start_, read_size_);
+
+        callback = read_callback_;
+        size = read_size_;
+        receive_start_ += size;
+        read_callback_.clear();
+        read_size_ = 0;
+        read_filled_ = 0;
+        has_read_callback_ = 0;
+
+        ROS_DEBUG_NAMED("superdebug", "Calling read callback with %d buffered bytes", size);
+        callback(shared_from_this(), buffer, size, true);
+        continue;
+      }
+
+      if (buffered && read_size_ <= MAX_BUFFERED_READ)
+      {
+        if (drained)
+        {
+          break;
+        }
+
+        // Read as much as is available, which may cover several more reads
+        compactReceiveBuffer();
+        uint32_t to_read = RECEIVE_BUFFER_SIZE - receive_end_;
+        int32_t bytes_read = transport_->read(receive_buffer_.get() + receive_end_, to_read);
+        ROS_DEBUG_NAMED("superdebug", "Connection read %d bytes into the receive buffer", bytes_read);
+        if (dropped_)
+        {
+          return;
+        }
+        else if (bytes_read < 0)
+        {
+          // Bad read, throw away results and report error
+          ReadFinishedFunc callback;
+          callback = read_callback_;
+          read_callback_.clear();
+          uint32_t size = read_size_;
+          read_size_ = 0;
+          read_filled_ = 0;
+          has_read_callback_ = 0;
+          receive_start_ = 0;
+          receive_end_ = 0;
+
+          if (callback)
+          {
+            callback(shared_from_this(), boost::shared_array<uint8_t>(), size, false);
+          }
+
+          break;
+        }
+
+        receive_end_ += bytes_read;
+        // Edge-triggered, only a read that would block means there's nothing left
+        drained = edge_triggered_ ? bytes_read == 0 : (uint32_t)bytes_read < to_read;
+        continue;
+      }
+
+      // Too large to go through the receive buffer.  Start it off with whatever has been buffered already.
+      read_buffer_ = BufferPool::instance().allocate(read_size_);
+      read_filled_ = 0;
+      if (available > 0)
+      {
+        memcpy(read_buffer_.get(), receive_buffer_.get() + receive_start_, available);
+        read_filled_ = available;
+        receive_start_ = 0;
+        receive_end_ = 0;
+      }
+    }
+
     uint32_t to_read = read_size_ - read_filled_;
+    bool would_block = false;
     if (to_read > 0)
     {
       int32_t bytes_read = transport_->read(read_buffer_.get() + read_filled_, to_read);
@@ -147,6 +262,7 @@ void Connection::readTransport()
       }
 
       read_filled_ += bytes_read;
+      would_block = bytes_read == 0;
     }
 
     ROS_ASSERT((int32_t)read_size_ >= 0);
@@ -174,65 +290,170 @@ void Connection::readTransport()
       ROS_DEBUG_NAMED("superdebug", "Calling read callback");
       callback(shared_from_this(), buffer, size, true);
     }
-    else
+    else if (would_block || !edge_triggered_)
     {
       break;
     }
   }
 
+  // Only hold on to a receive block while there is unconsumed data in it, so idle connections (and publisher side
+  // ones, which never read more than the header) don't tie one up each
+  if (receive_start_ == receive_end_)
+  {
+    receive_buffer_.reset();
+    receive_start_ = 0;
+    receive_end_ = 0;
+  }
+
   if (!has_read_callback_)
   {
     transport_->disableRead();
   }
-
-  reading_ = false;
 }
 
-void Connection::writeTransport()
+void Connection::compactReceiveBuffer()
 {
-  boost::recursive_mutex::scoped_try_lock lock(write_mutex_);
-
-  if (!lock.owns_lock() || dropped_ || writing_)
+  if (!receive_buffer_)
   {
+    receive_buffer_ = BufferPool::instance().allocate(RECEIVE_BUFFER_SIZE);
+    receive_start_ = 0;
+    receive_end_ = 0;
     return;
   }
 
-  writing_ = true;
-  bool can_write_more = true;
+  // Reads are copied out of the block, so nothing else refers to it and it can always be reused
+  uint32_t available = receive_end_ - receive_start_;
+  if (available == 0)
+  {
+    receive_start_ = 0;
+    receive_end_ = 0;
+  }
+  else if (RECEIVE_BUFFER_SIZE - receive_end_ < MAX_BUFFERED_READ)
+  {
+    memmove(receive_buffer_.get(), receive_buffer_.get() + receive_start_, available);
+    receive_start_ = 0;
+    receive_end_ = available;
+  }
+}
 
-  while (has_write_callback_ && can_write_more && !dropped_)
+void Connection::writeTransport()
+{
+  while (true)
   {
-    uint32_t to_write = write_size_ - write_sent_;
-    ROS_DEBUG_NAMED("superdebug", "Connection writing %d bytes", to_write);
-    int32_t bytes_sent = transport_->write(write_buffer_.get() + write_sent_, to_write);
-    ROS_DEBUG_NAMED("superdebug", "Connection wrote %d bytes", bytes_sent);
+    threading::recursive_mutex::scoped_try_lock lock(write_mutex_);
 
-    if (bytes_sent < 0)
+    if (!lock.owns_lock())
+    {
+      // Same as readTransport(), the thread writing has to pick this event up
+      write_pending_ = true;
+      if (!lock.try_lock())
+      {
+        return;
+      }
+    }
+
+    if (dropped_ || writing_)
     {
-      writing_ = false;
       return;
     }
 
-    write_sent_ += bytes_sent;
+    write_pending_ = false;
+    writing_ = true;
+    writeTransportLocked();
+    writing_ = false;
+
+    lock.unlock();
+    if (!write_pending_)
+    {
+      return;
+    }
+  }
+}
+
+void Connection::writeTransportLocked()
+{
+  bool can_write_more = true;
+
+  while (has_write_callback_ && can_write_more && !dropped_)
+  {
+    // Skip past anything already written, including empty buffers
+    while (write_index_ < write_buffers_.size() && write_sent_ == write_sizes_[write_index_])
+    {
+      ++write_index_;
+      write_sent_ = 0;
+    }
 
-    if (bytes_sent < (int)write_size_ - (int)write_sent_)
+    if (write_index_ < write_buffers_.size())
     {
-      can_write_more = false;
+      // Gather what's left, starting part way through the current buffer
+      Transport::WriteBuffer buffers[MAX_WRITE_BUFFERS];
+      uint32_t count = 0;
+      uint32_t to_write = 0;
+      for (uint32_t i = write_index_; i < write_buffers_.size() && count < MAX_WRITE_BUFFERS; ++i)
+      {
+        uint32_t offset = (i == write_index_) ? write_sent_ : 0;
+        if (write_sizes_[i] == offset)
+        {
+          continue;
+        }
+        buffers[count].data = write_buffers_[i].get() + offset;
+        buffers[count].size = write_sizes_[i] - offset;
+        to_write += buffers[count].size;
+        ++count;
+      }
+
+      ROS_DEBUG_NAMED("superdebug", "Connection writing %d bytes from %d buffers", to_write, count);
+      int32_t bytes_sent = (count == 1) ? transport_->write(buffers[0].data, buffers[0].size) : transport_->writev(buffers, count);
+      ROS_DEBUG_NAMED("superdebug", "Connection wrote %d bytes", bytes_sent);
+
+      if (bytes_sent < 0)
+      {
+        return;
+      }
+
+      // Edge-triggered, keep going until a write would block
+      if (edge_triggered_ ? bytes_sent == 0 : (uint32_t)bytes_sent < to_write)
+      {
+        can_write_more = false;
+      }
+
+      // Advance through the buffers by the amount written
+      uint32_t remaining = bytes_sent;
+      while (remaining > 0)
+      {
+        uint32_t left = write_sizes_[write_index_] - write_sent_;
+        if (remaining < left)
+        {
+          write_sent_ += remaining;
+          break;
+        }
+
+        remaining -= left;
+        ++write_index_;
+        write_sent_ = 0;
+      }
+
+      while (write_index_ < write_buffers_.size() && write_sent_ == write_sizes_[write_index_])
+      {
+        ++write_index_;
+        write_sent_ = 0;
+      }
     }
 
-    if (write_sent_ == write_size_ && !dropped_)
+    if (write_index_ == write_buffers_.size() && !dropped_)
     {
       WriteFinishedFunc callback;
 
       {
-        boost::mutex::scoped_lock lock(write_callback_mutex_);
+        threading::mutex::scoped_lock lock(write_callback_mutex_);
         ROS_ASSERT(has_write_callback_);
         // Store off a copy of the callback in case another write() call happens in it
         callback = write_callback_;
         write_callback_ = WriteFinishedFunc();
-        write_buffer_ = boost::shared_array<uint8_t>();
+        write_buffers_.clear();
+        write_sizes_.clear();
+        write_index_ = 0;
         write_sent_ = 0;
-        write_size_ = 0;
         has_write_callback_ = 0;
       }
 
@@ -242,14 +463,12 @@ void Connection::writeTransport()
   }
 
   {
-    boost::mutex::scoped_lock lock(write_callback_mutex_);
+    threading::mutex::scoped_lock lock(write_callback_mutex_);
     if (!has_write_callback_)
     {
       transport_->disableWrite();
     }
   }
-
-  writing_ = false;
 }
 
 void Connection::onWriteable(const TransportPtr& transport)
@@ -267,12 +486,13 @@ void Connection::read(uint32_t size, const ReadFinishedFunc& callback)
   }
 
   {
-    boost::recursive_mutex::scoped_lock lock(read_mutex_);
+    threading::recursive_mutex::scoped_lock lock(read_mutex_);
 
     ROS_ASSERT(!read_callback_);
 
     read_callback_ = callback;
-    read_buffer_ = boost::shared_array<uint8_t>(new uint8_t[size]);
+    // The buffer is set up by readTransport(), which may be able to fill it from the receive buffer
+    read_buffer_.reset();
     read_size_ = size;
     read_filled_ = 0;
     has_read_callback_ = 1;
@@ -292,13 +512,45 @@ void Connection::write(const boost::shared_array<uint8_t>& buffer, uint32_t size
   }
 
   {
-    boost::mutex::scoped_lock lock(write_callback_mutex_);
+    threading::mutex::scoped_lock lock(write_callback_mutex_);
+
+    ROS_ASSERT(!write_callback_);
+
+    write_callback_ = callback;
+    write_buffers_.assign(1, buffer);
+    write_sizes_.assign(1, size);
+    write_index_ = 0;
+    write_sent_ = 0;
+    has_write_callback_ = 1;
+  }
+
+  transport_->enableWrite();
+
+  if (immediate)
+  {
+    // write immediately if possible
+    writeTransport();
+  }
+}
+
+void Connection::write(const std::vector<boost::shared_array<uint8_t> >& buffers, const std::vector<uint32_t>& sizes, const WriteFinishedFunc& callback, bool immediate)
+{
+  ROS_ASSERT(buffers.size() == sizes.size());
+
+  if (dropped_ || sending_header_error_)
+  {
+    return;
+  }
+
+  {
+    threading::mutex::scoped_lock lock(write_callback_mutex_);
 
     ROS_ASSERT(!write_callback_);
 
     write_callback_ = callback;
-    write_buffer_ = buffer;
-    write_size_ = size;
+    write_buffers_.assign(buffers.begin(), buffers.end());
+    write_sizes_.assign(sizes.begin(), sizes.end());
+    write_index_ = 0;
     write_sent_ = 0;
     has_write_callback_ = 1;
   }
@@ -324,7 +576,7 @@ void Connection::drop(DropReason reason)
   ROSCPP_LOG_DEBUG("Connection::drop(%u)", reason);
   bool did_drop = false;
   {
-    boost::recursive_mutex::scoped_lock lock(drop_mutex_);
+    threading::recursive_mutex::scoped_lock lock(drop_mutex_);
     if (!dropped_)
     {
       dropped_ = true;
@@ -341,7 +593,7 @@ void Connection::drop(DropReason reason)
 
 bool Connection::isDropped()
 {
-  boost::recursive_mutex::scoped_lock lock(drop_mutex_);
+  threading::recursive_mutex::scoped_lock lock(drop_mutex_);
   return dropped_;
 }
 
@@ -32,21 +32,26 @@
 #include "ros/service_client_link.h"
 #include "ros/transport/transport_tcp.h"
 #include "ros/transport/transport_udp.h"
+#include "ros/transport/transport_shm.h"
 #include "ros/file_log.h"
 #include "ros/network.h"
 
 #include <ros/assert.h>
 
+#include <boost/functional/hash.hpp>
+
+#include <sstream>
+
 namespace ros
 {
 
 ConnectionManagerPtr g_connection_manager;
-boost::mutex g_connection_manager_mutex;
+threading::mutex g_connection_manager_mutex;
 const ConnectionManagerPtr& ConnectionManager::instance()
 {
   if (!g_connection_manager)
   {
-    boost::mutex::scoped_lock lock(g_connection_manager_mutex);
+    threading::mutex::scoped_lock lock(g_connection_manager_mutex);
     if (!g_connection_manager)
     {
       g_connection_manager.reset(new ConnectionManager);
@@ -56,8 +61,11 @@ const ConnectionManagerPtr& ConnectionManager::instance()
   return g_connection_manager;
 }
 
+ConnectionManager::PollSetAssignment ConnectionManager::s_poll_set_assignment_ = ConnectionManager::RoundRobin;
+
 ConnectionManager::ConnectionManager()
 : connection_id_counter_(0)
+, next_poll_set_(0)
 {
 }
 
@@ -74,6 +82,7 @@ void ConnectionManager::start()
 
   // Bring up the TCP listener socket
   tcpserver_transport_ = TransportTCPPtr(new TransportTCP(&poll_manager_->getPollSet()));
+  tcpserver_transport_->setAcceptPollSetFunc(boost::bind(&ConnectionManager::getPollSet, this, std::string()));
   if (!tcpserver_transport_->listen(network::getTCPROSPort(), 
 				    MAX_TCPROS_CONN_QUEUE, 
 				    boost::bind(&ConnectionManager::tcprosAcceptConnection, this, _1)))
@@ -89,10 +98,57 @@ void ConnectionManager::start()
     ROS_FATAL("Listen failed");
     ROS_BREAK();
   }
+
+  // Bring up the unix domain listener socket, for TCPROS connections from this host.  Not fatal either,
+  // subscribers on this host then connect over TCP/IP instead.
+  if (TransportTCP::s_use_unix_sockets_ && TransportTCP::isUnixAvailable())
+  {
+    std::string dir;
+    if (!get_environment_variable(dir, "TMPDIR") || dir.empty())
+    {
+      dir = "/tmp";
+    }
+    std::stringstream path;
+    path << dir << "/roscpp_" << getpid() << "_tcpros.sock";
+
+    unixserver_transport_ = TransportTCPPtr(new TransportTCP(&poll_manager_->getPollSet()));
+    unixserver_transport_->setAcceptPollSetFunc(boost::bind(&ConnectionManager::getPollSet, this, std::string()));
+    if (!unixserver_transport_->listenUnix(path.str(), MAX_TCPROS_CONN_QUEUE,
+                                           boost::bind(&ConnectionManager::tcprosAcceptConnection, this, _1)))
+    {
+      ROS_WARN("Listen on unix socket [%s] failed, local TCPROS connections will use TCP/IP", path.str().c_str());
+      unixserver_transport_.reset();
+    }
+  }
+
+  // Bring up the SHMROS listener socket.  Not fatal, subscribers just fall back to TCPROS.
+  if (TransportSHM::isAvailable())
+  {
+    shmserver_transport_ = TransportTCPPtr(new TransportTCP(&poll_manager_->getPollSet()));
+    shmserver_transport_->setAcceptPollSetFunc(boost::bind(&ConnectionManager::getPollSet, this, std::string()));
+    if (!shmserver_transport_->listen(0, MAX_TCPROS_CONN_QUEUE,
+                                      boost::bind(&ConnectionManager::shmrosAcceptConnection, this, _1)))
+    {
+      ROS_WARN("Listen for SHMROS connections failed, SHMROS will be unavailable");
+      shmserver_transport_.reset();
+    }
+  }
 }
 
 void ConnectionManager::shutdown()
 {
+  if (unixserver_transport_)
+  {
+    unixserver_transport_->close();
+    unixserver_transport_.reset();
+  }
+
+  if (shmserver_transport_)
+  {
+    shmserver_transport_->close();
+    shmserver_transport_.reset();
+  }
+
   if (udpserver_transport_)
   {
     udpserver_transport_->close();
@@ -114,7 +170,7 @@ void ConnectionManager::clear(Connection::DropReason reason)
 {
   S_Connection local_connections;
   {
-    boost::mutex::scoped_lock conn_lock(connections_mutex_);
+    threading::mutex::scoped_lock conn_lock(connections_mutex_);
     local_connections.swap(connections_);
   }
 
@@ -126,8 +182,27 @@ void ConnectionManager::clear(Connection::DropReason reason)
     conn->drop(reason);
   }
 
-  boost::mutex::scoped_lock dropped_lock(dropped_connections_mutex_);
+  threading::mutex::scoped_lock dropped_lock(dropped_connections_mutex_);
   dropped_connections_.clear();
+  pending_dropped_connections_.clear();
+}
+
+PollSet* ConnectionManager::getPollSet(const std::string& topic)
+{
+  uint32_t count = poll_manager_->getNumPollSets();
+  if (count == 1)
+  {
+    return &poll_manager_->getPollSet();
+  }
+
+  if (s_poll_set_assignment_ == TopicAffinity && !topic.empty())
+  {
+    return &poll_manager_->getPollSet(boost::hash<std::string>()(topic) % count);
+  }
+
+  threading::mutex::scoped_lock lock(next_poll_set_mutex_);
+  uint32_t index = next_poll_set_++ % count;
+  return &poll_manager_->getPollSet(index);
 }
 
 uint32_t ConnectionManager::getTCPPort()
@@ -140,16 +215,26 @@ uint32_t ConnectionManager::getUDPPort()
   return udpserver_transport_->getServerPort();
 }
 
+uint32_t ConnectionManager::getSHMPort()
+{
+  return shmserver_transport_ ? shmserver_transport_->getServerPort() : 0;
+}
+
+std::string ConnectionManager::getUnixSocketPath()
+{
+  return unixserver_transport_ ? unixserver_transport_->getUnixPath() : std::string();
+}
+
 uint32_t ConnectionManager::getNewConnectionID()
 {
-  boost::mutex::scoped_lock lock(connection_id_counter_mutex_);
+  threading::mutex::scoped_lock lock(connection_id_counter_mutex_);
   uint32_t ret = connection_id_counter_++;
   return ret;
 }
 
 void ConnectionManager::addConnection(const ConnectionPtr& conn)
 {
-  boost::mutex::scoped_lock lock(connections_mutex_);
+  threading::mutex::scoped_lock lock(connections_mutex_);
 
   connections_.insert(conn);
   conn->addDropListener(boost::bind(&ConnectionManager::onConnectionDropped, this, _1));
@@ -157,19 +242,69 @@ void ConnectionManager::addConnection(const ConnectionPtr& conn)
 
 void ConnectionManager::onConnectionDropped(const ConnectionPtr& conn)
 {
-  boost::mutex::scoped_lock lock(dropped_connections_mutex_);
+  threading::mutex::scoped_lock lock(dropped_connections_mutex_);
   dropped_connections_.push_back(conn);
 }
 
 void ConnectionManager::removeDroppedConnections()
 {
   V_Connection local_dropped;
+  uint32_t poll_set_count = poll_manager_->getNumPollSets();
+  if (poll_set_count == 1)
   {
-    boost::mutex::scoped_lock dropped_lock(dropped_connections_mutex_);
+    // We're being called from the only poll thread, so nothing else can be using these
+    threading::mutex::scoped_lock dropped_lock(dropped_connections_mutex_);
     dropped_connections_.swap(local_dropped);
   }
+  else
+  {
+    // The other poll threads may still be inside a callback on a connection that was just dropped.
+    // Hold on to it until each of them has finished the update() it was in when we first saw the drop.
+    // The counts are read under the lock, so every connection in dropped_connections_ was dropped before
+    // they were taken, and no poll thread can still be in the update() it dropped one from once its count
+    // has moved past them.
+    threading::mutex::scoped_lock dropped_lock(dropped_connections_mutex_);
+
+    std::vector<uint64_t> counts(poll_set_count);
+    for (uint32_t i = 0; i < poll_set_count; ++i)
+    {
+      counts[i] = poll_manager_->getUpdateCount(i);
+    }
+
+    std::vector<ConnectionAndUpdateCounts>::iterator it = pending_dropped_connections_.begin();
+    while (it != pending_dropped_connections_.end())
+    {
+      bool done = true;
+      for (uint32_t i = 0; i < poll_set_count; ++i)
+      {
+        if (counts[i] <= it->second[i])
+        {
+          done = false;
+          break;
+        }
+      }
+
+      if (done)
+      {
+        local_dropped.push_back(it->first);
+        it = pending_dropped_connections_.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+
+    V_Connection::iterator conn_it = dropped_connections_.begin();
+    V_Connection::iterator conn_end = dropped_connections_.end();
+    for (;conn_it != conn_end; ++conn_it)
+    {
+      pending_dropped_connections_.push_back(std::make_pair(*conn_it, counts));
+    }
+    dropped_connections_.clear();
+  }
 
-  boost::mutex::scoped_lock conn_lock(connections_mutex_);
+  threading::mutex::scoped_lock conn_lock(connections_mutex_);
 
   V_Connection::iterator conn_it = local_dropped.begin();
   V_Connection::iterator conn_end = local_dropped.end();
@@ -203,6 +338,20 @@ void ConnectionManager::tcprosAcceptConnection(const TransportTCPPtr& transport)
   conn->initialize(transport, true, boost::bind(&ConnectionManager::onConnectionHeaderReceived, this, _1, _2));
 }
 
+void ConnectionManager::shmrosAcceptConnection(const TransportTCPPtr& transport)
+{
+  std::string client_uri = transport->getClientURI();
+  ROSCPP_LOG_DEBUG("SHMROS received a connection from [%s]", client_uri.c_str());
+
+  TransportSHMPtr shm_transport(new TransportSHM(getPollSet()));
+  shm_transport->accept(transport);
+
+  ConnectionPtr conn(new Connection());
+  addConnection(conn);
+
+  conn->initialize(shm_transport, true, boost::bind(&ConnectionManager::onConnectionHeaderReceived, this, _1, _2));
+}
+
 bool ConnectionManager::onConnectionHeaderReceived(const ConnectionPtr& conn, const Header& header)
 {
   bool ret = false;
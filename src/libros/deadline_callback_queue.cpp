@@ -0,0 +1,102 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/deadline_callback_queue.h"
+
+namespace ros
+{
+
+DeadlineCallbackQueue::DeadlineCallbackQueue(ros::WallDuration default_deadline, bool enabled)
+: CallbackQueue(enabled)
+, default_deadline_(default_deadline)
+, missed_(0)
+{
+}
+
+DeadlineCallbackQueue::~DeadlineCallbackQueue()
+{
+  disable();
+}
+
+void DeadlineCallbackQueue::pushCallback(const CallbackInfo& info)
+{
+  CallbackInfo queued = info;
+  // Callbacks pushed back after returning TryAgain keep their original deadline
+  if (queued.added.isZero())
+  {
+    queued.added = WallTime::now();
+
+    WallDuration deadline = queued.callback->getDeadline();
+    queued.deadline = queued.added + (deadline.isZero() ? default_deadline_ : deadline);
+  }
+
+  // Deadlines mostly arrive in increasing order, so search from the back
+  D_CallbackInfo::iterator it = callbacks_.end();
+  while (it != callbacks_.begin())
+  {
+    D_CallbackInfo::iterator prev = it;
+    --prev;
+
+    if (prev->deadline <= queued.deadline)
+    {
+      break;
+    }
+
+    it = prev;
+  }
+
+  callbacks_.insert(it, queued);
+}
+
+void DeadlineCallbackQueue::callFinished(const CallbackInfo& info, CallbackInterface::CallResult result)
+{
+  if (result != CallbackInterface::Success)
+  {
+    return;
+  }
+
+  WallTime now = WallTime::now();
+  if (now > info.deadline)
+  {
+    missed_.fetch_add(1);
+    info.callback->deadlineMissed(now - info.deadline);
+  }
+}
+
+void DeadlineCallbackQueue::callAvailable(ros::WallDuration timeout)
+{
+  callAvailableInTurn(timeout);
+}
+
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "ros/high_resolution_sleeper.h"
+#include "ros/file_log.h"
+
+#include <ros/console.h>
+
+#ifdef HAVE_SYS_TIMERFD_H
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <sys/prctl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#endif
+
+namespace ros
+{
+
+int32_t HighResolutionSleeper::s_thread_priority_ = 0;
+
+HighResolutionSleeperPtr HighResolutionSleeper::create()
+{
+#ifdef HAVE_SYS_TIMERFD_H
+  int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  if (timer_fd < 0)
+  {
+    ROS_ERROR("timerfd_create failed, falling back to normal resolution timers: %s", strerror(errno));
+    return HighResolutionSleeperPtr();
+  }
+
+  int wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wake_fd < 0)
+  {
+    ROS_ERROR("eventfd failed, falling back to normal resolution timers: %s", strerror(errno));
+    ::close(timer_fd);
+    return HighResolutionSleeperPtr();
+  }
+
+  return HighResolutionSleeperPtr(new HighResolutionSleeper(timer_fd, wake_fd));
+#else
+  ROSCPP_LOG_DEBUG("High resolution timers are not available on this platform");
+  return HighResolutionSleeperPtr();
+#endif
+}
+
+HighResolutionSleeper::HighResolutionSleeper(int timer_fd, int wake_fd)
+: timer_fd_(timer_fd)
+, wake_fd_(wake_fd)
+{
+}
+
+HighResolutionSleeper::~HighResolutionSleeper()
+{
+#ifdef HAVE_SYS_TIMERFD_H
+  ::close(timer_fd_);
+  ::close(wake_fd_);
+#endif
+}
+
+void HighResolutionSleeper::setupThread()
+{
+#ifdef HAVE_SYS_TIMERFD_H
+  // The default slack of 50us would otherwise be added to every wakeup
+  prctl(PR_SET_TIMERSLACK, 1UL, 0UL, 0UL, 0UL);
+
+  if (s_thread_priority_ > 0)
+  {
+    sched_param param;
+    param.sched_priority = s_thread_priority_;
+    int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (ret != 0)
+    {
+      ROS_WARN("Could not make the high resolution timer thread SCHED_FIFO with priority %d: %s", s_thread_priority_, strerror(ret));
+    }
+  }
+#endif
+}
+
+void HighResolutionSleeper::sleep(const WallDuration& duration)
+{
+#ifdef HAVE_SYS_TIMERFD_H
+  // Turn the duration into an absolute expiry right away, so that nothing that happens before we get to poll() delays it
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  int64_t expiry = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec + std::max(duration.toNSec(), (int64_t)1);
+
+  itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  spec.it_value.tv_sec = expiry / 1000000000LL;
+  spec.it_value.tv_nsec = expiry % 1000000000LL;
+  if (timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, NULL) != 0)
+  {
+    ROS_ERROR("timerfd_settime failed: %s", strerror(errno));
+    return;
+  }
+
+  pollfd fds[2];
+  fds[0].fd = timer_fd_;
+  fds[0].events = POLLIN;
+  fds[1].fd = wake_fd_;
+  fds[1].events = POLLIN;
+
+  int ret;
+  do
+  {
+    ret = poll(fds, 2, -1);
+  } while (ret < 0 && errno == EINTR);
+
+  // Drain both, so the next sleep starts from a clean slate.  Both are non-blocking or known to be readable.
+  uint64_t count;
+  if ((fds[0].revents & POLLIN) && ::read(timer_fd_, &count, sizeof(count)) < 0)
+  {
+    ROSCPP_LOG_DEBUG("Reading the timerfd failed: %s", strerror(errno));
+  }
+  if (::read(wake_fd_, &count, sizeof(count)) < 0 && errno != EAGAIN)
+  {
+    ROSCPP_LOG_DEBUG("Reading the wakeup eventfd failed: %s", strerror(errno));
+  }
+#else
+  duration.sleep();
+#endif
+}
+
+void HighResolutionSleeper::wake()
+{
+#ifdef HAVE_SYS_TIMERFD_H
+  uint64_t one = 1;
+  if (::write(wake_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN)
+  {
+    ROS_ERROR("Writing the wakeup eventfd failed: %s", strerror(errno));
+  }
+#endif
+}
+
+}
@@ -43,11 +43,14 @@
 #include "ros/network.h"
 #include "ros/file_log.h"
 #include "ros/callback_queue.h"
+#include "ros/lockfree_callback_queue.h"
 #include "ros/param.h"
 #include "ros/rosout_appender.h"
 #include "ros/subscribe_options.h"
 #include "ros/transport/transport_tcp.h"
 #include "ros/internal_timer_manager.h"
+#include "ros/buffer_pool.h"
+#include "ros/high_resolution_sleeper.h"
 #include "XmlRpcSocket.h"
 
 #include "roscpp/GetLoggers.h"
@@ -99,13 +102,13 @@ static CallbackQueuePtr g_internal_callback_queue;
 static bool g_initialized = false;
 static bool g_started = false;
 static bool g_atexit_registered = false;
-static boost::mutex g_start_mutex;
+static threading::mutex g_start_mutex;
 static bool g_ok = false;
 static uint32_t g_init_options = 0;
 static bool g_shutdown_requested = false;
 static volatile bool g_shutting_down = false;
-static boost::recursive_mutex g_shutting_down_mutex;
-static boost::thread g_internal_queue_thread;
+static threading::recursive_mutex g_shutting_down_mutex;
+static threading::thread g_internal_queue_thread;
 
 bool isInitialized()
 {
@@ -123,7 +126,7 @@ void checkForShutdown()
   {
     // Since this gets run from within a mutex inside PollManager, we need to prevent ourselves from deadlocking with
     // another thread that's already in the middle of shutdown()
-    boost::recursive_mutex::scoped_try_lock lock(g_shutting_down_mutex, boost::defer_lock);
+    threading::recursive_mutex::scoped_try_lock lock(g_shutting_down_mutex, boost::defer_lock);
     while (!lock.try_lock() && !g_shutting_down)
     {
       ros::WallDuration(0.001).sleep();
@@ -290,7 +293,7 @@ bool isStarted()
 
 void start()
 {
-  boost::mutex::scoped_lock lock(g_start_mutex);
+  threading::mutex::scoped_lock lock(g_start_mutex);
   if (g_started)
   {
     return;
@@ -314,6 +317,57 @@ void start()
     }
   }
 
+  std::string poll_backend_env;
+  if (get_environment_variable(poll_backend_env, "ROSCPP_POLL_BACKEND"))
+  {
+    if (poll_backend_env == "poll")
+    {
+      PollSet::s_backend_ = PollSet::Poll;
+    }
+    else if (poll_backend_env == "epoll")
+    {
+      PollSet::s_backend_ = PollSet::EpollLevelTriggered;
+    }
+    else if (poll_backend_env == "epoll_et")
+    {
+      PollSet::s_backend_ = PollSet::EpollEdgeTriggered;
+    }
+    else
+    {
+      ROS_WARN("Unknown ROSCPP_POLL_BACKEND [%s], expected one of poll, epoll, epoll_et", poll_backend_env.c_str());
+    }
+  }
+
+  std::string poll_threads_env;
+  if (get_environment_variable(poll_threads_env, "ROSCPP_POLL_THREADS"))
+  {
+    try
+    {
+      PollManager::s_thread_count_ = std::max(boost::lexical_cast<uint32_t>(poll_threads_env), 1u);
+    }
+    catch (boost::bad_lexical_cast&)
+    {
+      ROS_WARN("Invalid ROSCPP_POLL_THREADS [%s], expected a positive integer", poll_threads_env.c_str());
+    }
+  }
+
+  std::string poll_assignment_env;
+  if (get_environment_variable(poll_assignment_env, "ROSCPP_POLL_ASSIGNMENT"))
+  {
+    if (poll_assignment_env == "round_robin")
+    {
+      ConnectionManager::s_poll_set_assignment_ = ConnectionManager::RoundRobin;
+    }
+    else if (poll_assignment_env == "topic")
+    {
+      ConnectionManager::s_poll_set_assignment_ = ConnectionManager::TopicAffinity;
+    }
+    else
+    {
+      ROS_WARN("Unknown ROSCPP_POLL_ASSIGNMENT [%s], expected one of round_robin, topic", poll_assignment_env.c_str());
+    }
+  }
+
   char* env_ipv6 = NULL;
 #ifdef _MSC_VER
   _dupenv_s(&env_ipv6, NULL, "ROS_IPV6");
@@ -334,6 +388,31 @@ void start()
 
   param::param("/tcp_keepalive", TransportTCP::s_use_keepalive_, TransportTCP::s_use_keepalive_);
 
+  std::string unix_sockets_env;
+  if (get_environment_variable(unix_sockets_env, "ROSCPP_UNIX_SOCKETS"))
+  {
+    TransportTCP::s_use_unix_sockets_ = !(unix_sockets_env == "0" || unix_sockets_env == "off" || unix_sockets_env == "false");
+  }
+
+  std::string buffer_pool_env;
+  if (get_environment_variable(buffer_pool_env, "ROSCPP_BUFFER_POOL"))
+  {
+    BufferPool::s_enabled_ = !(buffer_pool_env == "0" || buffer_pool_env == "off" || buffer_pool_env == "false");
+  }
+
+  std::string timer_priority_env;
+  if (get_environment_variable(timer_priority_env, "ROSCPP_HIGH_RESOLUTION_TIMER_PRIORITY"))
+  {
+    try
+    {
+      HighResolutionSleeper::s_thread_priority_ = boost::lexical_cast<int32_t>(timer_priority_env);
+    }
+    catch (boost::bad_lexical_cast&)
+    {
+      ROS_WARN("Invalid ROSCPP_HIGH_RESOLUTION_TIMER_PRIORITY [%s], expected an integer", timer_priority_env.c_str());
+    }
+  }
+
   PollManager::instance()->addPollThreadListener(checkForShutdown);
   XMLRPCManager::instance()->bind("shutdown", shutdownCallback);
 
@@ -410,7 +489,7 @@ void start()
 
   if (g_shutting_down) goto end;
 
-  g_internal_queue_thread = boost::thread(internalCallbackQueueThreadFunc);
+  g_internal_queue_thread = threading::thread(internalCallbackQueueThreadFunc);
   getGlobalCallbackQueue()->enable();
 
   ROSCPP_LOG_DEBUG("Started node [%s], pid [%d], bound on [%s], xmlrpc port [%d], tcpros port [%d], using [%s] time", 
@@ -424,7 +503,7 @@ end:
   // If we received a shutdown request while initializing, wait until we've shutdown to continue
   if (g_shutting_down)
   {
-    boost::recursive_mutex::scoped_lock lock(g_shutting_down_mutex);
+    threading::recursive_mutex::scoped_lock lock(g_shutting_down_mutex);
   }
 }
 
@@ -438,7 +517,16 @@ void init(const M_string& remappings, const std::string& name, uint32_t options)
 
   if (!g_global_queue)
   {
-    g_global_queue.reset(new CallbackQueue);
+    std::string lockfree_env;
+    if (get_environment_variable(lockfree_env, "ROSCPP_LOCKFREE_CALLBACK_QUEUE") &&
+        !(lockfree_env == "0" || lockfree_env == "off" || lockfree_env == "false"))
+    {
+      g_global_queue.reset(new LockFreeCallbackQueue);
+    }
+    else
+    {
+      g_global_queue.reset(new CallbackQueue);
+    }
   }
 
   if (!g_initialized)
@@ -558,7 +646,7 @@ bool ok()
 
 void shutdown()
 {
-  boost::recursive_mutex::scoped_lock lock(g_shutting_down_mutex);
+  threading::recursive_mutex::scoped_lock lock(g_shutting_down_mutex);
   if (g_shutting_down)
     return;
   else
@@ -569,7 +657,7 @@ void shutdown()
   g_global_queue->disable();
   g_global_queue->clear();
 
-  if (g_internal_queue_thread.get_id() != boost::this_thread::get_id())
+  if (g_internal_queue_thread.get_id() != threading::this_thread::get_id())
   {
     g_internal_queue_thread.join();
   }
@@ -79,14 +79,9 @@ void IntraProcessPublisherLink::setPublisher(const IntraProcessSubscriberLinkPtr
 
 void IntraProcessPublisherLink::drop()
 {
+  if (dropped_.exchange(true))
   {
-    boost::recursive_mutex::scoped_lock lock(drop_mutex_);
-    if (dropped_)
-    {
-      return;
-    }
-
-    dropped_ = true;
+    return;
   }
 
   if (publisher_)
@@ -105,20 +100,21 @@ void IntraProcessPublisherLink::drop()
 
 void IntraProcessPublisherLink::handleMessage(const SerializedMessage& m, bool ser, bool nocopy)
 {
-  boost::recursive_mutex::scoped_lock lock(drop_mutex_);
-  if (dropped_)
+  if (dropped_.load())
   {
     return;
   }
 
-  stats_.bytes_received_ += m.num_bytes;
-  stats_.messages_received_++;
+  // Only counters, so they need no ordering with anything else
+  stats_.bytes_received_.fetch_add(m.num_bytes, boost::memory_order_relaxed);
+  stats_.messages_received_.fetch_add(1, boost::memory_order_relaxed);
 
   SubscriptionPtr parent = parent_.lock();
 
   if (parent)
   {
-    stats_.drops_ += parent->handleMessage(m, ser, nocopy, header_.getValues(), shared_from_this());
+    uint32_t drops = parent->handleMessage(m, ser, nocopy, header_.getValues(), shared_from_this());
+    stats_.drops_.fetch_add(drops, boost::memory_order_relaxed);
   }
 }
 
@@ -135,8 +131,7 @@ std::string IntraProcessPublisherLink::getTransportInfo()
 
 void IntraProcessPublisherLink::getPublishTypes(bool& ser, bool& nocopy, const std::type_info& ti)
 {
-  boost::recursive_mutex::scoped_lock lock(drop_mutex_);
-  if (dropped_)
+  if (dropped_.load())
   {
     ser = false;
     nocopy = false;
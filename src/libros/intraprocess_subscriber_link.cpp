@@ -73,8 +73,7 @@ bool IntraProcessSubscriberLink::isLatching()
 
 void IntraProcessSubscriberLink::enqueueMessage(const SerializedMessage& m, bool ser, bool nocopy)
 {
-  boost::recursive_mutex::scoped_lock lock(drop_mutex_);
-  if (dropped_)
+  if (dropped_.load())
   {
     return;
   }
@@ -96,20 +95,15 @@ std::string IntraProcessSubscriberLink::getTransportInfo()
 
 void IntraProcessSubscriberLink::drop()
 {
+  if (dropped_.exchange(true))
   {
-    boost::recursive_mutex::scoped_lock lock(drop_mutex_);
-    if (dropped_)
-    {
-      return;
-    }
-
-    dropped_ = true;
+    return;
   }
 
+  // subscriber_ drops its reference back to us, which breaks the cycle between the two links
   if (subscriber_)
   {
     subscriber_->drop();
-    subscriber_.reset();
   }
 
   if (PublicationPtr parent = parent_.lock())
@@ -122,8 +116,7 @@ void IntraProcessSubscriberLink::drop()
 
 void IntraProcessSubscriberLink::getPublishTypes(bool& ser, bool& nocopy, const std::type_info& ti)
 {
-  boost::recursive_mutex::scoped_lock lock(drop_mutex_);
-  if (dropped_)
+  if (dropped_.load())
   {
     return;
   }
@@ -35,16 +35,21 @@
 ** Includes
 *****************************************************************************/
 
+#include "config.h"
 #include <ros/io.h>
 #include <ros/assert.h> // don't need if we dont call the pipe functions.
 #include <errno.h> // for EFAULT and co.
 #include <iostream>
 #include <sstream>
+#include <algorithm>
 #ifdef WIN32
 #else
   #include <cstring> // strerror
   #include <fcntl.h> // for non-blocking configuration
 #endif
+#if defined(HAVE_EPOLL)
+  #include <sys/epoll.h>
+#endif
 
 /*****************************************************************************
 ** Namespaces
@@ -392,4 +397,141 @@ int create_signal_pair(signal_fd_t signal_pair[2]) {
 #endif // create_pipe
 }
 
+/*****************************************************************************
+** Socket Watchers
+*****************************************************************************/
+/**
+ * @brief Whether an incremental socket watcher (epoll) was compiled in.
+ *
+ * When this returns false the watcher functions below all fail and callers
+ * are expected to fall back to poll_sockets().
+ */
+bool socket_watcher_available() {
+#if defined(HAVE_EPOLL)
+	return true;
+#else
+	return false;
+#endif
+}
+
+/**
+ * @brief Create a socket watcher.
+ * @return int : the watcher descriptor, -1 on failure.
+ */
+int create_socket_watcher() {
+#if defined(HAVE_EPOLL)
+	int watcher = ::epoll_create1(EPOLL_CLOEXEC);
+	if (watcher < 0) {
+		ROS_ERROR("epoll_create1() failed with error [%s]", last_socket_error_string());
+	}
+	return watcher;
+#else
+	return -1;
+#endif
+}
+
+void close_socket_watcher(int watcher) {
+#if defined(HAVE_EPOLL)
+	if (watcher >= 0) {
+		::close(watcher);
+	}
+#endif
+}
+
+/**
+ * @brief Start watching a socket. No events are requested until set_events_on_socket() is called.
+ * @return int : 0 on success, -1 on failure.
+ */
+int add_socket_to_watcher(int watcher, socket_fd_t fd) {
+#if defined(HAVE_EPOLL)
+	struct epoll_event ev;
+	ev.events = 0;
+	ev.data.fd = fd;
+	return ::epoll_ctl(watcher, EPOLL_CTL_ADD, fd, &ev);
+#else
+	return -1;
+#endif
+}
+
+/**
+ * @brief Stop watching a socket.
+ *
+ * Closing the socket removes it from the watcher implicitly, so a failure here
+ * on an already closed socket is not an error.
+ * @return int : 0 on success, -1 on failure.
+ */
+int del_socket_from_watcher(int watcher, socket_fd_t fd) {
+#if defined(HAVE_EPOLL)
+	struct epoll_event ev; // pre 2.6.9 kernels require a non-null event
+	ev.events = 0;
+	ev.data.fd = fd;
+	return ::epoll_ctl(watcher, EPOLL_CTL_DEL, fd, &ev);
+#else
+	return -1;
+#endif
+}
+
+/**
+ * @brief Replace the set of poll() style events watched on a socket.
+ * @param edge_triggered : only report transitions to the ready state rather than
+ * the ready state itself.
+ * @return int : 0 on success, -1 on failure.
+ */
+int set_events_on_socket(int watcher, socket_fd_t fd, int events, bool edge_triggered) {
+#if defined(HAVE_EPOLL)
+	struct epoll_event ev;
+	ev.events = 0;
+	if (events & POLLIN) ev.events |= EPOLLIN;
+	if (events & POLLPRI) ev.events |= EPOLLPRI;
+	if (events & POLLOUT) ev.events |= EPOLLOUT;
+	if (edge_triggered) ev.events |= EPOLLET;
+	ev.data.fd = fd;
+	return ::epoll_ctl(watcher, EPOLL_CTL_MOD, fd, &ev);
+#else
+	return -1;
+#endif
+}
+
+/**
+ * @brief Wait for events on a socket watcher.
+ *
+ * Unlike poll_sockets(), only the sockets which have events are written out, so the
+ * cost is proportional to the number of active sockets rather than the number watched.
+ * @param fds - output array, filled with the fd and poll() style revents of each ready socket.
+ * @param max_fds - the size of the output array.
+ * @param timeout - timeout in milliseconds.
+ * @return int : -1 on error, 0 on timeout, +ve number of entries written to fds.
+ */
+int poll_socket_watcher(int watcher, socket_pollfd *fds, nfds_t max_fds, int timeout) {
+#if defined(HAVE_EPOLL)
+	// anything left over past the end of this array stays ready and is picked up next time
+	struct epoll_event events[256];
+	int count = static_cast<int>(std::min<nfds_t>(max_fds, sizeof(events) / sizeof(events[0])));
+	int result = ::epoll_wait(watcher, events, count, timeout);
+	if (result < 0) {
+		// EINTR means that we got interrupted by a signal, and is not an error
+		if (errno == EINTR) {
+			result = 0;
+		}
+		return result;
+	}
+
+	for (int i = 0; i < result; ++i) {
+		const struct epoll_event& ev = events[i];
+		fds[i].fd = ev.data.fd;
+		fds[i].events = 0;
+		fds[i].revents = 0;
+		if (ev.events & EPOLLIN) fds[i].revents |= POLLIN;
+		if (ev.events & EPOLLPRI) fds[i].revents |= POLLPRI;
+		if (ev.events & EPOLLOUT) fds[i].revents |= POLLOUT;
+		if (ev.events & EPOLLERR) fds[i].revents |= POLLERR;
+		if (ev.events & EPOLLHUP) fds[i].revents |= POLLHUP;
+	}
+	return result;
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
 } // namespace ros
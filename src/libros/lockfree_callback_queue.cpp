@@ -0,0 +1,542 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "ros/lockfree_callback_queue.h"
+#include "ros/assert.h"
+
+#include "ros/threading.h"
+
+#ifdef HAVE_LINUX_FUTEX_H
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <ctime>
+#endif
+
+namespace ros
+{
+
+namespace
+{
+
+/**
+ * \brief Holds a count up for as long as it is in scope
+ */
+template<typename T>
+class ScopedCount
+{
+public:
+  ScopedCount(boost::atomic<T>& count)
+  : count_(count)
+  {
+    count_.fetch_add(1);
+  }
+
+  ~ScopedCount()
+  {
+    count_.fetch_sub(1);
+  }
+
+private:
+  boost::atomic<T>& count_;
+};
+
+}
+
+LockFreeCallbackQueue::LockFreeCallbackQueue(bool enabled, uint32_t capacity)
+: CallbackQueue(enabled)
+, enqueue_pos_(0)
+, dequeue_pos_(0)
+, overflow_size_(0)
+, calling_count_(0)
+, is_enabled_(enabled)
+, waiters_(0)
+, wait_epoch_(0)
+{
+  size_t size = 2;
+  while (size < capacity)
+  {
+    size <<= 1;
+  }
+
+  cells_ = new Cell[size];
+  mask_ = size - 1;
+  for (size_t i = 0; i < size; ++i)
+  {
+    cells_[i].sequence.store(i, boost::memory_order_relaxed);
+  }
+}
+
+LockFreeCallbackQueue::~LockFreeCallbackQueue()
+{
+  disable();
+  delete [] cells_;
+}
+
+void LockFreeCallbackQueue::enable()
+{
+  is_enabled_.store(true);
+  notify(true);
+}
+
+void LockFreeCallbackQueue::disable()
+{
+  is_enabled_.store(false);
+  notify(true);
+}
+
+bool LockFreeCallbackQueue::isEnabled()
+{
+  return is_enabled_.load();
+}
+
+void LockFreeCallbackQueue::clear()
+{
+  QueuedCallback item;
+  while (pop(item))
+  {
+  }
+}
+
+bool LockFreeCallbackQueue::isEmpty()
+{
+  return size() == 0 && calling_count_.load() == 0;
+}
+
+size_t LockFreeCallbackQueue::size()
+{
+  size_t dequeue_pos = dequeue_pos_.load();
+  size_t enqueue_pos = enqueue_pos_.load();
+  size_t in_ring = enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+  return in_ring + overflow_size_.load();
+}
+
+LockFreeCallbackQueue::ThreadState* LockFreeCallbackQueue::getThreadState()
+{
+  ThreadState* state = thread_state_.get();
+  if (!state)
+  {
+    state = new ThreadState;
+    thread_state_.reset(state);
+  }
+
+  return state;
+}
+
+LockFreeCallbackQueue::RemovalIDInfoPtr LockFreeCallbackQueue::getRemovalIDInfo(uint64_t id)
+{
+  ThreadState* state = getThreadState();
+  RemovalIDInfoPtr& cached = state->id_cache[id % ID_CACHE_SIZE];
+  if (cached && cached->id == id && !cached->removed.load())
+  {
+    return cached;
+  }
+
+  IDStripe& stripe = id_stripes_[id % ID_STRIPES];
+  threading::mutex::scoped_lock lock(stripe.mutex);
+  M_RemovalIDInfo::iterator it = stripe.ids.find(id);
+  if (it == stripe.ids.end())
+  {
+    it = stripe.ids.insert(std::make_pair(id, RemovalIDInfoPtr(new RemovalIDInfo(id)))).first;
+  }
+
+  cached = it->second;
+  return cached;
+}
+
+bool LockFreeCallbackQueue::tryPushRing(const QueuedCallback& item)
+{
+  size_t pos = enqueue_pos_.load(boost::memory_order_relaxed);
+  Cell* cell;
+  while (true)
+  {
+    cell = &cells_[pos & mask_];
+    size_t seq = cell->sequence.load(boost::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0)
+    {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (diff < 0)
+    {
+      // Full
+      return false;
+    }
+    else
+    {
+      pos = enqueue_pos_.load(boost::memory_order_relaxed);
+    }
+  }
+
+  cell->item = item;
+  cell->sequence.store(pos + 1, boost::memory_order_release);
+  return true;
+}
+
+bool LockFreeCallbackQueue::tryPopRing(QueuedCallback& item)
+{
+  size_t pos = dequeue_pos_.load(boost::memory_order_relaxed);
+  Cell* cell;
+  while (true)
+  {
+    cell = &cells_[pos & mask_];
+    size_t seq = cell->sequence.load(boost::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (diff == 0)
+    {
+      if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (diff < 0)
+    {
+      // Empty
+      return false;
+    }
+    else
+    {
+      pos = dequeue_pos_.load(boost::memory_order_relaxed);
+    }
+  }
+
+  item = cell->item;
+  cell->item = QueuedCallback();
+  cell->sequence.store(pos + mask_ + 1, boost::memory_order_release);
+  return true;
+}
+
+void LockFreeCallbackQueue::push(const QueuedCallback& item)
+{
+  // Once anything has spilled over, keep adding to the overflow list until it has been drained, so that callbacks
+  // stay roughly in order
+  if (overflow_size_.load() == 0 && tryPushRing(item))
+  {
+    return;
+  }
+
+  threading::mutex::scoped_lock lock(overflow_mutex_);
+  overflow_.push_back(item);
+  overflow_size_.fetch_add(1);
+}
+
+bool LockFreeCallbackQueue::pop(QueuedCallback& item)
+{
+  if (tryPopRing(item))
+  {
+    return true;
+  }
+
+  if (overflow_size_.load() == 0)
+  {
+    return false;
+  }
+
+  threading::mutex::scoped_lock lock(overflow_mutex_);
+  if (overflow_.empty())
+  {
+    return false;
+  }
+
+  item = overflow_.front();
+  overflow_.pop_front();
+  overflow_size_.fetch_sub(1);
+  return true;
+}
+
+void LockFreeCallbackQueue::addCallback(const CallbackInterfacePtr& callback, uint64_t removal_id)
+{
+  if (!is_enabled_.load())
+  {
+    return;
+  }
+
+  QueuedCallback item;
+  item.callback = callback;
+  item.id_info = getRemovalIDInfo(removal_id);
+  push(item);
+
+  // Pairs with the increment of waiters_ in wait(): either the waiter sees the new callback, or we see the waiter
+  boost::atomic_thread_fence(boost::memory_order_seq_cst);
+  if (waiters_.load() > 0)
+  {
+    notify(false);
+  }
+}
+
+void LockFreeCallbackQueue::removeByID(uint64_t removal_id)
+{
+  RemovalIDInfoPtr id_info;
+  {
+    IDStripe& stripe = id_stripes_[removal_id % ID_STRIPES];
+    threading::mutex::scoped_lock lock(stripe.mutex);
+    M_RemovalIDInfo::iterator it = stripe.ids.find(removal_id);
+    if (it == stripe.ids.end())
+    {
+      return;
+    }
+
+    id_info = it->second;
+    stripe.ids.erase(it);
+  }
+
+  // Anything still queued under this ID is dropped when it is popped.  Callbacks added from now on get a new
+  // RemovalIDInfo, and are unaffected.
+  id_info->removed.store(true);
+
+  // Wait for calls already in progress to finish.  If we're being called from within one of them, it counts too.
+  uint32_t own_calls = getThreadState()->calling_in_this_thread == removal_id ? 1 : 0;
+  uint32_t spins = 0;
+  while (id_info->calling.load() > own_calls)
+  {
+    if (++spins < 100)
+    {
+      threading::this_thread::yield();
+    }
+    else
+    {
+      threading::this_thread::sleep(boost::posix_time::milliseconds(1));
+    }
+  }
+}
+
+bool LockFreeCallbackQueue::call(const QueuedCallback& item, ThreadState* state, CallOneResult& result)
+{
+  RemovalIDInfo& id_info = *item.id_info;
+
+  // Pairs with removeByID(): either it sees this call in progress and waits for it, or we see the removal
+  ScopedCount<uint32_t> calling(id_info.calling);
+  if (id_info.removed.load())
+  {
+    return false;
+  }
+
+  uint64_t last_calling = state->calling_in_this_thread;
+  state->calling_in_this_thread = id_info.id;
+
+  CallbackInterface::CallResult call_result = CallbackInterface::Invalid;
+  try
+  {
+    call_result = item.callback->call();
+  }
+  catch (std::exception&)
+  {
+    // ensure that thread id gets restored, even in case of an exception
+    state->calling_in_this_thread = last_calling;
+    throw;
+  }
+
+  state->calling_in_this_thread = last_calling;
+
+  // Push TryAgain callbacks to the back of the queue
+  if (call_result == CallbackInterface::TryAgain && !id_info.removed.load())
+  {
+    push(item);
+    result = TryAgain;
+  }
+  else
+  {
+    result = Called;
+  }
+
+  return true;
+}
+
+LockFreeCallbackQueue::CallOneResult LockFreeCallbackQueue::callOne(ros::WallDuration timeout)
+{
+  if (!is_enabled_.load())
+  {
+    return Disabled;
+  }
+
+  ThreadState* state = getThreadState();
+
+  if (size() == 0)
+  {
+    if (!timeout.isZero())
+    {
+      wait(timeout);
+    }
+
+    if (!is_enabled_.load())
+    {
+      return Disabled;
+    }
+  }
+
+  // Look for a callback which is ready, moving the ones which aren't to the back.  Only go around the queue once.
+  size_t attempts = size();
+  QueuedCallback item;
+  bool tried_any = false;
+  while (attempts-- > 0)
+  {
+    // Counted from before the pop, so that isEmpty() never misses a callback in between
+    ScopedCount<size_t> calling(calling_count_);
+    if (!pop(item))
+    {
+      break;
+    }
+
+    if (item.id_info->removed.load())
+    {
+      continue;
+    }
+
+    if (!item.callback->ready())
+    {
+      tried_any = true;
+      push(item);
+      continue;
+    }
+
+    CallOneResult result = Called;
+    if (call(item, state, result))
+    {
+      return result;
+    }
+  }
+
+  return tried_any ? TryAgain : Empty;
+}
+
+void LockFreeCallbackQueue::callAvailable(ros::WallDuration timeout)
+{
+  if (!is_enabled_.load())
+  {
+    return;
+  }
+
+  if (size() == 0)
+  {
+    if (!timeout.isZero())
+    {
+      wait(timeout);
+    }
+
+    if (!is_enabled_.load())
+    {
+      return;
+    }
+  }
+
+  // Call at most as many callbacks as were queued on entry, so that callbacks which keep re-adding themselves can't
+  // keep us here forever
+  ThreadState* state = getThreadState();
+  size_t available = size();
+  QueuedCallback item;
+  while (available-- > 0 && is_enabled_.load())
+  {
+    ScopedCount<size_t> calling(calling_count_);
+    if (!pop(item))
+    {
+      break;
+    }
+
+    if (item.id_info->removed.load())
+    {
+      continue;
+    }
+
+    if (!item.callback->ready())
+    {
+      push(item);
+      continue;
+    }
+
+    CallOneResult result;
+    call(item, state, result);
+  }
+}
+
+#ifdef HAVE_LINUX_FUTEX_H
+void LockFreeCallbackQueue::wait(ros::WallDuration timeout)
+{
+  int32_t epoch = __sync_fetch_and_add(&wait_epoch_, 0);
+  waiters_.fetch_add(1);
+
+  if (size() == 0 && is_enabled_.load())
+  {
+    struct timespec ts;
+    ts.tv_sec = timeout.sec;
+    ts.tv_nsec = timeout.nsec;
+    // Returns straight away if wait_epoch_ has already moved on, ie. if we have been notified since reading it
+    syscall(SYS_futex, &wait_epoch_, FUTEX_WAIT_PRIVATE, epoch, &ts, NULL, 0);
+  }
+
+  waiters_.fetch_sub(1);
+}
+
+void LockFreeCallbackQueue::notify(bool all)
+{
+  __sync_fetch_and_add(&wait_epoch_, 1);
+  syscall(SYS_futex, &wait_epoch_, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, NULL, NULL, 0);
+}
+#else
+void LockFreeCallbackQueue::wait(ros::WallDuration timeout)
+{
+  threading::mutex::scoped_lock lock(wait_mutex_);
+  waiters_.fetch_add(1);
+
+  if (size() == 0 && is_enabled_.load())
+  {
+    wait_condition_.timed_wait(lock, boost::posix_time::microseconds((int64_t)(timeout.toSec() * 1000000.0)));
+  }
+
+  waiters_.fetch_sub(1);
+}
+
+void LockFreeCallbackQueue::notify(bool all)
+{
+  // Taking the lock makes sure a waiter which has checked the queue is already waiting on the condition
+  {
+    threading::mutex::scoped_lock lock(wait_mutex_);
+  }
+
+  if (all)
+  {
+    wait_condition_.notify_all();
+  }
+  else
+  {
+    wait_condition_.notify_one();
+  }
+}
+#endif
+
+}
@@ -173,7 +173,7 @@ bool getNodes(V_string& nodes)
 }
 
 #if defined(__APPLE__)
-boost::mutex g_xmlrpc_call_mutex;
+threading::mutex g_xmlrpc_call_mutex;
 #endif
 
 bool execute(const std::string& method, const XmlRpc::XmlRpcValue& request, XmlRpc::XmlRpcValue& response, XmlRpc::XmlRpcValue& payload, bool wait_for_master)
@@ -191,7 +191,7 @@ bool execute(const std::string& method, const XmlRpc::XmlRpcValue& request, XmlR
     bool b = false;
     {
 #if defined(__APPLE__)
-      boost::mutex::scoped_lock lock(g_xmlrpc_call_mutex);
+      threading::mutex::scoped_lock lock(g_xmlrpc_call_mutex);
 #endif
 
       b = c->execute(method.c_str(), request, response);
@@ -33,6 +33,8 @@
 namespace ros
 {
 
+boost::atomic<uint64_t> MessageDeserializer::s_avoided_(0);
+
 MessageDeserializer::MessageDeserializer(const SubscriptionCallbackHelperPtr& helper, const SerializedMessage& m, const boost::shared_ptr<M_string>& connection_header)
 : helper_(helper)
 , serialized_message_(m)
@@ -44,17 +46,28 @@ MessageDeserializer::MessageDeserializer(const SubscriptionCallbackHelperPtr& he
   }
 }
 
+MessageDeserializer::~MessageDeserializer()
+{
+  // The buffer is released once deserialize() has been called, so if we still have it nobody ever needed the message
+  if (serialized_message_.buf && !serialized_message_.message)
+  {
+    ++s_avoided_;
+  }
+}
+
 VoidConstPtr MessageDeserializer::deserialize()
 {
-  boost::mutex::scoped_lock lock(mutex_);
+  threading::mutex::scoped_lock lock(mutex_);
 
   if (msg_)
   {
+    ++s_avoided_;
     return msg_;
   }
 
   if (serialized_message_.message)
   {
+    ++s_avoided_;
     msg_ = serialized_message_.message;
     return msg_;
   }
@@ -77,6 +77,52 @@ uint16_t getTCPROSPort()
   return g_tcpros_server_port;
 }
 
+bool isLocalHost(const std::string& host)
+{
+  if (host == g_host || host == "localhost" || host == "::1" ||
+      (host.length() >= 4 && host.substr(0, 4) == "127."))
+  {
+    return true;
+  }
+
+  char hostname[1024];
+  memset(hostname, 0, sizeof(hostname));
+  if (gethostname(hostname, sizeof(hostname) - 1) == 0 && host == hostname)
+  {
+    return true;
+  }
+
+#ifdef HAVE_IFADDRS_H
+  struct ifaddrs *ifa = NULL, *ifp = NULL;
+  if (getifaddrs(&ifp) < 0)
+  {
+    return false;
+  }
+
+  bool found = false;
+  for (ifa = ifp; ifa && !found; ifa = ifa->ifa_next)
+  {
+    char ip_[200];
+    socklen_t salen;
+    if (!ifa->ifa_addr)
+      continue;
+    if (ifa->ifa_addr->sa_family == AF_INET)
+      salen = sizeof(struct sockaddr_in);
+    else if (ifa->ifa_addr->sa_family == AF_INET6)
+      salen = sizeof(struct sockaddr_in6);
+    else
+      continue;
+    if (getnameinfo(ifa->ifa_addr, salen, ip_, sizeof(ip_), NULL, 0, NI_NUMERICHOST) != 0)
+      continue;
+    found = (host == ip_);
+  }
+  freeifaddrs(ifp);
+  return found;
+#else
+  return false;
+#endif
+}
+
 static bool isPrivateIP(const char *ip)
 {
   bool b = !strncmp("192.168", ip, 7) || !strncmp("10.", ip, 3) ||
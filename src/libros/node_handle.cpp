@@ -49,7 +49,7 @@
 namespace ros
 {
 
-boost::mutex g_nh_refcount_mutex;
+threading::mutex g_nh_refcount_mutex;
 int32_t g_nh_refcount = 0;
 bool g_node_started_by_nh = false;
 
@@ -65,7 +65,7 @@ public:
   V_SubImpl subs_;
   V_SrvCImpl srv_cs_;
 
-  boost::mutex mutex_;
+  threading::mutex mutex_;
 };
 
 NodeHandle::NodeHandle(const std::string& ns, const M_string& remappings)
@@ -164,7 +164,7 @@ void NodeHandle::construct(const std::string& ns, bool validate_name)
     }
   ok_ = true;
 
-  boost::mutex::scoped_lock lock(g_nh_refcount_mutex);
+  threading::mutex::scoped_lock lock(g_nh_refcount_mutex);
 
   if (g_nh_refcount == 0 && !ros::isStarted())
   {
@@ -179,7 +179,7 @@ void NodeHandle::destruct()
 {
   delete collection_;
 
-  boost::mutex::scoped_lock lock(g_nh_refcount_mutex);
+  threading::mutex::scoped_lock lock(g_nh_refcount_mutex);
 
   --g_nh_refcount;
 
@@ -303,7 +303,7 @@ Publisher NodeHandle::advertise(AdvertiseOptions& ops)
     Publisher pub(ops.topic, ops.md5sum, ops.datatype, *this, callbacks);
 
     {
-      boost::mutex::scoped_lock lock(collection_->mutex_);
+      threading::mutex::scoped_lock lock(collection_->mutex_);
       collection_->pubs_.push_back(pub.impl_);
     }
 
@@ -333,7 +333,7 @@ Subscriber NodeHandle::subscribe(SubscribeOptions& ops)
     Subscriber sub(ops.topic, *this, ops.helper);
 
     {
-      boost::mutex::scoped_lock lock(collection_->mutex_);
+      threading::mutex::scoped_lock lock(collection_->mutex_);
       collection_->subs_.push_back(sub.impl_);
     }
 
@@ -363,7 +363,7 @@ ServiceServer NodeHandle::advertiseService(AdvertiseServiceOptions& ops)
     ServiceServer srv(ops.service, *this);
 
     {
-      boost::mutex::scoped_lock lock(collection_->mutex_);
+      threading::mutex::scoped_lock lock(collection_->mutex_);
       collection_->srvs_.push_back(srv.impl_);
     }
 
@@ -380,7 +380,7 @@ ServiceClient NodeHandle::serviceClient(ServiceClientOptions& ops)
 
   if (client)
   {
-    boost::mutex::scoped_lock lock(collection_->mutex_);
+    threading::mutex::scoped_lock lock(collection_->mutex_);
     collection_->srv_cs_.push_back(client.impl_);
   }
 
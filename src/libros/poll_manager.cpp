@@ -28,18 +28,20 @@
 #include "ros/poll_manager.h"
 #include "ros/common.h"
 
+#include <algorithm>
+
 #include <signal.h>
 
 namespace ros
 {
 
 PollManagerPtr g_poll_manager;
-boost::mutex g_poll_manager_mutex;
+threading::mutex g_poll_manager_mutex;
 const PollManagerPtr& PollManager::instance()
 {
   if (!g_poll_manager)
   {
-    boost::mutex::scoped_lock lock(g_poll_manager_mutex);
+    threading::mutex::scoped_lock lock(g_poll_manager_mutex);
     if (!g_poll_manager)
     {
       g_poll_manager.reset(new PollManager);
@@ -49,9 +51,17 @@ const PollManagerPtr& PollManager::instance()
   return g_poll_manager;
 }
 
+uint32_t PollManager::s_thread_count_ = 1;
+
 PollManager::PollManager()
   : shutting_down_(false)
 {
+  uint32_t count = std::max<uint32_t>(s_thread_count_, 1);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    poll_sets_.push_back(PollSetPtr(new PollSet));
+  }
+  update_counts_.resize(count, 0);
 }
 
 PollManager::~PollManager()
@@ -62,7 +72,11 @@ PollManager::~PollManager()
 void PollManager::start()
 {
   shutting_down_ = false;
-  thread_ = boost::thread(&PollManager::threadFunc, this);
+  threads_.clear();
+  for (uint32_t i = 0; i < poll_sets_.size(); ++i)
+  {
+    threads_.push_back(ThreadPtr(new threading::thread(&PollManager::threadFunc, this, i)));
+  }
 }
 
 void PollManager::shutdown()
@@ -70,23 +84,35 @@ void PollManager::shutdown()
   if (shutting_down_) return;
 
   shutting_down_ = true;
-  if (thread_.get_id() != boost::this_thread::get_id())
+  for (uint32_t i = 0; i < threads_.size(); ++i)
   {
-    thread_.join();
+    poll_sets_[i]->signal();
+    if (threads_[i]->get_id() != threading::this_thread::get_id())
+    {
+      threads_[i]->join();
+    }
   }
 
-  boost::recursive_mutex::scoped_lock lock(signal_mutex_);
+  threading::recursive_mutex::scoped_lock lock(signal_mutex_);
   poll_signal_.disconnect_all_slots();
 }
 
-void PollManager::threadFunc()
+uint64_t PollManager::getUpdateCount(uint32_t index)
+{
+  threading::mutex::scoped_lock lock(update_counts_mutex_);
+  return update_counts_[index];
+}
+
+void PollManager::threadFunc(uint32_t index)
 {
   disableAllSignalsInThisThread();
 
+  PollSet& poll_set = *poll_sets_[index];
   while (!shutting_down_)
   {
+    if (index == 0)
     {
-      boost::recursive_mutex::scoped_lock lock(signal_mutex_);
+      threading::recursive_mutex::scoped_lock lock(signal_mutex_);
       poll_signal_();
     }
 
@@ -95,19 +121,24 @@ void PollManager::threadFunc()
       return;
     }
 
-    poll_set_.update(100);
+    poll_set.update(100);
+
+    {
+      threading::mutex::scoped_lock lock(update_counts_mutex_);
+      ++update_counts_[index];
+    }
   }
 }
 
 boost::signals2::connection PollManager::addPollThreadListener(const VoidFunc& func)
 {
-  boost::recursive_mutex::scoped_lock lock(signal_mutex_);
+  threading::recursive_mutex::scoped_lock lock(signal_mutex_);
   return poll_signal_.connect(func);
 }
 
 void PollManager::removePollThreadListener(boost::signals2::connection c)
 {
-  boost::recursive_mutex::scoped_lock lock(signal_mutex_);
+  threading::recursive_mutex::scoped_lock lock(signal_mutex_);
   c.disconnect();
 }
 
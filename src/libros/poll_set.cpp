@@ -41,14 +41,33 @@
 
 #include <boost/bind.hpp>
 
+#include <algorithm>
+
 #include <fcntl.h>
 
 namespace ros
 {
 
+PollSet::Backend PollSet::s_backend_ = PollSet::EpollLevelTriggered;
+
 PollSet::PollSet()
 : sockets_changed_(false)
+, backend_(Poll)
+, epfd_(-1)
 {
+  if (s_backend_ != Poll && socket_watcher_available())
+  {
+    epfd_ = create_socket_watcher();
+    if (epfd_ >= 0)
+    {
+      backend_ = s_backend_;
+    }
+    else
+    {
+      ROS_WARN("Could not create epoll watcher, falling back to poll()");
+    }
+  }
+
 	if ( create_signal_pair(signal_pipe_) != 0 ) {
         ROS_FATAL("create_signal_pair() failed");
     ROS_BREAK();
@@ -60,6 +79,7 @@ PollSet::PollSet()
 PollSet::~PollSet()
 {
   close_signal_pair(signal_pipe_);
+  close_socket_watcher(epfd_);
 }
 
 bool PollSet::addSocket(int fd, const SocketUpdateFunc& update_func, const TransportPtr& transport)
@@ -71,7 +91,7 @@ bool PollSet::addSocket(int fd, const SocketUpdateFunc& update_func, const Trans
   info.func_ = update_func;
 
   {
-    boost::mutex::scoped_lock lock(socket_info_mutex_);
+    threading::mutex::scoped_lock lock(socket_info_mutex_);
 
     bool b = socket_info_.insert(std::make_pair(fd, info)).second;
     if (!b)
@@ -80,6 +100,11 @@ bool PollSet::addSocket(int fd, const SocketUpdateFunc& update_func, const Trans
       return false;
     }
 
+    if (epfd_ >= 0 && add_socket_to_watcher(epfd_, fd) != 0)
+    {
+      ROS_ERROR("PollSet: Failed to add fd [%d] to epoll watcher: [%s]", fd, last_socket_error_string());
+    }
+
     sockets_changed_ = true;
   }
 
@@ -95,14 +120,19 @@ bool PollSet::delSocket(int fd)
     return false;
   }
 
-  boost::mutex::scoped_lock lock(socket_info_mutex_);
+  threading::mutex::scoped_lock lock(socket_info_mutex_);
   M_SocketInfo::iterator it = socket_info_.find(fd);
   if (it != socket_info_.end())
   {
     socket_info_.erase(it);
 
+    if (epfd_ >= 0)
+    {
+      del_socket_from_watcher(epfd_, fd);
+    }
+
     {
-      boost::mutex::scoped_lock lock(just_deleted_mutex_);
+      threading::mutex::scoped_lock lock(just_deleted_mutex_);
       just_deleted_.push_back(fd);
     }
 
@@ -120,7 +150,7 @@ bool PollSet::delSocket(int fd)
 
 bool PollSet::addEvents(int sock, int events)
 {
-  boost::mutex::scoped_lock lock(socket_info_mutex_);
+  threading::mutex::scoped_lock lock(socket_info_mutex_);
 
   M_SocketInfo::iterator it = socket_info_.find(sock);
 
@@ -132,6 +162,14 @@ bool PollSet::addEvents(int sock, int events)
 
   it->second.events_ |= events;
 
+  if (epfd_ >= 0)
+  {
+    // the watcher picks up the change immediately, no need to wake the poll thread
+    updateWatcherEvents(sock, it->second.events_);
+    return true;
+  }
+
+  sockets_changed_ = true;
   signal();
 
   return true;
@@ -139,7 +177,7 @@ bool PollSet::addEvents(int sock, int events)
 
 bool PollSet::delEvents(int sock, int events)
 {
-  boost::mutex::scoped_lock lock(socket_info_mutex_);
+  threading::mutex::scoped_lock lock(socket_info_mutex_);
 
   M_SocketInfo::iterator it = socket_info_.find(sock);
   if (it != socket_info_.end())
@@ -152,14 +190,29 @@ bool PollSet::delEvents(int sock, int events)
     return false;
   }
 
+  if (epfd_ >= 0)
+  {
+    updateWatcherEvents(sock, it->second.events_);
+    return true;
+  }
+
+  sockets_changed_ = true;
   signal();
 
   return true;
 }
 
+void PollSet::updateWatcherEvents(int fd, int events)
+{
+  if (set_events_on_socket(epfd_, fd, events, backend_ == EpollEdgeTriggered) != 0)
+  {
+    ROSCPP_LOG_DEBUG("PollSet: Failed to set events [%d] on fd [%d]: [%s]", events, fd, last_socket_error_string());
+  }
+}
+
 void PollSet::signal()
 {
-  boost::mutex::scoped_try_lock lock(signal_mutex_);
+  threading::mutex::scoped_try_lock lock(signal_mutex_);
 
   if (lock.owns_lock())
   {
@@ -176,10 +229,20 @@ void PollSet::update(int poll_timeout)
 {
   createNativePollset();
 
-  // Poll across the sockets we're servicing
+  // Poll across the sockets we're servicing.  The epoll watcher only hands back the ones with events.
   int ret;
   size_t ufds_count = ufds_.size();
-  if((ret = poll_sockets(&ufds_.front(), ufds_count, poll_timeout)) < 0)
+  if (epfd_ >= 0)
+  {
+    ret = poll_socket_watcher(epfd_, &ufds_.front(), ufds_count, poll_timeout);
+    ufds_count = std::max(ret, 0);
+  }
+  else
+  {
+    ret = poll_sockets(&ufds_.front(), ufds_count, poll_timeout);
+  }
+
+  if (ret < 0)
   {
 	  ROS_ERROR_STREAM("poll failed with error " << last_socket_error_string());
     }
@@ -197,7 +260,7 @@ void PollSet::update(int poll_timeout)
       TransportPtr transport;
       int events = 0;
       {
-        boost::mutex::scoped_lock lock(socket_info_mutex_);
+        threading::mutex::scoped_lock lock(socket_info_mutex_);
         M_SocketInfo::iterator it = socket_info_.find(ufds_[i].fd);
         // the socket has been entirely deleted
         if (it == socket_info_.end())
@@ -230,7 +293,7 @@ void PollSet::update(int poll_timeout)
           // but which is actually referring to the previous fd with the same #.  If this is the case,
           // we ignore the first instance of one of these errors.  If it's a real error we'll
           // hit it again next time through.
-          boost::mutex::scoped_lock lock(just_deleted_mutex_);
+          threading::mutex::scoped_lock lock(just_deleted_mutex_);
           if (std::find(just_deleted_.begin(), just_deleted_.end(), ufds_[i].fd) != just_deleted_.end())
           {
             skip = true;
@@ -241,25 +304,44 @@ void PollSet::update(int poll_timeout)
         {
           func(revents & (events|POLLERR|POLLHUP|POLLNVAL));
         }
+        else if (backend_ == EpollEdgeTriggered)
+        {
+          // Edge-triggered, we'll only hit it again if the watcher is told to look at the socket afresh
+          threading::mutex::scoped_lock lock(socket_info_mutex_);
+          M_SocketInfo::iterator it = socket_info_.find(ufds_[i].fd);
+          if (it != socket_info_.end())
+          {
+            updateWatcherEvents(ufds_[i].fd, it->second.events_);
+          }
+        }
       }
 
       ufds_[i].revents = 0;
     }
 
-    boost::mutex::scoped_lock lock(just_deleted_mutex_);
+    threading::mutex::scoped_lock lock(just_deleted_mutex_);
     just_deleted_.clear();
   }
 }
 
 void PollSet::createNativePollset()
 {
-  boost::mutex::scoped_lock lock(socket_info_mutex_);
+  threading::mutex::scoped_lock lock(socket_info_mutex_);
 
   if (!sockets_changed_)
   {
     return;
   }
 
+  sockets_changed_ = false;
+
+  if (epfd_ >= 0)
+  {
+    // Interest is already registered with the watcher, ufds_ just receives the ready sockets
+    ufds_.resize(socket_info_.size());
+    return;
+  }
+
   // Build the list of structures to pass to poll for the sockets we're servicing
   ufds_.resize(socket_info_.size());
   M_SocketInfo::iterator sock_it = socket_info_.begin();
@@ -0,0 +1,100 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/priority_callback_queue.h"
+
+namespace ros
+{
+
+PriorityCallbackQueue::PriorityCallbackQueue(ros::WallDuration starvation_timeout, bool enabled)
+: CallbackQueue(enabled)
+, starvation_timeout_(starvation_timeout)
+{
+}
+
+PriorityCallbackQueue::~PriorityCallbackQueue()
+{
+  disable();
+}
+
+void PriorityCallbackQueue::setStarvationTimeout(ros::WallDuration timeout)
+{
+  threading::mutex::scoped_lock lock(mutex_);
+  starvation_timeout_ = timeout;
+}
+
+ros::WallDuration PriorityCallbackQueue::getStarvationTimeout()
+{
+  threading::mutex::scoped_lock lock(mutex_);
+  return starvation_timeout_;
+}
+
+void PriorityCallbackQueue::pushCallback(const CallbackInfo& info)
+{
+  WallTime now = WallTime::now();
+
+  CallbackInfo queued = info;
+  // Callbacks pushed back after returning TryAgain keep the time they were first added, so they don't lose their place
+  // to aging
+  if (queued.added.isZero())
+  {
+    queued.added = now;
+    queued.priority = queued.callback->getPriority();
+  }
+
+  // Walk forward from the back, past callbacks with a lower priority which have not been waiting too long yet.  One that
+  // has been waiting too long stops the walk, so nothing added after it overtakes it.
+  D_CallbackInfo::iterator it = callbacks_.end();
+  while (it != callbacks_.begin())
+  {
+    D_CallbackInfo::iterator prev = it;
+    --prev;
+
+    if (prev->priority >= queued.priority || now - prev->added >= starvation_timeout_)
+    {
+      break;
+    }
+
+    it = prev;
+  }
+
+  callbacks_.insert(it, queued);
+}
+
+void PriorityCallbackQueue::callAvailable(ros::WallDuration timeout)
+{
+  callAvailableInTurn(timeout);
+}
+
+}
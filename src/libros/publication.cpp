@@ -86,6 +86,7 @@ Publication::Publication(const std::string &name,
   message_definition_(message_definition),
   max_queue_(max_queue),
   seq_(0),
+  subscriber_links_(new V_SubscriberLink),
   dropped_(false),
   latch_(latch),
   has_header_(has_header),
@@ -100,16 +101,16 @@ Publication::~Publication()
 
 void Publication::addCallbacks(const SubscriberCallbacksPtr& callbacks)
 {
-  boost::mutex::scoped_lock lock(callbacks_mutex_);
+  threading::mutex::scoped_lock lock(callbacks_mutex_);
 
   callbacks_.push_back(callbacks);
 
   // Add connect callbacks for all current subscriptions if this publisher wants them
   if (callbacks->connect_ && callbacks->callback_queue_)
   {
-    boost::mutex::scoped_lock lock(subscriber_links_mutex_);
-    V_SubscriberLink::iterator it = subscriber_links_.begin();
-    V_SubscriberLink::iterator end = subscriber_links_.end();
+    threading::pi_mutex::scoped_lock lock(subscriber_links_mutex_);
+    V_SubscriberLink::const_iterator it = subscriber_links_->begin();
+    V_SubscriberLink::const_iterator end = subscriber_links_->end();
     for (; it != end; ++it)
     {
       const SubscriberLinkPtr& sub_link = *it;
@@ -121,7 +122,7 @@ void Publication::addCallbacks(const SubscriberCallbacksPtr& callbacks)
 
 void Publication::removeCallbacks(const SubscriberCallbacksPtr& callbacks)
 {
-  boost::mutex::scoped_lock lock(callbacks_mutex_);
+  threading::mutex::scoped_lock lock(callbacks_mutex_);
 
   V_Callback::iterator it = std::find(callbacks_.begin(), callbacks_.end(), callbacks);
   if (it != callbacks_.end())
@@ -137,11 +138,11 @@ void Publication::removeCallbacks(const SubscriberCallbacksPtr& callbacks)
 
 void Publication::drop()
 {
-  // grab a lock here, to ensure that no subscription callback will
-  // be invoked after we return
+  // grab a lock here, to ensure that nothing more is published once we return.  A message which
+  // was already being handed to the links from a snapshot of them may still go out.
   {
-    boost::mutex::scoped_lock lock(publish_queue_mutex_);
-    boost::mutex::scoped_lock lock2(subscriber_links_mutex_);
+    threading::pi_mutex::scoped_lock lock(publish_queue_mutex_);
+    threading::pi_mutex::scoped_lock lock2(subscriber_links_mutex_);
 
     if (dropped_)
     {
@@ -156,7 +157,6 @@ void Publication::drop()
 
 bool Publication::enqueueMessage(const SerializedMessage& m)
 {
-  boost::mutex::scoped_lock lock(subscriber_links_mutex_);
   if (dropped_)
   {
     return false;
@@ -178,16 +178,25 @@ bool Publication::enqueueMessage(const SerializedMessage& m)
     ser::serialize(ostream, header);
   }
 
-  for(V_SubscriberLink::iterator i = subscriber_links_.begin();
-      i != subscriber_links_.end(); ++i)
+  V_SubscriberLinkConstPtr links;
+  if (latch_)
   {
-    const SubscriberLinkPtr& sub_link = (*i);
-    sub_link->enqueueMessage(m, true, false);
+    // Take the snapshot along with storing the latched message, so a link added concurrently gets either this
+    // message or the latched one
+    threading::pi_mutex::scoped_lock lock(subscriber_links_mutex_);
+    last_message_ = m;
+    links = subscriber_links_;
+  }
+  else
+  {
+    links = boost::atomic_load(&subscriber_links_);
   }
 
-  if (latch_)
+  for(V_SubscriberLink::const_iterator i = links->begin();
+      i != links->end(); ++i)
   {
-    last_message_ = m;
+    const SubscriberLinkPtr& sub_link = (*i);
+    sub_link->enqueueMessage(m, true, false);
   }
 
   return true;
@@ -195,25 +204,30 @@ bool Publication::enqueueMessage(const SerializedMessage& m)
 
 void Publication::addSubscriberLink(const SubscriberLinkPtr& sub_link)
 {
+  SerializedMessage last_message;
   {
-    boost::mutex::scoped_lock lock(subscriber_links_mutex_);
+    threading::pi_mutex::scoped_lock lock(subscriber_links_mutex_);
 
     if (dropped_)
     {
       return;
     }
 
-    subscriber_links_.push_back(sub_link);
+    V_SubscriberLink links(*subscriber_links_);
+    links.push_back(sub_link);
+    setSubscriberLinks(links);
 
     if (sub_link->isIntraprocess())
     {
       ++intraprocess_subscriber_count_;
     }
+
+    last_message = last_message_;
   }
 
-  if (latch_ && last_message_.buf)
+  if (latch_ && last_message.buf)
   {
-    sub_link->enqueueMessage(last_message_, true, true);
+    sub_link->enqueueMessage(last_message, true, true);
   }
 
   // This call invokes the subscribe callback if there is one.
@@ -226,7 +240,7 @@ void Publication::removeSubscriberLink(const SubscriberLinkPtr& sub_link)
 {
   SubscriberLinkPtr link;
   {
-    boost::mutex::scoped_lock lock(subscriber_links_mutex_);
+    threading::pi_mutex::scoped_lock lock(subscriber_links_mutex_);
 
     if (dropped_)
     {
@@ -238,11 +252,13 @@ void Publication::removeSubscriberLink(const SubscriberLinkPtr& sub_link)
       --intraprocess_subscriber_count_;
     }
 
-    V_SubscriberLink::iterator it = std::find(subscriber_links_.begin(), subscriber_links_.end(), sub_link);
-    if (it != subscriber_links_.end())
+    V_SubscriberLink links(*subscriber_links_);
+    V_SubscriberLink::iterator it = std::find(links.begin(), links.end(), sub_link);
+    if (it != links.end())
     {
       link = *it;
-      subscriber_links_.erase(it);
+      links.erase(it);
+      setSubscriberLinks(links);
     }
   }
 
@@ -259,11 +275,11 @@ XmlRpc::XmlRpcValue Publication::getStats()
   XmlRpc::XmlRpcValue conn_data;
   conn_data.setSize(0); // force to be an array, even if it's empty
 
-  boost::mutex::scoped_lock lock(subscriber_links_mutex_);
+  V_SubscriberLinkConstPtr links = boost::atomic_load(&subscriber_links_);
 
   uint32_t cidx = 0;
-  for (V_SubscriberLink::iterator c = subscriber_links_.begin();
-       c != subscriber_links_.end(); ++c, cidx++)
+  for (V_SubscriberLink::const_iterator c = links->begin();
+       c != links->end(); ++c, cidx++)
   {
     const SubscriberLink::Stats& s = (*c)->getStats();
     conn_data[cidx][0] = (*c)->getConnectionID();
@@ -286,10 +302,10 @@ XmlRpc::XmlRpcValue Publication::getStats()
 // e.g. [(2, '/listener', 'o', 'TCPROS', '/chatter', 1, 'TCPROS connection on port 55878 to [127.0.0.1:44273 on socket 7]')]
 void Publication::getInfo(XmlRpc::XmlRpcValue& info)
 {
-  boost::mutex::scoped_lock lock(subscriber_links_mutex_);
+  V_SubscriberLinkConstPtr links = boost::atomic_load(&subscriber_links_);
 
-  for (V_SubscriberLink::iterator c = subscriber_links_.begin();
-       c != subscriber_links_.end(); ++c)
+  for (V_SubscriberLink::const_iterator c = links->begin();
+       c != links->end(); ++c)
   {
     XmlRpc::XmlRpcValue curr_info;
     curr_info[0] = (int)(*c)->getConnectionID();
@@ -310,9 +326,10 @@ void Publication::dropAllConnections()
   V_SubscriberLink local_publishers;
 
   {
-    boost::mutex::scoped_lock lock(subscriber_links_mutex_);
+    threading::pi_mutex::scoped_lock lock(subscriber_links_mutex_);
 
-    local_publishers.swap(subscriber_links_);
+    local_publishers = *subscriber_links_;
+    setSubscriberLinks(V_SubscriberLink());
   }
 
   for (V_SubscriberLink::iterator i = local_publishers.begin();
@@ -322,6 +339,29 @@ void Publication::dropAllConnections()
   }
 }
 
+void Publication::setSubscriberLinks(const V_SubscriberLink& links)
+{
+  boost::shared_ptr<V_SubscriberLink> intraprocess_links(new V_SubscriberLink);
+
+  V_SubscriberLink::const_iterator it = links.begin();
+  V_SubscriberLink::const_iterator end = links.end();
+  for (; it != end; ++it)
+  {
+    if ((*it)->isIntraprocess())
+    {
+      intraprocess_links->push_back(*it);
+    }
+  }
+
+  if (intraprocess_links->empty())
+  {
+    intraprocess_links.reset();
+  }
+
+  boost::atomic_store(&intraprocess_links_, V_SubscriberLinkConstPtr(intraprocess_links));
+  boost::atomic_store(&subscriber_links_, V_SubscriberLinkConstPtr(new V_SubscriberLink(links)));
+}
+
 void Publication::peerConnect(const SubscriberLinkPtr& sub_link)
 {
   V_Callback::iterator it = callbacks_.begin();
@@ -354,13 +394,13 @@ void Publication::peerDisconnect(const SubscriberLinkPtr& sub_link)
 
 size_t Publication::getNumCallbacks()
 {
-  boost::mutex::scoped_lock lock(callbacks_mutex_);
+  threading::mutex::scoped_lock lock(callbacks_mutex_);
   return callbacks_.size();
 }
 
 uint32_t Publication::incrementSequence()
 {
-  boost::mutex::scoped_lock lock(seq_mutex_);
+  threading::pi_mutex::scoped_lock lock(seq_mutex_);
   uint32_t old_seq = seq_;
   ++seq_;
 
@@ -369,15 +409,14 @@ uint32_t Publication::incrementSequence()
 
 uint32_t Publication::getNumSubscribers()
 {
-  boost::mutex::scoped_lock lock(subscriber_links_mutex_);
-  return (uint32_t)subscriber_links_.size();
+  return (uint32_t)boost::atomic_load(&subscriber_links_)->size();
 }
 
 void Publication::getPublishTypes(bool& serialize, bool& nocopy, const std::type_info& ti)
 {
-  boost::mutex::scoped_lock lock(subscriber_links_mutex_);
-  V_SubscriberLink::const_iterator it = subscriber_links_.begin();
-  V_SubscriberLink::const_iterator end = subscriber_links_.end();
+  V_SubscriberLinkConstPtr links = boost::atomic_load(&subscriber_links_);
+  V_SubscriberLink::const_iterator it = links->begin();
+  V_SubscriberLink::const_iterator end = links->end();
   for (; it != end; ++it)
   {
     const SubscriberLinkPtr& sub = *it;
@@ -396,23 +435,25 @@ void Publication::getPublishTypes(bool& serialize, bool& nocopy, const std::type
 
 bool Publication::hasSubscribers()
 {
-  boost::mutex::scoped_lock lock(subscriber_links_mutex_);
-  return !subscriber_links_.empty();
+  return !boost::atomic_load(&subscriber_links_)->empty();
 }
 
 void Publication::publish(SerializedMessage& m)
 {
   if (m.message)
   {
-    boost::mutex::scoped_lock lock(subscriber_links_mutex_);
-    V_SubscriberLink::const_iterator it = subscriber_links_.begin();
-    V_SubscriberLink::const_iterator end = subscriber_links_.end();
-    for (; it != end; ++it)
+    // Every intraprocess subscriber gets the same message, straight from the snapshot, so this neither serializes
+    // nor takes subscriber_links_mutex_.  Publishing can still wait on a subscriber connecting, since
+    // TopicManager::publish() looks the publication up under advertised_topics_mutex_, which
+    // registerSubscriber() also takes.
+    V_SubscriberLinkConstPtr links = boost::atomic_load(&intraprocess_links_);
+    if (links)
     {
-      const SubscriberLinkPtr& sub = *it;
-      if (sub->isIntraprocess())
+      V_SubscriberLink::const_iterator it = links->begin();
+      V_SubscriberLink::const_iterator end = links->end();
+      for (; it != end; ++it)
       {
-        sub->enqueueMessage(m, false, true);
+        (*it)->enqueueMessage(m, false, true);
       }
     }
 
@@ -421,7 +462,7 @@ void Publication::publish(SerializedMessage& m)
 
   if (m.buf)
   {
-    boost::mutex::scoped_lock lock(publish_queue_mutex_);
+    threading::pi_mutex::scoped_lock lock(publish_queue_mutex_);
     publish_queue_.push_back(m);
   }
 }
@@ -430,7 +471,7 @@ void Publication::processPublishQueue()
 {
   V_SerializedMessage queue;
   {
-    boost::mutex::scoped_lock lock(publish_queue_mutex_);
+    threading::pi_mutex::scoped_lock lock(publish_queue_mutex_);
 
     if (dropped_)
     {
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "ros/realtime_publisher.h"
+#include "ros/buffer_pool.h"
+
+#include <cstring>
+
+#ifdef HAVE_LINUX_FUTEX_H
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <ctime>
+#endif
+
+namespace ros
+{
+
+namespace
+{
+
+SerializedMessage returnSerialized(const SerializedMessage& m)
+{
+  return m;
+}
+
+uint32_t roundUpToPowerOfTwo(uint32_t n)
+{
+  uint32_t p = 1;
+  while (p < n)
+  {
+    p <<= 1;
+  }
+
+  return p;
+}
+
+}
+
+RealtimePublisherBase::RealtimePublisherBase(const Publisher& publisher, uint32_t num_slots, uint32_t slot_size,
+                                             bool owns_advertisement)
+: publisher_(publisher)
+, owns_advertisement_(owns_advertisement)
+, num_slots_(roundUpToPowerOfTwo(num_slots ? num_slots : 1))
+, slot_mask_(num_slots_ - 1)
+, slot_size_(slot_size)
+, slots_(new uint8_t[(size_t)num_slots_ * slot_size_])
+, lengths_(new uint32_t[num_slots_])
+, head_(0)
+, tail_(0)
+, published_(0)
+, dropped_full_(0)
+, dropped_oversize_(0)
+, waiting_(false)
+, shutting_down_(false)
+, wait_epoch_(0)
+{
+  // Touch every page now, so the real-time thread doesn't take page faults the first time it uses a slot
+  memset(slots_.get(), 0, (size_t)num_slots_ * slot_size_);
+  memset(lengths_.get(), 0, num_slots_ * sizeof(uint32_t));
+
+  if (!publisher_)
+  {
+    ROS_ERROR("RealtimePublisher created with an invalid Publisher");
+    return;
+  }
+
+  publish_thread_ = threading::thread(boost::bind(&RealtimePublisherBase::publishThread, this));
+}
+
+RealtimePublisherBase::~RealtimePublisherBase()
+{
+  shutdown();
+}
+
+void RealtimePublisherBase::shutdown()
+{
+  if (shutting_down_.exchange(true))
+  {
+    return;
+  }
+
+  wake();
+
+  if (publish_thread_.joinable())
+  {
+    publish_thread_.join();
+  }
+
+  // Publisher::shutdown() unadvertises for every copy of the Publisher, including the caller's
+  if (owns_advertisement_)
+  {
+    publisher_.shutdown();
+  }
+  else
+  {
+    publisher_ = Publisher();
+  }
+}
+
+RealtimePublisherBase::Stats RealtimePublisherBase::getStats() const
+{
+  Stats stats;
+  stats.published = published_.load(boost::memory_order_relaxed);
+  stats.dropped_full = dropped_full_.load(boost::memory_order_relaxed);
+  stats.dropped_oversize = dropped_oversize_.load(boost::memory_order_relaxed);
+  return stats;
+}
+
+void RealtimePublisherBase::commit(uint32_t num_bytes)
+{
+  uint32_t tail = tail_.load(boost::memory_order_relaxed);
+  lengths_[tail & slot_mask_] = num_bytes;
+  // Sequentially consistent, so that either this store is seen by the publish thread before it goes to sleep,
+  // or its waiting_ flag is seen here
+  tail_.store(tail + 1);
+  published_.fetch_add(1, boost::memory_order_relaxed);
+
+  if (waiting_.load())
+  {
+    wake();
+  }
+}
+
+bool RealtimePublisherBase::publishOne()
+{
+  uint32_t head = head_.load(boost::memory_order_relaxed);
+  if (head == tail_.load(boost::memory_order_acquire))
+  {
+    return false;
+  }
+
+  // Copy the message out so the slot can go straight back to the real-time thread, however long the subscriber
+  // links hold on to the buffer
+  uint32_t index = head & slot_mask_;
+  SerializedMessage m2;
+  m2.num_bytes = lengths_[index];
+  m2.buf = BufferPool::instance().allocate(m2.num_bytes);
+  memcpy(m2.buf.get(), &slots_[(size_t)index * slot_size_], m2.num_bytes);
+  m2.message_start = m2.buf.get() + 4;
+  head_.store(head + 1, boost::memory_order_release);
+
+  SerializedMessage m;
+  publisher_.publish(boost::bind(returnSerialized, m2), m);
+
+  return true;
+}
+
+void RealtimePublisherBase::publishThread()
+{
+  while (true)
+  {
+    while (publishOne())
+    {
+    }
+
+    if (shutting_down_.load())
+    {
+      // Anything committed before shutdown() was called has been published by now
+      while (publishOne())
+      {
+      }
+
+      break;
+    }
+
+    wait();
+  }
+}
+
+#ifdef HAVE_LINUX_FUTEX_H
+void RealtimePublisherBase::wait()
+{
+  int32_t epoch = __sync_fetch_and_add(&wait_epoch_, 0);
+  waiting_.store(true);
+
+  if (head_.load(boost::memory_order_relaxed) == tail_.load() && !shutting_down_.load())
+  {
+    struct timespec ts;
+    ts.tv_sec = 0;
+    ts.tv_nsec = 100000000;
+    // Returns straight away if wait_epoch_ has already moved on, ie. if we have been woken since reading it
+    syscall(SYS_futex, &wait_epoch_, FUTEX_WAIT_PRIVATE, epoch, &ts, NULL, 0);
+  }
+
+  waiting_.store(false);
+}
+
+void RealtimePublisherBase::wake()
+{
+  __sync_fetch_and_add(&wait_epoch_, 1);
+  syscall(SYS_futex, &wait_epoch_, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+#else
+void RealtimePublisherBase::wait()
+{
+  threading::mutex::scoped_lock lock(wait_mutex_);
+  waiting_.store(true);
+
+  if (head_.load(boost::memory_order_relaxed) == tail_.load() && !shutting_down_.load())
+  {
+    // Short timeout, since wake() gives up rather than block the real-time thread if it can't get the lock
+    wait_condition_.timed_wait(lock, boost::posix_time::milliseconds(1));
+  }
+
+  waiting_.store(false);
+}
+
+void RealtimePublisherBase::wake()
+{
+  // Only ever try the lock: if the publish thread holds it, it has not started waiting yet, or is just about to
+  // wake up anyway
+  threading::mutex::scoped_lock lock(wait_mutex_, boost::try_to_lock);
+  if (lock.owns_lock())
+  {
+    wait_condition_.notify_one();
+  }
+}
+#endif
+
+} // namespace ros
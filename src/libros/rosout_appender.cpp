@@ -60,7 +60,7 @@ ROSOutAppender::~ROSOutAppender()
   shutting_down_ = true;
 
   {
-    boost::mutex::scoped_lock lock(queue_mutex_);
+    threading::mutex::scoped_lock lock(queue_mutex_);
     queue_condition_.notify_all();
   }
 
@@ -109,7 +109,7 @@ void ROSOutAppender::log(::ros::console::Level level, const char* str, const cha
     last_error_ = str;
   }
 
-  boost::mutex::scoped_lock lock(queue_mutex_);
+  threading::mutex::scoped_lock lock(queue_mutex_);
   log_queue_.push_back(msg);
   queue_condition_.notify_all();
 }
@@ -121,7 +121,7 @@ void ROSOutAppender::logThread()
     V_Log local_queue;
 
     {
-      boost::mutex::scoped_lock lock(queue_mutex_);
+      threading::mutex::scoped_lock lock(queue_mutex_);
 
       if (shutting_down_)
       {
@@ -53,12 +53,12 @@ namespace ros
 {
 
 ServiceManagerPtr g_service_manager;
-boost::mutex g_service_manager_mutex;
+threading::mutex g_service_manager_mutex;
 const ServiceManagerPtr& ServiceManager::instance()
 {
   if (!g_service_manager)
   {
-    boost::mutex::scoped_lock lock(g_service_manager_mutex);
+    threading::mutex::scoped_lock lock(g_service_manager_mutex);
     if (!g_service_manager)
     {
       g_service_manager.reset(new ServiceManager);
@@ -90,7 +90,7 @@ void ServiceManager::start()
 
 void ServiceManager::shutdown()
 {
-  boost::recursive_mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
+  threading::recursive_mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
   if (shutting_down_)
   {
     return;
@@ -100,7 +100,7 @@ void ServiceManager::shutdown()
 
   ROSCPP_LOG_DEBUG("ServiceManager::shutdown(): unregistering our advertised services");
   {
-    boost::mutex::scoped_lock ss_lock(service_publications_mutex_);
+    threading::mutex::scoped_lock ss_lock(service_publications_mutex_);
 
     for (L_ServicePublication::iterator i = service_publications_.begin();
          i != service_publications_.end(); ++i)
@@ -114,7 +114,7 @@ void ServiceManager::shutdown()
 
   L_ServiceServerLink local_service_clients;
   {
-    boost::mutex::scoped_lock lock(service_server_links_mutex_);
+    threading::mutex::scoped_lock lock(service_server_links_mutex_);
     local_service_clients.swap(service_server_links_);
   }
 
@@ -133,14 +133,14 @@ void ServiceManager::shutdown()
 
 bool ServiceManager::advertiseService(const AdvertiseServiceOptions& ops)
 {
-  boost::recursive_mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
+  threading::recursive_mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
   if (shutting_down_)
   {
     return false;
   }
 
   {
-    boost::mutex::scoped_lock lock(service_publications_mutex_);
+    threading::mutex::scoped_lock lock(service_publications_mutex_);
 
     if (isServiceAdvertised(ops.service))
     {
@@ -148,7 +148,7 @@ bool ServiceManager::advertiseService(const AdvertiseServiceOptions& ops)
       return false;
     }
 
-    ServicePublicationPtr pub(new ServicePublication(ops.service, ops.md5sum, ops.datatype, ops.req_datatype, ops.res_datatype, ops.helper, ops.callback_queue, ops.tracked_object));
+    ServicePublicationPtr pub(new ServicePublication(ops.service, ops.md5sum, ops.datatype, ops.req_datatype, ops.res_datatype, ops.helper, ops.callback_queue, ops.tracked_object, ops.priority));
     service_publications_.push_back(pub);
   }
 
@@ -167,7 +167,7 @@ bool ServiceManager::advertiseService(const AdvertiseServiceOptions& ops)
 
 bool ServiceManager::unadvertiseService(const string &serv_name)
 {
-  boost::recursive_mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
+  threading::recursive_mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
   if (shutting_down_)
   {
     return false;
@@ -175,7 +175,7 @@ bool ServiceManager::unadvertiseService(const string &serv_name)
 
   ServicePublicationPtr pub;
   {
-    boost::mutex::scoped_lock lock(service_publications_mutex_);
+    threading::mutex::scoped_lock lock(service_publications_mutex_);
 
     for (L_ServicePublication::iterator i = service_publications_.begin();
          i != service_publications_.end(); ++i)
@@ -230,7 +230,7 @@ bool ServiceManager::isServiceAdvertised(const string& serv_name)
 
 ServicePublicationPtr ServiceManager::lookupServicePublication(const std::string& service)
 {
-  boost::mutex::scoped_lock lock(service_publications_mutex_);
+  threading::mutex::scoped_lock lock(service_publications_mutex_);
 
   for (L_ServicePublication::iterator t = service_publications_.begin();
        t != service_publications_.end(); ++t)
@@ -249,7 +249,7 @@ ServiceServerLinkPtr ServiceManager::createServiceServerLink(const std::string&
                                              const M_string& header_values)
 {
 
-  boost::recursive_mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
+  threading::recursive_mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
   if (shutting_down_)
   {
     return ServiceServerLinkPtr();
@@ -275,7 +275,7 @@ ServiceServerLinkPtr ServiceManager::createServiceServerLink(const std::string&
     ServiceServerLinkPtr client(new ServiceServerLink(service, persistent, request_md5sum, response_md5sum, header_values));
 
     {
-      boost::mutex::scoped_lock lock(service_server_links_mutex_);
+      threading::mutex::scoped_lock lock(service_server_links_mutex_);
       service_server_links_.push_back(client);
     }
 
@@ -297,14 +297,14 @@ void ServiceManager::removeServiceServerLink(const ServiceServerLinkPtr& client)
     return;
   }
 
-  boost::recursive_mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
+  threading::recursive_mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
   // Now check again, since the state may have changed between pre-lock/now
   if (shutting_down_)
   {
     return;
   }
 
-  boost::mutex::scoped_lock lock(service_server_links_mutex_);
+  threading::mutex::scoped_lock lock(service_server_links_mutex_);
 
   L_ServiceServerLink::iterator it = std::find(service_server_links_.begin(), service_server_links_.end(), client);
   if (it != service_server_links_.end())
@@ -46,7 +46,7 @@ namespace ros
 
 ServicePublication::ServicePublication(const std::string& name, const std::string &md5sum, const std::string& data_type, const std::string& request_data_type,
                              const std::string& response_data_type, const ServiceCallbackHelperPtr& helper, CallbackQueueInterface* callback_queue,
-                             const VoidConstPtr& tracked_object)
+                             const VoidConstPtr& tracked_object, int32_t priority)
 : name_(name)
 , md5sum_(md5sum)
 , data_type_(data_type)
@@ -57,6 +57,7 @@ ServicePublication::ServicePublication(const std::string& name, const std::strin
 , callback_queue_(callback_queue)
 , has_tracked_object_(false)
 , tracked_object_(tracked_object)
+, priority_(priority)
 {
   if (tracked_object)
   {
@@ -74,7 +75,7 @@ void ServicePublication::drop()
   // grab a lock here, to ensure that no subscription callback will
   // be invoked after we return
   {
-    boost::mutex::scoped_lock lock(client_links_mutex_);
+    threading::mutex::scoped_lock lock(client_links_mutex_);
     dropped_ = true;
   }
 
@@ -86,13 +87,14 @@ void ServicePublication::drop()
 class ServiceCallback : public CallbackInterface
 {
 public:
-  ServiceCallback(const ServiceCallbackHelperPtr& helper, const boost::shared_array<uint8_t>& buf, size_t num_bytes, const ServiceClientLinkPtr& link, bool has_tracked_object, const VoidConstWPtr& tracked_object)
+  ServiceCallback(const ServiceCallbackHelperPtr& helper, const boost::shared_array<uint8_t>& buf, size_t num_bytes, const ServiceClientLinkPtr& link, bool has_tracked_object, const VoidConstWPtr& tracked_object, int32_t priority)
   : helper_(helper)
   , buffer_(buf)
   , num_bytes_(num_bytes)
   , link_(link)
   , has_tracked_object_(has_tracked_object)
   , tracked_object_(tracked_object)
+  , priority_(priority)
   {
   }
 
@@ -146,6 +148,11 @@ public:
     return Success;
   }
 
+  virtual int32_t getPriority()
+  {
+    return priority_;
+  }
+
 private:
   ServiceCallbackHelperPtr helper_;
   boost::shared_array<uint8_t> buffer_;
@@ -153,24 +160,25 @@ private:
   ServiceClientLinkPtr link_;
   bool has_tracked_object_;
   VoidConstWPtr tracked_object_;
+  int32_t priority_;
 };
 
 void ServicePublication::processRequest(boost::shared_array<uint8_t> buf, size_t num_bytes, const ServiceClientLinkPtr& link)
 {
-  CallbackInterfacePtr cb(new ServiceCallback(helper_, buf, num_bytes, link, has_tracked_object_, tracked_object_));
+  CallbackInterfacePtr cb(new ServiceCallback(helper_, buf, num_bytes, link, has_tracked_object_, tracked_object_, priority_));
   callback_queue_->addCallback(cb, (uint64_t)this);
 }
 
 void ServicePublication::addServiceClientLink(const ServiceClientLinkPtr& link)
 {
-  boost::mutex::scoped_lock lock(client_links_mutex_);
+  threading::mutex::scoped_lock lock(client_links_mutex_);
 
   client_links_.push_back(link);
 }
 
 void ServicePublication::removeServiceClientLink(const ServiceClientLinkPtr& link)
 {
-  boost::mutex::scoped_lock lock(client_links_mutex_);
+  threading::mutex::scoped_lock lock(client_links_mutex_);
 
   V_ServiceClientLink::iterator it = std::find(client_links_.begin(), client_links_.end(), link);
   if (it != client_links_.end())
@@ -186,7 +194,7 @@ void ServicePublication::dropAllConnections()
   V_ServiceClientLink local_links;
 
   {
-    boost::mutex::scoped_lock lock(client_links_mutex_);
+    threading::mutex::scoped_lock lock(client_links_mutex_);
 
     local_links.swap(client_links_);
   }
@@ -71,16 +71,16 @@ void ServiceServerLink::cancelCall(const CallInfoPtr& info)
 {
   CallInfoPtr local = info;
   {
-    boost::mutex::scoped_lock lock(local->finished_mutex_);
+    threading::mutex::scoped_lock lock(local->finished_mutex_);
     local->finished_ = true;
     local->finished_condition_.notify_all();
   }
 
-  if (boost::this_thread::get_id() != info->caller_thread_id_)
+  if (threading::this_thread::get_id() != info->caller_thread_id_)
   {
     while (!local->call_finished_)
     {
-      boost::this_thread::yield();
+      threading::this_thread::yield();
     }
   }
 }
@@ -90,7 +90,7 @@ void ServiceServerLink::clearCalls()
   CallInfoPtr local_current;
 
   {
-    boost::mutex::scoped_lock lock(call_queue_mutex_);
+    threading::mutex::scoped_lock lock(call_queue_mutex_);
     local_current = current_call_;
   }
 
@@ -99,7 +99,7 @@ void ServiceServerLink::clearCalls()
     cancelCall(local_current);
   }
 
-  boost::mutex::scoped_lock lock(call_queue_mutex_);
+  threading::mutex::scoped_lock lock(call_queue_mutex_);
 
   while (!call_queue_.empty())
   {
@@ -145,7 +145,7 @@ bool ServiceServerLink::onHeaderReceived(const ConnectionPtr& conn, const Header
 
   bool empty = false;
   {
-    boost::mutex::scoped_lock lock(call_queue_mutex_);
+    threading::mutex::scoped_lock lock(call_queue_mutex_);
     empty = call_queue_.empty();
 
     if (empty)
@@ -204,7 +204,7 @@ void ServiceServerLink::onResponseOkAndLength(const ConnectionPtr& conn, const b
   }
 
   {
-    boost::mutex::scoped_lock lock(call_queue_mutex_);
+    threading::mutex::scoped_lock lock(call_queue_mutex_);
     if ( ok != 0 ) {
     	current_call_->success_ = true;
     } else {
@@ -230,7 +230,7 @@ void ServiceServerLink::onResponse(const ConnectionPtr& conn, const boost::share
     return;
 
   {
-    boost::mutex::scoped_lock queue_lock(call_queue_mutex_);
+    threading::mutex::scoped_lock queue_lock(call_queue_mutex_);
 
     if (current_call_->success_)
     {
@@ -250,8 +250,8 @@ void ServiceServerLink::callFinished()
   CallInfoPtr saved_call;
   ServiceServerLinkPtr self;
   {
-    boost::mutex::scoped_lock queue_lock(call_queue_mutex_);
-    boost::mutex::scoped_lock finished_lock(current_call_->finished_mutex_);
+    threading::mutex::scoped_lock queue_lock(call_queue_mutex_);
+    threading::mutex::scoped_lock finished_lock(current_call_->finished_mutex_);
 
     ROS_DEBUG_NAMED("superdebug", "Client to service [%s] call finished with success=[%s]", service_name_.c_str(), current_call_->success_ ? "true" : "false");
 
@@ -276,7 +276,7 @@ void ServiceServerLink::processNextCall()
 {
   bool empty = false;
   {
-    boost::mutex::scoped_lock lock(call_queue_mutex_);
+    threading::mutex::scoped_lock lock(call_queue_mutex_);
 
     if (current_call_)
     {
@@ -313,7 +313,7 @@ void ServiceServerLink::processNextCall()
     SerializedMessage request;
 
     {
-      boost::mutex::scoped_lock lock(call_queue_mutex_);
+      threading::mutex::scoped_lock lock(call_queue_mutex_);
       request = current_call_->req_;
     }
 
@@ -329,13 +329,13 @@ bool ServiceServerLink::call(const SerializedMessage& req, SerializedMessage& re
   info->success_ = false;
   info->finished_ = false;
   info->call_finished_ = false;
-  info->caller_thread_id_ = boost::this_thread::get_id();
+  info->caller_thread_id_ = threading::this_thread::get_id();
 
   //ros::WallDuration(0.1).sleep();
 
   bool immediate = false;
   {
-    boost::mutex::scoped_lock lock(call_queue_mutex_);
+    threading::mutex::scoped_lock lock(call_queue_mutex_);
 
     if (connection_->isDropped())
     {
@@ -358,7 +358,7 @@ bool ServiceServerLink::call(const SerializedMessage& req, SerializedMessage& re
   }
 
   {
-    boost::mutex::scoped_lock lock(info->finished_mutex_);
+    threading::mutex::scoped_lock lock(info->finished_mutex_);
 
     while (!info->finished_)
     {
@@ -29,11 +29,10 @@
 #include "ros/ros.h"
 #include "ros/callback_queue.h"
 
-#include <boost/thread/thread.hpp>
-#include <boost/thread/recursive_mutex.hpp>
+#include "ros/threading.h"
 
 namespace {
-  boost::recursive_mutex spinmutex;
+  ros::threading::recursive_mutex spinmutex;
 }
 
 namespace ros
@@ -42,7 +41,7 @@ namespace ros
 
 void SingleThreadedSpinner::spin(CallbackQueue* queue)
 {
-  boost::recursive_mutex::scoped_try_lock spinlock(spinmutex);
+  threading::recursive_mutex::scoped_try_lock spinlock(spinmutex);
   if(!spinlock.owns_lock()) {
     ROS_ERROR("SingleThreadedSpinner: You've attempted to call spin "
               "from multiple threads.  Use a MultiThreadedSpinner instead.");
@@ -70,7 +69,7 @@ MultiThreadedSpinner::MultiThreadedSpinner(uint32_t thread_count)
 
 void MultiThreadedSpinner::spin(CallbackQueue* queue)
 {
-  boost::recursive_mutex::scoped_try_lock spinlock(spinmutex);
+  threading::recursive_mutex::scoped_try_lock spinlock(spinmutex);
   if (!spinlock.owns_lock()) {
     ROS_ERROR("MultiThreadeSpinner: You've attempted to call ros::spin "
               "from multiple threads... "
@@ -96,9 +95,9 @@ public:
 private:
   void threadFunc();
 
-  boost::mutex mutex_;
-  boost::recursive_mutex::scoped_try_lock member_spinlock;
-  boost::thread_group threads_;
+  threading::mutex mutex_;
+  threading::recursive_mutex::scoped_try_lock member_spinlock;
+  threading::thread_group threads_;
 
   uint32_t thread_count_;
   CallbackQueue* callback_queue_;
@@ -115,7 +114,7 @@ AsyncSpinnerImpl::AsyncSpinnerImpl(uint32_t thread_count, CallbackQueue* queue)
 {
   if (thread_count == 0)
   {
-    thread_count_ = boost::thread::hardware_concurrency();
+    thread_count_ = threading::thread::hardware_concurrency();
 
     if (thread_count_ == 0)
     {
@@ -136,18 +135,18 @@ AsyncSpinnerImpl::~AsyncSpinnerImpl()
 
 bool AsyncSpinnerImpl::canStart()
 {
-  boost::recursive_mutex::scoped_try_lock spinlock(spinmutex);
+  threading::recursive_mutex::scoped_try_lock spinlock(spinmutex);
   return spinlock.owns_lock();
 }
 
 void AsyncSpinnerImpl::start()
 {
-  boost::mutex::scoped_lock lock(mutex_);
+  threading::mutex::scoped_lock lock(mutex_);
 
   if (continue_)
     return;
 
-  boost::recursive_mutex::scoped_try_lock spinlock(spinmutex);
+  threading::recursive_mutex::scoped_try_lock spinlock(spinmutex);
   if (!spinlock.owns_lock()) {
     ROS_WARN("AsyncSpinnerImpl: Attempt to start() an AsyncSpinner failed "
              "because another AsyncSpinner is already running. Note that the "
@@ -168,7 +167,7 @@ void AsyncSpinnerImpl::start()
 
 void AsyncSpinnerImpl::stop()
 {
-  boost::mutex::scoped_lock lock(mutex_);
+  threading::mutex::scoped_lock lock(mutex_);
   if (!continue_)
     return;
 
@@ -28,6 +28,7 @@
 #include "ros/subscriber.h"
 #include "ros/node_handle.h"
 #include "ros/topic_manager.h"
+#include "ros/subscription_queue.h"
 
 namespace ros
 {
@@ -104,4 +105,32 @@ namespace ros
     return 0;
   }
 
+  uint32_t Subscriber::getDeadlineMisses() const
+  {
+    if (impl_ && impl_->isValid())
+      {
+	SubscriptionQueuePtr queue = TopicManager::instance()->lookupSubscriptionQueue(impl_->topic_, impl_->helper_);
+	if (queue)
+	  {
+	    return queue->getDeadlineMisses();
+	  }
+      }
+
+    return 0;
+  }
+
+  uint64_t Subscriber::getConflatedCount() const
+  {
+    if (impl_ && impl_->isValid())
+      {
+	SubscriptionQueuePtr queue = TopicManager::instance()->lookupSubscriptionQueue(impl_->topic_, impl_->helper_);
+	if (queue)
+	  {
+	    return queue->getConflatedCount();
+	  }
+      }
+
+    return 0;
+  }
+
 } // namespace ros
@@ -37,6 +37,7 @@
 #include <cerrno>
 #include <cstring>
 #include <typeinfo>
+#include <algorithm>
 
 #include "ros/common.h"
 #include "ros/io.h"
@@ -48,12 +49,14 @@
 #include "ros/connection.h"
 #include "ros/transport/transport_tcp.h"
 #include "ros/transport/transport_udp.h"
+#include "ros/transport/transport_shm.h"
 #include "ros/callback_queue_interface.h"
 #include "ros/this_node.h"
 #include "ros/network.h"
 #include "ros/poll_manager.h"
 #include "ros/connection_manager.h"
 #include "ros/message_deserializer.h"
+#include "ros/buffer_pool.h"
 #include "ros/subscription_queue.h"
 #include "ros/file_log.h"
 #include "ros/transport_hints.h"
@@ -86,7 +89,7 @@ Subscription::~Subscription()
 void Subscription::shutdown()
 {
   {
-    boost::mutex::scoped_lock lock(shutdown_mutex_);
+    threading::mutex::scoped_lock lock(shutdown_mutex_);
     shutting_down_ = true;
   }
 
@@ -100,7 +103,7 @@ XmlRpcValue Subscription::getStats()
   XmlRpcValue conn_data;
   conn_data.setSize(0);
 
-  boost::mutex::scoped_lock lock(publisher_links_mutex_);
+  threading::mutex::scoped_lock lock(publisher_links_mutex_);
 
   uint32_t cidx = 0;
   for (V_PublisherLink::iterator c = publisher_links_.begin();
@@ -122,7 +125,7 @@ XmlRpcValue Subscription::getStats()
 // e.g. [(1, 'http://host:54893/', 'i', 'TCPROS', '/chatter', 1, 'TCPROS connection on port 59746 to [host:34318 on socket 11]')]
 void Subscription::getInfo(XmlRpc::XmlRpcValue& info)
 {
-  boost::mutex::scoped_lock lock(publisher_links_mutex_);
+  threading::mutex::scoped_lock lock(publisher_links_mutex_);
 
   for (V_PublisherLink::iterator c = publisher_links_.begin();
        c != publisher_links_.end(); ++c)
@@ -141,7 +144,7 @@ void Subscription::getInfo(XmlRpc::XmlRpcValue& info)
 
 uint32_t Subscription::getNumPublishers()
 {
-	boost::mutex::scoped_lock lock(publisher_links_mutex_);
+	threading::mutex::scoped_lock lock(publisher_links_mutex_);
 	return (uint32_t)publisher_links_.size();
 }
 
@@ -162,7 +165,7 @@ void Subscription::dropAllConnections()
   V_PublisherLink localsubscribers;
 
   {
-    boost::mutex::scoped_lock lock(publisher_links_mutex_);
+    threading::mutex::scoped_lock lock(publisher_links_mutex_);
 
     localsubscribers.swap(publisher_links_);
   }
@@ -177,7 +180,7 @@ void Subscription::dropAllConnections()
 
 void Subscription::addLocalConnection(const PublicationPtr& pub)
 {
-  boost::mutex::scoped_lock lock(publisher_links_mutex_);
+  threading::mutex::scoped_lock lock(publisher_links_mutex_);
   if (dropped_)
   {
     return;
@@ -205,7 +208,7 @@ bool urisEqual(const std::string& uri1, const std::string& uri2)
 
 bool Subscription::pubUpdate(const V_string& new_pubs)
 {
-  boost::mutex::scoped_lock lock(shutdown_mutex_);
+  threading::mutex::scoped_lock lock(shutdown_mutex_);
 
   if (shutting_down_ || dropped_)
   {
@@ -230,7 +233,7 @@ bool Subscription::pubUpdate(const V_string& new_pubs)
       ss << (*spc)->getPublisherXMLRPCURI() << ", ";
     }
 
-    boost::mutex::scoped_lock lock(pending_connections_mutex_);
+    threading::mutex::scoped_lock lock(pending_connections_mutex_);
     S_PendingConnection::iterator it = pending_connections_.begin();
     S_PendingConnection::iterator end = pending_connections_.end();
     for (; it != end; ++it)
@@ -247,7 +250,7 @@ bool Subscription::pubUpdate(const V_string& new_pubs)
   // could use the STL set operations... but these sets are so small
   // it doesn't really matter.
   {
-    boost::mutex::scoped_lock lock(publisher_links_mutex_);
+    threading::mutex::scoped_lock lock(publisher_links_mutex_);
 
     for (V_PublisherLink::iterator spc = publisher_links_.begin();
          spc!= publisher_links_.end(); ++spc)
@@ -284,7 +287,7 @@ bool Subscription::pubUpdate(const V_string& new_pubs)
 
       if (!found)
       {
-        boost::mutex::scoped_lock lock(pending_connections_mutex_);
+        threading::mutex::scoped_lock lock(pending_connections_mutex_);
         S_PendingConnection::iterator it = pending_connections_.begin();
         S_PendingConnection::iterator end = pending_connections_.end();
         for (; it != end; ++it)
@@ -348,6 +351,22 @@ bool Subscription::negotiateConnection(const std::string& xmlrpc_uri)
     transport_hints_.reliable();
     transports = transport_hints_.getTransports();
   }
+
+  std::string peer_host;
+  uint32_t peer_port;
+  if (!network::splitURI(xmlrpc_uri, peer_host, peer_port))
+  {
+    ROS_ERROR("Bad xml-rpc URI: [%s]", xmlrpc_uri.c_str());
+    return false;
+  }
+
+  // Shared memory only works with a publisher on this host, and needs TCPROS to fall back on otherwise
+  if (std::find(transports.begin(), transports.end(), "SHM") != transports.end() &&
+      std::find(transports.begin(), transports.end(), "TCP") == transports.end())
+  {
+    transports.push_back("TCP");
+  }
+
   for (V_string::const_iterator it = transports.begin();
        it != transports.end();
        ++it)
@@ -355,7 +374,7 @@ bool Subscription::negotiateConnection(const std::string& xmlrpc_uri)
     if (*it == "UDP")
     {
       int max_datagram_size = transport_hints_.getMaxDatagramSize();
-      udp_transport = TransportUDPPtr(new TransportUDP(&PollManager::instance()->getPollSet()));
+      udp_transport = TransportUDPPtr(new TransportUDP(ConnectionManager::instance()->getPollSet(getName())));
       if (!max_datagram_size)
         max_datagram_size = udp_transport->getMaxDatagramSize();
       udp_transport->createIncoming(0, false);
@@ -378,9 +397,30 @@ bool Subscription::negotiateConnection(const std::string& xmlrpc_uri)
     }
     else if (*it == "TCP")
     {
+      // A publisher on this host can be reached over a unix domain socket, the TCPROS stream is the same
+      if (TransportTCP::s_use_unix_sockets_ && TransportTCP::isUnixAvailable() && network::isLocalHost(peer_host))
+      {
+        XmlRpcValue unixros_array;
+        unixros_array[0] = std::string("UNIXROS");
+        protos_array[protos++] = unixros_array;
+      }
+
       tcpros_array[0] = std::string("TCPROS");
       protos_array[protos++] = tcpros_array;
     }
+    else if (*it == "SHM")
+    {
+      if (TransportSHM::isAvailable() && network::isLocalHost(peer_host))
+      {
+        XmlRpcValue shmros_array;
+        shmros_array[0] = std::string("SHMROS");
+        protos_array[protos++] = shmros_array;
+      }
+      else
+      {
+        ROSCPP_LOG_DEBUG("Publisher of topic [%s] at [%s] isn't local, not offering SHMROS", name_.c_str(), xmlrpc_uri.c_str());
+      }
+    }
     else
     {
       ROS_WARN("Unsupported transport type hinted: %s, skipping", it->c_str());
@@ -389,13 +429,6 @@ bool Subscription::negotiateConnection(const std::string& xmlrpc_uri)
   params[0] = this_node::getName();
   params[1] = name_;
   params[2] = protos_array;
-  std::string peer_host;
-  uint32_t peer_port;
-  if (!network::splitURI(xmlrpc_uri, peer_host, peer_port))
-  {
-    ROS_ERROR("Bad xml-rpc URI: [%s]", xmlrpc_uri.c_str());
-    return false;
-  }
 
   XmlRpc::XmlRpcClient* c = new XmlRpc::XmlRpcClient(peer_host.c_str(),
                                                      peer_port, "/");
@@ -424,7 +457,7 @@ bool Subscription::negotiateConnection(const std::string& xmlrpc_uri)
   XMLRPCManager::instance()->addASyncConnection(conn);
   // Put this connection on the list that we'll look at later.
   {
-    boost::mutex::scoped_lock pending_connections_lock(pending_connections_mutex_);
+    threading::mutex::scoped_lock pending_connections_lock(pending_connections_mutex_);
     pending_connections_.insert(conn);
   }
 
@@ -441,14 +474,14 @@ void closeTransport(const TransportUDPPtr& trans)
 
 void Subscription::pendingConnectionDone(const PendingConnectionPtr& conn, XmlRpcValue& result)
 {
-  boost::mutex::scoped_lock lock(shutdown_mutex_);
+  threading::mutex::scoped_lock lock(shutdown_mutex_);
   if (shutting_down_ || dropped_)
   {
     return;
   }
 
   {
-    boost::mutex::scoped_lock pending_connections_lock(pending_connections_mutex_);
+    threading::mutex::scoped_lock pending_connections_lock(pending_connections_mutex_);
     pending_connections_.erase(conn);
   }
 
@@ -505,7 +538,7 @@ void Subscription::pendingConnectionDone(const PendingConnectionPtr& conn, XmlRp
     int pub_port = proto[2];
     ROSCPP_LOG_DEBUG("Connecting via tcpros to topic [%s] at host [%s:%d]", name_.c_str(), pub_host.c_str(), pub_port);
 
-    TransportTCPPtr transport(new TransportTCP(&PollManager::instance()->getPollSet()));
+    TransportTCPPtr transport(new TransportTCP(ConnectionManager::instance()->getPollSet(name_)));
     if (transport->connect(pub_host, pub_port))
     {
       ConnectionPtr connection(new Connection());
@@ -516,7 +549,7 @@ void Subscription::pendingConnectionDone(const PendingConnectionPtr& conn, XmlRp
 
       ConnectionManager::instance()->addConnection(connection);
 
-      boost::mutex::scoped_lock lock(publisher_links_mutex_);
+      threading::mutex::scoped_lock lock(publisher_links_mutex_);
       addPublisherLink(pub_link);
 
       ROSCPP_LOG_DEBUG("Connected to publisher of topic [%s] at [%s:%d]", name_.c_str(), pub_host.c_str(), pub_port);
@@ -526,6 +559,90 @@ void Subscription::pendingConnectionDone(const PendingConnectionPtr& conn, XmlRp
     	ROSCPP_LOG_DEBUG("Failed to connect to publisher of topic [%s] at [%s:%d]", name_.c_str(), pub_host.c_str(), pub_port);
     }
   }
+  else if (proto_name == "UNIXROS")
+  {
+    // Publishers send the TCPROS host and port along with the socket path, to fall back on if the path can't
+    // be reached from here (eg. a container sharing the network namespace but not the filesystem)
+    if ((proto.size() != 2 && proto.size() != 4) ||
+        proto[1].getType() != XmlRpcValue::TypeString ||
+        (proto.size() == 4 && (proto[2].getType() != XmlRpcValue::TypeString ||
+                               proto[3].getType() != XmlRpcValue::TypeInt)))
+    {
+    	ROSCPP_LOG_DEBUG("publisher implements UNIXROS, but the " \
+                "parameters aren't string[,string,int]");
+      return;
+    }
+    std::string pub_path = proto[1];
+    ROSCPP_LOG_DEBUG("Connecting via tcpros to topic [%s] at unix socket [%s]", name_.c_str(), pub_path.c_str());
+
+    TransportTCPPtr transport(new TransportTCP(ConnectionManager::instance()->getPollSet(name_)));
+    bool connected = transport->connectUnix(pub_path);
+    if (!connected && proto.size() == 4)
+    {
+      std::string pub_host = proto[2];
+      int pub_port = proto[3];
+      ROS_WARN("Failed to connect to publisher of topic [%s] at unix socket [%s], falling back to tcpros at [%s:%d]",
+               name_.c_str(), pub_path.c_str(), pub_host.c_str(), pub_port);
+
+      transport.reset(new TransportTCP(ConnectionManager::instance()->getPollSet(name_)));
+      connected = transport->connect(pub_host, pub_port);
+    }
+
+    if (connected)
+    {
+      ConnectionPtr connection(new Connection());
+      TransportPublisherLinkPtr pub_link(new TransportPublisherLink(shared_from_this(), xmlrpc_uri, transport_hints_));
+
+      connection->initialize(transport, false, HeaderReceivedFunc());
+      pub_link->initialize(connection);
+
+      ConnectionManager::instance()->addConnection(connection);
+
+      threading::mutex::scoped_lock lock(publisher_links_mutex_);
+      addPublisherLink(pub_link);
+
+      ROSCPP_LOG_DEBUG("Connected to publisher of topic [%s] at [%s]", name_.c_str(), transport->getTransportInfo().c_str());
+    }
+    else
+    {
+    	ROSCPP_LOG_DEBUG("Failed to connect to publisher of topic [%s] at unix socket [%s]", name_.c_str(), pub_path.c_str());
+    }
+  }
+  else if (proto_name == "SHMROS")
+  {
+    if (proto.size() != 3 ||
+        proto[1].getType() != XmlRpcValue::TypeString ||
+        proto[2].getType() != XmlRpcValue::TypeInt)
+    {
+    	ROSCPP_LOG_DEBUG("publisher implements SHMROS, but the " \
+                "parameters aren't string,int");
+      return;
+    }
+    std::string pub_host = proto[1];
+    int pub_port = proto[2];
+    ROSCPP_LOG_DEBUG("Connecting via shmros to topic [%s] at host [%s:%d]", name_.c_str(), pub_host.c_str(), pub_port);
+
+    TransportSHMPtr transport(new TransportSHM(ConnectionManager::instance()->getPollSet(name_)));
+    if (transport->connect(pub_host, pub_port))
+    {
+      ConnectionPtr connection(new Connection());
+      TransportPublisherLinkPtr pub_link(new TransportPublisherLink(shared_from_this(), xmlrpc_uri, transport_hints_));
+
+      connection->initialize(transport, false, HeaderReceivedFunc());
+      pub_link->initialize(connection);
+
+      ConnectionManager::instance()->addConnection(connection);
+
+      threading::mutex::scoped_lock lock(publisher_links_mutex_);
+      addPublisherLink(pub_link);
+
+      ROSCPP_LOG_DEBUG("Connected to publisher of topic [%s] at [%s:%d] over shared memory", name_.c_str(), pub_host.c_str(), pub_port);
+    }
+    else
+    {
+    	ROSCPP_LOG_DEBUG("Failed to connect to publisher of topic [%s] at [%s:%d] over shared memory", name_.c_str(), pub_host.c_str(), pub_port);
+    }
+  }
   else if (proto_name == "UDPROS")
   {
     if (proto.size() != 6 ||
@@ -575,7 +692,7 @@ void Subscription::pendingConnectionDone(const PendingConnectionPtr& conn, XmlRp
 
       ConnectionManager::instance()->addConnection(connection);
 
-      boost::mutex::scoped_lock lock(publisher_links_mutex_);
+      threading::mutex::scoped_lock lock(publisher_links_mutex_);
       addPublisherLink(pub_link);
 
       ROSCPP_LOG_DEBUG("Connected to publisher of topic [%s] at [%s:%d]", name_.c_str(), pub_host.c_str(), pub_port);
@@ -595,14 +712,15 @@ void Subscription::pendingConnectionDone(const PendingConnectionPtr& conn, XmlRp
 
 uint32_t Subscription::handleMessage(const SerializedMessage& m, bool ser, bool nocopy, const boost::shared_ptr<M_string>& connection_header, const PublisherLinkPtr& link)
 {
-  boost::mutex::scoped_lock lock(callbacks_mutex_);
+  threading::mutex::scoped_lock lock(callbacks_mutex_);
 
   uint32_t drops = 0;
 
-  // Cache the deserializers by type info.  If all the subscriptions are the same type this has the same performance as before.  If
-  // there are subscriptions with different C++ type (but same ROS message type), this now works correctly rather than passing
-  // garbage to the messages with different C++ types than the first one.
-  cached_deserializers_.clear();
+  // One deserializer per C++ type, shared by all the callbacks of that type.  They only deserialize once the first of
+  // those callbacks is called, and hold onto the buffer until then, so messages dropped before any callback gets to them
+  // are never deserialized.  Subscriptions with different C++ types for the same ROS message type each get the type
+  // they asked for.
+  ROS_ASSERT(deserializers_.size() == callback_types_.size());
 
   ros::Time receipt_time = ros::Time::now();
 
@@ -613,43 +731,33 @@ uint32_t Subscription::handleMessage(const SerializedMessage& m, bool ser, bool
 
     ROS_ASSERT(info->callback_queue_);
 
-    const std::type_info* ti = &info->helper_->getTypeInfo();
+    const std::type_info* ti = callback_types_[info->type_index_];
 
     if ((nocopy && m.type_info && *ti == *m.type_info) || (ser && (!m.type_info || *ti != *m.type_info)))
     {
-      MessageDeserializerPtr deserializer;
-
-      V_TypeAndDeserializer::iterator des_it = cached_deserializers_.begin();
-      V_TypeAndDeserializer::iterator des_end = cached_deserializers_.end();
-      for (; des_it != des_end; ++des_it)
-      {
-        if (*des_it->first == *ti)
-        {
-          deserializer = des_it->second;
-          break;
-        }
-      }
-
+      MessageDeserializerPtr& deserializer = deserializers_[info->type_index_];
       if (!deserializer)
       {
-        deserializer = boost::make_shared<MessageDeserializer>(info->helper_, m, connection_header);
-        cached_deserializers_.push_back(std::make_pair(ti, deserializer));
+        deserializer = boost::allocate_shared<MessageDeserializer>(BufferPoolAllocator<MessageDeserializer>(), info->helper_, m, connection_header);
       }
 
       bool was_full = false;
+      bool was_conflated = false;
+      bool was_batched = false;
       bool nonconst_need_copy = false;
       if (callbacks_.size() > 1)
       {
         nonconst_need_copy = true;
       }
 
-      info->subscription_queue_->push(info->helper_, deserializer, info->has_tracked_object_, info->tracked_object_, nonconst_need_copy, receipt_time, &was_full);
+      info->subscription_queue_->push(info->helper_, deserializer, info->has_tracked_object_, info->tracked_object_, nonconst_need_copy, receipt_time, &was_full,
+                                      link.get(), &was_conflated, &was_batched);
 
       if (was_full)
       {
         ++drops;
       }
-      else
+      else if (!was_conflated && !was_batched)
       {
         info->callback_queue_->addCallback(info->subscription_queue_, (uint64_t)info.get());
       }
@@ -670,12 +778,43 @@ uint32_t Subscription::handleMessage(const SerializedMessage& m, bool ser, bool
     latched_messages_[link] = li;
   }
 
-  cached_deserializers_.clear();
+  // The subscription queues hold onto the deserializers for as long as they need them
+  for (size_t i = 0; i < deserializers_.size(); ++i)
+  {
+    deserializers_[i].reset();
+  }
 
   return drops;
 }
 
-bool Subscription::addCallback(const SubscriptionCallbackHelperPtr& helper, const std::string& md5sum, CallbackQueueInterface* queue, int32_t queue_size, const VoidConstPtr& tracked_object, bool allow_concurrent_callbacks)
+void Subscription::updateCallbackTypes()
+{
+  callback_types_.clear();
+
+  for (V_CallbackInfo::iterator it = callbacks_.begin(); it != callbacks_.end(); ++it)
+  {
+    const CallbackInfoPtr& info = *it;
+    const std::type_info* ti = &info->helper_->getTypeInfo();
+
+    size_t index = 0;
+    while (index < callback_types_.size() && *callback_types_[index] != *ti)
+    {
+      ++index;
+    }
+
+    if (index == callback_types_.size())
+    {
+      callback_types_.push_back(ti);
+    }
+
+    info->type_index_ = index;
+  }
+
+  deserializers_.resize(callback_types_.size());
+}
+
+bool Subscription::addCallback(const SubscriptionCallbackHelperPtr& helper, const std::string& md5sum, CallbackQueueInterface* queue, int32_t queue_size, const VoidConstPtr& tracked_object, bool allow_concurrent_callbacks, int32_t priority, const WallDuration& deadline, bool conflate,
+                               uint32_t max_batch, const WallDuration& max_latency)
 {
   ROS_ASSERT(helper);
   ROS_ASSERT(queue);
@@ -684,7 +823,7 @@ bool Subscription::addCallback(const SubscriptionCallbackHelperPtr& helper, cons
 
   // Decay to a real type as soon as we have a subscriber with a real type
   {
-    boost::mutex::scoped_lock lock(md5sum_mutex_);
+    threading::mutex::scoped_lock lock(md5sum_mutex_);
     if (md5sum_ == "*" && md5sum != "*")
     {
 
@@ -698,12 +837,14 @@ bool Subscription::addCallback(const SubscriptionCallbackHelperPtr& helper, cons
   }
 
   {
-    boost::mutex::scoped_lock lock(callbacks_mutex_);
+    threading::mutex::scoped_lock lock(callbacks_mutex_);
 
     CallbackInfoPtr info(new CallbackInfo);
     info->helper_ = helper;
     info->callback_queue_ = queue;
-    info->subscription_queue_.reset(new SubscriptionQueue(name_, queue_size, allow_concurrent_callbacks));
+    info->subscription_queue_.reset(new SubscriptionQueue(name_, queue_size, allow_concurrent_callbacks, priority, deadline, conflate,
+                                                          max_batch, max_latency));
+    info->subscription_queue_->setBatchCallbackQueue(queue, (uint64_t)info.get());
     info->tracked_object_ = tracked_object;
     info->has_tracked_object_ = false;
     if (tracked_object)
@@ -717,12 +858,12 @@ bool Subscription::addCallback(const SubscriptionCallbackHelperPtr& helper, cons
     }
 
     callbacks_.push_back(info);
-    cached_deserializers_.reserve(callbacks_.size());
+    updateCallbackTypes();
 
     // if we have any latched links, we need to immediately schedule callbacks
     if (!latched_messages_.empty())
     {
-      boost::mutex::scoped_lock lock(publisher_links_mutex_);
+      threading::mutex::scoped_lock lock(publisher_links_mutex_);
 
       V_PublisherLink::iterator it = publisher_links_.begin();
       V_PublisherLink::iterator end = publisher_links_.end();
@@ -738,8 +879,11 @@ bool Subscription::addCallback(const SubscriptionCallbackHelperPtr& helper, cons
 
             MessageDeserializerPtr des(new MessageDeserializer(helper, latch_info.message, latch_info.connection_header));
             bool was_full = false;
-            info->subscription_queue_->push(info->helper_, des, info->has_tracked_object_, info->tracked_object_, true, latch_info.receipt_time, &was_full);
-            if (!was_full)
+            bool was_conflated = false;
+            bool was_batched = false;
+            info->subscription_queue_->push(info->helper_, des, info->has_tracked_object_, info->tracked_object_, true, latch_info.receipt_time, &was_full,
+                                            latch_info.link.get(), &was_conflated, &was_batched);
+            if (!was_full && !was_conflated && !was_batched)
             {
               info->callback_queue_->addCallback(info->subscription_queue_, (uint64_t)info.get());
             }
@@ -752,11 +896,26 @@ bool Subscription::addCallback(const SubscriptionCallbackHelperPtr& helper, cons
   return true;
 }
 
+SubscriptionQueuePtr Subscription::getSubscriptionQueue(const SubscriptionCallbackHelperPtr& helper)
+{
+  threading::mutex::scoped_lock cbs_lock(callbacks_mutex_);
+  for (V_CallbackInfo::iterator it = callbacks_.begin();
+       it != callbacks_.end(); ++it)
+  {
+    if ((*it)->helper_ == helper)
+    {
+      return (*it)->subscription_queue_;
+    }
+  }
+
+  return SubscriptionQueuePtr();
+}
+
 void Subscription::removeCallback(const SubscriptionCallbackHelperPtr& helper)
 {
   CallbackInfoPtr info;
   {
-    boost::mutex::scoped_lock cbs_lock(callbacks_mutex_);
+    threading::mutex::scoped_lock cbs_lock(callbacks_mutex_);
     for (V_CallbackInfo::iterator it = callbacks_.begin();
          it != callbacks_.end(); ++it)
     {
@@ -764,6 +923,7 @@ void Subscription::removeCallback(const SubscriptionCallbackHelperPtr& helper)
       {
         info = *it;
         callbacks_.erase(it);
+        updateCallbackTypes();
 
         if (!helper->isConst())
         {
@@ -784,7 +944,7 @@ void Subscription::removeCallback(const SubscriptionCallbackHelperPtr& helper)
 
 void Subscription::headerReceived(const PublisherLinkPtr& link, const Header& h)
 {
-  boost::mutex::scoped_lock lock(md5sum_mutex_);
+  threading::mutex::scoped_lock lock(md5sum_mutex_);
   if (md5sum_ == "*")
   {
     md5sum_ = link->getMD5Sum();
@@ -798,23 +958,32 @@ void Subscription::addPublisherLink(const PublisherLinkPtr& link)
 
 void Subscription::removePublisherLink(const PublisherLinkPtr& pub_link)
 {
-  boost::mutex::scoped_lock lock(publisher_links_mutex_);
-
-  V_PublisherLink::iterator it = std::find(publisher_links_.begin(), publisher_links_.end(), pub_link);
-  if (it != publisher_links_.end())
   {
-    publisher_links_.erase(it);
+    threading::mutex::scoped_lock lock(publisher_links_mutex_);
+
+    V_PublisherLink::iterator it = std::find(publisher_links_.begin(), publisher_links_.end(), pub_link);
+    if (it != publisher_links_.end())
+    {
+      publisher_links_.erase(it);
+    }
+
+    if (pub_link->isLatched())
+    {
+      latched_messages_.erase(pub_link);
+    }
   }
 
-  if (pub_link->isLatched())
+  // Conflating queues keep a slot per link
+  threading::mutex::scoped_lock lock(callbacks_mutex_);
+  for (V_CallbackInfo::iterator cb = callbacks_.begin(); cb != callbacks_.end(); ++cb)
   {
-    latched_messages_.erase(pub_link);
+    (*cb)->subscription_queue_->removeLink(pub_link.get());
   }
 }
 
 void Subscription::getPublishTypes(bool& ser, bool& nocopy, const std::type_info& ti)
 {
-  boost::mutex::scoped_lock lock(callbacks_mutex_);
+  threading::mutex::scoped_lock lock(callbacks_mutex_);
   for (V_CallbackInfo::iterator cb = callbacks_.begin();
        cb != callbacks_.end(); ++cb)
   {
@@ -842,7 +1011,7 @@ const std::string Subscription::datatype()
 
 const std::string Subscription::md5sum()
 {
-  boost::mutex::scoped_lock lock(md5sum_mutex_);
+  threading::mutex::scoped_lock lock(md5sum_mutex_);
   return md5sum_;
 }
 
@@ -29,34 +29,150 @@
 #include "ros/subscription_queue.h"
 #include "ros/message_deserializer.h"
 #include "ros/subscription_callback_helper.h"
+#include "ros/callback_queue.h"
+#include "ros/timer_manager.h"
+#include "ros/internal_timer_manager.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <vector>
 
 namespace ros
 {
 
-SubscriptionQueue::SubscriptionQueue(const std::string& topic, int32_t queue_size, bool allow_concurrent_callbacks)
+CallbackQueuePtr getInternalCallbackQueue();
+
+SubscriptionQueue::SubscriptionQueue(const std::string& topic, int32_t queue_size, bool allow_concurrent_callbacks, int32_t priority, const WallDuration& deadline,
+                                     bool conflate, uint32_t max_batch, const WallDuration& max_latency)
 : topic_(topic)
 , size_(queue_size)
 , full_(false)
 , queue_size_(0)
 , allow_concurrent_callbacks_(allow_concurrent_callbacks)
+, priority_(priority)
+, deadline_(deadline)
+, deadline_misses_(0)
+, conflate_(conflate)
+, slots_(0)
+, retired_slots_(0)
+, removed_slots_(0)
+, conflation_readers_(0)
+, free_item_(0)
+, conflated_(0)
+, max_batch_(conflate ? 0 : max_batch)
+, max_latency_(max_latency)
+, batch_scheduled_(false)
+, batch_timer_armed_(false)
+, batch_timer_handle_(-1)
+, batch_timer_generation_(0)
+, batch_callback_queue_(0)
+, batch_removal_id_(0)
 {}
 
 SubscriptionQueue::~SubscriptionQueue()
 {
+  if (batch_timer_handle_ != -1)
+  {
+    InternalTimerManagerPtr manager = getInternalTimerManager();
+    if (manager)
+    {
+      manager->remove(batch_timer_handle_);
+    }
+  }
 
+  clearConflated();
+
+  ConflationSlot* slot = slots_.load();
+  while (slot)
+  {
+    ConflationSlot* next = slot->next.load();
+    delete slot;
+    slot = next;
+  }
+
+  while (retired_slots_)
+  {
+    ConflationSlot* next = retired_slots_->retired_next;
+    delete retired_slots_;
+    retired_slots_ = next;
+  }
+
+  delete free_item_.load();
 }
 
 void SubscriptionQueue::push(const SubscriptionCallbackHelperPtr& helper, const MessageDeserializerPtr& deserializer,
                                  bool has_tracked_object, const VoidConstWPtr& tracked_object, bool nonconst_need_copy,
-                                 ros::Time receipt_time, bool* was_full)
+                                 ros::Time receipt_time, bool* was_full, const void* link, bool* was_conflated,
+                                 bool* was_batched)
 {
-  boost::mutex::scoped_lock lock(queue_mutex_);
+  threading::mutex::scoped_lock lock(queue_mutex_);
 
   if (was_full)
   {
     *was_full = false;
   }
 
+  if (was_conflated)
+  {
+    *was_conflated = false;
+  }
+
+  if (was_batched)
+  {
+    *was_batched = false;
+  }
+
+  if (conflate_)
+  {
+    if (removed_slots_)
+    {
+      reclaimSlots();
+    }
+
+    // A new link may have the address of a removed one, so skip removed slots
+    ConflationSlot* slot = slots_.load();
+    while (slot && (slot->link != link || slot->removed))
+    {
+      slot = slot->next.load();
+    }
+
+    if (!slot)
+    {
+      slot = new ConflationSlot(link);
+      slot->next.store(slots_.load());
+      slots_.store(slot);
+    }
+
+    Item* i = free_item_.exchange(0);
+    if (!i)
+    {
+      i = new Item;
+    }
+
+    i->helper = helper;
+    i->deserializer = deserializer;
+    i->has_tracked_object = has_tracked_object;
+    i->tracked_object = tracked_object;
+    i->nonconst_need_copy = nonconst_need_copy;
+    i->receipt_time = receipt_time;
+
+    // The reader takes items out with an exchange too, so whichever of us gets the old item owns it
+    Item* old = slot->item.exchange(i);
+    if (old)
+    {
+      releaseConflated(old);
+      ++conflated_;
+
+      if (was_conflated)
+      {
+        *was_conflated = true;
+      }
+    }
+
+    return;
+  }
+
   if(fullNoLock())
   {
     queue_.pop_front();
@@ -88,15 +204,213 @@ void SubscriptionQueue::push(const SubscriptionCallbackHelperPtr& helper, const
   i.receipt_time = receipt_time;
   queue_.push_back(i);
   ++queue_size_;
+
+  if (max_batch_ > 1)
+  {
+    bool batched = false;
+    int32_t old_timer = -1;
+    if (!batch_scheduled_)
+    {
+      batch_scheduled_ = true;
+      batched = queue_size_ < max_batch_ && !max_latency_.isZero() && armBatchTimer(old_timer);
+    }
+    else if (batch_timer_armed_ && queue_size_ >= max_batch_)
+    {
+      // The batch filled up before the timer went off.  The timer will find it disarmed and do nothing.
+      batch_timer_armed_ = false;
+    }
+    else
+    {
+      batched = true;
+    }
+
+    if (was_batched)
+    {
+      *was_batched = batched;
+    }
+
+    if (old_timer != -1)
+    {
+      // remove() waits for onBatchTimer() if it is running, and that needs queue_mutex_
+      lock.unlock();
+      InternalTimerManagerPtr manager = getInternalTimerManager();
+      if (manager)
+      {
+        manager->remove(old_timer);
+      }
+    }
+  }
+}
+
+void SubscriptionQueue::setBatchCallbackQueue(CallbackQueueInterface* queue, uint64_t removal_id)
+{
+  threading::mutex::scoped_lock lock(queue_mutex_);
+  batch_callback_queue_ = queue;
+  batch_removal_id_ = removal_id;
+}
+
+bool SubscriptionQueue::armBatchTimer(int32_t& old_timer)
+{
+  InternalTimerManagerPtr manager = getInternalTimerManager();
+  if (!batch_callback_queue_ || !manager)
+  {
+    return false;
+  }
+
+  VoidConstPtr tracker;
+  try
+  {
+    tracker = shared_from_this();
+  }
+  catch (boost::bad_weak_ptr&) // For the tests, where we don't create a shared_ptr
+  {
+    return false;
+  }
+
+  // Each batch gets a new one-shot.  Re-arming the last one with setPeriod() is lost if it has gone off but its
+  // callback hasn't finished yet, since the timer manager then reschedules it as spent.
+  old_timer = batch_timer_handle_;
+  ++batch_timer_generation_;
+  batch_timer_handle_ = manager->add(max_latency_,
+                                     boost::bind(&SubscriptionQueue::onBatchTimer, this, _1, batch_timer_generation_),
+                                     getInternalCallbackQueue().get(), tracker, true);
+
+  batch_timer_armed_ = true;
+  return true;
+}
+
+void SubscriptionQueue::onBatchTimer(const WallTimerEvent&, uint32_t generation)
+{
+  CallbackQueueInterface* queue = 0;
+  uint64_t removal_id = 0;
+
+  {
+    threading::mutex::scoped_lock lock(queue_mutex_);
+    // An old timer may go off before push() gets round to removing it
+    if (!batch_timer_armed_ || generation != batch_timer_generation_)
+    {
+      return;
+    }
+
+    batch_timer_armed_ = false;
+    queue = batch_callback_queue_;
+    removal_id = batch_removal_id_;
+  }
+
+  // The timer tracks this queue, so it is still alive while we are called
+  queue->addCallback(shared_from_this(), removal_id);
 }
 
 void SubscriptionQueue::clear()
 {
-  boost::recursive_mutex::scoped_lock cb_lock(callback_mutex_);
-  boost::mutex::scoped_lock queue_lock(queue_mutex_);
+  threading::recursive_mutex::scoped_lock cb_lock(callback_mutex_);
+  threading::mutex::scoped_lock queue_lock(queue_mutex_);
 
   queue_.clear();
   queue_size_ = 0;
+  batch_scheduled_ = false;
+  batch_timer_armed_ = false;
+
+  clearConflated();
+  reclaimSlots();
+}
+
+void SubscriptionQueue::removeLink(const void* link)
+{
+  threading::mutex::scoped_lock lock(queue_mutex_);
+
+  for (ConflationSlot* slot = slots_.load(); slot; slot = slot->next.load())
+  {
+    if (slot->link == link && !slot->removed)
+    {
+      slot->removed = true;
+      ++removed_slots_;
+    }
+  }
+
+  if (removed_slots_)
+  {
+    reclaimSlots();
+  }
+}
+
+void SubscriptionQueue::reclaimSlots()
+{
+  // The slot list is only changed with queue_mutex_ held, so only call() can be walking it alongside us
+  boost::atomic<ConflationSlot*>* prev = &slots_;
+  ConflationSlot* slot = prev->load();
+  while (slot)
+  {
+    ConflationSlot* next = slot->next.load();
+    if (slot->removed && !slot->item.load())
+    {
+      prev->store(next);
+      slot->retired_next = retired_slots_;
+      retired_slots_ = slot;
+    }
+    else
+    {
+      prev = &slot->next;
+    }
+
+    slot = next;
+  }
+
+  // Any call() which starts after this can't reach the retired slots.  One which started before it has already
+  // counted itself in conflation_readers_.
+  if (retired_slots_ && conflation_readers_.load() == 0)
+  {
+    while (retired_slots_)
+    {
+      ConflationSlot* next = retired_slots_->retired_next;
+      delete retired_slots_;
+      retired_slots_ = next;
+      --removed_slots_;
+    }
+  }
+}
+
+void SubscriptionQueue::clearConflated()
+{
+  for (ConflationSlot* slot = slots_.load(); slot; slot = slot->next.load())
+  {
+    Item* i = slot->item.exchange(0);
+    if (i)
+    {
+      releaseConflated(i);
+    }
+  }
+}
+
+void SubscriptionQueue::releaseConflated(Item* item)
+{
+  item->helper.reset();
+  item->deserializer.reset();
+  item->tracked_object.reset();
+
+  delete free_item_.exchange(item);
+}
+
+bool SubscriptionQueue::popConflated(Item& item)
+{
+  // Keeps reclaimSlots() from deleting a slot we may still step through
+  ++conflation_readers_;
+
+  bool found = false;
+  for (ConflationSlot* slot = slots_.load(); slot; slot = slot->next.load())
+  {
+    Item* i = slot->item.exchange(0);
+    if (i)
+    {
+      item = *i;
+      releaseConflated(i);
+      found = true;
+      break;
+    }
+  }
+
+  --conflation_readers_;
+  return found;
 }
 
 CallbackInterface::CallResult SubscriptionQueue::call()
@@ -104,7 +418,7 @@ CallbackInterface::CallResult SubscriptionQueue::call()
   // The callback may result in our own destruction.  Therefore, we may need to keep a reference to ourselves
   // that outlasts the scoped_try_lock
   boost::shared_ptr<SubscriptionQueue> self;
-  boost::recursive_mutex::scoped_try_lock lock(callback_mutex_, boost::defer_lock);
+  threading::recursive_mutex::scoped_try_lock lock(callback_mutex_, boost::defer_lock);
 
   if (!allow_concurrent_callbacks_)
   {
@@ -115,11 +429,34 @@ CallbackInterface::CallResult SubscriptionQueue::call()
     }
   }
 
+  if (max_batch_ > 1)
+  {
+    return callBatch(self);
+  }
+
   VoidConstPtr tracker;
   Item i;
 
+  if (conflate_)
+  {
+    if (!popConflated(i))
+    {
+      return CallbackInterface::Invalid;
+    }
+
+    if (i.has_tracked_object)
+    {
+      tracker = i.tracked_object.lock();
+
+      if (!tracker)
+      {
+        return CallbackInterface::Invalid;
+      }
+    }
+  }
+  else
   {
-    boost::mutex::scoped_lock lock(queue_mutex_);
+    threading::mutex::scoped_lock lock(queue_mutex_);
 
     if (queue_.empty())
     {
@@ -167,6 +504,81 @@ CallbackInterface::CallResult SubscriptionQueue::call()
   return CallbackInterface::Success;
 }
 
+CallbackInterface::CallResult SubscriptionQueue::callBatch(boost::shared_ptr<SubscriptionQueue>& self)
+{
+  std::vector<Item> items;
+  bool more = false;
+
+  {
+    threading::mutex::scoped_lock lock(queue_mutex_);
+
+    if (queue_.empty())
+    {
+      return CallbackInterface::Invalid;
+    }
+
+    uint32_t count = std::min(max_batch_, queue_size_);
+    items.reserve(count);
+    items.assign(queue_.begin(), queue_.begin() + count);
+    queue_.erase(queue_.begin(), queue_.begin() + count);
+    queue_size_ -= count;
+
+    // Whatever is left has waited at least as long as this batch, so gets called as soon as possible
+    more = !queue_.empty();
+    batch_scheduled_ = more;
+    batch_timer_armed_ = false;
+  }
+
+  V_SubscriptionCallbackHelperCallParams params;
+  params.reserve(items.size());
+  std::vector<VoidConstPtr> trackers;
+
+  for (size_t j = 0; j < items.size(); ++j)
+  {
+    const Item& i = items[j];
+
+    if (i.has_tracked_object)
+    {
+      VoidConstPtr tracker = i.tracked_object.lock();
+      if (!tracker)
+      {
+        continue;
+      }
+
+      // All the messages of a subscription share one tracked object, so one reference is enough
+      if (trackers.empty())
+      {
+        trackers.push_back(tracker);
+      }
+    }
+
+    VoidConstPtr msg = i.deserializer->deserialize();
+
+    // msg can be null here if deserialization failed
+    if (msg)
+    {
+      SubscriptionCallbackHelperCallParams p;
+      p.event = MessageEvent<void const>(msg, i.deserializer->getConnectionHeader(), i.receipt_time, i.nonconst_need_copy, MessageEvent<void const>::CreateFunction());
+      params.push_back(p);
+    }
+  }
+
+  if (!params.empty())
+  {
+    try
+    {
+      self = shared_from_this();
+    }
+    catch (boost::bad_weak_ptr&) // For the tests, where we don't create a shared_ptr
+    {}
+
+    items.front().helper->callBatch(params);
+  }
+
+  // TryAgain puts this callback back on the queue, for the rest of the messages
+  return more ? CallbackInterface::TryAgain : CallbackInterface::Success;
+}
+
 bool SubscriptionQueue::ready()
 {
   return true;
@@ -174,7 +586,7 @@ bool SubscriptionQueue::ready()
 
 bool SubscriptionQueue::full()
 {
-  boost::mutex::scoped_lock lock(queue_mutex_);
+  threading::mutex::scoped_lock lock(queue_mutex_);
   return fullNoLock();
 }
 
@@ -183,5 +595,17 @@ bool SubscriptionQueue::fullNoLock()
   return (size_ > 0) && (queue_size_ >= (uint32_t)size_);
 }
 
+void SubscriptionQueue::deadlineMissed(const WallDuration&)
+{
+  threading::mutex::scoped_lock lock(queue_mutex_);
+  ++deadline_misses_;
+}
+
+uint32_t SubscriptionQueue::getDeadlineMisses()
+{
+  threading::mutex::scoped_lock lock(queue_mutex_);
+  return deadline_misses_;
+}
+
 }
 
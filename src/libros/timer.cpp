@@ -34,6 +34,9 @@ namespace ros
 Timer::Impl::Impl()
   : started_(false)
   , timer_handle_(-1)
+  , call_inline_(false)
+  , priority_(0)
+  , deadline_misses_(0)
 { }
 
 Timer::Impl::~Impl()
@@ -57,7 +60,7 @@ void Timer::Impl::start()
       tracked_object = tracked_object_.lock();
     }
 
-    timer_handle_ = TimerManager<Time, Duration, TimerEvent>::global().add(period_, callback_, callback_queue_, tracked_object, oneshot_);
+    timer_handle_ = TimerManager<Time, Duration, TimerEvent>::global().add(period_, callback_, callback_queue_, tracked_object, oneshot_, priority_, deadline_, call_inline_);
     started_ = true;
   }
 }
@@ -67,6 +70,8 @@ void Timer::Impl::stop()
   if (started_)
   {
     started_ = false;
+    deadline_misses_ += TimerManager<Time, Duration, TimerEvent>::global().getDeadlineMisses(timer_handle_);
+    statistics_.add(TimerManager<Time, Duration, TimerEvent>::global().getStatistics(timer_handle_));
     TimerManager<Time, Duration, TimerEvent>::global().remove(timer_handle_);
     timer_handle_ = -1;
   }
@@ -82,6 +87,27 @@ bool Timer::Impl::hasPending()
   return TimerManager<Time, Duration, TimerEvent>::global().hasPending(timer_handle_);
 }
 
+uint32_t Timer::Impl::getDeadlineMisses()
+{
+  if (timer_handle_ == -1)
+  {
+    return deadline_misses_;
+  }
+
+  return deadline_misses_ + TimerManager<Time, Duration, TimerEvent>::global().getDeadlineMisses(timer_handle_);
+}
+
+TimerStatistics Timer::Impl::getStatistics()
+{
+  TimerStatistics statistics = statistics_;
+  if (timer_handle_ != -1)
+  {
+    statistics.add(TimerManager<Time, Duration, TimerEvent>::global().getStatistics(timer_handle_));
+  }
+
+  return statistics;
+}
+
 void Timer::Impl::setPeriod(const Duration& period, bool reset)
 {
   period_ = period;
@@ -97,6 +123,9 @@ Timer::Timer(const TimerOptions& ops)
   impl_->tracked_object_ = ops.tracked_object;
   impl_->has_tracked_object_ = (ops.tracked_object != NULL);
   impl_->oneshot_ = ops.oneshot;
+  impl_->call_inline_ = ops.call_inline;
+  impl_->priority_ = ops.priority;
+  impl_->deadline_ = ops.deadline;
 }
 
 Timer::Timer(const Timer& rhs)
@@ -134,6 +163,26 @@ bool Timer::hasPending()
   return false;
 }
 
+uint32_t Timer::getDeadlineMisses()
+{
+  if (impl_)
+  {
+    return impl_->getDeadlineMisses();
+  }
+
+  return 0;
+}
+
+TimerStatistics Timer::getStatistics()
+{
+  if (impl_)
+  {
+    return impl_->getStatistics();
+  }
+
+  return TimerStatistics();
+}
+
 void Timer::setPeriod(const Duration& period, bool reset)
 {
   if (impl_)
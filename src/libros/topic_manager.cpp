@@ -54,12 +54,12 @@ namespace ros
 {
 
 TopicManagerPtr g_topic_manager;
-boost::mutex g_topic_manager_mutex;
+threading::mutex g_topic_manager_mutex;
 const TopicManagerPtr& TopicManager::instance()
 {
   if (!g_topic_manager)
   {
-    boost::mutex::scoped_lock lock(g_topic_manager_mutex);
+    threading::mutex::scoped_lock lock(g_topic_manager_mutex);
     if (!g_topic_manager)
     {
       g_topic_manager.reset(new TopicManager);
@@ -81,7 +81,7 @@ TopicManager::~TopicManager()
 
 void TopicManager::start()
 {
-  boost::mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
+  threading::mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
   shutting_down_ = false;
 
   poll_manager_ = PollManager::instance();
@@ -100,15 +100,15 @@ void TopicManager::start()
 
 void TopicManager::shutdown()
 {
-  boost::mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
+  threading::mutex::scoped_lock shutdown_lock(shutting_down_mutex_);
   if (shutting_down_)
   {
     return;
   }
 
   {
-    boost::recursive_mutex::scoped_lock lock1(advertised_topics_mutex_);
-    boost::mutex::scoped_lock lock2(subs_mutex_);
+    threading::recursive_mutex::scoped_lock lock1(advertised_topics_mutex_);
+    threading::mutex::scoped_lock lock2(subs_mutex_);
     shutting_down_ = true;
   }
 
@@ -122,7 +122,7 @@ void TopicManager::shutdown()
   ROSCPP_LOG_DEBUG("Shutting down topics...");
   ROSCPP_LOG_DEBUG("  shutting down publishers");
   {
-    boost::recursive_mutex::scoped_lock adv_lock(advertised_topics_mutex_);
+    threading::recursive_mutex::scoped_lock adv_lock(advertised_topics_mutex_);
 
     for (V_Publication::iterator i = advertised_topics_.begin();
          i != advertised_topics_.end(); ++i)
@@ -139,7 +139,7 @@ void TopicManager::shutdown()
   // unregister all of our subscriptions
   ROSCPP_LOG_DEBUG("  shutting down subscribers");
   {
-    boost::mutex::scoped_lock subs_lock(subs_mutex_);
+    threading::mutex::scoped_lock subs_lock(subs_mutex_);
 
     for (L_Subscription::iterator s = subscriptions_.begin(); s != subscriptions_.end(); ++s)
     {
@@ -154,20 +154,28 @@ void TopicManager::shutdown()
 
 void TopicManager::processPublishQueues()
 {
-  boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+  // Send the queued messages without advertised_topics_mutex_ held, so that a slow link doesn't hold up
+  // publishing, advertising or connecting on every other topic.  A publication unadvertised in the meantime is
+  // dropped, and processPublishQueue() does nothing for it.
+  {
+    threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+    publish_queue_topics_.assign(advertised_topics_.begin(), advertised_topics_.end());
+  }
 
-  V_Publication::iterator it = advertised_topics_.begin();
-  V_Publication::iterator end = advertised_topics_.end();
+  V_Publication::iterator it = publish_queue_topics_.begin();
+  V_Publication::iterator end = publish_queue_topics_.end();
   for (; it != end; ++it)
   {
     const PublicationPtr& pub = *it;
     pub->processPublishQueue();
   }
+
+  publish_queue_topics_.clear();
 }
 
 void TopicManager::getAdvertisedTopics(V_string& topics)
 {
-  boost::mutex::scoped_lock lock(advertised_topic_names_mutex_);
+  threading::mutex::scoped_lock lock(advertised_topic_names_mutex_);
 
   topics.resize(advertised_topic_names_.size());
   std::copy(advertised_topic_names_.begin(),
@@ -177,7 +185,7 @@ void TopicManager::getAdvertisedTopics(V_string& topics)
 
 void TopicManager::getSubscribedTopics(V_string& topics)
 {
-  boost::mutex::scoped_lock lock(subs_mutex_);
+  threading::mutex::scoped_lock lock(subs_mutex_);
 
   topics.reserve(subscriptions_.size());
   L_Subscription::const_iterator it = subscriptions_.begin();
@@ -191,7 +199,7 @@ void TopicManager::getSubscribedTopics(V_string& topics)
 
 PublicationPtr TopicManager::lookupPublication(const std::string& topic)
 {
-  boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+  threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
 
   return lookupPublicationWithoutLock(topic);
 }
@@ -239,7 +247,7 @@ bool TopicManager::addSubCallback(const SubscribeOptions& ops)
   }
   else if (found)
   {
-    if (!sub->addCallback(ops.helper, ops.md5sum, ops.callback_queue, ops.queue_size, ops.tracked_object, ops.allow_concurrent_callbacks))
+    if (!sub->addCallback(ops.helper, ops.md5sum, ops.callback_queue, ops.queue_size, ops.tracked_object, ops.allow_concurrent_callbacks, ops.priority, ops.deadline, ops.conflate, ops.max_batch, ops.max_latency))
     {
       return false;
     }
@@ -251,7 +259,7 @@ bool TopicManager::addSubCallback(const SubscribeOptions& ops)
 // this function has the subscription code that doesn't need to be templated.
 bool TopicManager::subscribe(const SubscribeOptions& ops)
 {
-  boost::mutex::scoped_lock lock(subs_mutex_);
+  threading::mutex::scoped_lock lock(subs_mutex_);
 
   if (addSubCallback(ops))
   {
@@ -282,7 +290,7 @@ bool TopicManager::subscribe(const SubscribeOptions& ops)
   std::string datatype = ops.datatype;
 
   SubscriptionPtr s(new Subscription(ops.topic, md5sum, datatype, ops.transport_hints));
-  s->addCallback(ops.helper, ops.md5sum, ops.callback_queue, ops.queue_size, ops.tracked_object, ops.allow_concurrent_callbacks);
+  s->addCallback(ops.helper, ops.md5sum, ops.callback_queue, ops.queue_size, ops.tracked_object, ops.allow_concurrent_callbacks, ops.priority, ops.deadline, ops.conflate, ops.max_batch, ops.max_latency);
 
   if (!registerSubscriber(s, ops.datatype))
   {
@@ -330,7 +338,7 @@ bool TopicManager::advertise(const AdvertiseOptions& ops, const SubscriberCallba
   PublicationPtr pub;
 
   {
-    boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+    threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
 
     if (isShuttingDown())
     {
@@ -364,7 +372,7 @@ bool TopicManager::advertise(const AdvertiseOptions& ops, const SubscriberCallba
 
 
   {
-    boost::mutex::scoped_lock lock(advertised_topic_names_mutex_);
+    threading::mutex::scoped_lock lock(advertised_topic_names_mutex_);
     advertised_topic_names_.push_back(ops.topic);
   }
 
@@ -376,7 +384,7 @@ bool TopicManager::advertise(const AdvertiseOptions& ops, const SubscriberCallba
   bool found = false;
   SubscriptionPtr sub;
   {
-    boost::mutex::scoped_lock lock(subs_mutex_);
+    threading::mutex::scoped_lock lock(subs_mutex_);
 
     for (L_Subscription::iterator s = subscriptions_.begin();
          s != subscriptions_.end() && !found; ++s)
@@ -410,7 +418,7 @@ bool TopicManager::unadvertise(const std::string &topic, const SubscriberCallbac
   PublicationPtr pub;
   V_Publication::iterator i;
   {
-    boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+    threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
 
     if (isShuttingDown())
     {
@@ -436,7 +444,7 @@ bool TopicManager::unadvertise(const std::string &topic, const SubscriberCallbac
   pub->removeCallbacks(callbacks);
 
   {
-    boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+    threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
     if (pub->getNumCallbacks() == 0)
     {
       unregisterPublisher(pub->getName());
@@ -445,7 +453,7 @@ bool TopicManager::unadvertise(const std::string &topic, const SubscriberCallbac
       advertised_topics_.erase(i);
 
       {
-        boost::mutex::scoped_lock lock(advertised_topic_names_mutex_);
+        threading::mutex::scoped_lock lock(advertised_topic_names_mutex_);
         advertised_topic_names_.remove(pub->getName());
       }
     }
@@ -505,7 +513,7 @@ bool TopicManager::registerSubscriber(const SubscriptionPtr& s, const string &da
   const std::string& sub_md5sum = s->md5sum();
   // Figure out if we have a local publisher
   {
-    boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+    threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
     V_Publication::const_iterator it = advertised_topics_.begin();
     V_Publication::const_iterator end = advertised_topics_.end();
     for (; it != end; ++it)
@@ -557,7 +565,7 @@ bool TopicManager::pubUpdate(const string &topic, const vector<string> &pubs)
 {
   SubscriptionPtr sub;
   {
-    boost::mutex::scoped_lock lock(subs_mutex_);
+    threading::mutex::scoped_lock lock(subs_mutex_);
 
     if (isShuttingDown())
     {
@@ -623,6 +631,46 @@ bool TopicManager::requestTopic(const string &topic,
       ret[2] = tcpros_params;
       return true;
     }
+    else if (proto_name == string("UNIXROS"))
+    {
+      std::string unix_path = connection_manager_->getUnixSocketPath();
+      if (unix_path.empty())
+      {
+        // The subscriber offers TCPROS after UNIXROS, so let it fall back
+        ROSCPP_LOG_DEBUG("UNIXROS was requested for topic [%s], but isn't available", topic.c_str());
+        continue;
+      }
+
+      XmlRpcValue unixros_params;
+      unixros_params[0] = string("UNIXROS");
+      unixros_params[1] = unix_path;
+      // for the subscriber to fall back on if it can't reach the socket
+      unixros_params[2] = network::getHost();
+      unixros_params[3] = int(connection_manager_->getTCPPort());
+      ret[0] = int(1);
+      ret[1] = string();
+      ret[2] = unixros_params;
+      return true;
+    }
+    else if (proto_name == string("SHMROS"))
+    {
+      uint32_t shm_port = connection_manager_->getSHMPort();
+      if (shm_port == 0)
+      {
+        // The subscriber offers TCPROS after SHMROS, so let it fall back
+        ROSCPP_LOG_DEBUG("SHMROS was requested for topic [%s], but isn't available", topic.c_str());
+        continue;
+      }
+
+      XmlRpcValue shmros_params;
+      shmros_params[0] = string("SHMROS");
+      shmros_params[1] = network::getHost();
+      shmros_params[2] = int(shm_port);
+      ret[0] = int(1);
+      ret[1] = string();
+      ret[2] = shmros_params;
+      return true;
+    }
     else if (proto_name == string("UDPROS"))
     {
       if (proto.size() != 5 ||
@@ -704,14 +752,21 @@ bool TopicManager::requestTopic(const string &topic,
 
 void TopicManager::publish(const std::string& topic, const boost::function<SerializedMessage(void)>& serfunc, SerializedMessage& m)
 {
-  boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
-
-  if (isShuttingDown())
+  PublicationPtr p;
   {
-    return;
+    threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+
+    if (isShuttingDown())
+    {
+      return;
+    }
+
+    p = lookupPublicationWithoutLock(topic);
   }
 
-  PublicationPtr p = lookupPublicationWithoutLock(topic);
+  // Serializing and handing the message to the links happen without advertised_topics_mutex_ held, so publishers on
+  // different topics don't serialize behind each other.  If the topic is unadvertised meanwhile the publication is
+  // dropped, and won't send the message.
   if (p->hasSubscribers() || p->isLatching())
   {
     ROS_DEBUG_NAMED("superdebug", "Publishing message on topic [%s] with sequence number [%d]", p->getName().c_str(), p->getSequence());
@@ -801,7 +856,7 @@ bool TopicManager::unsubscribe(const std::string &topic, const SubscriptionCallb
   SubscriptionPtr sub;
 
   {
-    boost::mutex::scoped_lock lock(subs_mutex_);
+    threading::mutex::scoped_lock lock(subs_mutex_);
 
     if (isShuttingDown())
     {
@@ -831,7 +886,7 @@ bool TopicManager::unsubscribe(const std::string &topic, const SubscriptionCallb
   {
     // nobody is left. blow away the subscription.
     {
-      boost::mutex::scoped_lock lock(subs_mutex_);
+      threading::mutex::scoped_lock lock(subs_mutex_);
 
       L_Subscription::iterator it;
       for (it = subscriptions_.begin();
@@ -859,7 +914,7 @@ bool TopicManager::unsubscribe(const std::string &topic, const SubscriptionCallb
 
 size_t TopicManager::getNumSubscribers(const std::string &topic)
 {
-  boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+  threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
 
   if (isShuttingDown())
   {
@@ -877,13 +932,13 @@ size_t TopicManager::getNumSubscribers(const std::string &topic)
 
 size_t TopicManager::getNumSubscriptions()
 {
-  boost::mutex::scoped_lock lock(subs_mutex_);
+  threading::mutex::scoped_lock lock(subs_mutex_);
   return subscriptions_.size();
 }
 
 size_t TopicManager::getNumPublishers(const std::string &topic)
 {
-  boost::mutex::scoped_lock lock(subs_mutex_);
+  threading::mutex::scoped_lock lock(subs_mutex_);
 
   if (isShuttingDown())
   {
@@ -902,6 +957,27 @@ size_t TopicManager::getNumPublishers(const std::string &topic)
   return 0;
 }
 
+SubscriptionQueuePtr TopicManager::lookupSubscriptionQueue(const std::string &topic, const SubscriptionCallbackHelperPtr& helper)
+{
+  threading::mutex::scoped_lock lock(subs_mutex_);
+
+  if (isShuttingDown())
+  {
+    return SubscriptionQueuePtr();
+  }
+
+  for (L_Subscription::const_iterator t = subscriptions_.begin();
+       t != subscriptions_.end(); ++t)
+  {
+    if (!(*t)->isDropped() && (*t)->getName() == topic)
+    {
+      return (*t)->getSubscriptionQueue(helper);
+    }
+  }
+
+  return SubscriptionQueuePtr();
+}
+
 void TopicManager::getBusStats(XmlRpcValue &stats)
 {
   XmlRpcValue publish_stats, subscribe_stats, service_stats;
@@ -912,7 +988,7 @@ void TopicManager::getBusStats(XmlRpcValue &stats)
 
   uint32_t pidx = 0;
   {
-    boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+    threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
     for (V_Publication::iterator t = advertised_topics_.begin();
          t != advertised_topics_.end(); ++t)
     {
@@ -923,7 +999,7 @@ void TopicManager::getBusStats(XmlRpcValue &stats)
   {
     uint32_t sidx = 0;
 
-    boost::mutex::scoped_lock lock(subs_mutex_);
+    threading::mutex::scoped_lock lock(subs_mutex_);
     for (L_Subscription::iterator t = subscriptions_.begin(); t != subscriptions_.end(); ++t)
     {
       subscribe_stats[sidx++] = (*t)->getStats();
@@ -941,7 +1017,7 @@ void TopicManager::getBusInfo(XmlRpcValue &info)
   info.setSize(0);
 
   {
-    boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+    threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
 
     for (V_Publication::iterator t = advertised_topics_.begin();
          t != advertised_topics_.end(); ++t)
@@ -951,7 +1027,7 @@ void TopicManager::getBusInfo(XmlRpcValue &info)
   }
 
   {
-    boost::mutex::scoped_lock lock(subs_mutex_);
+    threading::mutex::scoped_lock lock(subs_mutex_);
 
     for (L_Subscription::iterator t = subscriptions_.begin(); t != subscriptions_.end(); ++t)
     {
@@ -966,7 +1042,7 @@ void TopicManager::getSubscriptions(XmlRpcValue &subs)
   subs.setSize(0);
 
   {
-    boost::mutex::scoped_lock lock(subs_mutex_);
+    threading::mutex::scoped_lock lock(subs_mutex_);
 
     uint32_t sidx = 0;
 
@@ -986,7 +1062,7 @@ void TopicManager::getPublications(XmlRpcValue &pubs)
   pubs.setSize(0);
 
   {
-    boost::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
+    threading::recursive_mutex::scoped_lock lock(advertised_topics_mutex_);
 
     uint32_t sidx = 0;
 
@@ -104,6 +104,27 @@ Transport::Transport()
 #endif
 }
 
+int32_t Transport::writev(const WriteBuffer* buffers, uint32_t count)
+{
+  int32_t total = 0;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    int32_t bytes = write(buffers[i].data, buffers[i].size);
+    if (bytes < 0)
+    {
+      return total > 0 ? total : -1;
+    }
+
+    total += bytes;
+    if (bytes < (int32_t)buffers[i].size)
+    {
+      break;
+    }
+  }
+
+  return total;
+}
+
 bool Transport::isHostAllowed(const std::string &host) const
 {
   if (!only_localhost_allowed_)
@@ -0,0 +1,776 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2008, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "config.h"
+#include "ros/io.h"
+#include "ros/transport/transport_shm.h"
+#include "ros/poll_set.h"
+#include "ros/file_log.h"
+#include <ros/assert.h>
+#include <sstream>
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <fcntl.h>
+#include <errno.h>
+#include <cstring>
+#include <climits>
+#include <unistd.h>
+#if defined(HAVE_SHM_OPEN)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+#endif
+
+namespace ros
+{
+
+namespace
+{
+const uint32_t SEGMENT_MAGIC = 0x53524f53; // "SORS"
+const char* SEGMENT_PREFIX = "/roscpp_shm_";
+/// The subscriber only ever sends its connection header, so its ring can be small
+const uint32_t CLIENT_RING_SIZE = 1 << 16;
+const uint32_t SEGMENT_HEADER_SIZE = 64;
+const uint32_t MAX_SEGMENT_NAME = 255;
+
+struct SegmentHeader
+{
+  uint32_t magic;
+  uint32_t client_ring_size;
+  uint32_t server_ring_size;
+};
+
+uint32_t g_segment_counter = 0;
+}
+
+/**
+ * \brief Control block of one direction of the segment.  The writer owns write_pos, the reader owns
+ * read_pos; both are free running and wrap at 2^32, which is why ring sizes must be powers of two.
+ * Each lives on its own cache line so the two sides don't contend.
+ */
+struct TransportSHM::Ring
+{
+  volatile uint32_t write_pos;
+  uint8_t pad0[60];
+  volatile uint32_t read_pos;
+  uint8_t pad1[60];
+  /// Set by the reader when it runs out of data, cleared by the writer when it rings the doorbell
+  volatile uint32_t reader_waiting;
+  /// Set by the writer when the ring is full, cleared by the reader when it rings the doorbell
+  volatile uint32_t writer_waiting;
+  uint32_t size;
+  uint8_t pad2[52];
+};
+
+namespace
+{
+
+size_t segmentSize(uint32_t client_ring_size, uint32_t server_ring_size)
+{
+  return SEGMENT_HEADER_SIZE + 2 * sizeof(TransportSHM::Ring) + client_ring_size + server_ring_size;
+}
+
+/*
+ * The ring functions take the ring size from the caller rather than from shared memory, and never trust the
+ * distance between the positions: the peer can write anything it likes to the segment, and a distance larger
+ * than the ring would have the copies run off the end of it.
+ */
+
+uint32_t ringSpace(const TransportSHM::Ring* ring, uint32_t ring_size)
+{
+  uint32_t used = ring->write_pos - ring->read_pos;
+  // A corrupt ring reports space, so that the next ringWrite() finds out and the connection is dropped
+  return used > ring_size ? ring_size : ring_size - used;
+}
+
+/**
+ * \brief Copy up to size bytes into the ring.  Returns false if the ring's positions are corrupt.
+ */
+bool ringWrite(TransportSHM::Ring* ring, uint8_t* data, uint32_t ring_size, const uint8_t* buffer, uint32_t size, uint32_t& n)
+{
+  uint32_t read_pos = ring->read_pos;
+  // don't overwrite anything until the reader has finished copying it out
+  __sync_synchronize();
+  uint32_t write_pos = ring->write_pos;
+  uint32_t used = write_pos - read_pos;
+  if (used > ring_size)
+  {
+    n = 0;
+    return false;
+  }
+
+  n = std::min(size, ring_size - used);
+  uint32_t offset = write_pos & (ring_size - 1);
+  uint32_t first = std::min(n, ring_size - offset);
+  memcpy(data + offset, buffer, first);
+  memcpy(data, buffer + first, n - first);
+  // publish the data before the new write position
+  __sync_synchronize();
+  ring->write_pos = write_pos + n;
+  return true;
+}
+
+/**
+ * \brief Copy up to size bytes out of the ring.  Returns false if the ring's positions are corrupt.
+ */
+bool ringRead(TransportSHM::Ring* ring, const uint8_t* data, uint32_t ring_size, uint8_t* buffer, uint32_t size, uint32_t& n)
+{
+  uint32_t write_pos = ring->write_pos;
+  __sync_synchronize();
+  uint32_t read_pos = ring->read_pos;
+  uint32_t used = write_pos - read_pos;
+  if (used > ring_size)
+  {
+    n = 0;
+    return false;
+  }
+
+  n = std::min(size, used);
+  uint32_t offset = read_pos & (ring_size - 1);
+  uint32_t first = std::min(n, ring_size - offset);
+  memcpy(buffer, data + offset, first);
+  memcpy(buffer + first, data, n - first);
+  // finish copying out before handing the space back to the writer
+  __sync_synchronize();
+  ring->read_pos = read_pos + n;
+  return true;
+}
+
+}
+
+bool TransportSHM::isAvailable()
+{
+#if defined(HAVE_SHM_OPEN)
+  return true;
+#else
+  return false;
+#endif
+}
+
+TransportSHM::TransportSHM(PollSet* poll_set, uint32_t ring_size)
+: poll_set_(poll_set)
+, ring_size_(ring_size)
+, state_(SendingSegmentName)
+, closed_(false)
+, expecting_read_(false)
+, expecting_write_(false)
+, segment_(0)
+, segment_size_(0)
+, rx_(0)
+, rx_data_(0)
+, rx_size_(0)
+, tx_(0)
+, tx_data_(0)
+, tx_size_(0)
+, name_buffer_done_(0)
+{
+  ROS_ASSERT_MSG((ring_size_ & (ring_size_ - 1)) == 0 && ring_size_ >= CLIENT_RING_SIZE,
+                 "SHMROS ring size [%u] must be a power of two, at least %u", ring_size_, CLIENT_RING_SIZE);
+}
+
+TransportSHM::~TransportSHM()
+{
+  // Unmapping is left until nothing can be holding on to us, since close() may happen
+  // while another thread is in the middle of read() or write()
+  unmapSegment();
+}
+
+bool TransportSHM::createSegment()
+{
+#if defined(HAVE_SHM_OPEN)
+  std::stringstream ss;
+  ss << SEGMENT_PREFIX << getpid() << "_" << __sync_fetch_and_add(&g_segment_counter, 1);
+  segment_name_ = ss.str();
+
+  int fd = shm_open(segment_name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0)
+  {
+    ROS_ERROR("shm_open() of [%s] failed with error [%s]", segment_name_.c_str(), strerror(errno));
+    return false;
+  }
+
+  segment_size_ = segmentSize(CLIENT_RING_SIZE, ring_size_);
+  if (ftruncate(fd, segment_size_) != 0)
+  {
+    ROS_ERROR("ftruncate() of [%s] failed with error [%s]", segment_name_.c_str(), strerror(errno));
+    ::close(fd);
+    shm_unlink(segment_name_.c_str());
+    return false;
+  }
+
+  void* addr = mmap(NULL, segment_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED)
+  {
+    ROS_ERROR("mmap() of [%s] failed with error [%s]", segment_name_.c_str(), strerror(errno));
+    shm_unlink(segment_name_.c_str());
+    return false;
+  }
+
+  // ftruncate() zero fills, so the rings start out empty
+  segment_ = static_cast<uint8_t*>(addr);
+  SegmentHeader* header = reinterpret_cast<SegmentHeader*>(segment_);
+  header->client_ring_size = CLIENT_RING_SIZE;
+  header->server_ring_size = ring_size_;
+  setupRings(true, CLIENT_RING_SIZE, ring_size_);
+  tx_->size = CLIENT_RING_SIZE;
+  rx_->size = ring_size_;
+  __sync_synchronize();
+  header->magic = SEGMENT_MAGIC;
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool TransportSHM::attachSegment(const std::string& name)
+{
+#if defined(HAVE_SHM_OPEN)
+  if (name.compare(0, strlen(SEGMENT_PREFIX), SEGMENT_PREFIX) != 0 || name.find('/', 1) != std::string::npos)
+  {
+    ROS_ERROR("Refusing to attach to shared memory segment [%s]", name.c_str());
+    return false;
+  }
+
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0)
+  {
+    ROS_ERROR("shm_open() of [%s] failed with error [%s]", name.c_str(), strerror(errno));
+    return false;
+  }
+
+  // Both sides have it open now, so its name is no longer needed
+  shm_unlink(name.c_str());
+  segment_name_ = name;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)segmentSize(0, 0))
+  {
+    ROS_ERROR("Shared memory segment [%s] is too small", name.c_str());
+    ::close(fd);
+    return false;
+  }
+
+  void* addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED)
+  {
+    ROS_ERROR("mmap() of [%s] failed with error [%s]", name.c_str(), strerror(errno));
+    return false;
+  }
+
+  segment_ = static_cast<uint8_t*>(addr);
+  segment_size_ = st.st_size;
+
+  const SegmentHeader* header = reinterpret_cast<const SegmentHeader*>(segment_);
+  __sync_synchronize();
+  uint32_t client_ring_size = header->client_ring_size;
+  uint32_t server_ring_size = header->server_ring_size;
+  if (header->magic != SEGMENT_MAGIC ||
+      segmentSize(client_ring_size, server_ring_size) != segment_size_ ||
+      (client_ring_size & (client_ring_size - 1)) != 0 ||
+      (server_ring_size & (server_ring_size - 1)) != 0)
+  {
+    ROS_ERROR("Shared memory segment [%s] has an invalid layout", name.c_str());
+    return false;
+  }
+
+  // only trust sizes we've checked against the size of the mapping
+  ring_size_ = server_ring_size;
+  setupRings(false, client_ring_size, server_ring_size);
+  if (rx_->size != client_ring_size || tx_->size != server_ring_size)
+  {
+    ROS_ERROR("Shared memory segment [%s] has an invalid layout", name.c_str());
+    return false;
+  }
+
+  return true;
+#else
+  return false;
+#endif
+}
+
+void TransportSHM::unmapSegment()
+{
+#if defined(HAVE_SHM_OPEN)
+  if (segment_)
+  {
+    munmap(segment_, segment_size_);
+    segment_ = 0;
+    rx_ = tx_ = 0;
+    rx_data_ = tx_data_ = 0;
+    rx_size_ = tx_size_ = 0;
+  }
+#endif
+}
+
+void TransportSHM::setupRings(bool is_client, uint32_t client_ring_size, uint32_t server_ring_size)
+{
+  Ring* client_ring = reinterpret_cast<Ring*>(segment_ + SEGMENT_HEADER_SIZE);
+  uint8_t* client_data = segment_ + SEGMENT_HEADER_SIZE + sizeof(Ring);
+  Ring* server_ring = reinterpret_cast<Ring*>(client_data + client_ring_size);
+  uint8_t* server_data = client_data + client_ring_size + sizeof(Ring);
+
+  if (is_client)
+  {
+    tx_ = client_ring;
+    tx_data_ = client_data;
+    tx_size_ = client_ring_size;
+    rx_ = server_ring;
+    rx_data_ = server_data;
+    rx_size_ = server_ring_size;
+  }
+  else
+  {
+    rx_ = client_ring;
+    rx_data_ = client_data;
+    rx_size_ = client_ring_size;
+    tx_ = server_ring;
+    tx_data_ = server_data;
+    tx_size_ = server_ring_size;
+  }
+}
+
+void TransportSHM::setDoorbellCallbacks()
+{
+  doorbell_->setReadCallback(boost::bind(&TransportSHM::onDoorbellReadable, this, _1));
+  doorbell_->setWriteCallback(boost::bind(&TransportSHM::onDoorbellWritable, this, _1));
+  doorbell_->setDisconnectCallback(boost::bind(&TransportSHM::onDoorbellDisconnect, this, _1));
+}
+
+bool TransportSHM::connect(const std::string& host, int port)
+{
+  if (!createSegment())
+  {
+    return false;
+  }
+
+  doorbell_ = TransportTCPPtr(new TransportTCP(poll_set_));
+  setDoorbellCallbacks();
+  if (!doorbell_->connect(host, port))
+  {
+#if defined(HAVE_SHM_OPEN)
+    shm_unlink(segment_name_.c_str());
+#endif
+    return false;
+  }
+  doorbell_->setNoDelay(true);
+
+  std::stringstream ss;
+  ss << host << ":" << port;
+  cached_remote_host_ = ss.str();
+
+  uint32_t len = segment_name_.size();
+  name_buffer_.resize(4 + len);
+  memcpy(&name_buffer_[0], &len, 4);
+  memcpy(&name_buffer_[4], segment_name_.data(), len);
+  name_buffer_done_ = 0;
+
+  // Send the segment name as soon as the connection completes
+  state_ = SendingSegmentName;
+  doorbell_->enableWrite();
+
+  return true;
+}
+
+bool TransportSHM::accept(const TransportTCPPtr& transport)
+{
+  doorbell_ = transport;
+  setDoorbellCallbacks();
+  doorbell_->setNoDelay(true);
+  cached_remote_host_ = doorbell_->getClientURI();
+
+  name_buffer_.resize(4);
+  name_buffer_done_ = 0;
+
+  state_ = ReceivingSegmentName;
+  doorbell_->enableRead();
+
+  return true;
+}
+
+void TransportSHM::notifyActive()
+{
+  doorbell_->enableRead();
+
+  if (expecting_write_)
+  {
+    doorbell_->enableWrite();
+  }
+
+  // the client may have written into the ring before we mapped it
+  if (expecting_read_ && read_cb_)
+  {
+    read_cb_(shared_from_this());
+  }
+}
+
+void TransportSHM::onDoorbellWritable(const TransportPtr& transport)
+{
+  threading::recursive_mutex::scoped_lock lock(close_mutex_);
+  if (closed_)
+  {
+    return;
+  }
+
+  if (state_ == SendingSegmentName)
+  {
+    int32_t bytes = doorbell_->write(&name_buffer_[name_buffer_done_], name_buffer_.size() - name_buffer_done_);
+    if (bytes < 0)
+    {
+      return;
+    }
+
+    name_buffer_done_ += bytes;
+    if (name_buffer_done_ < name_buffer_.size())
+    {
+      return;
+    }
+
+    ROSCPP_LOG_DEBUG("SHMROS segment [%s] sent to [%s]", segment_name_.c_str(), cached_remote_host_.c_str());
+    name_buffer_.clear();
+    state_ = Active;
+    doorbell_->disableWrite();
+    notifyActive();
+    return;
+  }
+
+  if (state_ != Active || !expecting_write_)
+  {
+    doorbell_->disableWrite();
+    return;
+  }
+
+  if (ringSpace(tx_, tx_size_) == 0)
+  {
+    // Wait for the reader to ring the doorbell once it has made some room
+    doorbell_->disableWrite();
+    tx_->writer_waiting = 1;
+    __sync_synchronize();
+    if (ringSpace(tx_, tx_size_) == 0)
+    {
+      return;
+    }
+    doorbell_->enableWrite();
+  }
+
+  if (write_cb_)
+  {
+    write_cb_(shared_from_this());
+  }
+}
+
+void TransportSHM::onDoorbellReadable(const TransportPtr& transport)
+{
+  threading::recursive_mutex::scoped_lock lock(close_mutex_);
+  if (closed_)
+  {
+    return;
+  }
+
+  if (state_ == ReceivingSegmentName)
+  {
+    // Loop rather than waiting for another callback, an edge-triggered PollSet won't make one
+    while (name_buffer_done_ < name_buffer_.size())
+    {
+      int32_t bytes = doorbell_->read(&name_buffer_[name_buffer_done_], name_buffer_.size() - name_buffer_done_);
+      if (bytes <= 0)
+      {
+        return;
+      }
+
+      name_buffer_done_ += bytes;
+      if (name_buffer_done_ == 4 && name_buffer_.size() == 4)
+      {
+        uint32_t len;
+        memcpy(&len, &name_buffer_[0], 4);
+        if (len == 0 || len > MAX_SEGMENT_NAME)
+        {
+          ROSCPP_LOG_DEBUG("SHMROS connection from [%s] sent an invalid segment name length [%u]", cached_remote_host_.c_str(), len);
+          lock.unlock();
+          close();
+          return;
+        }
+        name_buffer_.resize(4 + len);
+      }
+    }
+
+    std::string name(name_buffer_.begin() + 4, name_buffer_.end());
+    name_buffer_.clear();
+    if (!attachSegment(name))
+    {
+      lock.unlock();
+      close();
+      return;
+    }
+
+    ROSCPP_LOG_DEBUG("SHMROS segment [%s] attached for [%s]", segment_name_.c_str(), cached_remote_host_.c_str());
+    state_ = Active;
+    notifyActive();
+    return;
+  }
+
+  if (state_ != Active)
+  {
+    return;
+  }
+
+  // The doorbell bytes themselves carry no information, drain them
+  uint8_t buf[64];
+  int32_t bytes;
+  do
+  {
+    bytes = doorbell_->read(buf, sizeof(buf));
+    if (bytes < 0)
+    {
+      return;
+    }
+  } while (bytes == (int32_t)sizeof(buf));
+
+  if (expecting_read_ && read_cb_)
+  {
+    read_cb_(shared_from_this());
+  }
+
+  if (expecting_write_)
+  {
+    doorbell_->enableWrite();
+  }
+}
+
+void TransportSHM::onDoorbellDisconnect(const TransportPtr& transport)
+{
+  close();
+}
+
+void TransportSHM::ringDoorbell(volatile uint32_t* flag)
+{
+  // Pairs with the barrier between setting the flag and re-checking the ring on the other side
+  __sync_synchronize();
+  if (*flag && __sync_bool_compare_and_swap(flag, 1, 0))
+  {
+    uint8_t b = 0;
+    doorbell_->write(&b, 1);
+  }
+}
+
+int32_t TransportSHM::read(uint8_t* buffer, uint32_t size)
+{
+  {
+    threading::recursive_mutex::scoped_lock lock(close_mutex_);
+
+    if (closed_)
+    {
+      ROSCPP_LOG_DEBUG("Tried to read on a closed SHMROS transport [%s]", segment_name_.c_str());
+      return -1;
+    }
+
+    if (state_ != Active)
+    {
+      return 0;
+    }
+  }
+
+  ROS_ASSERT(size > 0);
+
+  uint32_t bytes = 0;
+  bool ok = ringRead(rx_, rx_data_, rx_size_, buffer, size, bytes);
+  if (ok && bytes < size)
+  {
+    // Ask for a doorbell, then check again in case the writer got in before it saw the flag
+    rx_->reader_waiting = 1;
+    __sync_synchronize();
+    uint32_t more = 0;
+    ok = ringRead(rx_, rx_data_, rx_size_, buffer + bytes, size - bytes, more);
+    bytes += more;
+  }
+
+  if (!ok)
+  {
+    ROS_ERROR("SHMROS segment [%s] has a corrupt receive ring, dropping the connection", segment_name_.c_str());
+    close();
+    return -1;
+  }
+
+  if (bytes > 0)
+  {
+    ringDoorbell(&rx_->writer_waiting);
+  }
+
+  return std::min(bytes, static_cast<uint32_t>(INT_MAX));
+}
+
+int32_t TransportSHM::write(uint8_t* buffer, uint32_t size)
+{
+  {
+    threading::recursive_mutex::scoped_lock lock(close_mutex_);
+
+    if (closed_)
+    {
+      ROSCPP_LOG_DEBUG("Tried to write on a closed SHMROS transport [%s]", segment_name_.c_str());
+      return -1;
+    }
+
+    if (state_ != Active)
+    {
+      return 0;
+    }
+  }
+
+  ROS_ASSERT(size > 0);
+
+  uint32_t bytes = 0;
+  bool ok = ringWrite(tx_, tx_data_, tx_size_, buffer, size, bytes);
+  if (ok && bytes < size)
+  {
+    tx_->writer_waiting = 1;
+    __sync_synchronize();
+    uint32_t more = 0;
+    ok = ringWrite(tx_, tx_data_, tx_size_, buffer + bytes, size - bytes, more);
+    bytes += more;
+  }
+
+  if (!ok)
+  {
+    ROS_ERROR("SHMROS segment [%s] has a corrupt send ring, dropping the connection", segment_name_.c_str());
+    close();
+    return -1;
+  }
+
+  if (bytes > 0)
+  {
+    ringDoorbell(&tx_->reader_waiting);
+  }
+
+  return std::min(bytes, static_cast<uint32_t>(INT_MAX));
+}
+
+void TransportSHM::enableRead()
+{
+  threading::recursive_mutex::scoped_lock lock(close_mutex_);
+  if (closed_)
+  {
+    return;
+  }
+
+  // The doorbell is always read once we're active, there's nothing to register
+  expecting_read_ = true;
+}
+
+void TransportSHM::disableRead()
+{
+  threading::recursive_mutex::scoped_lock lock(close_mutex_);
+  expecting_read_ = false;
+}
+
+void TransportSHM::enableWrite()
+{
+  threading::recursive_mutex::scoped_lock lock(close_mutex_);
+  if (closed_)
+  {
+    return;
+  }
+
+  // Writability of the doorbell socket is used to get called back from the poll thread
+  expecting_write_ = true;
+  if (state_ == Active)
+  {
+    doorbell_->enableWrite();
+  }
+}
+
+void TransportSHM::disableWrite()
+{
+  threading::recursive_mutex::scoped_lock lock(close_mutex_);
+  if (closed_)
+  {
+    return;
+  }
+
+  expecting_write_ = false;
+  if (state_ == Active)
+  {
+    doorbell_->disableWrite();
+  }
+}
+
+void TransportSHM::close()
+{
+  Callback disconnect_cb;
+
+  if (!closed_)
+  {
+    {
+      threading::recursive_mutex::scoped_lock lock(close_mutex_);
+
+      if (!closed_)
+      {
+        closed_ = true;
+
+#if defined(HAVE_SHM_OPEN)
+        // in case the publisher never got as far as attaching
+        if (state_ == SendingSegmentName && !segment_name_.empty())
+        {
+          shm_unlink(segment_name_.c_str());
+        }
+#endif
+
+        disconnect_cb = disconnect_cb_;
+
+        disconnect_cb_ = Callback();
+        read_cb_ = Callback();
+        write_cb_ = Callback();
+      }
+    }
+
+    if (doorbell_)
+    {
+      doorbell_->close();
+    }
+  }
+
+  if (disconnect_cb)
+  {
+    disconnect_cb(shared_from_this());
+  }
+}
+
+std::string TransportSHM::getTransportInfo()
+{
+  std::stringstream str;
+  str << "SHMROS connection on segment [" << segment_name_ << "] to [" << cached_remote_host_ << "]";
+  return str.str();
+}
+
+} // namespace ros
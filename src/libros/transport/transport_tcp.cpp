@@ -32,6 +32,7 @@
  *  POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "config.h"
 #include "ros/io.h"
 #include "ros/transport/transport_tcp.h"
 #include "ros/poll_set.h"
@@ -42,12 +43,31 @@
 #include <boost/bind.hpp>
 #include <fcntl.h>
 #include <errno.h>
+#ifdef HAVE_SYS_UN_H
+  #include <sys/un.h>
+#endif
+#if !defined(WIN32)
+  #include <sys/uio.h>
+#endif
 namespace ros
 {
 
 bool TransportTCP::s_use_keepalive_ = true;
 bool TransportTCP::s_use_ipv6_ = false;
 
+// Most buffers handed to one writev() call
+static const uint32_t MAX_WRITEV_BUFFERS = 64;
+bool TransportTCP::s_use_unix_sockets_ = true;
+
+bool TransportTCP::isUnixAvailable()
+{
+#ifdef HAVE_SYS_UN_H
+  return true;
+#else
+  return false;
+#endif
+}
+
 TransportTCP::TransportTCP(PollSet* poll_set, int flags)
 : sock_(ROS_INVALID_SOCKET)
 , closed_(false)
@@ -58,6 +78,7 @@ TransportTCP::TransportTCP(PollSet* poll_set, int flags)
 , local_port_(-1)
 , poll_set_(poll_set)
 , flags_(flags)
+, is_unix_(false)
 {
 
 }
@@ -97,7 +118,10 @@ bool TransportTCP::initializeSocket()
     return false;
   }
 
-  setKeepAlive(s_use_keepalive_, 60, 10, 9);
+  if (!is_unix_)
+  {
+    setKeepAlive(s_use_keepalive_, 60, 10, 9);
+  }
 
   // connect() will set cached_remote_host_ because it already has the host/port available
   if (cached_remote_host_.empty())
@@ -114,7 +138,7 @@ bool TransportTCP::initializeSocket()
     }
   }
 
-  if (local_port_ < 0)
+  if (local_port_ < 0 && !is_unix_)
   {
     la_len_ = s_use_ipv6_  ? sizeof(sockaddr_in6) : sizeof(sockaddr_in);
     getsockname(sock_, (sockaddr *)&local_address_, &la_len_);
@@ -160,6 +184,12 @@ void TransportTCP::parseHeader(const Header& header)
 
 void TransportTCP::setNoDelay(bool nodelay)
 {
+  // there's no Nagle to turn off on a unix domain socket
+  if (is_unix_)
+  {
+    return;
+  }
+
   int flag = nodelay ? 1 : 0;
   int result = setsockopt(sock_, IPPROTO_TCP, TCP_NODELAY, (char *) &flag, sizeof(int));
   if (result < 0)
@@ -350,6 +380,119 @@ bool TransportTCP::connect(const std::string& host, int port)
   return true;
 }
 
+bool TransportTCP::connectUnix(const std::string& path)
+{
+#ifdef HAVE_SYS_UN_H
+  sockaddr_un address;
+  if (path.size() >= sizeof(address.sun_path))
+  {
+    ROS_ERROR("Unix socket path [%s] is too long", path.c_str());
+    return false;
+  }
+
+  is_unix_ = true;
+  unix_path_ = path;
+  connected_host_ = "localhost";
+  connected_port_ = 0;
+
+  sock_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock_ == ROS_INVALID_SOCKET)
+  {
+    ROS_ERROR("socket() failed with error [%s]",  last_socket_error_string());
+    return false;
+  }
+
+  setNonBlocking();
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  // Unlike TCP, a non-blocking connect() to a unix socket completes (or fails) immediately.  On Linux it
+  // returns EAGAIN when the listen backlog is full, and nothing follows: the connect has to be retried, so
+  // that is a failure like any other.
+  int ret = ::connect(sock_, (sockaddr*) &address, sizeof(address));
+  if (ret != 0)
+  {
+    ROSCPP_LOG_DEBUG("Connect to tcpros publisher on unix socket [%s] failed with error [%d, %s]", path.c_str(), ret, last_socket_error_string());
+    close();
+
+    return false;
+  }
+
+  std::stringstream ss;
+  ss << "unix:" << path << " on socket " << sock_;
+  cached_remote_host_ = ss.str();
+
+  if (!initializeSocket())
+  {
+    return false;
+  }
+
+  ROSCPP_LOG_DEBUG("connect() to unix socket [%s] on socket [%d]", path.c_str(), sock_);
+
+  return true;
+#else
+  ROS_ERROR("Unix domain sockets are not supported on this platform");
+  return false;
+#endif
+}
+
+bool TransportTCP::listenUnix(const std::string& path, int backlog, const AcceptCallback& accept_cb)
+{
+#ifdef HAVE_SYS_UN_H
+  sockaddr_un address;
+  if (path.size() >= sizeof(address.sun_path))
+  {
+    ROS_ERROR("Unix socket path [%s] is too long", path.c_str());
+    return false;
+  }
+
+  is_server_ = true;
+  is_unix_ = true;
+  accept_cb_ = accept_cb;
+
+  sock_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sock_ <= 0)
+  {
+    ROS_ERROR("socket() failed with error [%s]", last_socket_error_string());
+    return false;
+  }
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  // left behind by a process that crashed with our pid
+  ::unlink(path.c_str());
+
+  if (bind(sock_, (sockaddr *)&address, sizeof(address)) < 0)
+  {
+    ROS_ERROR("bind() to [%s] failed with error [%s]", path.c_str(), last_socket_error_string());
+    close();
+    return false;
+  }
+  unix_path_ = path;
+
+  ::listen(sock_, backlog);
+
+  if (!initializeSocket())
+  {
+    return false;
+  }
+
+  if (!(flags_ & SYNCHRONOUS))
+  {
+    enableRead();
+  }
+
+  return true;
+#else
+  ROS_ERROR("Unix domain sockets are not supported on this platform");
+  return false;
+#endif
+}
+
 bool TransportTCP::listen(int port, int backlog, const AcceptCallback& accept_cb)
 {
   is_server_ = true;
@@ -424,7 +567,7 @@ void TransportTCP::close()
   if (!closed_)
   {
     {
-      boost::recursive_mutex::scoped_lock lock(close_mutex_);
+      threading::recursive_mutex::scoped_lock lock(close_mutex_);
 
       if (!closed_)
       {
@@ -447,6 +590,11 @@ void TransportTCP::close()
         }
         sock_ = ROS_INVALID_SOCKET;
 
+        if (is_server_ && is_unix_ && !unix_path_.empty())
+        {
+          ::unlink(unix_path_.c_str());
+        }
+
         disconnect_cb = disconnect_cb_;
 
         disconnect_cb_ = Callback();
@@ -466,7 +614,7 @@ void TransportTCP::close()
 int32_t TransportTCP::read(uint8_t* buffer, uint32_t size)
 {
   {
-    boost::recursive_mutex::scoped_lock lock(close_mutex_);
+    threading::recursive_mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -505,7 +653,7 @@ int32_t TransportTCP::read(uint8_t* buffer, uint32_t size)
 int32_t TransportTCP::write(uint8_t* buffer, uint32_t size)
 {
   {
-    boost::recursive_mutex::scoped_lock lock(close_mutex_);
+    threading::recursive_mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -535,12 +683,64 @@ int32_t TransportTCP::write(uint8_t* buffer, uint32_t size)
   return num_bytes;
 }
 
+int32_t TransportTCP::writev(const WriteBuffer* buffers, uint32_t count)
+{
+#if defined(WIN32)
+  return Transport::writev(buffers, count);
+#else
+  {
+    threading::recursive_mutex::scoped_lock lock(close_mutex_);
+
+    if (closed_)
+    {
+      ROSCPP_LOG_DEBUG("Tried to write on a closed socket [%d]", sock_);
+      return -1;
+    }
+  }
+
+  ROS_ASSERT(count > 0);
+
+  // never write more than INT_MAX since this is the maximum we can report back with the current return type
+  struct iovec iov[MAX_WRITEV_BUFFERS];
+  uint32_t iov_count = 0;
+  uint32_t writesize = 0;
+  for (; iov_count < count && iov_count < MAX_WRITEV_BUFFERS; ++iov_count)
+  {
+    uint32_t size = std::min(buffers[iov_count].size, static_cast<uint32_t>(INT_MAX) - writesize);
+    if (size == 0)
+    {
+      break;
+    }
+    iov[iov_count].iov_base = buffers[iov_count].data;
+    iov[iov_count].iov_len = size;
+    writesize += size;
+  }
+
+  ssize_t num_bytes = ::writev(sock_, iov, iov_count);
+  if (num_bytes < 0)
+  {
+    if ( !last_socket_error_is_would_block() )
+    {
+      ROSCPP_LOG_DEBUG("writev() on socket [%d] failed with error [%s]", sock_, last_socket_error_string());
+      close();
+      return -1;
+    }
+    else
+    {
+      num_bytes = 0;
+    }
+  }
+
+  return num_bytes;
+#endif
+}
+
 void TransportTCP::enableRead()
 {
   ROS_ASSERT(!(flags_ & SYNCHRONOUS));
 
   {
-    boost::recursive_mutex::scoped_lock lock(close_mutex_);
+    threading::recursive_mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -560,7 +760,7 @@ void TransportTCP::disableRead()
   ROS_ASSERT(!(flags_ & SYNCHRONOUS));
 
   {
-    boost::recursive_mutex::scoped_lock lock(close_mutex_);
+    threading::recursive_mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -580,7 +780,7 @@ void TransportTCP::enableWrite()
   ROS_ASSERT(!(flags_ & SYNCHRONOUS));
 
   {
-    boost::recursive_mutex::scoped_lock lock(close_mutex_);
+    threading::recursive_mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -600,7 +800,7 @@ void TransportTCP::disableWrite()
   ROS_ASSERT(!(flags_ & SYNCHRONOUS));
 
   {
-    boost::recursive_mutex::scoped_lock lock(close_mutex_);
+    threading::recursive_mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -619,14 +819,16 @@ TransportTCPPtr TransportTCP::accept()
 {
   ROS_ASSERT(is_server_);
 
-  sockaddr client_address;
+  sockaddr_storage client_address;
   socklen_t len = sizeof(client_address);
   int new_sock = ::accept(sock_, (sockaddr *)&client_address, &len);
   if (new_sock >= 0)
   {
     ROSCPP_LOG_DEBUG("Accepted connection on socket [%d], new socket [%d]", sock_, new_sock);
 
-    TransportTCPPtr transport(new TransportTCP(poll_set_, flags_));
+    PollSet* poll_set = accept_poll_set_func_ ? accept_poll_set_func_() : poll_set_;
+    TransportTCPPtr transport(new TransportTCP(poll_set, flags_));
+    transport->is_unix_ = is_unix_;
     if (!transport->setSocket(new_sock))
     {
       ROS_ERROR("Failed to set socket on transport for socket %d", new_sock);
@@ -634,7 +836,7 @@ TransportTCPPtr TransportTCP::accept()
 
     return transport;
   }
-  else
+  else if (!last_socket_error_is_would_block())
   {
     ROS_ERROR("accept() on socket [%d] failed with error [%s]", sock_,  last_socket_error_string());
   }
@@ -645,7 +847,7 @@ TransportTCPPtr TransportTCP::accept()
 void TransportTCP::socketUpdate(int events)
 {
   {
-    boost::recursive_mutex::scoped_lock lock(close_mutex_);
+    threading::recursive_mutex::scoped_lock lock(close_mutex_);
     if (closed_)
     {
       return;
@@ -657,13 +859,20 @@ void TransportTCP::socketUpdate(int events)
       if (is_server_)
       {
         // Should not block here, because poll() said that it's ready
-        // for reading
-        TransportTCPPtr transport = accept();
-        if (transport)
+        // for reading.  An edge-triggered pollset won't tell us again about
+        // connections still in the backlog, so drain it.
+        bool drain = poll_set_->getBackend() == PollSet::EpollEdgeTriggered;
+        do
         {
+          TransportTCPPtr transport = accept();
+          if (!transport)
+          {
+            break;
+          }
+
           ROS_ASSERT(accept_cb_);
           accept_cb_(transport);
-        }
+        } while (drain && !closed_);
       }
       else
       {
@@ -708,7 +917,14 @@ void TransportTCP::socketUpdate(int events)
 std::string TransportTCP::getTransportInfo()
 {
   std::stringstream str;
-  str << "TCPROS connection on port " << local_port_ << " to [" << cached_remote_host_ << "]";
+  if (is_unix_)
+  {
+    str << "TCPROS connection on unix socket [" << unix_path_ << "] to [" << cached_remote_host_ << "]";
+  }
+  else
+  {
+    str << "TCPROS connection on port " << local_port_ << " to [" << cached_remote_host_ << "]";
+  }
   return str.str();
 }
 
@@ -736,6 +952,11 @@ std::string TransportTCP::getClientURI()
       port = ntohs(sin6->sin6_port);
       inet_ntop(AF_INET6, (void*)&(sin6->sin6_addr), namebuf, sizeof(namebuf));
       break;
+#ifdef HAVE_SYS_UN_H
+    case AF_UNIX:
+      // the accepting side of a unix socket has no peer name
+      return std::string("unix:") + ((sockaddr_un *)&sas)->sun_path;
+#endif
     default:
       namebuf[0] = 0;
       port = 0;
@@ -32,6 +32,7 @@
  *  POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "config.h"
 #include "ros/transport/transport_udp.h"
 #include "ros/poll_set.h"
 #include "ros/file_log.h"
@@ -40,6 +41,12 @@
 #include <boost/bind.hpp>
 
 #include <fcntl.h>
+#include <algorithm>
+#if defined(HAVE_RECVMMSG) || defined(HAVE_SENDMMSG)
+  // For recvmmsg() and sendmmsg(), and readv() and writev()
+  #include <sys/socket.h>
+  #include <sys/uio.h>
+#endif
 #if defined(__APPLE__)
   // For readv() and writev()
   #include <sys/types.h>
@@ -53,6 +60,17 @@
 namespace ros
 {
 
+namespace
+{
+// Most fragments handed to sendmmsg() at once
+const uint32_t SEND_BATCH_SIZE = 64;
+// How long to wait for a full socket to take the rest of a message that has been partly sent
+const int SEND_WAIT_TIMEOUT_MS = 10;
+// Most datagrams drained by one recvmmsg(), and the most memory to spend on holding them
+const uint32_t RECV_BATCH_SIZE = 64;
+const uint32_t RECV_BATCH_BYTES = 256 * 1024;
+}
+
 TransportUDP::TransportUDP(PollSet* poll_set, int flags, int max_datagram_size)
 : sock_(-1)
 , closed_(false)
@@ -71,6 +89,8 @@ TransportUDP::TransportUDP(PollSet* poll_set, int flags, int max_datagram_size)
 , data_filled_(0)
 , reorder_buffer_(0)
 , reorder_bytes_(0)
+, recv_batch_count_(0)
+, recv_batch_next_(0)
 {
   // This may eventually be machine dependent
   if (max_datagram_size_ == 0)
@@ -79,6 +99,7 @@ TransportUDP::TransportUDP(PollSet* poll_set, int flags, int max_datagram_size)
   reorder_start_ = reorder_buffer_;
   data_buffer_ = new uint8_t[max_datagram_size_];
   data_start_ = data_buffer_;
+  datagram_start_ = data_buffer_;
 }
 
 TransportUDP::~TransportUDP()
@@ -97,7 +118,7 @@ bool TransportUDP::setSocket(int sock)
 void TransportUDP::socketUpdate(int events)
 {
   {
-    boost::mutex::scoped_lock lock(close_mutex_);
+    threading::mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -303,7 +324,7 @@ void TransportUDP::close()
   if (!closed_)
   {
     {
-      boost::mutex::scoped_lock lock(close_mutex_);
+      threading::mutex::scoped_lock lock(close_mutex_);
 
       if (!closed_)
       {
@@ -340,10 +361,63 @@ void TransportUDP::close()
   }
 }
 
+int32_t TransportUDP::receiveDatagram(TransportUDPHeader& header)
+{
+#if defined(HAVE_RECVMMSG)
+  if (recv_batch_next_ == recv_batch_count_)
+  {
+    // Sized lazily, the transports on the publishing side never read
+    if (recv_batch_headers_.empty())
+    {
+      uint32_t capacity = std::max(1u, std::min(RECV_BATCH_SIZE, RECV_BATCH_BYTES / max_datagram_size_));
+      recv_batch_buffer_.resize(capacity * max_datagram_size_);
+      recv_batch_headers_.resize(capacity);
+      recv_batch_sizes_.resize(capacity);
+    }
+
+    const uint32_t capacity = recv_batch_headers_.size();
+    struct iovec iov[RECV_BATCH_SIZE][2];
+    struct mmsghdr msgs[RECV_BATCH_SIZE];
+    memset(msgs, 0, sizeof(msgs[0]) * capacity);
+    for (uint32_t i = 0; i < capacity; ++i)
+    {
+      iov[i][0].iov_base = &recv_batch_headers_[i];
+      iov[i][0].iov_len = sizeof(TransportUDPHeader);
+      iov[i][1].iov_base = &recv_batch_buffer_[i * max_datagram_size_];
+      iov[i][1].iov_len = max_datagram_size_ - sizeof(TransportUDPHeader);
+      msgs[i].msg_hdr.msg_iov = iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 2;
+    }
+
+    // MSG_WAITFORONE only blocks (on a SYNCHRONOUS socket) for the first datagram
+    int count = recvmmsg(sock_, msgs, capacity, MSG_WAITFORONE, NULL);
+    stats_.recv_syscalls.fetch_add(1, boost::memory_order_relaxed);
+    if (count <= 0)
+    {
+      return -1;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+      recv_batch_sizes_[i] = msgs[i].msg_len;
+    }
+    recv_batch_count_ = count;
+    recv_batch_next_ = 0;
+  }
+
+  uint32_t index = recv_batch_next_++;
+  header = recv_batch_headers_[index];
+  datagram_start_ = &recv_batch_buffer_[index * max_datagram_size_];
+  return recv_batch_sizes_[index];
+#else
+  return -1;
+#endif
+}
+
 int32_t TransportUDP::read(uint8_t* buffer, uint32_t size)
 {
   {
-    boost::mutex::scoped_lock lock(close_mutex_);
+    threading::mutex::scoped_lock lock(close_mutex_);
     if (closed_)
     {
       ROSCPP_LOG_DEBUG("Tried to read on a closed socket [%d]", sock_);
@@ -396,6 +470,9 @@ int32_t TransportUDP::read(uint8_t* buffer, uint32_t size)
 		} else {
 			num_bytes = received_bytes;
 		}
+#elif defined(HAVE_RECVMMSG)
+        // Takes the next datagram from a batch drained with one syscall
+        ssize_t num_bytes = receiveDatagram(header);
 #else
         ssize_t num_bytes;
         struct iovec iov[2];
@@ -405,6 +482,7 @@ int32_t TransportUDP::read(uint8_t* buffer, uint32_t size)
         iov[1].iov_len = max_datagram_size_ - sizeof(header);
         // Read a datagram with header
         num_bytes = readv(sock_, iov, 2);
+        stats_.recv_syscalls.fetch_add(1, boost::memory_order_relaxed);
 #endif
         if (num_bytes < 0)
         {
@@ -435,7 +513,8 @@ int32_t TransportUDP::read(uint8_t* buffer, uint32_t size)
 
 		num_bytes -= sizeof(header);
         data_filled_ = num_bytes;
-        data_start_ = data_buffer_;
+        data_start_ = datagram_start_;
+        stats_.datagrams_received.fetch_add(1, boost::memory_order_relaxed);
       }
       else
       {
@@ -470,15 +549,15 @@ int32_t TransportUDP::read(uint8_t* buffer, uint32_t size)
 
             // Copy the entire data buffer to the reorder buffer, as we will
             // need to replay this UDP datagram in the next call.
-            reorder_bytes_ = data_filled_ + (data_start_ - data_buffer_);
-            memcpy(reorder_buffer_, data_buffer_, reorder_bytes_);
+            reorder_bytes_ = data_filled_ + (data_start_ - datagram_start_);
+            memcpy(reorder_buffer_, datagram_start_, reorder_bytes_);
             reorder_start_ = reorder_buffer_;
             current_message_id_ = 0;
             total_blocks_ = 0;
             last_block_ = 0;
 
             data_filled_ = 0;
-            data_start_ = data_buffer_;
+            data_start_ = datagram_start_;
             return -1;
           }
           total_blocks_ = header.block_;
@@ -489,14 +568,16 @@ int32_t TransportUDP::read(uint8_t* buffer, uint32_t size)
           if (header.message_id_ != current_message_id_)
           {
             ROS_DEBUG("Message Id mismatch: %d != %d", header.message_id_, current_message_id_);
-            data_filled_ = 0; // discard datagram
-            return 0;
+            // discard datagram and go on to the next one.  Returning 0 here would look like the socket had been
+            // drained, which an edge-triggered poll set won't tell us about again.
+            data_filled_ = 0;
+            continue;
           }
           if (header.block_ != last_block_ + 1)
           {
             ROS_DEBUG("Expected block %d, received %d", last_block_ + 1, header.block_);
-            data_filled_ = 0; // discard datagram
-            return 0;
+            data_filled_ = 0; // discard datagram, as above
+            continue;
           }
           last_block_ = header.block_;
 
@@ -511,6 +592,7 @@ int32_t TransportUDP::read(uint8_t* buffer, uint32_t size)
       if (last_block_ == (total_blocks_ - 1))
       {
         current_message_id_ = 0;
+        stats_.messages_received.fetch_add(1, boost::memory_order_relaxed);
         break;
       }
     }
@@ -522,7 +604,7 @@ int32_t TransportUDP::read(uint8_t* buffer, uint32_t size)
 int32_t TransportUDP::write(uint8_t* buffer, uint32_t size)
 {
   {
-    boost::mutex::scoped_lock lock(close_mutex_);
+    threading::mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -533,12 +615,18 @@ int32_t TransportUDP::write(uint8_t* buffer, uint32_t size)
 
   ROS_ASSERT((int32_t)size > 0);
 
+#if defined(HAVE_SENDMMSG)
+  WriteBuffer message;
+  message.data = buffer;
+  message.size = size;
+  return sendMessages(&message, 1);
+#else
   const uint32_t max_payload_size = max_datagram_size_ - sizeof(TransportUDPHeader);
 
   uint32_t bytes_sent = 0;
-  uint32_t this_block = 0;
   if (++current_message_id_ == 0)
     ++current_message_id_;
+  uint32_t this_block = 0;
   while (bytes_sent < size)
   {
     TransportUDPHeader header;
@@ -576,8 +664,9 @@ int32_t TransportUDP::write(uint8_t* buffer, uint32_t size)
     iov[0].iov_len = sizeof(header);
     iov[1].iov_base = buffer + bytes_sent;
     iov[1].iov_len = std::min(max_payload_size, size - bytes_sent);
-    ssize_t num_bytes = writev(sock_, iov, 2);
+    ssize_t num_bytes = ::writev(sock_, iov, 2);
 #endif
+    stats_.send_syscalls.fetch_add(1, boost::memory_order_relaxed);
     //usleep(100);
     if (num_bytes < 0)
     {
@@ -589,7 +678,23 @@ int32_t TransportUDP::write(uint8_t* buffer, uint32_t size)
       }
       else
       {
+        // Nothing went out, so the same block goes again
+        --this_block;
         num_bytes = 0;
+
+        if (bytes_sent == 0)
+        {
+          // None of the message has been sent, so all of it can wait until the socket is writable again
+          break;
+        }
+
+        if (!waitWritable())
+        {
+          // The rest of the message can't be sent on its own later, so drop it
+          ROSCPP_LOG_DEBUG("Socket [%d] still full, dropping the rest of a message", sock_);
+          stats_.messages_dropped.fetch_add(1, boost::memory_order_relaxed);
+          return size;
+        }
       }
     }
     else if (num_bytes < (unsigned) sizeof(header))
@@ -601,17 +706,194 @@ int32_t TransportUDP::write(uint8_t* buffer, uint32_t size)
     else
     {
       num_bytes -= sizeof(header);
+      stats_.datagrams_sent.fetch_add(1, boost::memory_order_relaxed);
     }
     bytes_sent += num_bytes;
   }
 
+  if (bytes_sent == size)
+  {
+    stats_.messages_sent.fetch_add(1, boost::memory_order_relaxed);
+  }
+
+  return bytes_sent;
+#endif
+}
+
+int32_t TransportUDP::writev(const WriteBuffer* buffers, uint32_t count)
+{
+#if defined(HAVE_SENDMMSG)
+  {
+    threading::mutex::scoped_lock lock(close_mutex_);
+
+    if (closed_)
+    {
+      ROSCPP_LOG_DEBUG("Tried to write on a closed socket [%d]", sock_);
+      return -1;
+    }
+  }
+
+  return sendMessages(buffers, count);
+#else
+  return Transport::writev(buffers, count);
+#endif
+}
+
+bool TransportUDP::waitWritable()
+{
+  socket_pollfd pfd;
+  pfd.fd = sock_;
+  pfd.events = POLLOUT;
+  pfd.revents = 0;
+  return poll_sockets(&pfd, 1, SEND_WAIT_TIMEOUT_MS) > 0 && (pfd.revents & POLLOUT);
+}
+
+#if defined(HAVE_SENDMMSG)
+int32_t TransportUDP::sendMessages(const WriteBuffer* buffers, uint32_t count)
+{
+  const uint32_t max_payload_size = max_datagram_size_ - sizeof(TransportUDPHeader);
+
+  // Hand the kernel up to SEND_BATCH_SIZE fragments per syscall, from as many messages as they cover.  Every
+  // fragment of a message but the last is max_payload_size long, so a fragment's block number follows from its offset.
+  TransportUDPHeader headers[SEND_BATCH_SIZE];
+  struct iovec iov[SEND_BATCH_SIZE][2];
+  struct mmsghdr msgs[SEND_BATCH_SIZE];
+  // Where each fragment of the batch came from, to pick up from if only part of the batch is sent
+  uint32_t fragment_message[SEND_BATCH_SIZE];
+  uint32_t fragment_offset[SEND_BATCH_SIZE];
+
+  // The next fragment to send: its message, its offset within the message, and the message's id, or 0 if it hasn't
+  // been given one yet
+  uint32_t message = 0;
+  uint32_t offset = 0;
+  uint32_t message_id = 0;
+  uint32_t bytes_sent = 0;
+  while (message < count)
+  {
+    uint32_t batch = 0;
+    uint32_t next_message = message;
+    uint32_t next_offset = offset;
+    uint32_t next_id = message_id;
+    while (batch < SEND_BATCH_SIZE && next_message < count)
+    {
+      const WriteBuffer& buffer = buffers[next_message];
+      if (buffer.size == 0)
+      {
+        ++next_message;
+        continue;
+      }
+
+      TransportUDPHeader& header = headers[batch];
+      uint32_t this_block = next_offset / max_payload_size;
+      if (this_block == 0)
+      {
+        // A message keeps its id when its fragments are built again after the socket filled up
+        if (next_message != message || message_id == 0)
+        {
+          if (++current_message_id_ == 0)
+            ++current_message_id_;
+          next_id = current_message_id_;
+        }
+        header.op_ = ROS_UDP_DATA0;
+        header.block_ = (buffer.size + max_payload_size - 1) / max_payload_size;
+      }
+      else
+      {
+        header.op_ = ROS_UDP_DATAN;
+        header.block_ = this_block;
+      }
+      header.connection_id_ = connection_id_;
+      header.message_id_ = next_id;
+
+      iov[batch][0].iov_base = &header;
+      iov[batch][0].iov_len = sizeof(header);
+      iov[batch][1].iov_base = buffer.data + next_offset;
+      iov[batch][1].iov_len = std::min(max_payload_size, buffer.size - next_offset);
+      memset(&msgs[batch], 0, sizeof(msgs[batch]));
+      msgs[batch].msg_hdr.msg_iov = iov[batch];
+      msgs[batch].msg_hdr.msg_iovlen = 2;
+      fragment_message[batch] = next_message;
+      fragment_offset[batch] = next_offset;
+      ++batch;
+
+      next_offset += iov[batch - 1][1].iov_len;
+      if (next_offset == buffer.size)
+      {
+        ++next_message;
+        next_offset = 0;
+      }
+    }
+
+    if (batch == 0)
+    {
+      break;
+    }
+
+    int sent = sendmmsg(sock_, msgs, batch, 0);
+    stats_.send_syscalls.fetch_add(1, boost::memory_order_relaxed);
+    if (sent < 0)
+    {
+      if( !last_socket_error_is_would_block() ) // Actually EAGAIN or EWOULDBLOCK on posix
+      {
+        ROSCPP_LOG_DEBUG("sendmmsg() failed with error [%s]", last_socket_error_string());
+        close();
+        break;
+      }
+      sent = 0;
+    }
+
+    for (int i = 0; i < sent; ++i)
+    {
+      if (msgs[i].msg_len < sizeof(TransportUDPHeader))
+      {
+        ROSCPP_LOG_DEBUG("Socket [%d] short write (%d bytes), closing", sock_, int(msgs[i].msg_len));
+        close();
+        return bytes_sent;
+      }
+      bytes_sent += msgs[i].msg_len - sizeof(TransportUDPHeader);
+      stats_.datagrams_sent.fetch_add(1, boost::memory_order_relaxed);
+      if (fragment_offset[i] + iov[i][1].iov_len == buffers[fragment_message[i]].size)
+      {
+        stats_.messages_sent.fetch_add(1, boost::memory_order_relaxed);
+      }
+    }
+
+    if ((uint32_t)sent == batch)
+    {
+      message = next_message;
+      offset = next_offset;
+      message_id = next_offset ? next_id : 0;
+      continue;
+    }
+
+    message = fragment_message[sent];
+    offset = fragment_offset[sent];
+    message_id = headers[sent].message_id_;
+
+    // The socket is full.  Whole messages can wait until it is writable again, but the rest of one that has been partly
+    // sent can't follow later on its own.
+    if (offset == 0)
+    {
+      break;
+    }
+
+    if (!waitWritable())
+    {
+      ROSCPP_LOG_DEBUG("Socket [%d] still full, dropping the rest of a message", sock_);
+      stats_.messages_dropped.fetch_add(1, boost::memory_order_relaxed);
+      bytes_sent += buffers[message].size - offset;
+      break;
+    }
+  }
+
   return bytes_sent;
 }
+#endif
 
 void TransportUDP::enableRead()
 {
   {
-    boost::mutex::scoped_lock lock(close_mutex_);
+    threading::mutex::scoped_lock lock(close_mutex_);
   
     if (closed_)
     {
@@ -631,7 +913,7 @@ void TransportUDP::disableRead()
   ROS_ASSERT(!(flags_ & SYNCHRONOUS));
 
   {
-    boost::mutex::scoped_lock lock(close_mutex_);
+    threading::mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -649,7 +931,7 @@ void TransportUDP::disableRead()
 void TransportUDP::enableWrite()
 {
   {
-    boost::mutex::scoped_lock lock(close_mutex_);
+    threading::mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -667,7 +949,7 @@ void TransportUDP::enableWrite()
 void TransportUDP::disableWrite()
 {
   {
-    boost::mutex::scoped_lock lock(close_mutex_);
+    threading::mutex::scoped_lock lock(close_mutex_);
 
     if (closed_)
     {
@@ -217,8 +217,9 @@ void TransportPublisherLink::onRetryTimer(const ros::WallTimerEvent&)
 
       ROSCPP_LOG_DEBUG("Retrying connection to [%s:%d] for topic [%s]", host.c_str(), port, topic.c_str());
 
-      TransportTCPPtr transport(new TransportTCP(&PollManager::instance()->getPollSet()));
-      if (transport->connect(host, port))
+      TransportTCPPtr transport(new TransportTCP(ConnectionManager::instance()->getPollSet(topic)));
+      bool connected = old_transport->isUnix() ? transport->connectUnix(old_transport->getUnixPath()) : transport->connect(host, port);
+      if (connected)
       {
         ConnectionPtr connection(new Connection);
         connection->initialize(transport, false, HeaderReceivedFunc());
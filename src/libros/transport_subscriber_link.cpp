@@ -37,6 +37,9 @@
 #include "ros/file_log.h"
 
 #include <boost/bind.hpp>
+#include <boost/shared_array.hpp>
+
+#include <vector>
 
 namespace ros
 {
@@ -147,27 +150,45 @@ void TransportSubscriberLink::onMessageWritten(const ConnectionPtr& conn)
 
 void TransportSubscriberLink::startMessageWrite(bool immediate_write)
 {
-  boost::shared_array<uint8_t> dummy;
-  SerializedMessage m(dummy, (uint32_t)0);
+  // Messages taken off the outbox, handed to the connection together.  Local, so that nothing holds on to them once
+  // the connection is done with them.
+  std::vector<boost::shared_array<uint8_t> > write_buffers;
+  std::vector<uint32_t> write_sizes;
 
   {
-    boost::mutex::scoped_lock lock(outbox_mutex_);
+    threading::mutex::scoped_lock lock(outbox_mutex_);
     if (writing_message_ || !header_written_)
     {
       return;
     }
 
-    if (!outbox_.empty())
+    // Take everything queued up (to a limit), so that it can go out in one write
+    while (!outbox_.empty() && write_buffers.size() < Connection::MAX_WRITE_BUFFERS)
     {
-      writing_message_ = true;
-      m = outbox_.front();
+      const SerializedMessage& m = outbox_.front();
+      if (m.num_bytes > 0)
+      {
+        write_buffers.push_back(m.buf);
+        write_sizes.push_back(m.num_bytes);
+      }
       outbox_.pop();
     }
+
+    if (write_buffers.empty())
+    {
+      return;
+    }
+
+    writing_message_ = true;
   }
 
-  if (m.num_bytes > 0)
+  if (write_buffers.size() == 1)
+  {
+    connection_->write(write_buffers[0], write_sizes[0], boost::bind(&TransportSubscriberLink::onMessageWritten, this, _1), immediate_write);
+  }
+  else
   {
-    connection_->write(m.buf, m.num_bytes, boost::bind(&TransportSubscriberLink::onMessageWritten, this, _1), immediate_write);
+    connection_->write(write_buffers, write_sizes, boost::bind(&TransportSubscriberLink::onMessageWritten, this, _1), immediate_write);
   }
 }
 
@@ -179,7 +200,7 @@ void TransportSubscriberLink::enqueueMessage(const SerializedMessage& m, bool se
   }
 
   {
-    boost::mutex::scoped_lock lock(outbox_mutex_);
+    threading::mutex::scoped_lock lock(outbox_mutex_);
 
     int max_queue = 0;
     if (PublicationPtr parent = parent_.lock())
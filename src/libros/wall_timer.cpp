@@ -31,9 +31,28 @@
 namespace ros
 {
 
+namespace
+{
+
+TimerManager<WallTime, WallDuration, WallTimerEvent>& getManager(bool high_resolution)
+{
+  if (high_resolution)
+  {
+    return TimerManager<WallTime, WallDuration, WallTimerEvent>::highResolution();
+  }
+
+  return TimerManager<WallTime, WallDuration, WallTimerEvent>::global();
+}
+
+}
+
 WallTimer::Impl::Impl()
   : started_(false)
   , timer_handle_(-1)
+  , call_inline_(false)
+  , priority_(0)
+  , deadline_misses_(0)
+  , high_resolution_(false)
 { }
 
 WallTimer::Impl::~Impl()
@@ -51,7 +70,7 @@ void WallTimer::Impl::start()
     {
       tracked_object = tracked_object_.lock();
     }
-    timer_handle_ = TimerManager<WallTime, WallDuration, WallTimerEvent>::global().add(period_, callback_, callback_queue_, tracked_object, oneshot_);
+    timer_handle_ = getManager(high_resolution_).add(period_, callback_, callback_queue_, tracked_object, oneshot_, priority_, deadline_, call_inline_);
     started_ = true;
   }
 }
@@ -61,7 +80,9 @@ void WallTimer::Impl::stop()
   if (started_)
   {
     started_ = false;
-    TimerManager<WallTime, WallDuration, WallTimerEvent>::global().remove(timer_handle_);
+    deadline_misses_ += getManager(high_resolution_).getDeadlineMisses(timer_handle_);
+    statistics_.add(getManager(high_resolution_).getStatistics(timer_handle_));
+    getManager(high_resolution_).remove(timer_handle_);
     timer_handle_ = -1;
   }
 }
@@ -78,13 +99,34 @@ bool WallTimer::Impl::hasPending()
     return false;
   }
 
-  return TimerManager<WallTime, WallDuration, WallTimerEvent>::global().hasPending(timer_handle_);
+  return getManager(high_resolution_).hasPending(timer_handle_);
+}
+
+uint32_t WallTimer::Impl::getDeadlineMisses()
+{
+  if (timer_handle_ == -1)
+  {
+    return deadline_misses_;
+  }
+
+  return deadline_misses_ + getManager(high_resolution_).getDeadlineMisses(timer_handle_);
+}
+
+TimerStatistics WallTimer::Impl::getStatistics()
+{
+  TimerStatistics statistics = statistics_;
+  if (timer_handle_ != -1)
+  {
+    statistics.add(getManager(high_resolution_).getStatistics(timer_handle_));
+  }
+
+  return statistics;
 }
 
 void WallTimer::Impl::setPeriod(const WallDuration& period, bool reset)
 {
   period_ = period;
-  TimerManager<WallTime, WallDuration, WallTimerEvent>::global().setPeriod(timer_handle_, period, reset);
+  getManager(high_resolution_).setPeriod(timer_handle_, period, reset);
 }
 
 
@@ -97,6 +139,10 @@ WallTimer::WallTimer(const WallTimerOptions& ops)
   impl_->tracked_object_ = ops.tracked_object;
   impl_->has_tracked_object_ = (ops.tracked_object != NULL);
   impl_->oneshot_ = ops.oneshot;
+  impl_->call_inline_ = ops.call_inline;
+  impl_->priority_ = ops.priority;
+  impl_->deadline_ = ops.deadline;
+  impl_->high_resolution_ = ops.high_resolution;
 }
 
 WallTimer::WallTimer(const WallTimer& rhs)
@@ -134,6 +180,26 @@ bool WallTimer::hasPending()
   return false;
 }
 
+uint32_t WallTimer::getDeadlineMisses()
+{
+  if (impl_)
+  {
+    return impl_->getDeadlineMisses();
+  }
+
+  return 0;
+}
+
+TimerStatistics WallTimer::getStatistics()
+{
+  if (impl_)
+  {
+    return impl_->getStatistics();
+  }
+
+  return TimerStatistics();
+}
+
 void WallTimer::setPeriod(const WallDuration& period, bool reset)
 {
   if (impl_)
@@ -0,0 +1,464 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ros/work_stealing_callback_queue.h"
+#include "ros/assert.h"
+
+namespace ros
+{
+
+namespace
+{
+
+/**
+ * \brief Holds a count up for as long as it is in scope
+ */
+class ScopedCount
+{
+public:
+  ScopedCount(boost::atomic<size_t>& count)
+  : count_(count)
+  {
+    count_.fetch_add(1);
+  }
+
+  ~ScopedCount()
+  {
+    count_.fetch_sub(1);
+  }
+
+private:
+  boost::atomic<size_t>& count_;
+};
+
+/**
+ * \brief Removal IDs are usually pointers, so mix the bits up before using them to pick a local queue
+ */
+inline uint64_t hashID(uint64_t id)
+{
+  id ^= id >> 33;
+  id *= 0xff51afd7ed558ccdULL;
+  id ^= id >> 33;
+  return id;
+}
+
+}
+
+WorkStealingCallbackQueue::WorkStealingCallbackQueue(uint32_t worker_count, bool affinity, bool enabled)
+: CallbackQueue(enabled)
+, affinity_(affinity)
+, is_enabled_(enabled)
+, count_(0)
+, calling_count_(0)
+, stolen_(0)
+, next_worker_(0)
+, next_round_robin_(0)
+, waiters_(0)
+{
+  if (worker_count == 0)
+  {
+    worker_count = 1;
+  }
+
+  for (uint32_t i = 0; i < worker_count; ++i)
+  {
+    workers_.push_back(WorkerPtr(new Worker));
+  }
+}
+
+WorkStealingCallbackQueue::~WorkStealingCallbackQueue()
+{
+  disable();
+}
+
+void WorkStealingCallbackQueue::enable()
+{
+  is_enabled_.store(true);
+
+  threading::mutex::scoped_lock lock(mutex_);
+  condition_.notify_all();
+}
+
+void WorkStealingCallbackQueue::disable()
+{
+  is_enabled_.store(false);
+
+  threading::mutex::scoped_lock lock(mutex_);
+  condition_.notify_all();
+}
+
+bool WorkStealingCallbackQueue::isEnabled()
+{
+  return is_enabled_.load();
+}
+
+void WorkStealingCallbackQueue::clear()
+{
+  for (size_t i = 0; i < workers_.size(); ++i)
+  {
+    Worker& worker = *workers_[i];
+    threading::mutex::scoped_lock lock(worker.mutex);
+    count_.fetch_sub(worker.callbacks.size());
+    worker.callbacks.clear();
+  }
+}
+
+bool WorkStealingCallbackQueue::isEmpty()
+{
+  return count_.load() == 0 && calling_count_.load() == 0;
+}
+
+uint32_t WorkStealingCallbackQueue::getWorkerIndex()
+{
+  uint32_t* index = worker_index_.get();
+  if (!index)
+  {
+    index = new uint32_t(next_worker_.fetch_add(1) % workers_.size());
+    worker_index_.reset(index);
+  }
+
+  return *index;
+}
+
+uint32_t WorkStealingCallbackQueue::pickWorker(uint64_t removal_id)
+{
+  if (affinity_ && removal_id != 0)
+  {
+    return hashID(removal_id) % workers_.size();
+  }
+
+  return next_round_robin_.fetch_add(1) % workers_.size();
+}
+
+void WorkStealingCallbackQueue::push(uint32_t index, const CallbackInfo& info)
+{
+  {
+    Worker& worker = *workers_[index];
+    threading::mutex::scoped_lock lock(worker.mutex);
+    worker.callbacks.push_back(info);
+    count_.fetch_add(1);
+  }
+
+  // Pairs with the increment of waiters_ in wait(): either the waiter sees the new callback, or we see the waiter
+  boost::atomic_thread_fence(boost::memory_order_seq_cst);
+  if (waiters_.load() > 0)
+  {
+    // Taking the lock makes sure a waiter which has checked count_ is already waiting on the condition
+    {
+      threading::mutex::scoped_lock lock(mutex_);
+    }
+    condition_.notify_one();
+  }
+}
+
+bool WorkStealingCallbackQueue::pop(uint32_t index, CallbackInfo& info, uint32_t& from)
+{
+  if (count_.load() == 0)
+  {
+    return false;
+  }
+
+  {
+    Worker& worker = *workers_[index];
+    threading::mutex::scoped_lock lock(worker.mutex);
+    if (!worker.callbacks.empty())
+    {
+      info = worker.callbacks.front();
+      worker.callbacks.pop_front();
+      count_.fetch_sub(1);
+      from = index;
+      return true;
+    }
+  }
+
+  // Nothing of our own to do, steal from the back of someone else's queue
+  for (size_t i = 1; i < workers_.size(); ++i)
+  {
+    uint32_t victim = (index + i) % workers_.size();
+    Worker& worker = *workers_[victim];
+    threading::mutex::scoped_lock lock(worker.mutex);
+    if (!worker.callbacks.empty())
+    {
+      info = worker.callbacks.back();
+      worker.callbacks.pop_back();
+      count_.fetch_sub(1);
+      stolen_.fetch_add(1);
+      from = victim;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void WorkStealingCallbackQueue::addCallback(const CallbackInterfacePtr& callback, uint64_t removal_id)
+{
+  if (!is_enabled_.load())
+  {
+    return;
+  }
+
+  CallbackInfo info;
+  info.callback = callback;
+  info.removal_id = removal_id;
+
+  {
+    threading::mutex::scoped_lock lock(id_info_mutex_);
+
+    M_IDInfo::iterator it = id_info_.find(removal_id);
+    if (it == id_info_.end())
+    {
+      IDInfoPtr id_info(new IDInfo);
+      id_info->id = removal_id;
+      id_info_.insert(std::make_pair(removal_id, id_info));
+    }
+  }
+
+  push(pickWorker(removal_id), info);
+}
+
+void WorkStealingCallbackQueue::removeByID(uint64_t removal_id)
+{
+  setupTLS();
+
+  IDInfoPtr id_info;
+  {
+    threading::mutex::scoped_lock lock(id_info_mutex_);
+    M_IDInfo::iterator it = id_info_.find(removal_id);
+    if (it != id_info_.end())
+    {
+      id_info = it->second;
+    }
+    else
+    {
+      return;
+    }
+  }
+
+  // If we're being called from within a callback from our queue, we must unlock the shared lock we already own
+  // here so that we can take a unique lock.  We'll re-lock it later.
+  if (tls_->calling_in_this_thread == id_info->id)
+  {
+    id_info->calling_rw_mutex.unlock_shared();
+  }
+
+  {
+    boost::unique_lock<threading::shared_mutex> rw_lock(id_info->calling_rw_mutex);
+    for (size_t i = 0; i < workers_.size(); ++i)
+    {
+      Worker& worker = *workers_[i];
+      threading::mutex::scoped_lock lock(worker.mutex);
+      D_CallbackInfo::iterator it = worker.callbacks.begin();
+      while (it != worker.callbacks.end())
+      {
+        if (it->removal_id == removal_id)
+        {
+          it = worker.callbacks.erase(it);
+          count_.fetch_sub(1);
+        }
+        else
+        {
+          ++it;
+        }
+      }
+    }
+  }
+
+  if (tls_->calling_in_this_thread == id_info->id)
+  {
+    id_info->calling_rw_mutex.lock_shared();
+  }
+
+  {
+    threading::mutex::scoped_lock lock(id_info_mutex_);
+    id_info_.erase(removal_id);
+  }
+}
+
+WorkStealingCallbackQueue::CallOneResult WorkStealingCallbackQueue::call(const CallbackInfo& info, uint32_t from)
+{
+  IDInfoPtr id_info = getIDInfo(info.removal_id);
+  if (!id_info)
+  {
+    // Removed since it was popped
+    return Empty;
+  }
+
+  setupTLS();
+  TLS* tls = tls_.get();
+
+  boost::shared_lock<threading::shared_mutex> rw_lock(id_info->calling_rw_mutex);
+
+  uint64_t last_calling = tls->calling_in_this_thread;
+  tls->calling_in_this_thread = id_info->id;
+
+  CallbackInterface::CallResult result = CallbackInterface::Invalid;
+  try
+  {
+    result = info.callback->call();
+  }
+  catch (std::exception&)
+  {
+    // ensure that thread id gets restored, even in case of an exception
+    tls->calling_in_this_thread = last_calling;
+    throw;
+  }
+
+  tls->calling_in_this_thread = last_calling;
+
+  // Put TryAgain callbacks back where they came from.  This happens under the shared lock, so that a concurrent
+  // removeByID() will see it.
+  if (result == CallbackInterface::TryAgain)
+  {
+    push(from, info);
+    return TryAgain;
+  }
+
+  return Called;
+}
+
+WorkStealingCallbackQueue::CallOneResult WorkStealingCallbackQueue::callOne(ros::WallDuration timeout)
+{
+  if (!is_enabled_.load())
+  {
+    return Disabled;
+  }
+
+  uint32_t index = getWorkerIndex();
+
+  if (count_.load() == 0)
+  {
+    if (!timeout.isZero())
+    {
+      wait(timeout);
+    }
+
+    if (!is_enabled_.load())
+    {
+      return Disabled;
+    }
+  }
+
+  // Look for a callback which is ready, putting back the ones which aren't.  Only go around the queues once.
+  size_t attempts = count_.load();
+  bool tried_any = false;
+  while (attempts-- > 0)
+  {
+    // Counted from before the pop, so that isEmpty() never misses a callback in between
+    ScopedCount calling(calling_count_);
+
+    CallbackInfo info;
+    uint32_t from = index;
+    if (!pop(index, info, from))
+    {
+      break;
+    }
+
+    if (!info.callback->ready())
+    {
+      tried_any = true;
+      push(from, info);
+      continue;
+    }
+
+    CallOneResult result = call(info, from);
+    if (result != Empty)
+    {
+      return result;
+    }
+  }
+
+  return tried_any ? TryAgain : Empty;
+}
+
+void WorkStealingCallbackQueue::callAvailable(ros::WallDuration timeout)
+{
+  if (!is_enabled_.load())
+  {
+    return;
+  }
+
+  uint32_t index = getWorkerIndex();
+
+  if (count_.load() == 0)
+  {
+    if (!timeout.isZero())
+    {
+      wait(timeout);
+    }
+
+    if (!is_enabled_.load())
+    {
+      return;
+    }
+  }
+
+  // Call at most as many callbacks as were queued on entry, so that callbacks which keep re-adding themselves can't
+  // keep us here forever
+  size_t available = count_.load();
+  while (available-- > 0 && is_enabled_.load())
+  {
+    ScopedCount calling(calling_count_);
+
+    CallbackInfo info;
+    uint32_t from = index;
+    if (!pop(index, info, from))
+    {
+      break;
+    }
+
+    if (!info.callback->ready())
+    {
+      push(from, info);
+      continue;
+    }
+
+    call(info, from);
+  }
+}
+
+void WorkStealingCallbackQueue::wait(ros::WallDuration timeout)
+{
+  threading::mutex::scoped_lock lock(mutex_);
+  waiters_.fetch_add(1);
+
+  if (count_.load() == 0 && is_enabled_.load())
+  {
+    condition_.timed_wait(lock, boost::posix_time::microseconds((int64_t)(timeout.toSec() * 1000000.0)));
+  }
+
+  waiters_.fetch_sub(1);
+}
+
+}
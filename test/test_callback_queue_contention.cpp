@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Contention benchmark for the callback queues: N threads add callbacks while N spinner threads call them, for N from
+ * 1 to 32, through CallbackQueue and LockFreeCallbackQueue.  Prints the throughput of each, and checks that every
+ * callback is called exactly once.
+ */
+
+#include <gtest/gtest.h>
+
+#include "ros/callback_queue.h"
+#include "ros/lockfree_callback_queue.h"
+#include "ros/threading.h"
+#include "ros/time.h"
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+
+#include <cstdio>
+
+using namespace ros;
+
+namespace
+{
+
+/// Callbacks added in each run, split between the producer threads
+const uint32_t CALLBACKS_PER_RUN = 200000;
+const uint32_t MAX_THREADS = 32;
+
+class CountingCallback : public CallbackInterface
+{
+public:
+  CountingCallback(boost::atomic<uint32_t>& calls)
+  : calls_(calls)
+  {}
+
+  virtual CallResult call()
+  {
+    calls_.fetch_add(1, boost::memory_order_relaxed);
+    return Success;
+  }
+
+private:
+  boost::atomic<uint32_t>& calls_;
+};
+
+struct Counts
+{
+  Counts() : added(0), calls(0) {}
+
+  boost::atomic<uint32_t> added;
+  boost::atomic<uint32_t> calls;
+};
+
+void produce(CallbackQueue* queue, uint32_t index, uint32_t count, Counts* counts)
+{
+  CallbackInterfacePtr cb(new CountingCallback(counts->calls));
+  // Each producer uses its own removal ID, as subscriptions on different topics would
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    queue->addCallback(cb, index + 1);
+  }
+  counts->added.fetch_add(count);
+}
+
+void spin(CallbackQueue* queue, uint32_t total, Counts* counts)
+{
+  while (counts->calls.load(boost::memory_order_relaxed) < total)
+  {
+    // Stop rather than wait forever if callbacks have gone missing
+    if (queue->callOne(WallDuration(0.01)) == CallbackQueue::Empty && counts->added.load() == total && queue->isEmpty())
+    {
+      break;
+    }
+  }
+}
+
+/**
+ * \brief Run threads producers against threads spinners, returning the callbacks called per second
+ */
+double run(CallbackQueue& queue, uint32_t threads, uint32_t& calls_made)
+{
+  uint32_t per_thread = CALLBACKS_PER_RUN / threads;
+  uint32_t total = per_thread * threads;
+  Counts counts;
+
+  WallTime start = WallTime::now();
+  {
+    threading::thread_group group;
+    for (uint32_t i = 0; i < threads; ++i)
+    {
+      group.create_thread(boost::bind(spin, &queue, total, &counts));
+    }
+    for (uint32_t i = 0; i < threads; ++i)
+    {
+      group.create_thread(boost::bind(produce, &queue, i, per_thread, &counts));
+    }
+    group.join_all();
+  }
+  WallDuration elapsed = WallTime::now() - start;
+
+  calls_made = counts.calls.load();
+  EXPECT_EQ(total, calls_made);
+  EXPECT_TRUE(queue.isEmpty());
+  return calls_made / elapsed.toSec();
+}
+
+}
+
+TEST(CallbackQueueContention, compare)
+{
+  printf("%8s %18s %18s\n", "threads", "CallbackQueue/s", "LockFree/s");
+  for (uint32_t threads = 1; threads <= MAX_THREADS; threads *= 2)
+  {
+    uint32_t locked_calls = 0;
+    uint32_t lockfree_calls = 0;
+
+    CallbackQueue locked;
+    double locked_rate = run(locked, threads, locked_calls);
+
+    LockFreeCallbackQueue lockfree;
+    double lockfree_rate = run(lockfree, threads, lockfree_calls);
+
+    printf("%8u %18.0f %18.0f\n", threads, locked_rate, lockfree_rate);
+  }
+}
+
+TEST(CallbackQueueContention, removeByIDUnderLoad)
+{
+  // Once removeByID() returns, nothing added with the ID before it may be called
+  LockFreeCallbackQueue queue;
+  Counts counts;
+  CallbackInterfacePtr cb(new CountingCallback(counts.calls));
+
+  for (uint32_t i = 0; i < 1000; ++i)
+  {
+    queue.addCallback(cb, 1);
+  }
+  counts.added.store(1000);
+
+  threading::thread spinner(boost::bind(spin, &queue, 1000u, &counts));
+  queue.removeByID(1);
+  uint32_t after_remove = counts.calls.load();
+  spinner.join();
+  EXPECT_EQ(after_remove, counts.calls.load());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Benchmark for intraprocess publishing: times Publication::publish() handing a message to 1 to 32 intraprocess
+ * subscribers, from 1 and 4 publishing threads, and checks that every link's statistics counted every message.
+ * Publishes straight through the Publication, so no master is needed.
+ */
+
+#include <gtest/gtest.h>
+
+#include "ros/publication.h"
+#include "ros/subscription.h"
+#include "ros/subscription_callback_helper.h"
+#include "ros/callback_queue.h"
+#include "ros/serialized_message.h"
+#include "ros/threading.h"
+#include "ros/time.h"
+#include "std_msgs/String.h"
+
+#include <boost/bind.hpp>
+
+#include <cstdio>
+#include <typeinfo>
+#include <vector>
+
+using namespace ros;
+
+namespace
+{
+
+/// Messages published by each thread in each run
+const uint32_t MESSAGES_PER_THREAD = 20000;
+const uint32_t MAX_SUBSCRIBERS = 32;
+const uint32_t MAX_THREADS = 4;
+
+void messageCallback(const std_msgs::StringConstPtr&)
+{
+}
+
+void publishMessages(Publication* pub, const std_msgs::StringConstPtr& msg, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    SerializedMessage m;
+    m.message = msg;
+    m.type_info = &typeid(std_msgs::String);
+    pub->publish(m);
+  }
+}
+
+/**
+ * \brief Publish from threads threads to subscribers intraprocess subscriptions, returning the time per publish() call
+ */
+WallDuration run(uint32_t subscribers, uint32_t threads)
+{
+  PublicationPtr pub(new Publication("/benchmark", "std_msgs/String", "*", "", 1, false, false));
+  CallbackQueue queue;
+  SubscriptionCallbackHelperPtr helper(new SubscriptionCallbackHelperT<const std_msgs::StringConstPtr&>(messageCallback));
+
+  std::vector<SubscriptionPtr> subs;
+  for (uint32_t i = 0; i < subscribers; ++i)
+  {
+    // Nothing spins the queue, so each subscription keeps just the latest message, and counts the rest as drops
+    SubscriptionPtr sub(new Subscription("/benchmark", "*", "std_msgs/String", TransportHints()));
+    sub->addCallback(helper, "*", &queue, 1, VoidConstPtr(), false, 0, WallDuration(), false, 0, WallDuration());
+    sub->addLocalConnection(pub);
+    subs.push_back(sub);
+  }
+
+  std_msgs::StringPtr msg(new std_msgs::String);
+  msg->data = "benchmark";
+
+  WallTime start = WallTime::now();
+  {
+    threading::thread_group group;
+    for (uint32_t i = 0; i < threads; ++i)
+    {
+      group.create_thread(boost::bind(publishMessages, pub.get(), msg, MESSAGES_PER_THREAD));
+    }
+    group.join_all();
+  }
+  WallDuration elapsed = WallTime::now() - start;
+
+  // [topic, [[connection_id, bytes_received, messages_received, drops, connected]]]
+  for (uint32_t i = 0; i < subscribers; ++i)
+  {
+    XmlRpc::XmlRpcValue stats = subs[i]->getStats();
+    EXPECT_EQ((int)(MESSAGES_PER_THREAD * threads), (int)stats[1][0][2]) << "subscriber " << i << " lost count";
+    subs[i]->shutdown();
+  }
+  pub->drop();
+
+  return WallDuration(elapsed.toSec() / (MESSAGES_PER_THREAD * threads));
+}
+
+}
+
+TEST(IntraprocessPublish, benchmark)
+{
+  printf("%12s %8s %16s %20s\n", "subscribers", "threads", "ns/publish", "ns/subscriber");
+  for (uint32_t threads = 1; threads <= MAX_THREADS; threads *= 4)
+  {
+    for (uint32_t subscribers = 1; subscribers <= MAX_SUBSCRIBERS; subscribers *= 2)
+    {
+      WallDuration per_publish = run(subscribers, threads);
+      printf("%12u %8u %16.0f %20.0f\n", subscribers, threads, per_publish.toSec() * 1e9,
+             per_publish.toSec() * 1e9 / subscribers);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * RealtimePublisher::publish() must not allocate once the publisher is set up.  Every operator new is counted while
+ * the test thread is inside publish(), through the normal, ring full and oversize paths, and any allocation fails the
+ * test.  Also checks that shutdown() leaves a caller's advertisement alone.
+ */
+
+#include <gtest/gtest.h>
+
+#include "ros/ros.h"
+#include "ros/realtime_publisher.h"
+#include "std_msgs/String.h"
+
+#include <boost/atomic.hpp>
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+/// Set while the test thread is inside RealtimePublisher::publish().  Other threads' allocations are not counted.
+__thread bool g_counting = false;
+boost::atomic<uint32_t> g_allocations(0);
+
+void* countedAlloc(size_t size)
+{
+  if (g_counting)
+  {
+    ++g_allocations;
+  }
+
+  void* p = malloc(size ? size : 1);
+  if (!p)
+  {
+    throw std::bad_alloc();
+  }
+
+  return p;
+}
+
+}
+
+void* operator new(size_t size)
+{
+  return countedAlloc(size);
+}
+
+void* operator new[](size_t size)
+{
+  return countedAlloc(size);
+}
+
+void operator delete(void* p) throw()
+{
+  free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+  free(p);
+}
+
+namespace
+{
+
+boost::atomic<uint32_t> g_received(0);
+
+void messageCallback(const std_msgs::StringConstPtr&)
+{
+  ++g_received;
+}
+
+bool countedPublish(ros::RealtimePublisher<std_msgs::String>& pub, const std_msgs::String& msg)
+{
+  g_counting = true;
+  bool published = pub.publish(msg);
+  g_counting = false;
+  return published;
+}
+
+void spinUntil(const boost::atomic<uint32_t>& value, uint32_t target, const ros::WallDuration& timeout)
+{
+  ros::WallTime end = ros::WallTime::now() + timeout;
+  while (value.load() < target && ros::WallTime::now() < end)
+  {
+    ros::spinOnce();
+    ros::WallDuration(0.001).sleep();
+  }
+}
+
+}
+
+TEST(RealtimePublisher, publishDoesNotAllocate)
+{
+  ros::NodeHandle nh;
+  ros::Subscriber sub = nh.subscribe("rt_chatter", 1000, messageCallback);
+  ros::RealtimePublisher<std_msgs::String> pub(nh, "rt_chatter", 1000, 16, 256);
+
+  ros::WallTime end = ros::WallTime::now() + ros::WallDuration(10.0);
+  while (pub.getPublisher().getNumSubscribers() == 0 && ros::WallTime::now() < end)
+  {
+    ros::WallDuration(0.01).sleep();
+  }
+  ASSERT_LT(0U, pub.getPublisher().getNumSubscribers());
+
+  std_msgs::String msg;
+  msg.data = "real-time";
+  std_msgs::String oversize;
+  oversize.data.assign(1024, 'x');
+
+  g_allocations = 0;
+
+  // Steady state, with the publish thread keeping up
+  uint32_t published = 0;
+  for (uint32_t i = 0; i < 500; ++i)
+  {
+    if (countedPublish(pub, msg))
+    {
+      ++published;
+    }
+    ros::WallDuration(0.0002).sleep();
+  }
+
+  // Faster than the publish thread can keep up, so the ring fills
+  for (uint32_t i = 0; i < 200; ++i)
+  {
+    countedPublish(pub, msg);
+  }
+
+  EXPECT_FALSE(countedPublish(pub, oversize));
+
+  EXPECT_EQ(0U, g_allocations.load()) << "RealtimePublisher::publish() allocated";
+
+  ros::RealtimePublisherBase::Stats stats = pub.getStats();
+  EXPECT_EQ(1U, stats.dropped_oversize);
+  EXPECT_LT(0U, stats.published);
+
+  spinUntil(g_received, published, ros::WallDuration(10.0));
+  EXPECT_LE(published, g_received.load());
+}
+
+TEST(RealtimePublisher, shutdownKeepsCallersAdvertisement)
+{
+  ros::NodeHandle nh;
+  ros::Publisher shared = nh.advertise<std_msgs::String>("rt_shared", 10);
+
+  std_msgs::String msg;
+  msg.data = "shared";
+  {
+    ros::RealtimePublisher<std_msgs::String> pub(shared, 4, 64);
+    EXPECT_TRUE(pub.publish(msg));
+    pub.shutdown();
+  }
+  EXPECT_TRUE(shared);
+
+  ros::RealtimePublisher<std_msgs::String> owned(nh, "rt_owned", 10, 4, 64);
+  ros::Publisher copy = owned.getPublisher();
+  ASSERT_TRUE(copy);
+  owned.shutdown();
+  EXPECT_FALSE(copy);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_realtime_publisher");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests for batched delivery in SubscriptionQueue: a batch that doesn't fill up is delivered once max_latency has
+ * passed, including a batch started from inside the previous batch's callback, while the previous max_latency timer
+ * is still being called.
+ */
+
+#include <gtest/gtest.h>
+
+#include "ros/subscription_queue.h"
+#include "ros/subscription_callback_helper.h"
+#include "ros/message_deserializer.h"
+#include "ros/callback_queue.h"
+#include "ros/internal_timer_manager.h"
+#include "ros/serialization.h"
+#include "std_msgs/String.h"
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+using namespace ros;
+
+namespace ros
+{
+CallbackQueuePtr getInternalCallbackQueue();
+}
+
+namespace
+{
+
+/// Calls callbacks as soon as they are added, so a batch is called from inside the max_latency timer's callback
+class InlineQueue : public CallbackQueueInterface
+{
+public:
+  virtual void addCallback(const CallbackInterfacePtr& callback, uint64_t owner_id = 0)
+  {
+    callback->call();
+  }
+
+  virtual void removeByID(uint64_t owner_id)
+  {
+  }
+};
+
+boost::atomic<bool> g_stop(false);
+
+void spinInternalQueue()
+{
+  while (!g_stop)
+  {
+    getInternalCallbackQueue()->callAvailable(WallDuration(0.01));
+  }
+}
+
+struct Batches
+{
+  Batches()
+  : messages(0)
+  , rearm(false)
+  {}
+
+  void callback(const std_msgs::StringConstPtr&)
+  {
+    if (++messages == 1 && rearm)
+    {
+      // Starts a new batch before the timer manager has finished with the timer that delivered this one
+      push();
+    }
+  }
+
+  void push()
+  {
+    queue->push(helper, deserializer, false, VoidConstWPtr(), false, ros::Time(), 0, 0, 0, 0);
+  }
+
+  bool waitFor(uint32_t count, const WallDuration& timeout)
+  {
+    WallTime end = WallTime::now() + timeout;
+    while (messages < count && WallTime::now() < end)
+    {
+      WallDuration(0.001).sleep();
+    }
+
+    return messages >= count;
+  }
+
+  boost::atomic<uint32_t> messages;
+  bool rearm;
+  boost::shared_ptr<SubscriptionQueue> queue;
+  SubscriptionCallbackHelperPtr helper;
+  MessageDeserializerPtr deserializer;
+};
+
+class SubscriptionQueueBatching : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    initInternalTimerManager();
+    g_stop = false;
+    spinner_ = boost::thread(spinInternalQueue);
+
+    batches_.queue.reset(new SubscriptionQueue("batched", 100, false, 0, WallDuration(), false, 10, WallDuration(0.01)));
+    batches_.queue->setBatchCallbackQueue(&inline_queue_, 1);
+    batches_.helper.reset(new SubscriptionCallbackHelperT<const std_msgs::StringConstPtr&>(
+                            boost::bind(&Batches::callback, &batches_, _1)));
+
+    std_msgs::String msg;
+    msg.data = "batched";
+    batches_.deserializer.reset(new MessageDeserializer(batches_.helper, serialization::serializeMessage(msg),
+                                                        boost::shared_ptr<M_string>()));
+  }
+
+  virtual void TearDown()
+  {
+    g_stop = true;
+    spinner_.join();
+    batches_.queue.reset();
+  }
+
+  InlineQueue inline_queue_;
+  Batches batches_;
+  boost::thread spinner_;
+};
+
+} // namespace
+
+TEST_F(SubscriptionQueueBatching, deliversAfterMaxLatency)
+{
+  batches_.push();
+  EXPECT_EQ(0U, batches_.messages);
+
+  EXPECT_TRUE(batches_.waitFor(1, WallDuration(2.0)));
+
+  // A second batch gets a timer of its own
+  batches_.push();
+  EXPECT_TRUE(batches_.waitFor(2, WallDuration(2.0)));
+}
+
+TEST_F(SubscriptionQueueBatching, rearmFromBatchCallback)
+{
+  batches_.rearm = true;
+  batches_.push();
+
+  EXPECT_TRUE(batches_.waitFor(2, WallDuration(2.0))) << "the batch started inside the callback was never delivered";
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2009, Willow Garage, Inc.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the names of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived from
+ *     this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tests for the TimerManager waiting heap: timers fire in order of their expected time, removed timers stop firing,
+ * including inline timers stopped by another inline timer, and setPeriod() moves a timer to its new place in the
+ * heap.  The benchmark case times add(), setPeriod() and remove() with 10k and 100k timers.
+ */
+
+#include <gtest/gtest.h>
+
+#include "ros/timer_manager.h"
+#include "ros/callback_queue.h"
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+using namespace ros;
+
+namespace
+{
+
+typedef TimerManager<WallTime, WallDuration, WallTimerEvent> WallTimerManager;
+
+struct Fired
+{
+  Fired(uint32_t index, const WallTime& expected)
+  : index(index)
+  , expected(expected)
+  {}
+
+  bool operator<(const Fired& rhs) const
+  {
+    if (expected == rhs.expected)
+    {
+      return index < rhs.index;
+    }
+
+    return expected < rhs.expected;
+  }
+
+  uint32_t index;
+  WallTime expected;
+};
+
+/// Only called from the thread spinning the queue, so needs no locking
+struct Recorder
+{
+  Recorder(uint32_t num_timers)
+  : counts(num_timers, 0)
+  {}
+
+  void callback(uint32_t index, const WallTimerEvent& event)
+  {
+    ++counts[index];
+    fired.push_back(Fired(index, event.current_expected));
+  }
+
+  void clear()
+  {
+    std::fill(counts.begin(), counts.end(), 0);
+    fired.clear();
+  }
+
+  std::vector<uint32_t> counts;
+  std::vector<Fired> fired;
+};
+
+void spinFor(CallbackQueue& queue, const WallDuration& duration)
+{
+  WallTime end = WallTime::now() + duration;
+  while (WallTime::now() < end)
+  {
+    queue.callAvailable(WallDuration(0.01));
+  }
+}
+
+std::vector<int32_t> addTimers(WallTimerManager& manager, CallbackQueue& queue, Recorder& recorder,
+                               const std::vector<WallDuration>& periods, bool oneshot)
+{
+  std::vector<int32_t> handles;
+  for (uint32_t i = 0; i < periods.size(); ++i)
+  {
+    handles.push_back(manager.add(periods[i], boost::bind(&Recorder::callback, &recorder, i, _1), &queue,
+                                  VoidConstPtr(), oneshot));
+  }
+
+  return handles;
+}
+
+/// Inline timers which stop each other.  Only called from the timer thread.
+struct Stopper
+{
+  Stopper()
+  : calls(0)
+  {}
+
+  void stopAll(const WallTimerEvent&)
+  {
+    ++calls;
+    for (size_t i = 0; i < handles.size(); ++i)
+    {
+      manager->remove(handles[i]);
+    }
+  }
+
+  void block(const WallTimerEvent&)
+  {
+    WallDuration(0.05).sleep();
+  }
+
+  WallTimerManager* manager;
+  std::vector<int32_t> handles;
+  uint32_t calls;
+};
+
+} // namespace
+
+TEST(TimerManager, firesInExpectedOrder)
+{
+  const uint32_t count = 200;
+  WallTimerManager manager;
+  CallbackQueue queue;
+  Recorder recorder(count);
+
+  // Periods from 0.5ms to 100ms, added out of order
+  std::vector<WallDuration> periods;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    periods.push_back(WallDuration((((i * 73) % count) + 1) * 0.0005));
+  }
+
+  std::vector<int32_t> handles = addTimers(manager, queue, recorder, periods, true);
+
+  // Let every timer expire before calling any of them, so the queue holds them in the order the timer thread took
+  // them off the heap
+  WallDuration(0.3).sleep();
+  queue.callAvailable();
+
+  ASSERT_EQ(count, recorder.fired.size());
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    EXPECT_EQ(1U, recorder.counts[i]);
+  }
+
+  for (uint32_t i = 1; i < count; ++i)
+  {
+    EXPECT_FALSE(recorder.fired[i] < recorder.fired[i - 1]) << "timer " << recorder.fired[i].index << " fired after "
+                                                             << recorder.fired[i - 1].index;
+  }
+
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    manager.remove(handles[i]);
+  }
+}
+
+TEST(TimerManager, removedTimersStopFiring)
+{
+  const uint32_t count = 1000;
+  WallTimerManager manager;
+  CallbackQueue queue;
+  Recorder recorder(count);
+
+  std::vector<WallDuration> periods(count, WallDuration(0.005));
+  std::vector<int32_t> handles = addTimers(manager, queue, recorder, periods, false);
+
+  spinFor(queue, WallDuration(0.05));
+
+  // Remove every other timer, including ones whose callbacks are already in the queue
+  for (uint32_t i = 0; i < count; i += 2)
+  {
+    manager.remove(handles[i]);
+    EXPECT_FALSE(manager.hasPending(handles[i]));
+  }
+
+  recorder.clear();
+  spinFor(queue, WallDuration(0.1));
+
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (i % 2 == 0)
+    {
+      EXPECT_EQ(0U, recorder.counts[i]) << "removed timer " << i << " fired";
+    }
+    else
+    {
+      EXPECT_LT(0U, recorder.counts[i]) << "timer " << i << " never fired";
+    }
+  }
+
+  for (uint32_t i = 1; i < count; i += 2)
+  {
+    manager.remove(handles[i]);
+  }
+}
+
+TEST(TimerManager, inlineTimerStoppedByInlineTimer)
+{
+  WallTimerManager manager;
+  CallbackQueue queue;
+  Stopper stopper;
+  stopper.manager = &manager;
+
+  // The first inline call holds up the timer thread until both of the others are due, so they get called in the same
+  // pass.  Whichever goes first stops both.
+  int32_t blocker = manager.add(WallDuration(0.001), boost::bind(&Stopper::block, &stopper, _1), &queue, VoidConstPtr(),
+                                true, 0, WallDuration(), true);
+  for (uint32_t i = 0; i < 2; ++i)
+  {
+    stopper.handles.push_back(manager.add(WallDuration(0.01), boost::bind(&Stopper::stopAll, &stopper, _1), &queue,
+                                          VoidConstPtr(), false, 0, WallDuration(), true));
+  }
+
+  WallDuration(0.2).sleep();
+
+  // remove() from outside the timer thread waits for any inline call in progress
+  manager.remove(blocker);
+  for (size_t i = 0; i < stopper.handles.size(); ++i)
+  {
+    manager.remove(stopper.handles[i]);
+  }
+
+  EXPECT_EQ(1U, stopper.calls);
+}
+
+TEST(TimerManager, setPeriodReordersHeap)
+{
+  const uint32_t count = 500;
+  WallTimerManager manager;
+  CallbackQueue queue;
+  Recorder recorder(count);
+
+  // Every fifth timer starts fast, the rest are far in the future
+  std::vector<WallDuration> periods;
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    periods.push_back(i % 5 == 0 ? WallDuration(0.005) : WallDuration(1000.0));
+  }
+
+  std::vector<int32_t> handles = addTimers(manager, queue, recorder, periods, false);
+
+  spinFor(queue, WallDuration(0.05));
+
+  // Swap them: slow the fast timers down and bring a different set of slow ones forward
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (i % 5 == 0)
+    {
+      manager.setPeriod(handles[i], WallDuration(1000.0));
+    }
+    else if (i % 5 == 1)
+    {
+      manager.setPeriod(handles[i], WallDuration(0.005));
+    }
+  }
+
+  // Callbacks queued before the change still run, and reschedule their timers with the new period
+  queue.callAvailable();
+  recorder.clear();
+  spinFor(queue, WallDuration(0.1));
+
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (i % 5 == 1)
+    {
+      EXPECT_LT(0U, recorder.counts[i]) << "timer " << i << " never fired after its period was shortened";
+    }
+    else
+    {
+      EXPECT_EQ(0U, recorder.counts[i]) << "timer " << i << " fired";
+    }
+  }
+
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    manager.remove(handles[i]);
+  }
+}
+
+TEST(TimerManager, benchmark)
+{
+  const uint32_t sizes[] = { 10000, 100000 };
+
+  printf("%10s %14s %14s %14s\n", "timers", "add (s)", "setPeriod (s)", "remove (s)");
+  for (uint32_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+  {
+    const uint32_t count = sizes[s];
+    WallTimerManager manager;
+    CallbackQueue queue;
+    Recorder recorder(count);
+
+    // Long periods, spread out so the heap has real work to do, and none fire during the run
+    std::vector<WallDuration> periods;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      periods.push_back(WallDuration(1000.0 + ((i * 7919) % count)));
+    }
+
+    WallTime start = WallTime::now();
+    std::vector<int32_t> handles = addTimers(manager, queue, recorder, periods, false);
+    WallDuration add_time = WallTime::now() - start;
+
+    start = WallTime::now();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      manager.setPeriod(handles[i], WallDuration(1000.0 + ((i * 104729) % count)));
+    }
+    WallDuration set_period_time = WallTime::now() - start;
+
+    start = WallTime::now();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+      manager.remove(handles[i]);
+    }
+    WallDuration remove_time = WallTime::now() - start;
+
+    printf("%10u %14.4f %14.4f %14.4f\n", count, add_time.toSec(), set_period_time.toSec(), remove_time.toSec());
+
+    EXPECT_TRUE(recorder.fired.empty());
+  }
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,5 +1,224 @@
+#include <iostream>
+#include <cstdio>
+#include <time.h>
+#include <boost/atomic.hpp>
 #include "rtai_thread.h"
 
+void increment(int* counter)
+{
+	++*counter;
+}
+
+// Who holds the shared_mutex under test, counted by the threads holding it, and how often that broke the rules.
+// Holders yield while counted, so that a thread let in when it shouldn't be gets to run and be caught.
+struct shared_mutex_holders
+{
+	shared_mutex_holders() : readers(0), upgraders(0), writers(0), errors(0) {}
+
+	void shared()
+	{
+		++readers;
+		rtai_thread::this_thread::yield();
+		if (writers.load())
+		{
+			++errors;
+		}
+		--readers;
+	}
+
+	void upgrade()
+	{
+		++upgraders;
+		rtai_thread::this_thread::yield();
+		if (upgraders.load() != 1 || writers.load())
+		{
+			++errors;
+		}
+		--upgraders;
+	}
+
+	void exclusive()
+	{
+		++writers;
+		rtai_thread::this_thread::yield();
+		if (writers.load() != 1 || readers.load() || upgraders.load())
+		{
+			++errors;
+		}
+		--writers;
+	}
+
+	boost::atomic<int> readers;
+	boost::atomic<int> upgraders;
+	boost::atomic<int> writers;
+	boost::atomic<int> errors;
+};
+
+// Each thread cycles through every way of taking, converting and releasing the lock, starting at a different one
+void stress_shared_mutex(rtai_thread::shared_mutex* m, shared_mutex_holders* h, int id, int iterations)
+{
+	boost::posix_time::milliseconds const timeout(1);
+	for (int i = 0; i < iterations; ++i)
+	{
+		switch ((i + id) % 9)
+		{
+		case 0:
+			m->lock_shared();
+			h->shared();
+			m->unlock_shared();
+			break;
+		case 1:
+			if (m->timed_lock_shared(timeout))
+			{
+				h->shared();
+				m->unlock_shared();
+			}
+			break;
+		case 2:
+			m->lock();
+			h->exclusive();
+			m->unlock();
+			break;
+		case 3:
+			if (m->timed_lock(timeout))
+			{
+				h->exclusive();
+				m->unlock();
+			}
+			break;
+		case 4:
+			m->lock_upgrade();
+			h->upgrade();
+			m->unlock_upgrade_and_lock();
+			h->exclusive();
+			m->unlock_and_lock_upgrade();
+			h->upgrade();
+			m->unlock_upgrade_and_lock_shared();
+			h->shared();
+			m->unlock_shared();
+			break;
+		case 5:
+			if (m->timed_lock_upgrade(timeout))
+			{
+				h->upgrade();
+				if (m->try_unlock_upgrade_and_lock())
+				{
+					h->exclusive();
+					m->unlock_and_lock_shared();
+					h->shared();
+					m->unlock_shared();
+				}
+				else
+				{
+					m->unlock_upgrade();
+				}
+			}
+			break;
+#ifdef BOOST_THREAD_PROVIDES_SHARED_MUTEX_UPWARDS_CONVERSIONS
+		case 6:
+			m->lock_shared();
+			h->shared();
+			if (m->try_unlock_shared_and_lock())
+			{
+				h->exclusive();
+				m->unlock();
+			}
+			else
+			{
+				m->unlock_shared();
+			}
+			break;
+		case 7:
+			m->lock_shared();
+			h->shared();
+			if (m->try_unlock_shared_and_lock_upgrade())
+			{
+				h->upgrade();
+				m->unlock_upgrade();
+			}
+			else
+			{
+				m->unlock_shared();
+			}
+			break;
+#endif
+#ifdef BOOST_THREAD_USES_CHRONO
+		case 8:
+			if (m->try_lock_upgrade_for(boost::chrono::milliseconds(1)))
+			{
+				h->upgrade();
+				if (m->try_unlock_upgrade_and_lock_for(boost::chrono::milliseconds(1)))
+				{
+					h->exclusive();
+					m->unlock();
+				}
+				else
+				{
+					m->unlock_upgrade();
+				}
+			}
+			break;
+#endif
+		default:
+			break;
+		}
+	}
+}
+
+#ifdef RTAI_THREAD_POSIX
+double seconds_now()
+{
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+template <class SharedMutex>
+void read_shared_mutex(SharedMutex* m, int iterations)
+{
+	for (int i = 0; i < iterations; ++i)
+	{
+		m->lock_shared();
+		m->unlock_shared();
+	}
+}
+
+template <class SharedMutex>
+void write_shared_mutex(SharedMutex* m, boost::atomic<bool>* done)
+{
+	while (!done->load())
+	{
+		m->lock();
+		m->unlock();
+		rtai_thread::this_thread::yield();
+	}
+}
+
+// Reads per second through readers threads, with one writer taking the lock in between
+template <class SharedMutex>
+double shared_mutex_reads_per_second(int readers, int iterations)
+{
+	SharedMutex m;
+	boost::atomic<bool> done(false);
+	rtai_thread::thread writer(boost::bind(write_shared_mutex<SharedMutex>, &m, &done));
+
+	double const start = seconds_now();
+	{
+		rtai_thread::thread_group group;
+		for (int i = 0; i < readers; ++i)
+		{
+			group.create_thread(boost::bind(read_shared_mutex<SharedMutex>, &m, iterations));
+		}
+		group.join_all();
+	}
+	double const elapsed = seconds_now() - start;
+
+	done = true;
+	writer.join();
+	return readers * iterations / elapsed;
+}
+#endif
+
 int main()
 {
 	//test thread
@@ -7,17 +226,107 @@ int main()
 	std::cout << test_th.get_id() << std::endl;
 	std::cout << "thread pass!" << std::endl;
 
+	//test thread_attributes
+	{
+		int counter = 0;
+		rtai_thread::thread::attributes attrs;
+		attrs.set_stack_size(256 * 1024);
+		attrs.set_prefault_stack_size(128 * 1024);
+		attrs.set_cpu_affinity(0);
+		rtai_thread::thread attr_th(attrs, boost::bind(increment, &counter));
+		attr_th.join();
+		if (counter != 1)
+		{
+			return 1;
+		}
+	}
+	std::cout << "thread_attributes pass!" << std::endl;
+
 	//test mutex
 	rtai_thread::mutex rtai_m;
 	rtai_m.lock();
 	rtai_m.unlock();
 	std::cout << "mutex pass!" << std::endl;
+
+	//test pi_mutex with condition_variable
+	{
+		rtai_thread::pi_mutex pi_m;
+		rtai_thread::condition_variable pi_cv;
+		rtai_thread::pi_mutex::scoped_lock pi_sl(pi_m);
+		pi_cv.timed_wait(pi_sl, boost::posix_time::milliseconds(1));
+	}
+	std::cout << "pi_mutex pass!" << std::endl;
+
+	//test ceiling_mutex
+	{
+		rtai_thread::ceiling_mutex ceil_m(sched_get_priority_max(SCHED_FIFO));
+		// Locking is refused unless the thread's policy and priority fit under the ceiling, so only check it unlocks
+		if (ceil_m.try_lock())
+		{
+			ceil_m.unlock();
+		}
+	}
+#ifdef RTAI_THREAD_POSIX
+	{
+		int failed = 0;
+		try
+		{
+			rtai_thread::ceiling_mutex no_ceil_m(sched_get_priority_min(SCHED_FIFO) - 1);
+			++failed;
+		}
+		catch (boost::thread_resource_error&)
+		{
+		}
+		try
+		{
+			rtai_thread::mutex no_ceil_m(rtai_thread::mutex_protocol_protect);
+			++failed;
+		}
+		catch (boost::thread_resource_error&)
+		{
+		}
+		if (failed)
+		{
+			return 1;
+		}
+	}
+#endif
+	std::cout << "ceiling_mutex pass!" << std::endl;
 	
 	rtai_thread::shared_mutex rtai_sm;
 	rtai_sm.lock();
 	rtai_sm.unlock();
 	std::cout << "shared_mutex pass!" << std::endl;
 
+	//stress shared_mutex with readers, writers and upgraders, through the timed and conversion paths too
+	{
+		shared_mutex_holders holders;
+		rtai_thread::thread_group group;
+		for (int i = 0; i < 8; ++i)
+		{
+			group.create_thread(boost::bind(stress_shared_mutex, &rtai_sm, &holders, i, 20000));
+		}
+		group.join_all();
+		if (holders.errors.load())
+		{
+			std::cout << "shared_mutex stress: " << holders.errors.load() << " errors" << std::endl;
+			return 1;
+		}
+	}
+	std::cout << "shared_mutex stress pass!" << std::endl;
+
+#ifdef RTAI_THREAD_POSIX
+	//compare futex_shared_mutex with the condition variable one it replaced
+	printf("%8s %20s %20s\n", "readers", "futex reads/s", "cv reads/s");
+	for (int readers = 1; readers <= 8; readers *= 2)
+	{
+		printf("%8d %20.0f %20.0f\n", readers,
+		       shared_mutex_reads_per_second<rtai_thread::futex_shared_mutex>(readers, 200000),
+		       shared_mutex_reads_per_second<rtai_thread::cv_shared_mutex>(readers, 200000));
+	}
+	std::cout << "shared_mutex benchmark pass!" << std::endl;
+#endif
+
 	//test scoped_lock
 	{
 		rtai_thread::mutex::scoped_lock rtai_sl;